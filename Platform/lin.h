@@ -2,7 +2,9 @@
 
 #include <linux/futex.h>
 #include <sys/syscall.h>
+#include <sys/mman.h>
 #include <unistd.h>
+#include <time.h>
 #include <errno.h>
 #include <cstring>
 #include <cassert>
@@ -16,6 +18,25 @@ inline long sys_futex(void* addr1, int op, uint32_t val1, const struct timespec*
     return syscall(SYS_futex, addr1, op, val1, timeout, addr2, val3);
 }
 
+inline int cpuCount()
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+// High resolution monotonic clock, in ticks of 1/clockFrequency() seconds
+inline uint64_t clockTicks()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+inline uint64_t clockFrequency()
+{
+    return 1000000000ull;
+}
+
 inline size_t atomicCompareExchange(volatile size_t* pval, size_t val, size_t compare)
 {
     __atomic_compare_exchange_n(pval, &compare, val, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
@@ -139,4 +160,88 @@ inline void futexWakeAll(volatile void* pv)
     sys_futex((void*)pv, FUTEX_WAKE, (uint32_t)INT_MAX, nullptr, nullptr, 0);
 }
 
+// Granularity of virtual memory allocations
+inline size_t vmPageSize()
+{
+    static size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    return pageSize;
+}
+
+// Size of a huge page
+inline size_t vmHugePageSize()
+{
+    return 2 * 1024 * 1024;
+}
+
+// Map `size` bytes (a multiple of vmPageSize) of zeroed read/write memory.
+// Returns nullptr on failure.
+inline void* vmAlloc(size_t size)
+{
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+// Map `size` bytes (a multiple of vmHugePageSize) backed by huge pages.
+// Returns nullptr if huge pages aren't available (they must be reserved
+// by the system, see /proc/sys/vm/nr_hugepages).
+inline void* vmAllocHuge(size_t size)
+{
+#ifdef MAP_HUGETLB
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+#else
+    return nullptr;
+#endif
+}
+
+// Map at least `size` bytes (any size - rounded up to whole pages) of
+// zeroed read/write memory starting at a multiple of `alignment` (a power
+// of two). Only the pages covering `size` stay mapped. Returns nullptr on
+// failure.
+inline void* vmAllocAligned(size_t size, size_t alignment)
+{
+    size_t page = vmPageSize();
+    size = (size + page - 1) & ~(page - 1);
+    if (alignment <= page)
+        return vmAlloc(size);
+
+    // Over-map by the alignment, then unmap the unaligned ends
+    size_t mapped = size + alignment - page;
+    char* p = (char*)vmAlloc(mapped);
+    if (!p)
+        return nullptr;
+    char* aligned = (char*)(((uintptr_t)p + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    if (aligned > p)
+        munmap(p, aligned - p);
+    if (aligned + size < p + mapped)
+        munmap(aligned + size, p + mapped - (aligned + size));
+    return aligned;
+}
+
+// Hint that a mapping should use transparent huge pages
+inline void vmAdviseHuge(void* p, size_t size)
+{
+#ifdef MADV_HUGEPAGE
+    madvise(p, size, MADV_HUGEPAGE);
+#else
+    (void)p;
+    (void)size;
+#endif
+}
+
+// Resize a mapping, moving it if necessary, without copying (the kernel
+// just moves the page table entries). Returns nullptr if the mapping
+// can't be resized - the caller should map a new block and copy.
+inline void* vmReAlloc(void* p, size_t oldSize, size_t newSize)
+{
+    void* pNew = mremap(p, oldSize, newSize, MREMAP_MAYMOVE);
+    return pNew == MAP_FAILED ? nullptr : pNew;
+}
+
+// Unmap memory mapped by vmAlloc, vmAllocAligned or vmAllocHuge
+inline void vmFree(void* p, size_t size)
+{
+    munmap(p, size);
+}
+
 }
\ No newline at end of file
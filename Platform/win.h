@@ -73,6 +73,26 @@ inline void Sleep(uint32_t ms)
     ::Sleep(ms);
 }
 
+inline int cpuCount()
+{
+    return (int)GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+}
+
+// High resolution monotonic clock, in ticks of 1/clockFrequency() seconds
+inline uint64_t clockTicks()
+{
+    LARGE_INTEGER value;
+    QueryPerformanceCounter(&value);
+    return (uint64_t)value.QuadPart;
+}
+
+inline uint64_t clockFrequency()
+{
+    LARGE_INTEGER value;
+    QueryPerformanceFrequency(&value);
+    return (uint64_t)value.QuadPart;
+}
+
 inline size_t atomicCompareExchange(volatile size_t* pval, size_t val, size_t compare)
 {
     return (size_t)InterlockedCompareExchangePointer((void* volatile*)pval, (void*)val, (void*)compare);
@@ -447,6 +467,94 @@ inline void tlsSet(TTls& tls, void* val)
     TlsSetValue(tls, val);
 }
 
+// --------- Virtual Memory ----------
+
+// Granularity of virtual memory allocations
+inline size_t vmPageSize()
+{
+    static size_t pageSize = 0;
+    if (pageSize == 0)
+    {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        pageSize = info.dwAllocationGranularity;
+    }
+    return pageSize;
+}
+
+// Size of a huge ("large") page
+inline size_t vmHugePageSize()
+{
+    size_t size = GetLargePageMinimum();
+    return size ? size : 2 * 1024 * 1024;
+}
+
+// Map `size` bytes (a multiple of vmPageSize) of zeroed read/write memory.
+// Returns nullptr on failure.
+inline void* vmAlloc(size_t size)
+{
+    return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+// Map `size` bytes (a multiple of vmHugePageSize) backed by huge pages.
+// Returns nullptr if huge pages aren't available (the process needs the
+// "Lock pages in memory" privilege).
+inline void* vmAllocHuge(size_t size)
+{
+    return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+}
+
+// Map at least `size` bytes (any size - rounded up to whole pages) of
+// zeroed read/write memory starting at a multiple of `alignment` (a power
+// of two). Only the pages covering `size` are committed. Returns nullptr
+// on failure.
+inline void* vmAllocAligned(size_t size, size_t alignment)
+{
+    // Reservations are always aligned to the allocation granularity
+    if (alignment <= vmPageSize())
+        return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+    // Find an aligned range, then try to claim it (another thread may
+    // take it first)
+    for (int attempt = 0; attempt < 16; attempt++)
+    {
+        char* p = (char*)VirtualAlloc(nullptr, size + alignment, MEM_RESERVE, PAGE_NOACCESS);
+        if (!p)
+            return nullptr;
+        VirtualFree(p, 0, MEM_RELEASE);
+        char* aligned = (char*)(((uintptr_t)p + alignment - 1) & ~(uintptr_t)(alignment - 1));
+        void* result = VirtualAlloc(aligned, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        if (result)
+            return result;
+    }
+    return nullptr;
+}
+
+// Hint that a mapping should use transparent huge pages (not supported)
+inline void vmAdviseHuge(void* p, size_t size)
+{
+    (void)p;
+    (void)size;
+}
+
+// Resize a mapping, moving it if necessary, without copying. Returns
+// nullptr if the mapping can't be resized (always on Windows - the caller
+// should map a new block and copy)
+inline void* vmReAlloc(void* p, size_t oldSize, size_t newSize)
+{
+    (void)p;
+    (void)oldSize;
+    (void)newSize;
+    return nullptr;
+}
+
+// Unmap memory mapped by vmAlloc, vmAllocAligned or vmAllocHuge
+inline void vmFree(void* p, size_t size)
+{
+    (void)size;
+    VirtualFree(p, 0, MEM_RELEASE);
+}
+
 // --------- File System ----------
 
 inline bool FileExists(const char* filename)
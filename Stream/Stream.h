@@ -55,6 +55,41 @@ public:
         return Write(psz, SChar<char>::Length(psz));
     }
 
+    int Write(const StringView<char>& view)
+    {
+        if (view.IsNull())
+            return 0;
+        return Write(view.GetBuffer(), view.GetLength());
+    }
+
+    template <typename TRefCount>
+    int Write(const StringCore<char, TRefCount>& str)
+    {
+        if (str.IsNull())
+            return 0;
+        return Write(str.sz(), str.GetLength());
+    }
+
+    // Write a string builder's content (a chunked builder is written chunk
+    // by chunk, without flattening it)
+    template <typename TAllocator>
+    int Write(const StringBuilder<char, TAllocator>& builder)
+    {
+        if (builder.IsContiguous())
+        {
+            int length;
+            const char* psz = builder.Finish(&length);
+            return Write(psz, length);
+        }
+
+        int result = 0;
+        builder.ForEachChunk([&](const char* p, int length) {
+            result = Write(p, length);
+            return result == 0;
+        });
+        return result;
+    }
+
     int Write(const wchar_t* psz)
     {
         if (!psz)
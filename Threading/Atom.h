@@ -0,0 +1,335 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#include "../Core/String.h"
+#include "../Core/Arena.h"
+#include "Atomic.h"
+#include "Mutex.h"
+
+namespace SimpleLib
+{
+
+class AtomTable;
+
+// An interned string - every Atom with the same text (from the same
+// AtomTable) points at the same entry, so comparing two atoms is a pointer
+// compare and hashing one just returns the hash cached in its entry, eg:
+//
+//     Map<Atom, float> params;
+//     params.Set(Atom("gain"), 0.5f);
+//
+// Use atoms for identifiers that are looked up far more often than they're
+// created - parameter names, JSON keys, node identifiers. Interning a new
+// string takes a lock, but looking up an existing one (including with
+// Find, which never interns) doesn't, so a real-time thread can look up
+// atoms that have already been created.
+//
+// Entries are never freed, so don't intern unbounded sets of strings (eg:
+// user input) in the global table - use a private AtomTable for those.
+// Atoms are plain pointers and can be freely copied between threads.
+class Atom
+{
+public:
+	// Constructor (null atom)
+	Atom()
+	{
+		m_entry = nullptr;
+	}
+
+	// Intern a string in the global table
+	explicit Atom(const char* psz, int length = -1);
+
+	// Intern a string in the global table
+	explicit Atom(const String& str);
+
+	// Find an existing atom in the global table without interning, returns
+	// a null atom if the string has never been interned
+	static Atom Find(const char* psz, int length = -1);
+
+	// Get the string (nullptr for a null atom)
+	const char* sz() const
+	{
+		return m_entry ? m_entry->sz : nullptr;
+	}
+
+	// Get the length of the string
+	int GetLength() const
+	{
+		return m_entry ? m_entry->length : 0;
+	}
+
+	// Get the string's hash (same as String::Hash of the same text)
+	uint32_t GetHash() const
+	{
+		return m_entry ? m_entry->hash : String::Hash(nullptr, 0);
+	}
+
+	// Check if this is a null atom
+	bool IsNull() const
+	{
+		return m_entry == nullptr;
+	}
+
+	// Copy the string
+	String ToString() const
+	{
+		return String(sz(), GetLength());
+	}
+
+	// Equality is identity
+	bool operator==(const Atom& other) const
+	{
+		return m_entry == other.m_entry;
+	}
+
+	bool operator!=(const Atom& other) const
+	{
+		return m_entry != other.m_entry;
+	}
+
+	// Ordering is by text, so sorted atoms come out in a stable order
+	bool operator<(const Atom& other) const
+	{
+		return Compare(other) < 0;
+	}
+
+	bool operator>(const Atom& other) const
+	{
+		return Compare(other) > 0;
+	}
+
+	// Cached hash, for Map and Set
+	static uint32_t Hash(const Atom& atom)
+	{
+		return atom.GetHash();
+	}
+
+private:
+	struct ENTRY
+	{
+		uint32_t hash;
+		int length;
+		char sz[1];
+	};
+
+	Atom(const ENTRY* entry)
+	{
+		m_entry = entry;
+	}
+
+	int Compare(const Atom& other) const
+	{
+		if (m_entry == other.m_entry)
+			return 0;
+		if (!m_entry)
+			return -1;
+		if (!other.m_entry)
+			return 1;
+		return strcmp(m_entry->sz, other.m_entry->sz);
+	}
+
+	const ENTRY* m_entry;
+	friend class AtomTable;
+};
+
+// A table of interned strings.
+//
+// Entries are carved from an arena (so interning many small strings costs
+// a pointer increment each rather than a heap allocation) and live until
+// the table is destroyed. Lookups are lock free: the entries are indexed
+// by an open addressed hash table that's only ever added to, under a
+// mutex, and is replaced (rather than resized in place) when it grows.
+// Replaced tables are kept until the table is destroyed so a concurrent
+// lookup can finish probing one.
+//
+// Atom's constructors use Global(). A private table can be used for
+// strings that shouldn't live forever - its atoms are only valid while it
+// exists, and never equal atoms from another table.
+class AtomTable
+{
+public:
+	// Constructor
+	AtomTable(size_t blockSize = 16384)
+		: m_arena(blockSize)
+	{
+		m_table.Set(NewTable(kInitialCapacity));
+	}
+
+	// Destructor
+	virtual ~AtomTable()
+	{
+		TABLE* p = m_table.Get();
+		while (p)
+		{
+			TABLE* pRetired = p->retired;
+			TMalloc::Free(p);
+			p = pRetired;
+		}
+	}
+
+	// No copy
+	AtomTable(const AtomTable&) = delete;
+	AtomTable& operator=(const AtomTable&) = delete;
+
+	// Get the atom for a string, interning it if it's not already in the
+	// table. Returns a null atom for a null string (or if out of memory).
+	Atom Intern(const char* psz, int length = -1)
+	{
+		if (psz == nullptr)
+			return Atom();
+		if (length < 0)
+			length = (int)strlen(psz);
+
+		// Already interned?
+		uint32_t hash = String::Hash(psz, length);
+		Atom atom(Lookup(m_table.Get(), psz, length, hash));
+		if (!atom.IsNull())
+			return atom;
+
+		EnterMutex lock(m_mutex);
+
+		// Check again now we have the lock (another thread may have just
+		// added it)
+		TABLE* table = m_table.Get();
+		atom = Atom(Lookup(table, psz, length, hash));
+		if (!atom.IsNull())
+			return atom;
+
+		// Create the entry
+		Atom::ENTRY* entry = (Atom::ENTRY*)m_arena.Alloc(offsetof(Atom::ENTRY, sz) + length + 1, alignof(Atom::ENTRY));
+		if (!entry)
+			return Atom();
+		entry->hash = hash;
+		entry->length = length;
+		memcpy(entry->sz, psz, length);
+		entry->sz[length] = '\0';
+
+		// Keep the load factor under 1/2, so probe sequences stay short
+		if ((m_count.Get() + 1) * 2 > table->capacity)
+		{
+			TABLE* newTable = Grow(table);
+			if (!newTable)
+				return Atom();
+			table = newTable;
+		}
+
+		// Add it (publishing the entry's contents with it)
+		Insert(table, entry);
+		m_count.Inc();
+		return Atom(entry);
+	}
+
+	// Get the atom for a string without interning it. Returns a null atom
+	// if the string isn't in the table.
+	Atom Find(const char* psz, int length = -1) const
+	{
+		if (psz == nullptr)
+			return Atom();
+		if (length < 0)
+			length = (int)strlen(psz);
+		return Atom(Lookup(m_table.Get(), psz, length, String::Hash(psz, length)));
+	}
+
+	// Get the number of interned strings
+	int GetCount() const
+	{
+		return m_count.Get();
+	}
+
+	// The table used by Atom's constructors
+	static AtomTable& Global()
+	{
+		// Deliberately leaked - atoms in other static objects may still be
+		// used during process shutdown
+		static AtomTable* table = new AtomTable();
+		return *table;
+	}
+
+private:
+	static const int kInitialCapacity = 256;
+
+	struct TABLE
+	{
+		TABLE* retired;			// The table this one replaced
+		int capacity;			// Power of two
+		Atomic<const Atom::ENTRY*> slots[1];
+	};
+
+	static TABLE* NewTable(int capacity)
+	{
+		TABLE* table = (TABLE*)TMalloc::Alloc(offsetof(TABLE, slots) + capacity * sizeof(table->slots[0]));
+		if (!table)
+			return nullptr;
+		memset((void*)table->slots, 0, capacity * sizeof(table->slots[0]));
+		table->retired = nullptr;
+		table->capacity = capacity;
+		return table;
+	}
+
+	static const Atom::ENTRY* Lookup(TABLE* table, const char* psz, int length, uint32_t hash)
+	{
+		int mask = table->capacity - 1;
+		for (int i = (int)hash & mask; ; i = (i + 1) & mask)
+		{
+			const Atom::ENTRY* entry = table->slots[i].Get();
+			if (!entry)
+				return nullptr;
+			if (entry->hash == hash && entry->length == length && memcmp(entry->sz, psz, length) == 0)
+				return entry;
+		}
+	}
+
+	static void Insert(TABLE* table, const Atom::ENTRY* entry)
+	{
+		int mask = table->capacity - 1;
+		int i = (int)entry->hash & mask;
+		while (table->slots[i].Get())
+			i = (i + 1) & mask;
+		table->slots[i].Set(entry);
+	}
+
+	// Replace the table with one twice the size
+	TABLE* Grow(TABLE* table)
+	{
+		TABLE* newTable = NewTable(table->capacity * 2);
+		if (!newTable)
+			return nullptr;
+
+		for (int i = 0; i < table->capacity; i++)
+		{
+			const Atom::ENTRY* entry = table->slots[i].Get();
+			if (entry)
+				Insert(newTable, entry);
+		}
+
+		newTable->retired = table;
+		m_table.Set(newTable);
+		return newTable;
+	}
+
+	Mutex m_mutex;
+	Arena m_arena;
+	Atomic<TABLE*> m_table;
+	Atomic<int> m_count;
+};
+
+inline Atom::Atom(const char* psz, int length)
+{
+	*this = AtomTable::Global().Intern(psz, length);
+}
+
+inline Atom::Atom(const String& str)
+{
+	*this = AtomTable::Global().Intern(str.sz(), str.GetLength());
+}
+
+inline Atom Atom::Find(const char* psz, int length)
+{
+	return AtomTable::Global().Find(psz, length);
+}
+
+}
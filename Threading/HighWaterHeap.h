@@ -42,6 +42,16 @@ public:
         m_state.Set(0);
     }
 
+    // Free the heap's memory, leaving it with no capacity until the
+    // next Reset(). The heap object itself stays valid.
+    void Release()
+    {
+        free(m_pmem);
+        m_pmem = nullptr;
+        m_capacity = 0;
+        m_state.Set(0);
+    }
+
     // Immediately free everything from the heap
     void FreeAll()
     {
@@ -2,13 +2,57 @@
 
 #include "MpmcStack.h"
 #include "HighWaterHeap.h"
+#include "Mutex.h"
+#include "../Core/List.h"
+#include "../Platform/Platform.h"
 
 namespace SimpleLib
 {
 
+// Sizing policy for a HighWaterHeapSet (see HighWaterHeapSet::Maintain)
+struct HighWaterHeapSetPolicy
+{
+    // Maintain() tops the reserve up to at least this many empty buckets
+    int minReserveBuckets = 0;
+
+    // Maintain() frees empty reserve buckets beyond this many
+    // (-1 = never free any)
+    int maxReserveBuckets = -1;
+
+    // Maintain() never grows the set beyond this many buckets in total
+    // (0 = no limit)
+    int maxBuckets = 0;
+
+    // Fraction of a bucket's capacity that, once passed, asks for more
+    // buckets if the reserve is running low (0 = never)
+    float growTriggerLevel = 0.75f;
+};
+
+// Counters reported by HighWaterHeapSet::GetStats
+struct HighWaterHeapSetStats
+{
+    int buckets;                    // Total buckets
+    int reserveBuckets;             // Empty buckets waiting in reserve
+    uint64_t capacity;              // Total bytes in all buckets
+    uint64_t used;                  // Bytes used in all buckets (high-water marks)
+    uint32_t failedAllocs;          // Allocations that returned nullptr
+    uint32_t bucketsAdded;          // Buckets added by Maintain()
+    uint32_t bucketsFreed;          // Buckets freed by Maintain()
+    uint32_t recycles;              // Times a bucket filled up and later drained
+    double averageRecycleMs;        // Average time from a bucket filling to draining
+    double maxRecycleMs;            // Longest time from a bucket filling to draining
+};
+
 // Implements a lock free high-water heap set.
 // This is designed for a very specific use case - fast, lock free, but short-lived
 // memory allocations.
+//
+// The set can resize itself to follow the load, but never on the allocating
+// thread: when a bucket passes its trigger level while the reserve is low,
+// fills up, or an allocation fails, the set just flags that it needs to grow
+// and calls OnGrowthNeeded() - override that to wake a housekeeping thread,
+// which then calls Maintain() to add (or free) reserve buckets according
+// to the policy (see SetPolicy).
 class HighWaterHeapSet
 {
 public:
@@ -20,14 +64,115 @@ public:
         // Allocate the initial buckets
         for (int i=0; i<initialBuckets; i++)
         {
-            m_reserveBuckets.Push(new Bucket(bucketSize));
+            m_reserveBuckets.Push(NewBucket());
         }
     }
 
-    ~HighWaterHeapSet()
+    virtual ~HighWaterHeapSet()
     {
         DeleteAll(m_activeBuckets);
         DeleteAll(m_reserveBuckets);
+        for (int i = 0; i < m_retiredBuckets.GetCount(); i++)
+            delete m_retiredBuckets[i];
+    }
+
+    // Set the sizing policy used by Maintain() (not real-time safe)
+    void SetPolicy(const HighWaterHeapSetPolicy& policy)
+    {
+        EnterMutex lock(m_mutex);
+        m_policy = policy;
+        m_minReserveBuckets.Set(policy.minReserveBuckets);
+
+        // Trigger levels are atomic, so live buckets can pick up the new
+        // one mid fill cycle (at worst that cycle's OnTrigger is missed
+        // or repeated)
+        for (int i = 0; i < m_buckets.GetCount(); i++)
+            ApplyTrigger(m_buckets[i]);
+    }
+
+    // Grow or shrink the reserve according to the policy. Allocates and
+    // frees memory, so must be called from a non real-time thread - eg:
+    // periodically, or in response to OnGrowthNeeded()
+    void Maintain()
+    {
+        EnterMutex lock(m_mutex);
+
+        // Work out how many reserve buckets we want
+        bool grow = m_growthNeeded.Get() != 0;
+        m_growthNeeded.Set(0);
+        int reserve = m_reserveBuckets.GetLikelyCount();
+        int target = reserve < m_policy.minReserveBuckets ? m_policy.minReserveBuckets : reserve;
+        if (grow && target <= reserve)
+            target = reserve + 1;
+
+        // Grow
+        bool added = false;
+        while (reserve < target)
+        {
+            if (m_policy.maxBuckets > 0 && m_buckets.GetCount() >= m_policy.maxBuckets)
+                break;
+            m_reserveBuckets.Push(NewBucket());
+            m_bucketsAdded.Inc();
+            reserve++;
+            added = true;
+        }
+
+        // Shrink (but never below the minimum, or straight after growing)
+        int maxReserve = m_policy.maxReserveBuckets;
+        if (maxReserve >= 0 && !added && !grow)
+        {
+            if (maxReserve < m_policy.minReserveBuckets)
+                maxReserve = m_policy.minReserveBuckets;
+            while (m_reserveBuckets.GetLikelyCount() > maxReserve)
+            {
+                // Reserve buckets are empty so their memory can be freed,
+                // but not the Bucket itself - an Alloc() racing to pop the
+                // reserve stack may still read its `next` field. Keep it
+                // for reuse by NewBucket() instead.
+                Bucket* bucket = m_reserveBuckets.Pop();
+                if (!bucket)
+                    break;
+                m_buckets.Remove(bucket);
+                bucket->Release();
+                m_retiredBuckets.Add(bucket);
+                m_bucketsFreed.Inc();
+            }
+        }
+    }
+
+    // Check if the set has asked to grow since the last Maintain()
+    bool IsGrowthNeeded()
+    {
+        return m_growthNeeded.Get() != 0;
+    }
+
+    // Get usage counters (not real-time safe)
+    void GetStats(HighWaterHeapSetStats& stats)
+    {
+        EnterMutex lock(m_mutex);
+        stats.buckets = m_buckets.GetCount();
+        stats.reserveBuckets = m_reserveBuckets.GetLikelyCount();
+        stats.capacity = 0;
+        stats.used = 0;
+        for (int i = 0; i < m_buckets.GetCount(); i++)
+        {
+            stats.capacity += m_buckets[i]->GetCapacity();
+            stats.used += m_buckets[i]->GetLikelyUsed();
+        }
+        stats.failedAllocs = m_failedAllocs.Get();
+        stats.bucketsAdded = m_bucketsAdded.Get();
+        stats.bucketsFreed = m_bucketsFreed.Get();
+        stats.recycles = m_recycles.Get();
+
+        double msPerTick = 1000.0 / (double)Platform::clockFrequency();
+        stats.averageRecycleMs = stats.recycles ? (double)m_recycleTicks.Get() * msPerTick / stats.recycles : 0;
+        stats.maxRecycleMs = (double)m_maxRecycleTicks.Get() * msPerTick;
+    }
+
+    // Notification (on the allocating thread, so must be real-time safe)
+    // that the set wants to grow - eg: signal a thread that calls Maintain()
+    virtual void OnGrowthNeeded()
+    {
     }
 
     // Allocate memory
@@ -80,9 +225,15 @@ public:
         // Try the reserve list
         bucket = m_reserveBuckets.Pop();
         if (!bucket)
+        {
+            m_failedAllocs.Inc();
+            RequestGrowth();
             return nullptr;
+        }
         void* mem = bucket->Alloc(size);
         m_activeBuckets.Push(bucket);
+        if (!mem)
+            m_failedAllocs.Inc();
 
         // Done
         return mem;
@@ -107,13 +258,94 @@ protected:
     class Bucket : public HighWaterHeap
     {
     public:
-        Bucket(uint32_t capacity) : HighWaterHeap(capacity)
+        Bucket(HighWaterHeapSet* owner, uint32_t capacity) : HighWaterHeap(capacity)
+        {
+            m_owner = owner;
+        }
+
+        // Passed the trigger level, ask for more buckets if the reserve
+        // is running low
+        virtual void OnTrigger() override
+        {
+            if (m_owner->m_reserveBuckets.GetLikelyCount() <= m_owner->m_minReserveBuckets.Get())
+                m_owner->RequestGrowth();
+        }
+
+        // Full, start timing how long it takes to drain (and, like
+        // OnTrigger, only ask for more buckets if the reserve is low -
+        // buckets filling and rotating is the normal steady state)
+        virtual void OnFull() override
+        {
+            if (m_fullTicks.Get() == 0)
+            {
+                m_fullTicks.TrySet(Platform::clockTicks(), 0);
+                if (m_owner->m_reserveBuckets.GetLikelyCount() <= m_owner->m_minReserveBuckets.Get())
+                    m_owner->RequestGrowth();
+            }
+        }
+
+        // Drained, record how long it took since it filled
+        virtual void OnEmpty() override
         {
+            uint64_t fullTicks = m_fullTicks.Get();
+            if (fullTicks != 0 && m_fullTicks.TrySet(0, fullTicks))
+                m_owner->RecordRecycle(Platform::clockTicks() - fullTicks);
         }
 
         Bucket* next = nullptr;       // For MpmcStack
+
+    private:
+        HighWaterHeapSet* m_owner;
+        Atomic<uint64_t> m_fullTicks;
     };
 
+    // Create a new bucket, reusing a retired one if there is one (caller
+    // must hold m_mutex, or be the constructor)
+    Bucket* NewBucket()
+    {
+        Bucket* bucket;
+        int retired = m_retiredBuckets.GetCount();
+        if (retired > 0)
+        {
+            bucket = m_retiredBuckets[retired - 1];
+            m_retiredBuckets.RemoveAt(retired - 1);
+            bucket->Reset(m_bucketSize);
+        }
+        else
+        {
+            bucket = new Bucket(this, m_bucketSize);
+        }
+        ApplyTrigger(bucket);
+        m_buckets.Add(bucket);
+        return bucket;
+    }
+
+    void ApplyTrigger(Bucket* bucket)
+    {
+        // Trigger level of zero would fire on every fill cycle, so use
+        // the capacity (never reached) to disable it
+        float level = m_policy.growTriggerLevel;
+        bucket->SetTrigger(level > 0 ? (uint32_t)(m_bucketSize * level) : m_bucketSize);
+    }
+
+    void RequestGrowth()
+    {
+        if (m_growthNeeded.TrySet(1, 0))
+            OnGrowthNeeded();
+    }
+
+    void RecordRecycle(uint64_t ticks)
+    {
+        m_recycles.Inc();
+        m_recycleTicks.Add(ticks);
+        while (true)
+        {
+            uint64_t max = m_maxRecycleTicks.Get();
+            if (ticks <= max || m_maxRecycleTicks.TrySet(ticks, max))
+                break;
+        }
+    }
+
     // Pop and delete every bucket remaining on a stack
     static void DeleteAll(MpmcStack<Bucket>& stack)
     {
@@ -129,6 +361,26 @@ protected:
     uint32_t m_bucketSize;
     MpmcStack<Bucket> m_reserveBuckets;
     MpmcStack<Bucket> m_activeBuckets;
+
+    // Every bucket (for stats and shrinking), and buckets whose memory
+    // has been freed by Maintain(), guarded by m_mutex which is never
+    // taken on the allocating path
+    Mutex m_mutex;
+    List<Bucket*> m_buckets;
+    List<Bucket*> m_retiredBuckets;
+    HighWaterHeapSetPolicy m_policy;
+
+    // Copy of m_policy.minReserveBuckets for the allocating path
+    Atomic<int> m_minReserveBuckets;
+
+    // Telemetry
+    Atomic<uint32_t> m_growthNeeded;
+    Atomic<uint32_t> m_failedAllocs;
+    Atomic<uint32_t> m_bucketsAdded;
+    Atomic<uint32_t> m_bucketsFreed;
+    Atomic<uint32_t> m_recycles;
+    Atomic<uint64_t> m_recycleTicks;
+    Atomic<uint64_t> m_maxRecycleTicks;
 };
 
 
@@ -0,0 +1,355 @@
+#pragma once
+
+#include <stdlib.h>
+#include <assert.h>
+#include <utility>
+
+#include "../Core/PlacedConstructor.h"
+#include "MpmcStack.h"
+#include "ThreadLocal.h"
+
+namespace SimpleLib
+{
+
+// Lock free pool of fixed size slots for objects of type T.
+//
+// Slots are carved from slabs of `slabSize` objects and are never given
+// back to the heap until the pool is destroyed, so once the pool has grown
+// to its working size allocating and freeing never touch malloc.
+//
+// Each thread has its own cache of free slots (a "magazine"), so most
+// Alloc/Free calls are just a pointer swap on thread local data with no
+// shared cache lines and no atomics at all. When a thread's cache runs dry
+// it takes a whole magazine of kMagazineSize slots from a shared lock free
+// stack (an MpmcStack, one CAS), and when it overflows it hands one back -
+// so objects freed on a different thread to the one that allocated them
+// (eg: messages passed between threads) just flow back to the allocating
+// threads a magazine at a time.
+//
+// For real-time threads call Prewarm() on the thread before it starts
+// real-time work (so the pool has enough slots and the thread has its
+// cache) and use TryAlloc(), which fails rather than growing the pool.
+//
+// Slots cached by a thread are returned to the shared stack when the
+// thread ends (SimpleLib Threads only - other threads should call
+// FlushThreadCache() before they exit). The pool keeps a registry of the
+// threads' caches and releases any that are left when it's destroyed, so
+// threads needn't have ended by then - but they must have stopped using
+// the pool.
+template <typename T>
+class ObjectPool
+{
+public:
+	// Number of slots moved between a thread's cache and the shared stack
+	// at a time
+	static const int kMagazineSize = 32;
+
+	// Constructor
+	ObjectPool(int slabSize = 256)
+	{
+		assert(slabSize > 0);
+		m_slabSize = slabSize;
+	}
+
+	// Destructor
+	virtual ~ObjectPool()
+	{
+		// Release every thread's cache. The slots go with the slabs below,
+		// and the other threads' pointers to their caches go with the TLS
+		// slot when m_cache is destroyed.
+		EnterMutex lock(m_cachesMutex);
+		while (m_caches)
+		{
+			CACHE* cache = m_caches;
+			m_caches = cache->nextCache;
+			cache->pool = nullptr;
+			delete cache;
+		}
+		lock.Leave();
+
+		// Free the slabs
+		SLAB* slab = m_slabs.PopAll();
+		while (slab)
+		{
+			SLAB* next = slab->next;
+			free(slab);
+			slab = next;
+		}
+	}
+
+	// No copy
+	ObjectPool(const ObjectPool&) = delete;
+	ObjectPool& operator=(const ObjectPool&) = delete;
+
+	// Allocate an uninitialized slot, growing the pool if it's empty.
+	// Returns nullptr if memory couldn't be allocated.
+	void* Alloc()
+	{
+		return AllocInternal(true);
+	}
+
+	// Allocate an uninitialized slot without ever growing the pool
+	// (ie: without ever calling malloc). Returns nullptr if there are no
+	// free slots.
+	void* TryAlloc()
+	{
+		return AllocInternal(false);
+	}
+
+	// Return a slot to the pool (from any thread)
+	void Free(void* p)
+	{
+		if (!p)
+			return;
+
+		CACHE* cache = GetCache();
+		FREESLOT* slot = (FREESLOT*)p;
+		slot->chain = cache->head;
+		cache->head = slot;
+		cache->count++;
+
+		// Hand a magazine back to the shared stack if the cache has
+		// grown too big (keeping a magazine's worth so alternating
+		// Alloc/Free at the boundary doesn't thrash the shared stack)
+		if (cache->count >= kMagazineSize * 2)
+		{
+			FREESLOT* first = cache->head;
+			FREESLOT* last = first;
+			for (int i = 1; i < kMagazineSize; i++)
+				last = last->chain;
+			cache->head = last->chain;
+			cache->count -= kMagazineSize;
+			last->chain = nullptr;
+			PushMagazine(first, kMagazineSize);
+		}
+	}
+
+	// Allocate and construct an object, growing the pool if needed.
+	// Returns nullptr if memory couldn't be allocated.
+	template <typename... TArgs>
+	T* New(TArgs&&... args)
+	{
+		void* p = Alloc();
+		if (!p)
+			return nullptr;
+		return new (p) T(std::forward<TArgs>(args)...);
+	}
+
+	// Destruct and free an object allocated with New()
+	void Delete(T* p)
+	{
+		if (!p)
+			return;
+		p->~T();
+		Free(p);
+	}
+
+	// Grow the pool until it has room for at least `count` objects in
+	// total and set up the calling thread's cache - call on a real-time
+	// thread before it starts so TryAlloc() (and Free) never allocate.
+	// Returns false if memory couldn't be allocated.
+	bool Prewarm(int count)
+	{
+		GetCache();
+		while (m_capacity.Get() < count)
+		{
+			FREESLOT* first;
+			FREESLOT* last;
+			if (!AllocSlab(first, last))
+				return false;
+
+			// Push the new slots to the shared stack a magazine at a time
+			while (first)
+			{
+				FREESLOT* magazine = first;
+				int n = 1;
+				FREESLOT* p = first;
+				while (n < kMagazineSize && p->chain)
+				{
+					p = p->chain;
+					n++;
+				}
+				first = p->chain;
+				p->chain = nullptr;
+				PushMagazine(magazine, n);
+			}
+		}
+		return true;
+	}
+
+	// Move all of the calling thread's cached slots back to the shared
+	// stack
+	void FlushThreadCache()
+	{
+		Flush(GetCache());
+	}
+
+	// Total number of slots (allocated or free)
+	int GetCapacity()
+	{
+		return m_capacity.Get();
+	}
+
+	// Size of each slot
+	static constexpr size_t GetSlotSize()
+	{
+		return kSlotSize;
+	}
+
+private:
+	// A free slot. `next` links magazines on the shared stack and `chain`
+	// links the slots within a magazine or a thread's cache. Popping from
+	// the shared stack may read `next` from a slot that another thread has
+	// just popped and started using - that's fine, the stack's tagged CAS
+	// then fails and the slab memory is never released while the pool
+	// exists.
+	struct FREESLOT
+	{
+		FREESLOT* next;
+		FREESLOT* chain;
+		int count;
+	};
+
+	struct SLAB
+	{
+		SLAB* next;
+	};
+
+	struct CACHE
+	{
+		CACHE()
+		{
+			pool = nullptr;
+			head = nullptr;
+			count = 0;
+			prevCache = nullptr;
+			nextCache = nullptr;
+		}
+		~CACHE()
+		{
+			// Thread's ending, return its slots
+			if (pool)
+			{
+				pool->Flush(this);
+				pool->UnregisterCache(this);
+			}
+		}
+		ObjectPool* pool;
+		FREESLOT* head;
+		int count;
+		CACHE* prevCache;           // Registry of all threads' caches
+		CACHE* nextCache;
+	};
+
+	static_assert(alignof(T) <= 16, "ObjectPool doesn't support over-aligned types");
+
+	static constexpr size_t kSlotAlignment = alignof(T) > alignof(FREESLOT) ? alignof(T) : alignof(FREESLOT);
+	static constexpr size_t kSlotSize = ((sizeof(T) > sizeof(FREESLOT) ? sizeof(T) : sizeof(FREESLOT)) + kSlotAlignment - 1) & ~(kSlotAlignment - 1);
+	static constexpr size_t kSlabHeaderSize = (sizeof(SLAB) + kSlotAlignment - 1) & ~(kSlotAlignment - 1);
+
+	CACHE* GetCache()
+	{
+		CACHE* cache = m_cache.Get();
+		if (!cache->pool)
+			RegisterCache(cache);
+		return cache;
+	}
+
+	// Add a thread's cache to the registry the first time the thread uses
+	// the pool (not real-time safe - see Prewarm)
+	void RegisterCache(CACHE* cache)
+	{
+		EnterMutex lock(m_cachesMutex);
+		cache->pool = this;
+		cache->prevCache = nullptr;
+		cache->nextCache = m_caches;
+		if (m_caches)
+			m_caches->prevCache = cache;
+		m_caches = cache;
+	}
+
+	void UnregisterCache(CACHE* cache)
+	{
+		EnterMutex lock(m_cachesMutex);
+		if (cache->prevCache)
+			cache->prevCache->nextCache = cache->nextCache;
+		else
+			m_caches = cache->nextCache;
+		if (cache->nextCache)
+			cache->nextCache->prevCache = cache->prevCache;
+	}
+
+	void* AllocInternal(bool grow)
+	{
+		CACHE* cache = GetCache();
+		if (!cache->head)
+		{
+			// Take a magazine from the shared stack
+			FREESLOT* magazine = m_magazines.Pop();
+			if (magazine)
+			{
+				cache->head = magazine;
+				cache->count = magazine->count;
+			}
+			else
+			{
+				// Carve a new slab straight into the cache
+				FREESLOT* last;
+				if (!grow || !AllocSlab(cache->head, last))
+					return nullptr;
+				cache->count = m_slabSize;
+			}
+		}
+
+		FREESLOT* slot = cache->head;
+		cache->head = slot->chain;
+		cache->count--;
+		return slot;
+	}
+
+	void PushMagazine(FREESLOT* first, int count)
+	{
+		first->count = count;
+		first->next = nullptr;
+		m_magazines.Push(first);
+	}
+
+	void Flush(CACHE* cache)
+	{
+		if (cache->head)
+			PushMagazine(cache->head, cache->count);
+		cache->head = nullptr;
+		cache->count = 0;
+	}
+
+	// Allocate a slab and chain its slots together
+	bool AllocSlab(FREESLOT*& first, FREESLOT*& last)
+	{
+		SLAB* slab = (SLAB*)malloc(kSlabHeaderSize + kSlotSize * m_slabSize);
+		if (!slab)
+			return false;
+		slab->next = nullptr;
+		m_slabs.Push(slab);
+		m_capacity.Add(m_slabSize);
+
+		char* slots = (char*)slab + kSlabHeaderSize;
+		for (int i = 0; i < m_slabSize; i++)
+		{
+			FREESLOT* slot = (FREESLOT*)(slots + i * kSlotSize);
+			slot->chain = i + 1 < m_slabSize ? (FREESLOT*)(slots + (i + 1) * kSlotSize) : nullptr;
+		}
+		first = (FREESLOT*)slots;
+		last = (FREESLOT*)(slots + (m_slabSize - 1) * kSlotSize);
+		return true;
+	}
+
+	MpmcStack<FREESLOT> m_magazines;
+	MpmcStack<SLAB> m_slabs;
+	ThreadLocal<CACHE> m_cache;
+	Mutex m_cachesMutex;
+	CACHE* m_caches = nullptr;
+	Atomic<int> m_capacity;
+	int m_slabSize;
+};
+
+}
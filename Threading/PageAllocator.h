@@ -0,0 +1,229 @@
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "../Core/Allocator.h"
+#include "../Platform/Platform.h"
+
+namespace SimpleLib
+{
+
+// How TPageAlloc backs its mapped blocks
+enum class HugePageMode
+{
+	None,			// Normal (4K) pages
+	Transparent,	// Normal mappings, hinted to use transparent huge pages (Linux)
+	Explicit,		// Reserved huge pages (MAP_HUGETLB, MEM_LARGE_PAGES) where
+					// available, otherwise as for Transparent
+};
+
+// Stateless allocator for large, growing buffers (eg: a List or Map
+// holding a multi-gigabyte dataset), eg:
+//
+//     List<Sample, TPageAlloc<HugePageMode::Transparent>> samples;
+//
+// Blocks of `threshold` bytes or more are mapped straight from the OS in
+// whole pages (or huge pages, to cut TLB misses) rather than coming from
+// the heap, and are unmapped as soon as they're freed. Growing a mapped
+// block remaps it (mremap on Linux) so the contents are never copied, no
+// matter how large the block. Windows can't remap, so there a growing
+// block is mapped afresh and copied, as realloc would.
+//
+// Smaller blocks come from TMalloc, so containers that never get large
+// don't waste a page each - a block moves to a mapping when it's resized
+// past the threshold (and stays mapped if it later shrinks).
+template <HugePageMode mode = HugePageMode::None, size_t threshold = 256 * 1024>
+class TPageAlloc
+{
+public:
+	static void* Alloc(size_t size)
+	{
+		if (size < threshold)
+			return AllocSmall(size);
+		return Map(size);
+	}
+
+	static void* ReAlloc(void* ptr, size_t size)
+	{
+		if (!ptr)
+			return Alloc(size);
+
+		HEADER* header = GetHeader(ptr);
+		if (header->mapped == 0)
+		{
+			// Heap block staying small
+			if (size < threshold)
+			{
+				header = (HEADER*)TMalloc::ReAlloc(header, kHeaderSize + size);
+				if (!header)
+					return nullptr;
+				header->size = size;
+				return header + 1;
+			}
+
+			// Heap block moving to a mapping
+			void* p = Map(size);
+			if (!p)
+				return nullptr;
+			memcpy(p, ptr, header->size);
+			TMalloc::Free(header);
+			return p;
+		}
+
+		// Mapped block, nothing to do if the page count doesn't change
+		size_t mapped = GetMappedSize(header);
+		size_t newMapped = RoundUp(kHeaderSize + size, IsHuge(header) ? Platform::vmHugePageSize() : Granularity());
+		if (newMapped == mapped)
+		{
+			header->size = size;
+			return ptr;
+		}
+
+		SIMPLELIB_REALTIME_CHECK(Alloc);
+
+		// Remap without copying
+		HEADER* remapped = (HEADER*)Platform::vmReAlloc(header, mapped, newMapped);
+		if (remapped)
+		{
+			if (mode != HugePageMode::None && !IsHuge(remapped) && newMapped > mapped)
+				Platform::vmAdviseHuge(remapped, newMapped);
+			remapped->size = size;
+			remapped->mapped = newMapped | (remapped->mapped & kHugeFlag);
+			return remapped + 1;
+		}
+
+		// Can't remap. Shrinking just keeps the larger mapping, growing
+		// maps a new block and copies.
+		if (newMapped < mapped)
+		{
+			header->size = size;
+			return ptr;
+		}
+
+		void* p = Map(size);
+		if (!p)
+			return nullptr;
+		memcpy(p, ptr, header->size);
+		Platform::vmFree(header, mapped);
+		return p;
+	}
+
+	static void Free(void* ptr)
+	{
+		if (!ptr)
+			return;
+
+		HEADER* header = GetHeader(ptr);
+		if (header->mapped == 0)
+		{
+			TMalloc::Free(header);
+			return;
+		}
+
+		SIMPLELIB_REALTIME_CHECK(Free);
+		Platform::vmFree(header, GetMappedSize(header));
+	}
+
+	// Check if a block is mapped from the OS (rather than the heap)
+	static bool IsMapped(void* ptr)
+	{
+		return GetHeader(ptr)->mapped != 0;
+	}
+
+	// Check if a block is backed by reserved huge pages
+	static bool IsHugePages(void* ptr)
+	{
+		return IsHuge(GetHeader(ptr));
+	}
+
+	// Get the size of the mapping holding a block (0 for heap blocks)
+	static size_t GetMappedSize(void* ptr)
+	{
+		return GetMappedSize(GetHeader(ptr));
+	}
+
+private:
+	struct HEADER
+	{
+		size_t size;		// Requested size
+		size_t mapped;		// Size of the mapping (0 for heap blocks) | kHugeFlag
+	};
+
+	// Mapped sizes are whole pages, leaving the low bit free for a flag
+	static const size_t kHugeFlag = 1;
+
+	// Header size keeps allocations 16 byte aligned
+	static constexpr size_t kHeaderSize = 16;
+	static_assert(sizeof(HEADER) <= kHeaderSize, "Header too big");
+
+	static HEADER* GetHeader(void* ptr)
+	{
+		return (HEADER*)((char*)ptr - kHeaderSize);
+	}
+
+	static size_t GetMappedSize(HEADER* header)
+	{
+		return header->mapped & ~kHugeFlag;
+	}
+
+	static bool IsHuge(HEADER* header)
+	{
+		return (header->mapped & kHugeFlag) != 0;
+	}
+
+	static size_t RoundUp(size_t size, size_t granularity)
+	{
+		return (size + granularity - 1) / granularity * granularity;
+	}
+
+	// Mapping granularity for normal pages - huge page multiples when
+	// asking for transparent huge pages so the ends of the mapping can be
+	// huge pages too
+	static size_t Granularity()
+	{
+		return mode == HugePageMode::None ? Platform::vmPageSize() : Platform::vmHugePageSize();
+	}
+
+	static void* AllocSmall(size_t size)
+	{
+		HEADER* header = (HEADER*)TMalloc::Alloc(kHeaderSize + size);
+		if (!header)
+			return nullptr;
+		header->size = size;
+		header->mapped = 0;
+		return (char*)header + kHeaderSize;
+	}
+
+	static void* Map(size_t size)
+	{
+		SIMPLELIB_REALTIME_CHECK(Alloc);
+
+		HEADER* header = nullptr;
+		size_t mapped = 0;
+		if (mode == HugePageMode::Explicit)
+		{
+			mapped = RoundUp(kHeaderSize + size, Platform::vmHugePageSize());
+			header = (HEADER*)Platform::vmAllocHuge(mapped);
+			if (header)
+				mapped |= kHugeFlag;
+		}
+
+		if (!header)
+		{
+			mapped = RoundUp(kHeaderSize + size, Granularity());
+			header = (HEADER*)Platform::vmAlloc(mapped);
+			if (!header)
+				return nullptr;
+			if (mode != HugePageMode::None)
+				Platform::vmAdviseHuge(header, mapped);
+		}
+
+		header->size = size;
+		header->mapped = mapped;
+		return (char*)header + kHeaderSize;
+	}
+};
+
+}
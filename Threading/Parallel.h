@@ -0,0 +1,637 @@
+#pragma once
+
+#include "../Core/Sorting.h"
+#include "../Core/List.h"
+#include "../Core/Compare.h"
+#include "WorkerSet.h"
+
+namespace SimpleLib
+{
+
+// Parallel versions of the core algorithms, spreading the work over a
+// WorkerSet (by default the shared WorkerSet::Default()).
+//
+// Everything here falls back to the serial algorithm for inputs too small
+// to be worth splitting up, and (through WorkerSet::Run) when called from
+// inside another parallel job.
+//
+// For/ForEach/Map/Filter/Reduce size their chunks from the measured cost of
+// the items: the calling thread first processes a handful of items on its
+// own, doubling the batch size until it's spent about kProbeMicroseconds,
+// which gives a per item cost estimate. If what's left would take less
+// than one chunk's worth of time (kChunkMicroseconds) it's finished off
+// serially - so small or cheap inputs never touch the worker threads -
+// otherwise the rest is split into chunks of about kChunkMicroseconds each
+// (but at least kChunksPerThread chunks per thread, so uneven item costs
+// still balance) which the workers pick up dynamically.
+//
+// Callbacks run concurrently on several threads, so must be safe to call
+// that way. The order in which items are visited is unspecified, but
+// Map/Filter/Reduce results are always in list order.
+class Parallel
+{
+public:
+	// Invoke fn(index) for each index in [0, count)
+	template <typename TFn>
+	static void For(int count, TFn fn, WorkerSet& workers = WorkerSet::Default())
+	{
+		ForRanges(count, [&](int, int begin, int end) {
+			for (int i = begin; i < end; i++)
+				fn(i);
+		}, nullptr, workers);
+	}
+
+	// Invoke fn(TArg) for each element of a list
+	template <typename T, typename TAllocator, typename TFn>
+	static void ForEach(const List<T, TAllocator>& list, TFn fn, WorkerSet& workers = WorkerSet::Default())
+	{
+		typedef typename get_semantics<T>::TSemantics::TArg TArg;
+		auto data = list.GetBuffer();
+		ForRanges(list.GetCount(), [&](int, int begin, int end) {
+			for (int i = begin; i < end; i++)
+				fn(static_cast<TArg>(data[i]));
+		}, nullptr, workers);
+	}
+
+	// Parallel List::Map - transform each element to a new list (of the
+	// type fn returns). The result is presized and each element is
+	// constructed in place by whichever thread maps it. Returns an empty
+	// list if the result couldn't be allocated.
+	template <typename T, typename TAllocator, typename TFn>
+	static auto Map(const List<T, TAllocator>& list, TFn fn, WorkerSet& workers = WorkerSet::Default())
+	{
+		typedef typename get_semantics<T>::TSemantics::TArg TArg;
+		typedef typename std::decay<decltype(fn(std::declval<TArg>()))>::type TResult;
+
+		List<TResult> result;
+		auto out = result.AddUninitialized(list.GetCount());
+		if (!out)
+			return result;
+
+		auto data = list.GetBuffer();
+		ForRanges(list.GetCount(), [&](int, int begin, int end) {
+			for (int i = begin; i < end; i++)
+				Constructor(out + i, fn(static_cast<TArg>(data[i])));
+		}, nullptr, workers);
+		return result;
+	}
+
+	// Parallel List::Filter - a new list of the elements (copied) for which
+	// predicate(TArg) returns true, in their original order.
+	//
+	// The predicate is evaluated in parallel into a flag per element. The
+	// flags are then counted per block in parallel, an exclusive prefix
+	// sum of the block counts gives each block its offset in the output,
+	// the output is presized to the total and the blocks copy their kept
+	// elements into place in parallel. Returns an empty list if memory
+	// couldn't be allocated.
+	template <typename T, typename TAllocator, typename TPredicate>
+	static List<T, TAllocator> Filter(const List<T, TAllocator>& list, TPredicate predicate, WorkerSet& workers = WorkerSet::Default())
+	{
+		typedef typename get_semantics<T>::TSemantics::TArg TArg;
+
+		List<T, TAllocator> result(list.GetAllocator());
+		int count = list.GetCount();
+		if (count == 0)
+			return result;
+
+		auto allocator = list.GetAllocator();
+		uint8_t* flags = (uint8_t*)allocator.Alloc(count);
+		if (!flags)
+			return result;
+
+		auto data = list.GetBuffer();
+		ForRanges(count, [&](int, int begin, int end) {
+			for (int i = begin; i < end; i++)
+				flags[i] = predicate(static_cast<TArg>(data[i])) ? 1 : 0;
+		}, nullptr, workers);
+
+		// Count kept elements per block (compacting is cheap and uniform,
+		// so fixed size blocks are fine here)
+		int blocks = BlockCount(count, kMinBlockSize, workers);
+		int blockSize = (count + blocks - 1) / blocks;
+		List<int> offsets;
+		offsets.SetCount(blocks + 1, 0);
+		int* blockOffsets = offsets.GetBuffer();
+		workers.Run(blocks, [&](int block) {
+			int kept = 0;
+			int end = ChunkEnd(block, blockSize, count);
+			for (int i = block * blockSize; i < end; i++)
+				kept += flags[i];
+			blockOffsets[block + 1] = kept;
+		});
+
+		// Exclusive prefix sum
+		for (int block = 0; block < blocks; block++)
+			blockOffsets[block + 1] += blockOffsets[block];
+
+		auto out = result.AddUninitialized(blockOffsets[blocks]);
+		if (out || blockOffsets[blocks] == 0)
+		{
+			workers.Run(blocks, [&](int block) {
+				auto dest = out + blockOffsets[block];
+				int end = ChunkEnd(block, blockSize, count);
+				for (int i = block * blockSize; i < end; i++)
+				{
+					if (flags[i])
+						Constructor(dest++, data[i]);
+				}
+			});
+		}
+
+		allocator.Free(flags);
+		return result;
+	}
+
+	// Reduce a list to a single value: each chunk folds its elements into
+	// its own accumulator (starting from identity) with
+	// accumulate(TResult, TArg) and the chunk results are then folded
+	// together, in list order, with combine(TResult, TResult). combine must
+	// be associative and identity must be its identity value, but neither
+	// needs to be commutative.
+	template <typename T, typename TAllocator, typename TResult, typename TAccumulate, typename TCombine>
+	static TResult Reduce(const List<T, TAllocator>& list, TResult identity, TAccumulate accumulate, TCombine combine, WorkerSet& workers = WorkerSet::Default())
+	{
+		typedef typename get_semantics<T>::TSemantics::TArg TArg;
+
+		// One partial result per chunk, allocated once the chunk count is
+		// known. The probe (chunk 0) can arrive in several consecutive
+		// pieces, so chunks accumulate onto their partial rather than
+		// replacing it.
+		TResult probe = identity;
+		List<TResult> partials;
+		auto data = list.GetBuffer();
+		ForRanges(list.GetCount(), [&](int chunk, int begin, int end) {
+			TResult acc = chunk == 0 ? probe : identity;
+			for (int i = begin; i < end; i++)
+				acc = accumulate(acc, static_cast<TArg>(data[i]));
+			if (chunk == 0)
+				probe = acc;
+			else
+				partials.GetRefAt(chunk) = acc;
+		}, [&](int chunks) {
+			partials.SetCount(chunks, identity);
+		}, workers);
+
+		TResult result = probe;
+		for (int i = 1; i < partials.GetCount(); i++)
+			result = combine(result, partials[i]);
+		return result;
+	}
+
+	// Reduce where the elements and result are the same type and one
+	// operation (eg: addition) serves for both
+	template <typename T, typename TAllocator, typename TOp>
+	static T Reduce(const List<T, TAllocator>& list, T identity, TOp op, WorkerSet& workers = WorkerSet::Default())
+	{
+		return Reduce(list, identity, op, op, workers);
+	}
+
+	// Parallel merge sort of a raw array, `less(const T&, const T&)`.
+	//
+	// The data is split into one chunk per thread and the chunks are
+	// sorted concurrently (with Sorting::Sort, or Sorting::StableSort if
+	// `stable`). Pairs of sorted runs are then merged, ping-ponging with a
+	// scratch buffer, until one run is left. So the last few rounds (with
+	// fewer pairs than threads) still use every thread, each merge is split
+	// into equal slices of its output and each slice's starting point in
+	// the two inputs is found by a binary search along the merge path.
+	// Merges take ties from the left run, so the result is stable if the
+	// chunk sorts are. Returns false (with the data intact) if the scratch
+	// buffer (from `allocator`, only ever called on this thread) couldn't
+	// be allocated.
+	template <typename TAllocator = TMalloc, typename T, typename TLess>
+	static bool Sort(T* data, int count, TLess less, bool stable = false, WorkerSet& workers = WorkerSet::Default(), TAllocator allocator = TAllocator())
+	{
+		int chunks = workers.GetConcurrency();
+		if (chunks > count / kMinSortChunkSize)
+			chunks = count / kMinSortChunkSize;
+		if (chunks < 2)
+		{
+			if (stable)
+				return Sorting::StableSort(data, count, less, allocator);
+			Sorting::Sort(data, count, less);
+			return true;
+		}
+
+		T* scratch = (T*)allocator.Alloc(count * sizeof(T));
+		if (!scratch)
+			return false;
+
+		// Run boundaries - run i is [bounds[i], bounds[i + 1])
+		List<int> bounds;
+		int chunkSize = (count + chunks - 1) / chunks;
+		for (int i = 0; i < chunks; i++)
+			bounds.Add(i * chunkSize);
+		bounds.Add(count);
+
+		// Sort the chunks (stable sorts use the matching slice of the
+		// scratch buffer, so the allocator's only ever used on this thread)
+		workers.Run(chunks, [&](int chunk) {
+			T* begin = data + bounds[chunk];
+			int n = bounds[chunk + 1] - bounds[chunk];
+			if (stable)
+				Sorting::StableSort(begin, n, less, scratch + bounds[chunk]);
+			else
+				Sorting::Sort(begin, n, less);
+		});
+
+		// Merge pairs of runs until there's only one
+		T* src = data;
+		T* dst = scratch;
+		int threads = workers.GetConcurrency();
+		while (bounds.GetCount() > 2)
+		{
+			int runs = bounds.GetCount() - 1;
+			int pairs = (runs + 1) / 2;
+			int slices = threads / pairs > 1 ? threads / pairs : 1;
+
+			workers.Run(pairs * slices, [&](int task) {
+				int pair = task / slices;
+				int slice = task % slices;
+				int lo = bounds[pair * 2];
+				int mid = pair * 2 + 1 < runs ? bounds[pair * 2 + 1] : bounds[runs];
+				int hi = pair * 2 + 2 <= runs ? bounds[pair * 2 + 2] : bounds[runs];
+
+				// This slice's share of the output
+				int total = hi - lo;
+				int k0 = (int)((int64_t)total * slice / slices);
+				int k1 = (int)((int64_t)total * (slice + 1) / slices);
+
+				T* a = src + lo;
+				T* b = src + mid;
+				int na = mid - lo;
+				int nb = hi - mid;
+				int i0 = MergePathSplit(a, na, b, nb, k0, less);
+				int i1 = MergePathSplit(a, na, b, nb, k1, less);
+				MergeRange(a + i0, a + i1, b + (k0 - i0), b + (k1 - i1), dst + lo + k0, less);
+			});
+
+			// Every other boundary goes
+			List<int> merged;
+			for (int i = 0; i < bounds.GetCount(); i += 2)
+				merged.Add(bounds[i]);
+			if (merged[merged.GetCount() - 1] != count)
+				merged.Add(count);
+			bounds = SimpleLib::move(merged);
+
+			T* temp = src;
+			src = dst;
+			dst = temp;
+		}
+
+		// Make sure the final result ends up back in the caller's buffer
+		if (src != data)
+			memcpy((void*)data, (const void*)src, count * sizeof(T));
+
+		allocator.Free(scratch);
+		return true;
+	}
+
+	// Parallel List::Sort(compare), with the same compare convention
+	template <typename T, typename TAllocator, typename TCompare>
+	static bool Sort(List<T, TAllocator>& list, TCompare compare, WorkerSet& workers = WorkerSet::Default())
+	{
+		return SortList(list, compare, false, workers);
+	}
+
+	// Parallel List::Sort()
+	template <typename T, typename TAllocator>
+	static bool Sort(List<T, TAllocator>& list, WorkerSet& workers = WorkerSet::Default())
+	{
+		return SortList(list, nullptr, false, workers);
+	}
+
+	// Parallel List::StableSort(compare)
+	template <typename T, typename TAllocator, typename TCompare>
+	static bool StableSort(List<T, TAllocator>& list, TCompare compare, WorkerSet& workers = WorkerSet::Default())
+	{
+		return SortList(list, compare, true, workers);
+	}
+
+	// Parallel List::StableSort()
+	template <typename T, typename TAllocator>
+	static bool StableSort(List<T, TAllocator>& list, WorkerSet& workers = WorkerSet::Default())
+	{
+		return SortList(list, nullptr, true, workers);
+	}
+
+	// Parallel version of Sorting::RadixSort - same key requirements,
+	// stability and result.
+	//
+	// The data is split into one contiguous chunk per thread. Each digit
+	// pass histograms the chunks in parallel, a prefix sum over
+	// (digit, chunk) gives every chunk its own output offsets for every
+	// digit, and the chunks then scatter in parallel without any
+	// synchronization - chunk i's elements with a given digit land
+	// immediately after chunk i-1's, so the sort stays stable.
+	template <typename TAllocator = TMalloc, typename T, typename TKeyFn>
+	static bool RadixSort(T* data, int count, TKeyFn key, WorkerSet& workers = WorkerSet::Default(), TAllocator allocator = TAllocator())
+	{
+		typedef Sorting::RadixKey<typename std::decay<decltype(key(*data))>::type> TRadix;
+		typedef typename TRadix::TBits TBits;
+		const int passes = (int)sizeof(TBits);
+
+		// Work out how many chunks, falling back to the serial sort if
+		// there's not enough data to be worth it
+		int chunks = workers.GetConcurrency();
+		if (chunks > count / kMinRadixChunkSize)
+			chunks = count / kMinRadixChunkSize;
+		if (chunks < 2)
+			return Sorting::RadixSort(data, count, key, allocator);
+		int chunkSize = (count + chunks - 1) / chunks;
+
+		// Per chunk, per pass digit counts
+		int* counts = (int*)allocator.Alloc(chunks * passes * 256 * sizeof(int));
+		if (!counts)
+			return false;
+		auto chunkCounts = [&](int chunk, int pass) {
+			return counts + (chunk * passes + pass) * 256;
+		};
+
+		// Histogram every digit of every chunk
+		workers.Run(chunks, [&](int chunk) {
+			int* c = chunkCounts(chunk, 0);
+			memset(c, 0, passes * 256 * sizeof(int));
+			int end = ChunkEnd(chunk, chunkSize, count);
+			for (int i = chunk * chunkSize; i < end; i++)
+			{
+				TBits bits = TRadix::ToBits(key(data[i]));
+				for (int pass = 0; pass < passes; pass++)
+					c[pass * 256 + TRadix::Digit(bits, pass)]++;
+			}
+		});
+
+		// Work out which digits actually vary
+		TBits first = TRadix::ToBits(key(data[0]));
+		bool anyPass = false;
+		bool skip[sizeof(TBits)];
+		for (int pass = 0; pass < passes; pass++)
+		{
+			int digit = TRadix::Digit(first, pass);
+			int total = 0;
+			for (int chunk = 0; chunk < chunks; chunk++)
+				total += chunkCounts(chunk, pass)[digit];
+			skip[pass] = total == count;
+			if (!skip[pass])
+				anyPass = true;
+		}
+
+		if (!anyPass)
+		{
+			allocator.Free(counts);
+			return true;
+		}
+
+		T* scratch = (T*)allocator.Alloc(count * sizeof(T));
+		if (!scratch)
+		{
+			allocator.Free(counts);
+			return false;
+		}
+
+		T* src = data;
+		T* dst = scratch;
+		bool scattered = false;
+		for (int pass = 0; pass < passes; pass++)
+		{
+			if (skip[pass])
+				continue;
+
+			// Once the data's been scattered the chunks hold different
+			// elements, so the up-front counts no longer apply
+			if (scattered)
+			{
+				workers.Run(chunks, [&](int chunk) {
+					int* c = chunkCounts(chunk, pass);
+					memset(c, 0, 256 * sizeof(int));
+					int end = ChunkEnd(chunk, chunkSize, count);
+					for (int i = chunk * chunkSize; i < end; i++)
+						c[TRadix::Digit(TRadix::ToBits(key(src[i])), pass)]++;
+				});
+			}
+
+			// Counts to starting offsets, digit major then chunk
+			int total = 0;
+			for (int digit = 0; digit < 256; digit++)
+			{
+				for (int chunk = 0; chunk < chunks; chunk++)
+				{
+					int* c = chunkCounts(chunk, pass);
+					int n = c[digit];
+					c[digit] = total;
+					total += n;
+				}
+			}
+
+			// Scatter
+			workers.Run(chunks, [&](int chunk) {
+				int* offsets = chunkCounts(chunk, pass);
+				int end = ChunkEnd(chunk, chunkSize, count);
+				for (int i = chunk * chunkSize; i < end; i++)
+				{
+					int digit = TRadix::Digit(TRadix::ToBits(key(src[i])), pass);
+					memcpy((void*)(dst + offsets[digit]++), (const void*)(src + i), sizeof(T));
+				}
+			});
+
+			T* temp = src;
+			src = dst;
+			dst = temp;
+			scattered = true;
+		}
+
+		// Make sure the final result ends up back in the caller's buffer
+		if (src != data)
+			memcpy((void*)data, (const void*)src, count * sizeof(T));
+
+		allocator.Free(scratch);
+		allocator.Free(counts);
+		return true;
+	}
+
+	// Parallel List::RadixSort(key)
+	template <typename T, typename TAllocator, typename TKeyFn>
+	static bool RadixSort(List<T, TAllocator>& list, TKeyFn key, WorkerSet& workers = WorkerSet::Default())
+	{
+		typedef typename get_semantics<T>::TSemantics::TArg TArg;
+		typedef typename get_semantics<T>::TSemantics::TStorage TStorage;
+		return RadixSort(list.GetBuffer(), list.GetCount(), [&](const TStorage& a) {
+			return key(static_cast<const TArg&>(a));
+		}, workers, list.GetAllocator());
+	}
+
+	// Parallel List::RadixSort()
+	template <typename T, typename TAllocator>
+	static bool RadixSort(List<T, TAllocator>& list, WorkerSet& workers = WorkerSet::Default())
+	{
+		typedef typename get_semantics<T>::TSemantics::TArg TArg;
+		return RadixSort(list, [](const TArg& a) { return a; }, workers);
+	}
+
+	// Minimum number of elements per chunk in RadixSort (smaller inputs
+	// use fewer threads, or the serial sort)
+	static const int kMinRadixChunkSize = 65536;
+
+	// Minimum number of elements per chunk in Sort/StableSort
+	static const int kMinSortChunkSize = 16384;
+
+	// Approximate time spent timing items before choosing a chunk size,
+	// and the approximate time each chunk should take
+	static const int kProbeMicroseconds = 20;
+	static const int kChunkMicroseconds = 100;
+
+	// Minimum number of chunks per thread (for load balancing)
+	static const int kChunksPerThread = 4;
+
+	// Minimum elements per block for Filter's compaction
+	static const int kMinBlockSize = 16384;
+
+private:
+	// Run body(chunk, begin, end) over consecutive ranges covering
+	// [0, count), sizing the chunks as described above. Chunk 0 is the
+	// probe: it runs on the calling thread, possibly as several calls
+	// (for consecutive ranges, in order) as the batch size doubles. If
+	// supplied, prepare(chunkCount) is called on the calling thread once
+	// the total number of chunks (including chunk 0) is known, after the
+	// probe and before any other chunk runs.
+	template <typename TBody, typename TPrepare>
+	static void ForRanges(int count, TBody body, TPrepare prepare, WorkerSet& workers)
+	{
+		if (count <= 0)
+		{
+			CallPrepare(prepare, 0);
+			return;
+		}
+
+		// No workers, nothing to measure
+		if (workers.GetWorkerCount() == 0)
+		{
+			body(0, 0, count);
+			CallPrepare(prepare, 1);
+			return;
+		}
+
+		// Run batches of doubling size until enough time has elapsed for a
+		// reasonable cost estimate (or everything's done)
+		uint64_t frequency = Platform::clockFrequency();
+		uint64_t probeTicks = frequency * kProbeMicroseconds / 1000000;
+		uint64_t chunkTicks = frequency * kChunkMicroseconds / 1000000;
+		uint64_t start = Platform::clockTicks();
+		uint64_t elapsed = 0;
+		int probed = 0;
+		int batch = 1;
+		while (probed < count && elapsed < probeTicks)
+		{
+			int end = count - probed > batch ? probed + batch : count;
+			body(0, probed, end);
+			probed = end;
+			batch *= 2;
+			elapsed = Platform::clockTicks() - start;
+		}
+
+		// Finish off serially if the rest isn't worth a chunk
+		int remaining = count - probed;
+		double ticksPerItem = (double)elapsed / probed;
+		if (remaining == 0 || ticksPerItem * remaining < (double)chunkTicks)
+		{
+			if (remaining > 0)
+				body(0, probed, count);
+			CallPrepare(prepare, 1);
+			return;
+		}
+
+		// Size the chunks
+		double idealSize = ticksPerItem > 0 ? (double)chunkTicks / ticksPerItem : (double)remaining;
+		int chunkSize = idealSize < (double)remaining ? (int)idealSize : remaining;
+		int balancedSize = remaining / (workers.GetConcurrency() * kChunksPerThread);
+		if (chunkSize > balancedSize)
+			chunkSize = balancedSize;
+		if (chunkSize < 1)
+			chunkSize = 1;
+		int chunks = (remaining + chunkSize - 1) / chunkSize;
+
+		CallPrepare(prepare, chunks + 1);
+		workers.Run(chunks, [&](int chunk) {
+			int begin = probed + chunk * chunkSize;
+			int end = remaining - chunk * chunkSize > chunkSize ? begin + chunkSize : count;
+			body(chunk + 1, begin, end);
+		});
+	}
+
+	template <typename TPrepare>
+	static void CallPrepare(TPrepare& prepare, int chunks)
+	{
+		if constexpr (!std::is_same<TPrepare, std::nullptr_t>::value)
+			prepare(chunks);
+	}
+
+	// Number of fixed size blocks to split `count` uniform cost items into
+	static int BlockCount(int count, int minBlockSize, WorkerSet& workers)
+	{
+		int blocks = workers.GetConcurrency() * kChunksPerThread;
+		if (blocks > count / minBlockSize)
+			blocks = count / minBlockSize;
+		return blocks < 1 ? 1 : blocks;
+	}
+
+	// Number of elements of `a` among the first k elements of the stable
+	// merge of a and b (ties taken from a)
+	template <typename T, typename TLess>
+	static int MergePathSplit(const T* a, int na, const T* b, int nb, int k, TLess& less)
+	{
+		int lo = k - nb > 0 ? k - nb : 0;
+		int hi = k < na ? k : na;
+		while (lo < hi)
+		{
+			int mid = lo + (hi - lo) / 2;
+			if (less(b[k - mid - 1], a[mid]))
+				hi = mid;
+			else
+				lo = mid + 1;
+		}
+		return lo;
+	}
+
+	// Merge [a, aEnd) and [b, bEnd) into dest, ties from a
+	template <typename T, typename TLess>
+	static void MergeRange(const T* a, const T* aEnd, const T* b, const T* bEnd, T* dest, TLess& less)
+	{
+		while (a < aEnd && b < bEnd)
+		{
+			if (less(*b, *a))
+				memcpy((void*)dest++, (const void*)b++, sizeof(T));
+			else
+				memcpy((void*)dest++, (const void*)a++, sizeof(T));
+		}
+		if (a < aEnd)
+			memcpy((void*)dest, (const void*)a, (aEnd - a) * sizeof(T));
+		if (b < bEnd)
+			memcpy((void*)dest, (const void*)b, (bEnd - b) * sizeof(T));
+	}
+
+	// List Sort/StableSort, compare is either an int returning comparer or
+	// nullptr for the default
+	template <typename T, typename TAllocator, typename TCompare>
+	static bool SortList(List<T, TAllocator>& list, TCompare compare, bool stable, WorkerSet& workers)
+	{
+		typedef typename get_semantics<T>::TSemantics::TArg TArg;
+		typedef typename get_semantics<T>::TSemantics::TStorage TStorage;
+		return Sort(list.GetBuffer(), list.GetCount(), [&](const TStorage& a, const TStorage& b) {
+			if constexpr (!std::is_same<TCompare, std::nullptr_t>::value)
+				return compare(static_cast<const TArg&>(a), static_cast<const TArg&>(b)) < 0;
+			else if constexpr (std::is_arithmetic<TStorage>::value || std::is_pointer<TStorage>::value)
+				return a < b;
+			else
+				return SDefaultCompare::Compare(static_cast<const TArg&>(a), static_cast<const TArg&>(b)) < 0;
+		}, stable, workers, list.GetAllocator());
+	}
+
+	static int ChunkEnd(int chunk, int chunkSize, int count)
+	{
+		int end = (chunk + 1) * chunkSize;
+		return end < count ? end : count;
+	}
+};
+
+}
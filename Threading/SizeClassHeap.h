@@ -0,0 +1,440 @@
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+#include "../Core/Bit.h"
+#include "../Platform/Platform.h"
+#include "MpmcStack.h"
+#include "ThreadLocal.h"
+
+namespace SimpleLib
+{
+
+// Thread caching small object heap.
+//
+// Requests of up to kMaxSmallSize bytes are rounded up to one of 32 size
+// classes (16 byte steps up to 128 bytes, then four classes per power of
+// two, so at most 25% is lost to rounding) and served from slabs of
+// kSlabSize bytes that each hold just one class. Larger requests are
+// mapped straight from the OS, in whole pages.
+//
+// Every thread has its own cache of free blocks per class, so most Alloc
+// and Free calls are a pointer swap on thread local data. Blocks move
+// between the thread caches and a shared lock free stack per class
+// (an MpmcStack) a batch at a time - a thread that runs dry takes a batch
+// with one CAS, a thread that frees more than it allocates (eg: the
+// consumer in a producer/consumer pair) hands batches back for the
+// producer to pick up. So cross-thread frees need no special handling and
+// never block.
+//
+// Slabs are aligned to kSlabSize so Free finds a block's size class from
+// the slab header just by masking the pointer. Large blocks start on a
+// kSlabSize boundary too, so the same test recognises them, but only the
+// pages they use are mapped - the rest of the aligned range is left free.
+// Slabs are retained and reused (by any thread, and for any future
+// allocation of the same class) rather than returned to the system - the
+// heap sizes itself to the peak number of live blocks per class.
+//
+// A thread's cached blocks are returned to the shared stacks when the
+// thread ends (SimpleLib Threads only - other threads should call
+// FlushThreadCache() before they exit). The heap must outlive all threads
+// that use it - the Default() instance is never destroyed.
+//
+// SizeClassHeap can be used directly as a (stateful) container allocator
+// via SizeClassAllocator, or through the stateless TSizeClassAlloc which
+// uses the Default() heap.
+class SizeClassHeap
+{
+public:
+	// Largest size served from the size classes
+	static const size_t kMaxSmallSize = 8192;
+
+	// Size of (and alignment of) each slab
+	static const size_t kSlabSize = 65536;
+
+	// Number of size classes
+	static const int kClassCount = 32;
+
+	// Constructor
+	SizeClassHeap()
+	{
+	}
+
+	// Destructor
+	virtual ~SizeClassHeap()
+	{
+		// Discard the calling thread's cache (other threads' caches must
+		// have already been flushed, see above)
+		CACHE* cache = m_cache.Get();
+		cache->heap = nullptr;
+		delete cache;
+		m_cache.Set(nullptr);
+
+		SLAB* slab = m_slabs.PopAll();
+		while (slab)
+		{
+			SLAB* next = slab->next;
+			FreeAligned(slab);
+			slab = next;
+		}
+	}
+
+	// No copy
+	SizeClassHeap(const SizeClassHeap&) = delete;
+	SizeClassHeap& operator=(const SizeClassHeap&) = delete;
+
+	// The shared, process wide heap
+	static SizeClassHeap& Default()
+	{
+		// Deliberately leaked - threads may still be freeing into it
+		// during process shutdown
+		static SizeClassHeap* heap = new SizeClassHeap();
+		return *heap;
+	}
+
+	// Allocate memory (16 byte aligned). Returns nullptr on failure.
+	void* Alloc(size_t size)
+	{
+		if (size > kMaxSmallSize)
+			return AllocLarge(size);
+
+		int sizeClass = SizeToClass(size);
+		CACHE* cache = GetCache();
+		FREEBLOCK* block = cache->head[sizeClass];
+		if (!block)
+		{
+			block = Refill(cache, sizeClass);
+			if (!block)
+				return nullptr;
+		}
+		cache->head[sizeClass] = block->chain;
+		cache->count[sizeClass]--;
+		return block;
+	}
+
+	// Free memory allocated by this heap (from any thread)
+	void Free(void* ptr)
+	{
+		if (!ptr)
+			return;
+
+		SLAB* slab = GetSlab(ptr);
+		if (slab->sizeClass < 0)
+		{
+			Platform::vmFree(slab, kHeaderSize + slab->largeSize);
+			return;
+		}
+
+		int sizeClass = slab->sizeClass;
+		CACHE* cache = GetCache();
+		FREEBLOCK* block = (FREEBLOCK*)ptr;
+		block->chain = cache->head[sizeClass];
+		cache->head[sizeClass] = block;
+
+		// Hand a batch back if the cache has grown beyond two batches
+		int batch = BatchSize(sizeClass);
+		if (++cache->count[sizeClass] >= batch * 2)
+		{
+			FREEBLOCK* first = cache->head[sizeClass];
+			FREEBLOCK* last = first;
+			for (int i = 1; i < batch; i++)
+				last = last->chain;
+			cache->head[sizeClass] = last->chain;
+			cache->count[sizeClass] -= batch;
+			last->chain = nullptr;
+			PushBatch(sizeClass, first);
+		}
+	}
+
+	// Resize an allocation, keeping it in place if it stays in the same
+	// size class
+	void* ReAlloc(void* ptr, size_t size)
+	{
+		if (!ptr)
+			return Alloc(size);
+
+		size_t oldSize = GetSize(ptr);
+		if (size <= oldSize && (size > kMaxSmallSize || SizeToClass(size) == GetSlab(ptr)->sizeClass))
+			return ptr;
+
+		void* p = Alloc(size);
+		if (p)
+		{
+			memcpy(p, ptr, oldSize < size ? oldSize : size);
+			Free(ptr);
+		}
+		return p;
+	}
+
+	// Get the usable size of an allocation
+	size_t GetSize(void* ptr)
+	{
+		SLAB* slab = GetSlab(ptr);
+		if (slab->sizeClass < 0)
+			return slab->largeSize;
+		return ClassToSize(slab->sizeClass);
+	}
+
+	// Move all of the calling thread's cached blocks back to the shared
+	// stacks
+	void FlushThreadCache()
+	{
+		Flush(GetCache());
+	}
+
+	// Number of slabs allocated (for all size classes)
+	int GetSlabCount()
+	{
+		return m_slabCount.Get();
+	}
+
+	// Map a size (1..kMaxSmallSize) to its size class
+	static int SizeToClass(size_t size)
+	{
+		if (size <= 128)
+			return size == 0 ? 0 : (int)((size - 1) >> 4);
+
+		// Four classes per power of two
+		uint32_t n = (uint32_t)(size - 1);
+		int bit = Bit::HighestBit(n);
+		return 8 + (bit - 7) * 4 + (int)(n >> (bit - 2)) - 4;
+	}
+
+	// Size of the blocks in a size class
+	static size_t ClassToSize(int sizeClass)
+	{
+		if (sizeClass < 8)
+			return (size_t)(sizeClass + 1) << 4;
+		int bit = 7 + (sizeClass - 8) / 4;
+		return ((size_t)1 << bit) + (size_t)((sizeClass - 8) % 4 + 1) * ((size_t)1 << (bit - 2));
+	}
+
+private:
+	// A free block. `next` links batches on the shared stacks and `chain`
+	// links the blocks within a batch or a thread's cache (see ObjectPool
+	// for why reading `next` from a block that's just been handed out is
+	// safe). Has to fit in the smallest (16 byte) class, so there's no
+	// room for a batch count - batches are counted when they're taken.
+	struct FREEBLOCK
+	{
+		FREEBLOCK* next;
+		FREEBLOCK* chain;
+	};
+
+	// Header at the start of every slab (and large block)
+	struct SLAB
+	{
+		SLAB* next;
+		int sizeClass;			// -1 for large blocks
+		size_t largeSize;
+	};
+	static const size_t kHeaderSize = 64;
+
+	struct CACHE
+	{
+		CACHE()
+		{
+			heap = nullptr;
+			memset(head, 0, sizeof(head));
+			memset(count, 0, sizeof(count));
+		}
+		~CACHE()
+		{
+			// Thread's ending, return its blocks
+			if (heap)
+				heap->Flush(this);
+		}
+		SizeClassHeap* heap;
+		FREEBLOCK* head[kClassCount];
+		int count[kClassCount];
+	};
+
+	static SLAB* GetSlab(void* ptr)
+	{
+		return (SLAB*)((uintptr_t)ptr & ~(uintptr_t)(kSlabSize - 1));
+	}
+
+	// Number of blocks moved between a thread's cache and the shared stack
+	// at a time - about 16K worth, but at least 2 and at most 64
+	static int BatchSize(int sizeClass)
+	{
+		size_t n = 16384 / ClassToSize(sizeClass);
+		return n < 2 ? 2 : n > 64 ? 64 : (int)n;
+	}
+
+	CACHE* GetCache()
+	{
+		CACHE* cache = m_cache.Get();
+		cache->heap = this;
+		return cache;
+	}
+
+	// Refill a thread's (empty) cache for a size class, returning the first
+	// block
+	FREEBLOCK* Refill(CACHE* cache, int sizeClass)
+	{
+		// Take a batch from the shared stack
+		FREEBLOCK* batch = m_central[sizeClass].Pop();
+		if (batch)
+		{
+			int count = 0;
+			for (FREEBLOCK* p = batch; p; p = p->chain)
+				count++;
+			cache->head[sizeClass] = batch;
+			cache->count[sizeClass] = count;
+			return batch;
+		}
+
+		// Carve a new slab, keeping one batch and sharing the rest
+		SLAB* slab = (SLAB*)AllocAligned(kSlabSize);
+		if (!slab)
+			return nullptr;
+		slab->next = nullptr;
+		slab->sizeClass = sizeClass;
+		slab->largeSize = 0;
+		m_slabs.Push(slab);
+		m_slabCount.Inc();
+
+		size_t blockSize = ClassToSize(sizeClass);
+		int blocks = (int)((kSlabSize - kHeaderSize) / blockSize);
+		char* base = (char*)slab + kHeaderSize;
+		int batchSize = BatchSize(sizeClass);
+		for (int first = 0; first < blocks; first += batchSize)
+		{
+			int n = blocks - first < batchSize ? blocks - first : batchSize;
+			for (int i = first; i < first + n; i++)
+			{
+				FREEBLOCK* block = (FREEBLOCK*)(base + i * blockSize);
+				block->chain = i + 1 < first + n ? (FREEBLOCK*)(base + (i + 1) * blockSize) : nullptr;
+			}
+
+			FREEBLOCK* head = (FREEBLOCK*)(base + first * blockSize);
+			if (first == 0)
+			{
+				cache->head[sizeClass] = head;
+				cache->count[sizeClass] = n;
+			}
+			else
+			{
+				PushBatch(sizeClass, head);
+			}
+		}
+		return cache->head[sizeClass];
+	}
+
+	void PushBatch(int sizeClass, FREEBLOCK* first)
+	{
+		first->next = nullptr;
+		m_central[sizeClass].Push(first);
+	}
+
+	void Flush(CACHE* cache)
+	{
+		for (int i = 0; i < kClassCount; i++)
+		{
+			if (cache->head[i])
+				PushBatch(i, cache->head[i]);
+			cache->head[i] = nullptr;
+			cache->count[i] = 0;
+		}
+	}
+
+	// Large blocks get their own mapping, starting on a slab boundary so
+	// Free can recognise them the same way
+	void* AllocLarge(size_t size)
+	{
+		SLAB* slab = (SLAB*)Platform::vmAllocAligned(kHeaderSize + size, kSlabSize);
+		if (!slab)
+			return nullptr;
+		slab->next = nullptr;
+		slab->sizeClass = -1;
+		slab->largeSize = size;
+		return (char*)slab + kHeaderSize;
+	}
+
+	// Slabs are exactly kSlabSize, so come from the heap
+	static void* AllocAligned(size_t size)
+	{
+#ifdef _MSC_VER
+		return _aligned_malloc(size, kSlabSize);
+#else
+		return aligned_alloc(kSlabSize, size);
+#endif
+	}
+
+	static void FreeAligned(void* p)
+	{
+#ifdef _MSC_VER
+		_aligned_free(p);
+#else
+		::free(p);
+#endif
+	}
+
+	// One shared stack of batches per size class (MpmcStack is cache line
+	// aligned, so they don't false share)
+	MpmcStack<FREEBLOCK> m_central[kClassCount];
+	MpmcStack<SLAB> m_slabs;
+	ThreadLocal<CACHE> m_cache;
+	Atomic<int> m_slabCount;
+};
+
+// Container allocator handle for a specific SizeClassHeap
+class SizeClassAllocator
+{
+public:
+	SizeClassAllocator() : m_heap(&SizeClassHeap::Default())
+	{
+	}
+	SizeClassAllocator(SizeClassHeap* heap) : m_heap(heap)
+	{
+	}
+
+	void* Alloc(size_t size)
+	{
+		return m_heap->Alloc(size);
+	}
+	void* ReAlloc(void* ptr, size_t size)
+	{
+		return m_heap->ReAlloc(ptr, size);
+	}
+	void Free(void* ptr)
+	{
+		m_heap->Free(ptr);
+	}
+
+	SizeClassHeap* GetHeap() const
+	{
+		return m_heap;
+	}
+
+private:
+	SizeClassHeap* m_heap;
+};
+
+// Stateless container allocator using SizeClassHeap::Default(), eg:
+//
+//     List<Message*, TSizeClassAlloc> list;
+class TSizeClassAlloc
+{
+public:
+	static void* Alloc(size_t size)
+	{
+		return SizeClassHeap::Default().Alloc(size);
+	}
+	static void* ReAlloc(void* ptr, size_t size)
+	{
+		return SizeClassHeap::Default().ReAlloc(ptr, size);
+	}
+	static void Free(void* ptr)
+	{
+		SizeClassHeap::Default().Free(ptr);
+	}
+};
+
+}
@@ -0,0 +1,412 @@
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+
+#include "../Core/Allocator.h"
+#include "../Core/List.h"
+#include "../Core/StringBuilder.h"
+#include "../Stream/Stream.h"
+#include "Atomic.h"
+#include "Mutex.h"
+
+namespace SimpleLib
+{
+
+// A snapshot of an AllocationTracker's counters
+struct AllocationStats
+{
+	size_t bytesLive;		// Bytes currently allocated (ie: reserved by the container)
+	size_t bytesPeak;		// High water mark of bytesLive
+	size_t bytesTotal;		// Bytes allocated over the tracker's lifetime
+	size_t blocksLive;		// Number of blocks currently allocated
+	size_t allocCount;		// Number of Alloc calls (and ReAllocs of nullptr)
+	size_t reallocCount;	// Number of ReAlloc calls
+	size_t freeCount;		// Number of Free calls (of non-null pointers)
+};
+
+// Counts the memory allocated through a TrackingAllocator.
+//
+// A tracker can be dedicated to one container (to watch that container's
+// memory use and allocation rate) or shared by several (eg: every mesh
+// vertex List). Each tracker has a tag and registers itself with the
+// global registry while it exists, so Dump() can list the biggest users
+// of memory by tag - trackers with the same tag are summed together.
+//
+// Note that containers never hand spare capacity back on their own (eg:
+// a HashCore keeps its buckets after Clear()), so a container that's
+// mostly empty but still holding a large buffer shows up here as a
+// large bytesLive.
+//
+// The counters are atomic so a tracker can be shared between threads. The
+// tag string isn't copied and must outlive the tracker, as must any memory
+// allocated through it (the tracker itself doesn't own any memory).
+class AllocationTracker
+{
+public:
+	// Constructor
+	AllocationTracker(const char* tag)
+	{
+		assert(tag != nullptr);
+		m_tag = tag;
+		m_prev = nullptr;
+		m_next = nullptr;
+		Registry().Add(this);
+	}
+
+	// Destructor
+	virtual ~AllocationTracker()
+	{
+		Registry().Remove(this);
+	}
+
+	// No copy
+	AllocationTracker(const AllocationTracker&) = delete;
+	AllocationTracker& operator=(const AllocationTracker&) = delete;
+
+	// Get the tag
+	const char* GetTag() const
+	{
+		return m_tag;
+	}
+
+	// Get the current counters
+	AllocationStats GetStats() const
+	{
+		AllocationStats stats;
+		stats.bytesLive = m_bytesLive.Get();
+		stats.bytesPeak = m_bytesPeak.Get();
+		stats.bytesTotal = m_bytesTotal.Get();
+		stats.blocksLive = m_blocksLive.Get();
+		stats.allocCount = m_allocCount.Get();
+		stats.reallocCount = m_reallocCount.Get();
+		stats.freeCount = m_freeCount.Get();
+		return stats;
+	}
+
+	// Reset the peak to the current live size (eg: at the start of a
+	// frame, to measure that frame's peak)
+	void ResetPeak()
+	{
+		m_bytesPeak.Set(m_bytesLive.Get());
+	}
+
+	// Record an allocation of `size` bytes
+	void OnAlloc(size_t size)
+	{
+		m_allocCount.Inc();
+		m_blocksLive.Inc();
+		m_bytesTotal.Add(size);
+		UpdatePeak(m_bytesLive.Add(size));
+	}
+
+	// Record a block being resized from `oldSize` to `newSize`
+	void OnReAlloc(size_t oldSize, size_t newSize)
+	{
+		m_reallocCount.Inc();
+		if (newSize > oldSize)
+		{
+			m_bytesTotal.Add(newSize - oldSize);
+			UpdatePeak(m_bytesLive.Add(newSize - oldSize));
+		}
+		else
+		{
+			m_bytesLive.Add((size_t)0 - (oldSize - newSize));
+		}
+	}
+
+	// Record a block of `size` bytes being freed
+	void OnFree(size_t size)
+	{
+		m_freeCount.Inc();
+		m_blocksLive.Dec();
+		m_bytesLive.Add((size_t)0 - size);
+	}
+
+	// Write a table of the `maxTags` tags with the most live bytes to a
+	// stream. Returns 0 on success or the stream's error code.
+	static int Dump(Stream& stream, int maxTags = 20)
+	{
+		return Registry().Dump(stream, maxTags);
+	}
+
+	// Get the combined counters of all trackers with the given tag.
+	// Returns false if there are none.
+	static bool GetTagStats(const char* tag, AllocationStats& stats)
+	{
+		return Registry().GetTagStats(tag, stats);
+	}
+
+private:
+	void UpdatePeak(size_t live)
+	{
+		size_t peak = m_bytesPeak.Get();
+		while (live > peak && !m_bytesPeak.TrySet(live, peak))
+			peak = m_bytesPeak.Get();
+	}
+
+	// Combined counters of all the trackers with the same tag
+	struct TAGSTATS
+	{
+		const char* tag;
+		int trackers;
+		AllocationStats stats;
+	};
+
+	// All the live trackers, in an intrusive list guarded by a mutex
+	class REGISTRY
+	{
+	public:
+		REGISTRY()
+		{
+			m_first = nullptr;
+		}
+
+		void Add(AllocationTracker* tracker)
+		{
+			EnterMutex lock(m_mutex);
+			tracker->m_prev = nullptr;
+			tracker->m_next = m_first;
+			if (m_first)
+				m_first->m_prev = tracker;
+			m_first = tracker;
+		}
+
+		void Remove(AllocationTracker* tracker)
+		{
+			EnterMutex lock(m_mutex);
+			if (tracker->m_prev)
+				tracker->m_prev->m_next = tracker->m_next;
+			else
+				m_first = tracker->m_next;
+			if (tracker->m_next)
+				tracker->m_next->m_prev = tracker->m_prev;
+		}
+
+		bool GetTagStats(const char* tag, AllocationStats& stats)
+		{
+			List<TAGSTATS> tags;
+			Collect(tags);
+			for (int i = 0; i < tags.GetCount(); i++)
+			{
+				if (strcmp(tags[i].tag, tag) == 0)
+				{
+					stats = tags[i].stats;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		int Dump(Stream& stream, int maxTags)
+		{
+			List<TAGSTATS> tags;
+			Collect(tags);
+			tags.Sort([](const TAGSTATS& a, const TAGSTATS& b) {
+				if (a.stats.bytesLive != b.stats.bytesLive)
+					return a.stats.bytesLive > b.stats.bytesLive ? -1 : 1;
+				return strcmp(a.tag, b.tag);
+			});
+
+			int count = tags.GetCount() < maxTags ? tags.GetCount() : maxTags;
+
+			StringBuilder<char> sb;
+			sb.Format("Allocations by tag (top %i of %i):\n", count, tags.GetCount());
+			sb.Format("  %-24s %12s %12s %12s %10s %10s %10s %6s\n",
+				"tag", "live", "peak", "total", "blocks", "allocs", "reallocs", "count");
+			RIFE(stream.Write(sb.sz()));
+
+			for (int i = 0; i < count; i++)
+			{
+				const AllocationStats& s = tags[i].stats;
+				sb.Clear();
+				sb.Format("  %-24s %12zu %12zu %12zu %10zu %10zu %10zu %6i\n",
+					tags[i].tag, s.bytesLive, s.bytesPeak, s.bytesTotal, s.blocksLive,
+					s.allocCount, s.reallocCount, tags[i].trackers);
+				RIFE(stream.Write(sb.sz()));
+			}
+			return 0;
+		}
+
+	private:
+		// Sum the trackers' counters by tag (the peaks are summed too, so
+		// a shared tag's peak is an upper bound)
+		void Collect(List<TAGSTATS>& tags)
+		{
+			EnterMutex lock(m_mutex);
+			for (AllocationTracker* p = m_first; p; p = p->m_next)
+			{
+				AllocationStats s = p->GetStats();
+
+				int i;
+				for (i = 0; i < tags.GetCount(); i++)
+				{
+					if (strcmp(tags[i].tag, p->m_tag) == 0)
+						break;
+				}
+				if (i == tags.GetCount())
+				{
+					TAGSTATS t;
+					t.tag = p->m_tag;
+					t.trackers = 0;
+					memset(&t.stats, 0, sizeof(t.stats));
+					tags.Add(t);
+				}
+
+				TAGSTATS& t = tags.GetRefAt(i);
+				t.trackers++;
+				t.stats.bytesLive += s.bytesLive;
+				t.stats.bytesPeak += s.bytesPeak;
+				t.stats.bytesTotal += s.bytesTotal;
+				t.stats.blocksLive += s.blocksLive;
+				t.stats.allocCount += s.allocCount;
+				t.stats.reallocCount += s.reallocCount;
+				t.stats.freeCount += s.freeCount;
+			}
+		}
+
+		Mutex m_mutex;
+		AllocationTracker* m_first;
+	};
+
+	static REGISTRY& Registry()
+	{
+		// Deliberately leaked - trackers in other static objects may
+		// unregister during process shutdown
+		static REGISTRY* registry = new REGISTRY();
+		return *registry;
+	}
+
+	const char* m_tag;
+	AllocationTracker* m_prev;
+	AllocationTracker* m_next;
+	Atomic<size_t> m_bytesLive;
+	Atomic<size_t> m_bytesPeak;
+	Atomic<size_t> m_bytesTotal;
+	Atomic<size_t> m_blocksLive;
+	Atomic<size_t> m_allocCount;
+	Atomic<size_t> m_reallocCount;
+	Atomic<size_t> m_freeCount;
+};
+
+// Container allocator handle that passes allocations through to another
+// allocator, counting them in an AllocationTracker, eg:
+//
+//     AllocationTracker tracker("Mesh Vertices");
+//     List<Vertex, TrackingAllocator<>> vertices(&tracker);
+//
+// Each allocation carries a small size header (so Free knows how much to
+// uncount), so don't mix pointers with the underlying allocator. A null
+// tracker passes straight through without counting (or a header).
+template <typename TAllocator = TMalloc>
+class TrackingAllocator
+{
+public:
+	TrackingAllocator() : m_tracker(nullptr)
+	{
+	}
+	TrackingAllocator(AllocationTracker* tracker, TAllocator allocator = TAllocator())
+		: m_tracker(tracker), m_allocator(allocator)
+	{
+	}
+
+	void* Alloc(size_t size)
+	{
+		if (!m_tracker)
+			return m_allocator.Alloc(size);
+
+		char* p = (char*)m_allocator.Alloc(kHeaderSize + size);
+		if (!p)
+			return nullptr;
+		*(size_t*)p = size;
+		m_tracker->OnAlloc(size);
+		return p + kHeaderSize;
+	}
+
+	void* ReAlloc(void* ptr, size_t size)
+	{
+		if (!m_tracker)
+			return m_allocator.ReAlloc(ptr, size);
+		if (!ptr)
+			return Alloc(size);
+
+		char* header = (char*)ptr - kHeaderSize;
+		size_t oldSize = *(size_t*)header;
+		char* p = (char*)m_allocator.ReAlloc(header, kHeaderSize + size);
+		if (!p)
+			return nullptr;
+		*(size_t*)p = size;
+		m_tracker->OnReAlloc(oldSize, size);
+		return p + kHeaderSize;
+	}
+
+	void Free(void* ptr)
+	{
+		if (!m_tracker)
+		{
+			m_allocator.Free(ptr);
+			return;
+		}
+		if (!ptr)
+			return;
+
+		char* header = (char*)ptr - kHeaderSize;
+		m_tracker->OnFree(*(size_t*)header);
+		m_allocator.Free(header);
+	}
+
+	AllocationTracker* GetTracker() const
+	{
+		return m_tracker;
+	}
+
+private:
+	// Header size keeps allocations 16 byte aligned
+	static constexpr size_t kHeaderSize = 16;
+
+	AllocationTracker* m_tracker;
+	TAllocator m_allocator;
+};
+
+// Stateless tracking allocator with one tracker per tag type, for
+// accounting whole classes of containers without giving each one a
+// tracker, eg:
+//
+//     struct MeshTag { static const char* Name() { return "Mesh"; } };
+//     List<Vertex, TTrackedAlloc<MeshTag>> vertices;
+template <typename TTag, typename TAllocator = TMalloc>
+class TTrackedAlloc
+{
+public:
+	static void* Alloc(size_t size)
+	{
+		return Allocator().Alloc(size);
+	}
+	static void* ReAlloc(void* ptr, size_t size)
+	{
+		return Allocator().ReAlloc(ptr, size);
+	}
+	static void Free(void* ptr)
+	{
+		Allocator().Free(ptr);
+	}
+
+	// The tracker shared by all allocations with this tag
+	static AllocationTracker& Tracker()
+	{
+		// Deliberately leaked - static containers may free into it during
+		// process shutdown
+		static AllocationTracker* tracker = new AllocationTracker(TTag::Name());
+		return *tracker;
+	}
+
+private:
+	static TrackingAllocator<TAllocator> Allocator()
+	{
+		return TrackingAllocator<TAllocator>(&Tracker());
+	}
+};
+
+}
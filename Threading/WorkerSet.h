@@ -0,0 +1,202 @@
+#pragma once
+
+#include "../Core/List.h"
+#include "../Core/OwnedPtr.h"
+#include "Atomic.h"
+#include "Semaphore.h"
+#include "Thread.h"
+
+namespace SimpleLib
+{
+
+// WorkerSet - a fixed set of worker threads for fork/join style data
+// parallelism (see Parallel.h).
+//
+// Run(count, callback) invokes callback(index) for every index in
+// [0, count), handing indices out to the worker threads and the calling
+// thread through a shared atomic counter, and returns once every call has
+// completed. Callers normally pass chunk indices rather than item indices
+// so each call does a worthwhile amount of work.
+//
+// Threads are created lazily on the first Run that can use them, so
+// constructing a WorkerSet (including the shared Default() instance) is
+// cheap.
+//
+// A WorkerSet runs one job at a time. If Run is called while another job is
+// in progress - from another thread, or re-entrantly from inside a callback
+// - the new job is simply run serially on the calling thread rather than
+// blocking, so nested parallel algorithms are safe (if not parallel).
+class WorkerSet
+{
+public:
+	// Create a worker set with `workerCount` threads. The calling thread
+	// always participates in Run too, so the default is one fewer than the
+	// number of processors.
+	WorkerSet(int workerCount = -1) :
+		m_start(0),
+		m_finished(0)
+	{
+		if (workerCount < 0)
+			workerCount = Thread::GetProcessorCount() - 1;
+		m_workerCount = workerCount;
+		m_stop = false;
+		m_proc = nullptr;
+		m_user = nullptr;
+		m_count = 0;
+	}
+
+	~WorkerSet()
+	{
+		if (m_workers.GetCount() == 0)
+			return;
+
+		// Wake everyone with the stop flag set and wait for them to exit
+		m_stop = true;
+		m_start.Release(m_workers.GetCount());
+		for (int i = 0; i < m_workers.GetCount(); i++)
+			m_workers[i]->Join();
+	}
+
+	// Number of worker threads (excluding the calling thread)
+	int GetWorkerCount()
+	{
+		return m_workerCount;
+	}
+
+	// Number of threads that execute a Run (the workers plus the caller)
+	int GetConcurrency()
+	{
+		return m_workerCount + 1;
+	}
+
+	// Invoke callback(index) for each index in [0, count) across the
+	// worker threads and the calling thread
+	template <typename TCallback>
+	void Run(int count, TCallback&& callback)
+	{
+		typedef typename std::remove_reference<TCallback>::type TFn;
+		Run(count, [](void* user, int index) {
+			(*(TFn*)user)(index);
+		}, (void*)&callback);
+	}
+
+	void Run(int count, void (*proc)(void* user, int index), void* user)
+	{
+		if (count <= 0)
+			return;
+
+		// Nothing to share, no workers, or already busy with another job?
+		if (count == 1 || m_workerCount == 0 || !m_busy.TrySet(1, 0))
+		{
+			for (int i = 0; i < count; i++)
+				proc(user, i);
+			return;
+		}
+
+		if (!StartWorkers())
+		{
+			m_busy.Set(0);
+			for (int i = 0; i < count; i++)
+				proc(user, i);
+			return;
+		}
+
+		// Publish the job
+		m_proc = proc;
+		m_user = user;
+		m_count = count;
+		m_next.Set(0);
+
+		// Wake as many workers as there are indices for the caller not to
+		// run, and help out
+		int woken = count - 1 < m_workers.GetCount() ? count - 1 : m_workers.GetCount();
+		m_start.Release(woken);
+		Drain();
+
+		// Wait for every woken worker to check out. Waiting on all of them
+		// (rather than just until the last index completes) guarantees no
+		// straggler is still looking at this job when the next is published.
+		for (int i = 0; i < woken; i++)
+			m_finished.Wait();
+
+		m_busy.Set(0);
+	}
+
+	// Shared worker set used by the parallel algorithms by default
+	static WorkerSet& Default()
+	{
+		static WorkerSet workers;
+		return workers;
+	}
+
+private:
+	class Worker : public Thread
+	{
+	public:
+		Worker(WorkerSet* owner) : m_owner(owner)
+		{
+		}
+
+	protected:
+		virtual void ThreadProc() override
+		{
+			m_owner->WorkerProc();
+		}
+
+	private:
+		WorkerSet* m_owner;
+	};
+
+	int m_workerCount;
+	List<OwnedPtr<Worker>> m_workers;
+	Atomic<uint32_t> m_busy;		// (not a mutex, since those are re-entrant)
+	Semaphore m_start;
+	Semaphore m_finished;
+	volatile bool m_stop;
+
+	// Current job
+	void (*m_proc)(void* user, int index);
+	void* m_user;
+	int m_count;
+	Atomic<uint32_t> m_next;
+
+	bool StartWorkers()
+	{
+		while (m_workers.GetCount() < m_workerCount)
+		{
+			Worker* worker = new Worker(this);
+			if (!worker->Start())
+			{
+				delete worker;
+				return m_workers.GetCount() > 0;
+			}
+			m_workers.Add(worker);
+		}
+		return true;
+	}
+
+	void Drain()
+	{
+		while (true)
+		{
+			int index = (int)m_next.FetchAdd(1);
+			if (index >= m_count)
+				return;
+			m_proc(m_user, index);
+		}
+	}
+
+	void WorkerProc()
+	{
+		while (true)
+		{
+			m_start.Wait();
+			if (m_stop)
+				return;
+			Drain();
+			m_finished.Release();
+		}
+	}
+};
+
+}
@@ -3,6 +3,7 @@
 
 // Strings
 #include "Core/String.h"
+#include "Core/StringView.h"
 #include "Core/StringBuilder.h"
 #include "Core/StringPool.h"
 #include "Core/Encoding.h"
@@ -12,13 +13,23 @@
 // Collections
 #include "Core/Delegate.h"
 #include "Core/Buffer.h"
+#include "Core/RefCount.h"
 #include "Core/SharedPtr.h"
 #include "Core/OwnedPtr.h"
 #include "Core/RefCountedPtr.h"
+#include "Core/Sorting.h"
+#include "Core/Query.h"
 #include "Core/List.h"
+#include "Core/SegmentedList.h"
+#include "Core/Deque.h"
 #include "Core/Map.h"
 #include "Core/Set.h"
 
+// Memory
+#include "Core/Allocator.h"
+#include "Core/Arena.h"
+#include "Core/RealTime.h"
+
 
 // Misc
 #include "Core/Bit.h"
@@ -1,25 +1,105 @@
 #pragma once
 
 #include <stdlib.h>
+#include <type_traits>
+
+#include "RealTime.h"
 
 namespace SimpleLib
 {
 
+// Allocators provide Alloc/ReAlloc/Free and come in two flavours:
+//
+// * Stateless allocators (like TMalloc) are empty classes, usually with
+//   static methods, and cost nothing to store in a container.
+//
+// * Stateful allocators carry state (typically a pointer to an arena, pool
+//   or per-thread heap) and have instance methods.  They should be small,
+//   cheap to copy handles - a container keeps its own copy, passes copies
+//   to helpers that need scratch memory (eg: Sorting) and hands it over
+//   when moved.
+//
+// Containers always call through an allocator instance (see AllocatorHolder)
+// so the same code works with either flavour - calling a static method via
+// an object is fine.
 class TMalloc
 {
 public:
     static void* Alloc(size_t size)
     {
+        SIMPLELIB_REALTIME_CHECK(Alloc);
         return malloc(size);
     }
     static void* ReAlloc(void* ptr, size_t size)
     {
+        SIMPLELIB_REALTIME_CHECK(Alloc);
         return realloc(ptr, size);
     }
     static void Free(void* ptr)
     {
+        if (ptr)
+            SIMPLELIB_REALTIME_CHECK(Free);
         free(ptr);
     }
 };
 
-}
\ No newline at end of file
+// Stores the allocator instance used by a container.  Stateful allocators
+// are stored as a member, stateless (empty) allocators aren't stored at all
+// - GetAllocator() just returns a fresh instance so the holder is an empty
+// base class and adds nothing to the size of the container.
+template <typename TAllocator, bool = std::is_empty<TAllocator>::value>
+class AllocatorHolder
+{
+public:
+    AllocatorHolder()
+    {
+    }
+    AllocatorHolder(const TAllocator& allocator) : m_allocator(allocator)
+    {
+    }
+
+    // Get the allocator
+    TAllocator& GetAllocator()
+    {
+        return m_allocator;
+    }
+    const TAllocator& GetAllocator() const
+    {
+        return m_allocator;
+    }
+
+protected:
+    // Replace the allocator (only valid while nothing is allocated from it)
+    void SetAllocator(const TAllocator& allocator)
+    {
+        m_allocator = allocator;
+    }
+
+private:
+    TAllocator m_allocator;
+};
+
+template <typename TAllocator>
+class AllocatorHolder<TAllocator, true>
+{
+public:
+    AllocatorHolder()
+    {
+    }
+    AllocatorHolder(const TAllocator&)
+    {
+    }
+
+    // Get the allocator
+    TAllocator GetAllocator() const
+    {
+        return TAllocator();
+    }
+
+protected:
+    void SetAllocator(const TAllocator&)
+    {
+    }
+};
+
+}
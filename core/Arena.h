@@ -0,0 +1,365 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+namespace SimpleLib
+{
+
+// A position in an Arena, see Arena::Mark()
+struct ArenaMark
+{
+	void* block;
+	size_t used;
+};
+
+// General purpose monotonic ("bump") arena.
+//
+// Memory is carved sequentially out of a chain of blocks, so allocating is
+// little more than a pointer increment and individual allocations are never
+// freed - instead everything is released at once with FreeAll(), or
+// everything allocated since a Mark() is released with Rewind(). Blocks
+// are kept for reuse (only Reset() and the destructor give them back),
+// so an arena that's rewound every request or audio cycle soon stops
+// touching the heap altogether.
+//
+// Not thread safe - use one arena per thread (or per task).
+//
+// To use an arena as the allocator for a List, Map, etc... see
+// ArenaAllocator below.
+class Arena
+{
+public:
+	// Default alignment of allocations (same as malloc on 64-bit platforms)
+	static constexpr size_t kDefaultAlignment = 16;
+
+	// Largest supported alignment
+	static constexpr size_t kMaxAlignment = 64;
+
+	// Smallest block size (smaller requests are rounded up to this)
+	static constexpr size_t kMinBlockSize = 256;
+
+	// Constructor
+	Arena(size_t blockSize = 65536)
+	{
+		m_first = nullptr;
+		m_current = nullptr;
+		m_blockSize = blockSize < kMinBlockSize ? kMinBlockSize : blockSize;
+	}
+
+	// Destructor
+	virtual ~Arena()
+	{
+		Reset();
+	}
+
+	// No copy
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	// Free everything, releasing all blocks back to the heap
+	void Reset()
+	{
+		BLOCK* p = m_first;
+		while (p)
+		{
+			BLOCK* next = p->next;
+			FreeAligned(p);
+			p = next;
+		}
+		m_first = nullptr;
+		m_current = nullptr;
+	}
+
+	// Free everything, but keep the blocks for reuse
+	void FreeAll()
+	{
+		m_current = m_first;
+		if (m_current)
+			m_current->used = 0;
+	}
+
+	// Allocate `size` bytes aligned to `alignment` (a power of two).
+	// Returns nullptr if memory couldn't be allocated.
+	void* Alloc(size_t size, size_t alignment = kDefaultAlignment)
+	{
+		assert((alignment & (alignment - 1)) == 0 && alignment <= kMaxAlignment);
+
+		// Fast path, fits in the current block
+		if (m_current)
+		{
+			size_t offset = AlignUp(m_current->used, alignment);
+			if (offset <= m_current->capacity && size <= m_current->capacity - offset)
+			{
+				m_current->used = offset + size;
+				return Data(m_current) + offset;
+			}
+		}
+
+		// Move to the next block (the start of which is suitably aligned)
+		BLOCK* block = NextBlock(size);
+		if (!block)
+			return nullptr;
+
+		block->used = size;
+		return Data(block);
+	}
+
+	// Allocate uninitialized storage for `count` objects of type T
+	template <typename T>
+	T* AllocArray(size_t count)
+	{
+		return (T*)Alloc(count * sizeof(T), alignof(T));
+	}
+
+	// Resize the most recent allocation in place. Returns false (and
+	// leaves the allocation unchanged) if `p` isn't the most recent
+	// allocation or there isn't room for it to grow in its block.
+	bool Resize(void* p, size_t oldSize, size_t newSize)
+	{
+		if (!IsTop(p, oldSize))
+			return false;
+
+		size_t offset = (char*)p - Data(m_current);
+		if (newSize > m_current->capacity - offset)
+			return false;
+
+		m_current->used = offset + newSize;
+		return true;
+	}
+
+	// Give back the most recent allocation (does nothing for any other
+	// allocation - the memory is just released with everything else)
+	void Free(void* p, size_t size)
+	{
+		if (IsTop(p, size))
+			m_current->used = (char*)p - Data(m_current);
+	}
+
+	// Get the current position, to later rewind to
+	ArenaMark Mark() const
+	{
+		ArenaMark mark;
+		mark.block = m_current;
+		mark.used = m_current ? m_current->used : 0;
+		return mark;
+	}
+
+	// Free everything allocated since `mark` was taken
+	void Rewind(const ArenaMark& mark)
+	{
+		if (mark.block == nullptr)
+		{
+			FreeAll();
+			return;
+		}
+		m_current = (BLOCK*)mark.block;
+		m_current->used = mark.used;
+	}
+
+	// Total bytes in all blocks (whether used or not)
+	size_t GetCapacity() const
+	{
+		size_t total = 0;
+		for (BLOCK* p = m_first; p; p = p->next)
+			total += p->capacity;
+		return total;
+	}
+
+	// Bytes handed out (including alignment padding) since the last
+	// FreeAll/Rewind to the start
+	size_t GetUsed() const
+	{
+		size_t total = 0;
+		for (BLOCK* p = m_first; p; p = p->next)
+		{
+			total += p->used;
+			if (p == m_current)
+				break;
+		}
+		return m_current ? total : 0;
+	}
+
+private:
+	struct BLOCK
+	{
+		BLOCK* next;
+		size_t used;
+		size_t capacity;
+	};
+
+	static size_t AlignUp(size_t offset, size_t alignment)
+	{
+		return (offset + alignment - 1) & ~(alignment - 1);
+	}
+
+	// Blocks are allocated aligned to kMaxAlignment with the header padded
+	// out to match, so offsets within a block align the same as addresses
+	static constexpr size_t kHeaderSize = (sizeof(BLOCK) + kMaxAlignment - 1) & ~(kMaxAlignment - 1);
+
+	static char* Data(BLOCK* block)
+	{
+		return (char*)block + kHeaderSize;
+	}
+
+	bool IsTop(void* p, size_t size) const
+	{
+		return m_current && (char*)p + size == Data(m_current) + m_current->used;
+	}
+
+	// Move on to the next block, reusing the one after the current if it's
+	// big enough or inserting a new one if not. Returns nullptr if
+	// `required` is too big to ever allocate.
+	BLOCK* NextBlock(size_t required)
+	{
+		BLOCK* next = m_current ? m_current->next : m_first;
+		if (next == nullptr || next->capacity < required)
+		{
+			// Leave room for the header and rounding up in AllocAligned
+			if (required > SIZE_MAX - kHeaderSize - kMaxAlignment)
+				return nullptr;
+
+			// Double the block size until it fits, or use exactly the
+			// required size if doubling would overflow
+			size_t capacity = m_blockSize;
+			while (capacity < required)
+				capacity = capacity > SIZE_MAX / 2 ? required : capacity * 2;
+
+			BLOCK* block = (BLOCK*)AllocAligned(kHeaderSize + capacity);
+			if (!block)
+				return nullptr;
+			block->capacity = capacity;
+			block->next = next;
+			if (m_current)
+				m_current->next = block;
+			else
+				m_first = block;
+			next = block;
+		}
+
+		next->used = 0;
+		m_current = next;
+		return next;
+	}
+
+	// malloc only guarantees 16 byte alignment, over-align the blocks so
+	// cache line aligned allocations work
+	static void* AllocAligned(size_t size)
+	{
+#ifdef _MSC_VER
+		return _aligned_malloc(size, kMaxAlignment);
+#else
+		return aligned_alloc(kMaxAlignment, AlignUp(size, kMaxAlignment));
+#endif
+	}
+
+	static void FreeAligned(void* p)
+	{
+#ifdef _MSC_VER
+		_aligned_free(p);
+#else
+		::free(p);
+#endif
+	}
+
+	BLOCK* m_first;
+	BLOCK* m_current;
+	size_t m_blockSize;
+};
+
+// Container allocator handle for an Arena, eg:
+//
+//     Arena arena;
+//     List<int, ArenaAllocator> list(&arena);
+//
+// Each allocation carries a small size header so ReAlloc can copy (or grow
+// in place, for the most recent allocation). Free only reclaims the most
+// recent allocation, everything else goes when the arena is rewound - so
+// the arena must outlive (or be rewound after) any container using it.
+class ArenaAllocator
+{
+public:
+	ArenaAllocator() : m_arena(nullptr)
+	{
+	}
+	ArenaAllocator(Arena* arena) : m_arena(arena)
+	{
+	}
+
+	void* Alloc(size_t size)
+	{
+		assert(m_arena != nullptr);
+		char* p = (char*)m_arena->Alloc(kHeaderSize + size);
+		if (!p)
+			return nullptr;
+		*(size_t*)p = size;
+		return p + kHeaderSize;
+	}
+
+	void* ReAlloc(void* ptr, size_t size)
+	{
+		if (!ptr)
+			return Alloc(size);
+
+		char* header = (char*)ptr - kHeaderSize;
+		size_t oldSize = *(size_t*)header;
+		if (m_arena->Resize(header, kHeaderSize + oldSize, kHeaderSize + size))
+		{
+			*(size_t*)header = size;
+			return ptr;
+		}
+
+		void* p = Alloc(size);
+		if (p)
+			memcpy(p, ptr, oldSize < size ? oldSize : size);
+		return p;
+	}
+
+	void Free(void* ptr)
+	{
+		if (!ptr)
+			return;
+		char* header = (char*)ptr - kHeaderSize;
+		m_arena->Free(header, kHeaderSize + *(size_t*)header);
+	}
+
+	Arena* GetArena() const
+	{
+		return m_arena;
+	}
+
+private:
+	// Header size is the default alignment so allocations stay aligned
+	static constexpr size_t kHeaderSize = Arena::kDefaultAlignment;
+
+	Arena* m_arena;
+};
+
+// Marks an arena on construction and rewinds it on destruction, releasing
+// everything allocated within the scope
+class ArenaScope
+{
+public:
+	ArenaScope(Arena& arena) : m_arena(arena), m_mark(arena.Mark())
+	{
+	}
+	~ArenaScope()
+	{
+		m_arena.Rewind(m_mark);
+	}
+
+	ArenaScope(const ArenaScope&) = delete;
+	ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+	Arena& m_arena;
+	ArenaMark m_mark;
+};
+
+}
@@ -1,5 +1,11 @@
 #pragma once
 
+#include <stdint.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 namespace SimpleLib
 {
 
@@ -60,6 +66,46 @@ public:
         return Find(mask, 0);
     }
 
+    // Index of the lowest set bit (mask must be non-zero). Compiles to a
+    // single instruction, unlike Scan.
+    static int TrailingZeros(uint32_t mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return (int)index;
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+
+    static int TrailingZeros(uint64_t mask)
+    {
+#if defined(_MSC_VER) && defined(_WIN64)
+        unsigned long index;
+        _BitScanForward64(&index, mask);
+        return (int)index;
+#elif defined(_MSC_VER)
+        uint32_t low = (uint32_t)mask;
+        return low ? TrailingZeros(low) : 32 + TrailingZeros((uint32_t)(mask >> 32));
+#else
+        return __builtin_ctzll(mask);
+#endif
+    }
+
+    // Index of the highest set bit, ie: floor(log2(mask)) (mask must be
+    // non-zero)
+    static int HighestBit(uint32_t mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse(&index, mask);
+        return (int)index;
+#else
+        return 31 - __builtin_clz(mask);
+#endif
+    }
+
     // Find the index'th set bit
     template <typename T>
     static int Find(T mask, int index)
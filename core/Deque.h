@@ -0,0 +1,367 @@
+#pragma once
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Compare.h"
+#include "Semantics.h"
+#include "PlacedConstructor.h"
+
+#include "Allocator.h"
+
+namespace SimpleLib
+{
+
+// Double ended queue - a growable ring buffer with O(1) push and pop at
+// both ends and O(1) indexing (index 0 is the front).
+//
+// The capacity is always a power of two so wrapping is just a mask. The
+// elements occupy at most two contiguous runs of the buffer (the second
+// only when they wrap around the end), see GetSpans() for bulk access.
+//
+// Not thread safe - for passing items between threads see SpscQueue and
+// MpmcQueue.
+template <typename T, typename TAllocator = TMalloc>
+class Deque : private AllocatorHolder<TAllocator>
+{
+	typedef typename get_semantics<T>::TSemantics TSemantics;
+	typedef typename TSemantics::TArg TArg;
+	typedef typename TSemantics::TStorage TStorage;
+	typedef AllocatorHolder<TAllocator> TAllocatorHolder;
+
+public:
+	// Constructor
+	Deque()
+	{
+	}
+
+	// Constructor with a specific allocator instance
+	explicit Deque(const TAllocator& allocator)
+		: TAllocatorHolder(allocator)
+	{
+	}
+
+	// Destructor
+	virtual ~Deque()
+	{
+		Clear();
+		if (m_data)
+			GetAllocator().Free(m_data);
+	}
+
+	// Get the allocator this deque allocates from
+	using TAllocatorHolder::GetAllocator;
+
+	// No copy
+	Deque(const Deque&) = delete;
+	Deque& operator=(const Deque&) = delete;
+
+	// Move
+	Deque(Deque&& other)
+		: TAllocatorHolder(other.GetAllocator())
+	{
+		TakeFrom(other);
+	}
+
+	// Move
+	Deque& operator=(Deque&& other)
+	{
+		if (this == &other)
+			return *this;
+
+		Clear();
+		if (m_data)
+			GetAllocator().Free(m_data);
+		this->SetAllocator(other.GetAllocator());
+		TakeFrom(other);
+		return *this;
+	}
+
+	// Ensure allocated capacity is at least requiredCapacity (rounded up to
+	// a power of two, does not shrink)
+	bool SetCapacity(int requiredCapacity)
+	{
+		if (requiredCapacity <= m_capacity)
+			return true;
+
+		int newCapacity = m_capacity ? m_capacity : 16;
+		while (newCapacity < requiredCapacity)
+			newCapacity *= 2;
+
+		TStorage* data = (TStorage*)GetAllocator().ReAlloc((void*)m_data, newCapacity * sizeof(TStorage));
+		if (!data)
+			return false;
+
+		// The buffer grew in place (or was copied as is), so if the elements
+		// wrapped, move the wrapped part from the start of the buffer to
+		// just after the old end (there's always room since the capacity
+		// at least doubled)
+		int wrapped = m_head + m_count - m_capacity;
+		if (wrapped > 0)
+			memcpy((void*)(data + m_capacity), (void*)data, wrapped * sizeof(TStorage));
+
+		m_data = data;
+		m_capacity = newCapacity;
+		return true;
+	}
+
+	// Get the allocated capacity
+	int GetCapacity() const
+	{
+		return m_capacity;
+	}
+
+	// Add an element at the back
+	bool PushBack(TArg val)
+	{
+		if (m_count == m_capacity && !SetCapacity(m_count + 1))
+			return false;
+
+		Constructor(Slot(m_count), val);
+		m_count++;
+		return true;
+	}
+
+	// Add an element at the front
+	bool PushFront(TArg val)
+	{
+		if (m_count == m_capacity && !SetCapacity(m_count + 1))
+			return false;
+
+		m_head = (m_head - 1) & (m_capacity - 1);
+		Constructor(m_data + m_head, val);
+		m_count++;
+		return true;
+	}
+
+	// Remove and return the front element
+	TArg PopFront()
+	{
+		assert(m_count > 0);
+
+		TArg val = TSemantics::Detach(m_data[m_head]);
+		m_head = (m_head + 1) & (m_capacity - 1);
+		m_count--;
+		return val;
+	}
+
+	// Remove and return the back element
+	TArg PopBack()
+	{
+		assert(m_count > 0);
+
+		m_count--;
+		return TSemantics::Detach(*Slot(m_count));
+	}
+
+	// Remove `count` elements from the front (eg: to slide a window along)
+	void RemoveFront(int count)
+	{
+		assert(count >= 0 && count <= m_count);
+
+		for (int i = 0; i < count; i++)
+			Destructor(Slot(i));
+		m_head = (m_head + count) & (m_capacity - 1);
+		m_count -= count;
+	}
+
+	// Remove `count` elements from the back
+	void RemoveBack(int count)
+	{
+		assert(count >= 0 && count <= m_count);
+
+		for (int i = 0; i < count; i++)
+			Destructor(Slot(m_count - 1 - i));
+		m_count -= count;
+	}
+
+	// Remove all elements
+	void Clear()
+	{
+		RemoveBack(m_count);
+		m_head = 0;
+	}
+
+	// Get the front element
+	TArg GetFront() const
+	{
+		assert(m_count > 0);
+		return m_data[m_head];
+	}
+
+	// Get the back element
+	TArg GetBack() const
+	{
+		assert(m_count > 0);
+		return *Slot(m_count - 1);
+	}
+
+	// GetAt
+	TArg GetAt(int position) const
+	{
+		assert(position >= 0);
+		assert(position < GetCount());
+
+		return *Slot(position);
+	}
+
+	// Get reference to element
+	const TStorage& GetRefAt(int position) const
+	{
+		assert(position >= 0);
+		assert(position < GetCount());
+
+		return *Slot(position);
+	}
+
+	// Get reference to element
+	TStorage& GetRefAt(int position)
+	{
+		assert(position >= 0);
+		assert(position < GetCount());
+
+		return *Slot(position);
+	}
+
+	// operator[]
+	TArg operator[](int position) const
+	{
+		return GetAt(position);
+	}
+
+	// GetCount
+	int GetCount() const
+	{
+		return m_count;
+	}
+
+	// IsEmpty
+	bool IsEmpty() const
+	{
+		return m_count == 0;
+	}
+
+	// Get the elements as (at most) two contiguous runs - the first starts
+	// with the front element, the second (which is empty unless the
+	// elements wrap around the end of the buffer) ends with the back one
+	void GetSpans(TStorage*& first, int& firstCount, TStorage*& second, int& secondCount) const
+	{
+		int toEnd = m_capacity - m_head;
+		first = m_data + m_head;
+		firstCount = m_count < toEnd ? m_count : toEnd;
+		second = m_data;
+		secondCount = m_count - firstCount;
+	}
+
+	// Copy `count` elements starting at `position` to `dest` (bitwise, so
+	// for plain value types only)
+	void CopyTo(TStorage* dest, int position, int count) const
+	{
+		assert(position >= 0 && count >= 0 && position + count <= m_count);
+
+		int start = (m_head + position) & (m_capacity - 1);
+		int toEnd = m_capacity - start;
+		int n = count < toEnd ? count : toEnd;
+		memcpy((void*)dest, (void*)(m_data + start), n * sizeof(TStorage));
+		memcpy((void*)(dest + n), (void*)m_data, (count - n) * sizeof(TStorage));
+	}
+
+	// Find index of an item (linear, from the front)
+	template <typename TCompare = SDefaultCompare>
+	int IndexOf(TArg val, int startAfter = -1) const
+	{
+		for (int i = startAfter + 1; i < m_count; i++)
+		{
+			if (TCompare::AreEqual(static_cast<TArg>(*Slot(i)), val))
+				return i;
+		}
+		return -1;
+	}
+
+	// Check if the deque contains an item
+	bool Contains(TArg val) const
+	{
+		return IndexOf(val) >= 0;
+	}
+
+	class Iter
+	{
+	public:
+		TArg Get() { return *_value; };
+
+		bool Next() { return _owner->GetNext(*this); }
+
+	private:
+		Iter(const Deque* owner, bool forward)
+		{
+			_owner = owner;
+			_forward = forward;
+		}
+
+		const TStorage* _value = nullptr;
+		const Deque* _owner;
+		int _pos = -1;
+		bool _forward = true;
+		friend class Deque;
+	};
+
+	// Iterate from front to back
+	Iter Iterate() const
+	{
+		return Iter(this, true);
+	}
+
+	// Iterate from back to front
+	Iter IterateReverse() const
+	{
+		Iter iter(this, false);
+		iter._pos = m_count;
+		return iter;
+	}
+
+	bool GetNext(Iter& iter) const
+	{
+		if (iter._forward)
+		{
+			iter._pos++;
+			if (iter._pos >= m_count)
+				return false;
+		}
+		else
+		{
+			iter._pos--;
+			if (iter._pos < 0)
+				return false;
+		}
+
+		iter._value = Slot(iter._pos);
+		return true;
+	}
+
+private:
+	TStorage* Slot(int position) const
+	{
+		return m_data + ((m_head + position) & (m_capacity - 1));
+	}
+
+	void TakeFrom(Deque& other)
+	{
+		m_data = other.m_data;
+		m_capacity = other.m_capacity;
+		m_head = other.m_head;
+		m_count = other.m_count;
+
+		other.m_data = nullptr;
+		other.m_capacity = 0;
+		other.m_head = 0;
+		other.m_count = 0;
+	}
+
+	TStorage* m_data = nullptr;
+	int m_capacity = 0;
+	int m_head = 0;
+	int m_count = 0;
+};
+
+}
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <stdint.h>
+#include <type_traits>
+
+#include "StringSimd.h"
 
 namespace SimpleLib
 {
@@ -26,8 +29,15 @@ public:
             return false;
 
         p++;
-        while (IsWhiteSpace(p[0]))
-            p++;
+        if constexpr (std::is_same<T, char>::value)
+        {
+            p = StringSimd::SkipWhiteSpace(p);
+        }
+        else
+        {
+            while (IsWhiteSpace(p[0]))
+                p++;
+        }
 
         return true;
     }
@@ -109,6 +119,17 @@ public:
 
     // Parse an identifier
     static bool ParseIdentifier(const T*& p, StringCore<T>& str, const T* otherLeadChars = nullptr, const T* otherChars = nullptr)
+    {
+        StringView<T> view;
+        if (!ParseIdentifier(p, view, otherLeadChars, otherChars))
+            return false;
+
+        str = StringCore<T>(view);
+        return true;
+    }
+
+    // Parse an identifier, returning a view of it in the parsed text
+    static bool ParseIdentifier(const T*& p, StringView<T>& view, const T* otherLeadChars = nullptr, const T* otherChars = nullptr)
     {
         // Store start
         const T* start=p;
@@ -131,7 +152,7 @@ public:
         }
 
         // Setup return value
-        str = StringCore<T>(start, int(p - start));
+        view = StringView<T>(start, int(p - start));
 
         return true;
     }
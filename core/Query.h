@@ -0,0 +1,435 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+
+#include "Compare.h"
+#include "PlacedConstructor.h"
+#include "Allocator.h"
+
+namespace SimpleLib
+{
+
+template <typename T, typename TAllocator>
+class List;
+
+// Lazy, allocation free query pipelines over any collection iterator
+// following the usual Next()/Get() protocol:
+//
+//     List<int> result = list.AsQuery()
+//         .Where([](int x) { return x > 10; })
+//         .Select([](int x) { return x * 2; })
+//         .Take(100)
+//         .ToList();
+//
+// Each operator just wraps the previous stage's iterator (by value, along
+// with its callable) in a new one, so building a query allocates nothing
+// and does no work. Nothing runs until the query is iterated or one of
+// the terminal operations (ToList, Count, Any, ForEach) is called - at which
+// point all the stages run fused together in a single pass over the
+// source, with every callable a template parameter the compiler can
+// inline. Compare List::Filter/Map, which allocate a complete
+// intermediate list per stage and make an indirect Delegate call per
+// element.
+//
+// A Query is itself an iterator (Next()/Get()) positioned before the first
+// item, and copying one copies its position - so a query can be iterated
+// more than once by iterating copies of it (eg: through Iterate()). Like
+// the underlying collection iterators, a query is invalidated by
+// modifying the collection it's reading.
+//
+// Queries are created with AsQuery() on List, Map and Set. Map queries
+// yield QueryPair items (with Key and Value members).
+template <typename TIter>
+class Query;
+
+// Map entry yielded by Map::AsQuery()
+template <typename TKey, typename TValue>
+struct QueryPair
+{
+	TKey Key;
+	TValue Value;
+};
+
+// Storage for an optional lazily computed value (used to cache Select
+// results, so a Select followed by a Where doesn't invoke the selector
+// twice per item)
+template <typename T>
+class QuerySlot
+{
+public:
+	QuerySlot() {}
+	QuerySlot(const QuerySlot& other)
+	{
+		if (other.m_value)
+			Set(*other.m_value);
+	}
+	QuerySlot& operator=(const QuerySlot& other)
+	{
+		if (this != &other)
+		{
+			Clear();
+			if (other.m_value)
+				Set(*other.m_value);
+		}
+		return *this;
+	}
+	~QuerySlot()
+	{
+		Clear();
+	}
+
+	bool HasValue() const { return m_value != nullptr; }
+	const T& Get() const { return *m_value; }
+
+	const T& Set(const T& value)
+	{
+		Clear();
+		m_value = new ((void*)m_storage) T(value);
+		return *m_value;
+	}
+
+	void Clear()
+	{
+		if (m_value)
+		{
+			m_value->~T();
+			m_value = nullptr;
+		}
+	}
+
+private:
+	alignas(T) unsigned char m_storage[sizeof(T)];
+	T* m_value = nullptr;		// Points into m_storage when set
+};
+
+// Source stage over a contiguous array (List::AsQuery)
+template <typename TStorage, typename TArg>
+class QueryArraySource
+{
+public:
+	QueryArraySource(const TStorage* data, int count) :
+		m_data(data),
+		m_count(count)
+	{
+	}
+
+	bool Next() { return ++m_pos < m_count; }
+	TArg Get() { return static_cast<const TArg&>(m_data[m_pos]); }
+
+private:
+	const TStorage* m_data;
+	int m_count;
+	int m_pos = -1;
+};
+
+// Source stage over a Map iterator (Map::AsQuery)
+template <typename TMapIter, typename TKeyArg, typename TValueArg>
+class QueryMapSource
+{
+public:
+	QueryMapSource(const TMapIter& iter) : m_iter(iter) {}
+
+	bool Next() { return m_iter.Next(); }
+	QueryPair<TKeyArg, TValueArg> Get() { return { m_iter.GetKey(), m_iter.GetValue() }; }
+
+private:
+	TMapIter m_iter;
+};
+
+// Where(predicate) - items for which predicate(item) is true
+template <typename TIter, typename TPredicate>
+class QueryWhere
+{
+public:
+	QueryWhere(const TIter& iter, const TPredicate& predicate) : m_iter(iter), m_predicate(predicate) {}
+
+	bool Next()
+	{
+		while (m_iter.Next())
+		{
+			if (m_predicate(m_iter.Get()))
+				return true;
+		}
+		return false;
+	}
+
+	decltype(auto) Get() { return m_iter.Get(); }
+
+private:
+	TIter m_iter;
+	TPredicate m_predicate;
+};
+
+// Select(selector) - selector(item) for each item
+template <typename TIter, typename TSelector>
+class QuerySelect
+{
+public:
+	typedef typename std::decay<decltype(std::declval<TSelector&>()(std::declval<TIter&>().Get()))>::type TResult;
+
+	QuerySelect(const TIter& iter, const TSelector& selector) : m_iter(iter), m_selector(selector) {}
+
+	bool Next()
+	{
+		m_value.Clear();
+		return m_iter.Next();
+	}
+
+	const TResult& Get()
+	{
+		if (!m_value.HasValue())
+			return m_value.Set(m_selector(m_iter.Get()));
+		return m_value.Get();
+	}
+
+private:
+	TIter m_iter;
+	TSelector m_selector;
+	QuerySlot<TResult> m_value;
+};
+
+// Take(count) - at most the first count items
+template <typename TIter>
+class QueryTake
+{
+public:
+	QueryTake(const TIter& iter, int count) : m_iter(iter), m_remaining(count) {}
+
+	bool Next()
+	{
+		if (m_remaining <= 0)
+			return false;
+		m_remaining--;
+		return m_iter.Next();
+	}
+
+	decltype(auto) Get() { return m_iter.Get(); }
+
+private:
+	TIter m_iter;
+	int m_remaining;
+};
+
+// Skip(count) - all but the first count items
+template <typename TIter>
+class QuerySkip
+{
+public:
+	QuerySkip(const TIter& iter, int count) : m_iter(iter), m_skip(count) {}
+
+	bool Next()
+	{
+		for (; m_skip > 0; m_skip--)
+		{
+			if (!m_iter.Next())
+				return false;
+		}
+		return m_iter.Next();
+	}
+
+	decltype(auto) Get() { return m_iter.Get(); }
+
+private:
+	TIter m_iter;
+	int m_skip;
+};
+
+// Zip(other, combine) - combine(a, b) for pairs of items from two
+// sequences, stopping at the end of the shorter
+template <typename TIterA, typename TIterB, typename TCombine>
+class QueryZip
+{
+public:
+	QueryZip(const TIterA& a, const TIterB& b, const TCombine& combine) : m_a(a), m_b(b), m_combine(combine) {}
+
+	bool Next() { return m_a.Next() && m_b.Next(); }
+	decltype(auto) Get() { return m_combine(m_a.Get(), m_b.Get()); }
+
+private:
+	TIterA m_a;
+	TIterB m_b;
+	TCombine m_combine;
+};
+
+// The items of one GroupBy group - a copy of the source iterator that
+// starts at the group's first item and stops at the first item with a
+// different key
+template <typename TIter, typename TKeyFn, typename TKey>
+class QueryGroupItems
+{
+public:
+	QueryGroupItems(const TIter& iter, const TKeyFn& keyFn, const TKey& key) : m_iter(iter), m_keyFn(keyFn), m_key(key) {}
+
+	bool Next()
+	{
+		if (m_first)
+		{
+			m_first = false;
+			return true;
+		}
+		return m_iter.Next() && SDefaultCompare::AreEqual<TKey>(m_keyFn(m_iter.Get()), m_key);
+	}
+
+	decltype(auto) Get() { return m_iter.Get(); }
+
+private:
+	TIter m_iter;
+	TKeyFn m_keyFn;
+	TKey m_key;
+	bool m_first = true;
+};
+
+// One group yielded by GroupBy
+template <typename TKey, typename TItemsIter>
+struct QueryGroup
+{
+	TKey Key;
+	Query<TItemsIter> Items;
+};
+
+// GroupBy(keyFn) - groups of consecutive items with equal keys (so, like
+// Python's itertools.groupby, group sorted input to get one group per
+// distinct key). Each group is a QueryGroup with the group's Key and a
+// query over its Items, which reads straight from the source without
+// buffering anything.
+template <typename TIter, typename TKeyFn>
+class QueryGroupBy
+{
+public:
+	typedef typename std::decay<decltype(std::declval<TKeyFn&>()(std::declval<TIter&>().Get()))>::type TKey;
+	typedef QueryGroupItems<TIter, TKeyFn, TKey> TItemsIter;
+	typedef QueryGroup<TKey, TItemsIter> TGroup;
+
+	QueryGroupBy(const TIter& iter, const TKeyFn& keyFn) : m_iter(iter), m_keyFn(keyFn) {}
+
+	bool Next()
+	{
+		if (!m_started)
+		{
+			m_started = true;
+			m_has = m_iter.Next();
+		}
+		else
+		{
+			// Skip the rest of the current group
+			while (m_has && SDefaultCompare::AreEqual<TKey>(m_keyFn(m_iter.Get()), m_group.Get().Key))
+				m_has = m_iter.Next();
+		}
+
+		if (!m_has)
+		{
+			m_group.Clear();
+			return false;
+		}
+
+		TKey key = m_keyFn(m_iter.Get());
+		m_group.Set(TGroup{ key, Query<TItemsIter>(TItemsIter(m_iter, m_keyFn, key)) });
+		return true;
+	}
+
+	const TGroup& Get() { return m_group.Get(); }
+
+private:
+	TIter m_iter;
+	TKeyFn m_keyFn;
+	QuerySlot<TGroup> m_group;
+	bool m_started = false;
+	bool m_has = false;
+};
+
+template <typename TIter>
+class Query
+{
+public:
+	typedef typename std::decay<decltype(std::declval<TIter&>().Get())>::type TItem;
+
+	Query(const TIter& iter) : m_iter(iter) {}
+
+	// Iterator protocol
+	bool Next() { return m_iter.Next(); }
+	decltype(auto) Get() { return m_iter.Get(); }
+
+	// A fresh copy of this query (positioned wherever this one is)
+	Query Iterate() const
+	{
+		return *this;
+	}
+
+	template <typename TPredicate>
+	Query<QueryWhere<TIter, TPredicate>> Where(TPredicate predicate) const
+	{
+		return Query<QueryWhere<TIter, TPredicate>>(QueryWhere<TIter, TPredicate>(m_iter, predicate));
+	}
+
+	template <typename TSelector>
+	Query<QuerySelect<TIter, TSelector>> Select(TSelector selector) const
+	{
+		return Query<QuerySelect<TIter, TSelector>>(QuerySelect<TIter, TSelector>(m_iter, selector));
+	}
+
+	Query<QueryTake<TIter>> Take(int count) const
+	{
+		return Query<QueryTake<TIter>>(QueryTake<TIter>(m_iter, count));
+	}
+
+	Query<QuerySkip<TIter>> Skip(int count) const
+	{
+		return Query<QuerySkip<TIter>>(QuerySkip<TIter>(m_iter, count));
+	}
+
+	template <typename TOther, typename TCombine>
+	Query<QueryZip<TIter, TOther, TCombine>> Zip(const Query<TOther>& other, TCombine combine) const
+	{
+		return Query<QueryZip<TIter, TOther, TCombine>>(QueryZip<TIter, TOther, TCombine>(m_iter, other.m_iter, combine));
+	}
+
+	template <typename TKeyFn>
+	Query<QueryGroupBy<TIter, TKeyFn>> GroupBy(TKeyFn keyFn) const
+	{
+		return Query<QueryGroupBy<TIter, TKeyFn>>(QueryGroupBy<TIter, TKeyFn>(m_iter, keyFn));
+	}
+
+	// Run the query, collecting the results into a new list
+	template <typename TAllocator = TMalloc>
+	List<TItem, TAllocator> ToList() const
+	{
+		List<TItem, TAllocator> result;
+		for (TIter iter = m_iter; iter.Next(); )
+			result.Add(iter.Get());
+		return result;
+	}
+
+	// Run the query, counting the results
+	int Count() const
+	{
+		int count = 0;
+		for (TIter iter = m_iter; iter.Next(); )
+			count++;
+		return count;
+	}
+
+	// Check if the query produces any results (only runs it as far as the
+	// first one)
+	bool Any() const
+	{
+		TIter iter = m_iter;
+		return iter.Next();
+	}
+
+	// Run the query, invoking fn(item) for each result
+	template <typename TFn>
+	void ForEach(TFn fn) const
+	{
+		for (TIter iter = m_iter; iter.Next(); )
+			fn(iter.Get());
+	}
+
+private:
+	TIter m_iter;
+
+	template <typename TOther>
+	friend class Query;
+};
+
+}
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace SimpleLib
+{
+
+// Operations that a real-time thread (eg: an audio thread) must never
+// perform since they can take locks inside the heap or block
+enum class RealTimeViolationKind
+{
+	Alloc,				// TMalloc::Alloc or ReAlloc
+	Free,				// TMalloc::Free
+	MutexEnter,			// Mutex::Enter
+	SemaphoreWait,		// Semaphore::Wait with a non-zero timeout
+};
+
+// What to do when a real-time thread performs a violation
+enum class RealTimeMode
+{
+	Count,				// Just count it (see RealTimeGuard::GetViolationCount)
+	Trap,				// Count it and call the trap handler
+};
+
+// Details of a violation
+struct RealTimeViolation
+{
+	RealTimeViolationKind kind;
+
+	// Return address of the function that performed the operation (ie: an
+	// address in its caller) - the container or library call that
+	// allocated has often been inlined into the offending code, so this
+	// usually points right at it. For a full stack use Trap mode under a
+	// debugger.
+	void* callSite;
+};
+
+// Debug/profiling guard that catches real-time threads touching the heap,
+// taking a mutex or blocking on a semaphore.
+//
+// A thread marks itself real-time with Enter()/Leave() (or a RealTimeScope)
+// around its real-time work, eg: an audio callback. While marked, every
+// TMalloc allocation or free, Mutex::Enter and blocking Semaphore::Wait on
+// that thread is counted and, in Trap mode, reported to the trap handler
+// (which by default prints the violation and aborts, so a debugger stops
+// with the offending stack). Other threads are unaffected.
+//
+// The checks are only compiled in when _SIMPLELIB_REALTIME_GUARD is defined
+// (define it consistently for the whole program - it changes inline
+// functions) and cost a thread local read per operation when they are.
+// Without it, threads can still be marked but nothing is ever counted.
+//
+// Memory that doesn't come from TMalloc (eg: a HighWaterHeap, ObjectPool or
+// Arena that's been prewarmed) is deliberately not checked - that's the
+// point of those allocators.
+class RealTimeGuard
+{
+public:
+	static constexpr int kKindCount = 4;
+
+	// Whether the checks are compiled in
+	static constexpr bool IsEnabled()
+	{
+#ifdef _SIMPLELIB_REALTIME_GUARD
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	// Mark the calling thread as real-time. Calls nest - the mode of the
+	// outermost call applies and the violation counts are reset when the
+	// outermost call is made.
+	static void Enter(RealTimeMode mode = RealTimeMode::Count)
+	{
+		STATE& state = State();
+		if (state.depth++ == 0)
+		{
+			state.mode = mode;
+			state.total = 0;
+			for (int i = 0; i < kKindCount; i++)
+				state.counts[i] = 0;
+			state.first.callSite = nullptr;
+		}
+	}
+
+	// Unmark the calling thread (the counts are kept until the next Enter)
+	static void Leave()
+	{
+		STATE& state = State();
+		if (state.depth > 0)
+			state.depth--;
+	}
+
+	// Check if the calling thread is marked real-time
+	static bool IsRealTimeThread()
+	{
+		return State().depth > 0;
+	}
+
+	// Number of violations on the calling thread since it was marked
+	static int GetViolationCount()
+	{
+		return State().total;
+	}
+
+	// Number of violations of a particular kind on the calling thread
+	static int GetViolationCount(RealTimeViolationKind kind)
+	{
+		return State().counts[(int)kind];
+	}
+
+	// Get the first violation on the calling thread since it was marked.
+	// Returns false if there hasn't been one.
+	static bool GetFirstViolation(RealTimeViolation& violation)
+	{
+		STATE& state = State();
+		if (state.total == 0)
+			return false;
+		violation = state.first;
+		return true;
+	}
+
+	// Set the handler called for violations in Trap mode (nullptr restores
+	// the default, which prints the violation and aborts). The handler is
+	// called on the real-time thread, which is unmarked while it runs.
+	static void SetTrapHandler(void (*handler)(const RealTimeViolation& violation))
+	{
+		TrapHandler() = handler;
+	}
+
+	// Get a display name for a kind of violation
+	static const char* GetKindName(RealTimeViolationKind kind)
+	{
+		switch (kind)
+		{
+			case RealTimeViolationKind::Alloc: return "Alloc";
+			case RealTimeViolationKind::Free: return "Free";
+			case RealTimeViolationKind::MutexEnter: return "MutexEnter";
+			case RealTimeViolationKind::SemaphoreWait: return "SemaphoreWait";
+		}
+		return "Unknown";
+	}
+
+	// Called by the checked operations (see SIMPLELIB_REALTIME_CHECK)
+	static void Check(RealTimeViolationKind kind, void* callSite)
+	{
+		STATE& state = State();
+		if (state.depth > 0)
+			Report(state, kind, callSite);
+	}
+
+private:
+	struct STATE
+	{
+		int depth;
+		RealTimeMode mode;
+		int total;
+		int counts[kKindCount];
+		RealTimeViolation first;
+	};
+
+	static STATE& State()
+	{
+		static thread_local STATE state;
+		return state;
+	}
+
+	static void (*&TrapHandler())(const RealTimeViolation&)
+	{
+		static void (*handler)(const RealTimeViolation&) = nullptr;
+		return handler;
+	}
+
+	static void Report(STATE& state, RealTimeViolationKind kind, void* callSite)
+	{
+		RealTimeViolation violation;
+		violation.kind = kind;
+		violation.callSite = callSite;
+
+		if (state.total++ == 0)
+			state.first = violation;
+		state.counts[(int)kind]++;
+
+		if (state.mode != RealTimeMode::Trap)
+			return;
+
+		// Unmark the thread while the handler runs so it can allocate
+		int depth = state.depth;
+		state.depth = 0;
+		auto handler = TrapHandler();
+		if (handler)
+		{
+			handler(violation);
+		}
+		else
+		{
+			fprintf(stderr, "real-time violation: %s at %p\n", GetKindName(kind), callSite);
+			abort();
+		}
+		state.depth = depth;
+	}
+};
+
+// Marks the calling thread real-time for the lifetime of the scope
+class RealTimeScope
+{
+public:
+	RealTimeScope(RealTimeMode mode = RealTimeMode::Count)
+	{
+		RealTimeGuard::Enter(mode);
+	}
+	~RealTimeScope()
+	{
+		RealTimeGuard::Leave();
+	}
+
+	RealTimeScope(const RealTimeScope&) = delete;
+	RealTimeScope& operator=(const RealTimeScope&) = delete;
+};
+
+#ifdef _MSC_VER
+#define SIMPLELIB_RETURN_ADDRESS() _ReturnAddress()
+#else
+#define SIMPLELIB_RETURN_ADDRESS() __builtin_return_address(0)
+#endif
+
+// Placed at the start of operations that aren't real-time safe
+#ifdef _SIMPLELIB_REALTIME_GUARD
+#define SIMPLELIB_REALTIME_CHECK(kind) \
+	SimpleLib::RealTimeGuard::Check(SimpleLib::RealTimeViolationKind::kind, SIMPLELIB_RETURN_ADDRESS())
+#else
+#define SIMPLELIB_REALTIME_CHECK(kind) ((void)0)
+#endif
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+
+#include "PlacedConstructor.h"
+
+namespace SimpleLib
+{
+
+// Reference count policies for the shared, reference counted types
+// (StringCore's heap buffer and SharedPtr's control block).
+//
+// SRefCount is a plain int - cheapest, but a value (and every copy of it)
+// must stay on one thread. SAtomicRefCount lets copies of a value be made
+// and released on any thread, so an immutable string or object can be
+// handed between threads without a deep copy (see AtomicString and
+// AtomicSharedPtr). The value itself must still not be modified while
+// shared.
+
+// Plain (single thread) reference count
+struct SRefCount
+{
+	typedef int TCount;
+
+	// Set the count of a new block to 1
+	static void Init(TCount& count)
+	{
+		count = 1;
+	}
+
+	static void AddRef(TCount& count)
+	{
+		count++;
+	}
+
+	// Returns true when the last reference was released
+	static bool Release(TCount& count)
+	{
+		return --count == 0;
+	}
+};
+
+// Thread safe reference count
+struct SAtomicRefCount
+{
+	typedef std::atomic<int> TCount;
+
+	// Set the count of a new block to 1 (constructs the atomic, so may be
+	// used on raw memory)
+	static void Init(TCount& count)
+	{
+		new (&count) TCount(1);
+	}
+
+	// A new reference can only be made from an existing one, so there's
+	// nothing to order against
+	static void AddRef(TCount& count)
+	{
+		count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Releases must be ordered before the final one (which acquires them)
+	// so all other threads are done with the block before it's freed
+	static bool Release(TCount& count)
+	{
+		return count.fetch_sub(1, std::memory_order_acq_rel) == 1;
+	}
+};
+
+}
@@ -0,0 +1,403 @@
+#pragma once
+
+#include <string.h>
+#include <stdint.h>
+#include <type_traits>
+
+#include "Allocator.h"
+#include "Bit.h"
+
+// Vector instruction set used by the search primitives, picked at compile
+// time from the target architecture flags (/arch:AVX2, -mavx2 etc. - x64
+// always has SSE2). Define _SIMPLELIB_NO_SIMD to force the scalar code.
+#if !defined(_SIMPLELIB_NO_SIMD)
+	#if defined(__AVX2__)
+		#define _SIMPLELIB_SIMD_AVX2
+		#include <immintrin.h>
+	#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		#define _SIMPLELIB_SIMD_SSE2
+		#include <emmintrin.h>
+	#endif
+#endif
+
+namespace SimpleLib
+{
+
+// Search primitives used by List::IndexOf/Contains/BinarySearch (and
+// usable directly on any raw array).
+class Search
+{
+public:
+	// Types IndexOf can scan with vector compares - anything whose
+	// equality under the default comparer is either bitwise (integers,
+	// enums and pointers) or an IEEE compare (float, double)
+	template <typename T>
+	struct is_scannable
+	{
+		static constexpr bool value =
+			((std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value) &&
+				(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8)) ||
+			std::is_same<T, float>::value ||
+			std::is_same<T, double>::value;
+	};
+
+	// Index of the first element equal to value (with == semantics, so
+	// 0.0 matches -0.0 and NaN matches nothing), or -1.
+	//
+	// Compares a full vector of elements per instruction (AVX2 or SSE2),
+	// four vectors per loop iteration so the loop overhead and the "any
+	// match?" test are amortized over 64 (SSE2) or 128 (AVX2) bytes.
+	template <typename T>
+	static int IndexOf(const T* data, int count, T value)
+	{
+		static_assert(is_scannable<T>::value, "IndexOf requires an integral, enum, pointer, float or double element type");
+
+#if defined(_SIMPLELIB_SIMD_AVX2)
+		return VectorIndexOf<Avx2>(data, count, value);
+#elif defined(_SIMPLELIB_SIMD_SSE2)
+		return VectorIndexOf<Sse2>(data, count, value);
+#else
+		return ScalarIndexOf(data, 0, count, value);
+#endif
+	}
+
+	// Index of the first element for which less(element, key) is false
+	// (ie: the insertion point for key in a sorted array).
+	//
+	// Branchless: the loop always runs log2(count) iterations and the
+	// comparison result only feeds arithmetic, so there are no
+	// mispredicted branches - typically 2-3x quicker than a conventional
+	// binary search on arrays that fit in cache.
+	template <typename T, typename TKey, typename TLess>
+	static int LowerBound(const T* data, int count, const TKey& key, TLess less)
+	{
+		if (count == 0)
+			return 0;
+
+		const T* base = data;
+		int n = count;
+		while (n > 1)
+		{
+			int half = n / 2;
+
+			// (multiply rather than ?: - compilers often turn the latter
+			// back into a branch)
+			base += (int)less(base[half - 1], key) * half;
+			n -= half;
+		}
+		return (int)(base - data) + (less(*base, key) ? 1 : 0);
+	}
+
+private:
+	template <typename T>
+	static int ScalarIndexOf(const T* data, int start, int count, T value)
+	{
+		for (int i = start; i < count; i++)
+		{
+			if (data[i] == value)
+				return i;
+		}
+		return -1;
+	}
+
+	// Unsigned integer of the same size as T, for splatting T's bits
+	template <typename T>
+	using TBitsOf = typename std::conditional<sizeof(T) == 1, uint8_t,
+		typename std::conditional<sizeof(T) == 2, uint16_t,
+		typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type>::type>::type;
+
+#if defined(_SIMPLELIB_SIMD_SSE2) || defined(_SIMPLELIB_SIMD_AVX2)
+	// Instruction set wrappers for VectorIndexOf. Equal returns a vector
+	// with every byte of each matching lane set, Mask collapses that to a
+	// bitmask with one bit per byte.
+	struct Sse2
+	{
+		typedef __m128i V;
+		typedef uint32_t TMask;
+		static const int kBytes = 16;
+
+		static V Load(const void* p) { return _mm_loadu_si128((const __m128i*)p); }
+		static V Or(V a, V b) { return _mm_or_si128(a, b); }
+		static TMask Mask(V v) { return (TMask)_mm_movemask_epi8(v); }
+
+		template <typename T>
+		static V Splat(T value)
+		{
+			TBitsOf<T> bits;
+			memcpy(&bits, &value, sizeof(T));
+			if constexpr (sizeof(T) == 1)
+				return _mm_set1_epi8((char)bits);
+			else if constexpr (sizeof(T) == 2)
+				return _mm_set1_epi16((short)bits);
+			else if constexpr (sizeof(T) == 4)
+				return _mm_set1_epi32((int)bits);
+			else
+				return _mm_set_epi32((int)(bits >> 32), (int)bits, (int)(bits >> 32), (int)bits);
+		}
+
+		template <typename T>
+		static V Equal(V a, V b)
+		{
+			if constexpr (std::is_same<T, float>::value)
+				return _mm_castps_si128(_mm_cmpeq_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b)));
+			else if constexpr (std::is_same<T, double>::value)
+				return _mm_castpd_si128(_mm_cmpeq_pd(_mm_castsi128_pd(a), _mm_castsi128_pd(b)));
+			else if constexpr (sizeof(T) == 1)
+				return _mm_cmpeq_epi8(a, b);
+			else if constexpr (sizeof(T) == 2)
+				return _mm_cmpeq_epi16(a, b);
+			else if constexpr (sizeof(T) == 4)
+				return _mm_cmpeq_epi32(a, b);
+			else
+			{
+				// No 64-bit compare before SSE4.1 - both 32-bit halves
+				// must match
+				V eq = _mm_cmpeq_epi32(a, b);
+				return _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+			}
+		}
+	};
+#endif
+
+#if defined(_SIMPLELIB_SIMD_AVX2)
+	struct Avx2
+	{
+		typedef __m256i V;
+		typedef uint32_t TMask;
+		static const int kBytes = 32;
+
+		static V Load(const void* p) { return _mm256_loadu_si256((const __m256i*)p); }
+		static V Or(V a, V b) { return _mm256_or_si256(a, b); }
+		static TMask Mask(V v) { return (TMask)_mm256_movemask_epi8(v); }
+
+		template <typename T>
+		static V Splat(T value)
+		{
+			TBitsOf<T> bits;
+			memcpy(&bits, &value, sizeof(T));
+			if constexpr (sizeof(T) == 1)
+				return _mm256_set1_epi8((char)bits);
+			else if constexpr (sizeof(T) == 2)
+				return _mm256_set1_epi16((short)bits);
+			else if constexpr (sizeof(T) == 4)
+				return _mm256_set1_epi32((int)bits);
+			else
+				return _mm256_set1_epi64x((long long)bits);
+		}
+
+		template <typename T>
+		static V Equal(V a, V b)
+		{
+			if constexpr (std::is_same<T, float>::value)
+				return _mm256_castps_si256(_mm256_cmp_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b), _CMP_EQ_OQ));
+			else if constexpr (std::is_same<T, double>::value)
+				return _mm256_castpd_si256(_mm256_cmp_pd(_mm256_castsi256_pd(a), _mm256_castsi256_pd(b), _CMP_EQ_OQ));
+			else if constexpr (sizeof(T) == 1)
+				return _mm256_cmpeq_epi8(a, b);
+			else if constexpr (sizeof(T) == 2)
+				return _mm256_cmpeq_epi16(a, b);
+			else if constexpr (sizeof(T) == 4)
+				return _mm256_cmpeq_epi32(a, b);
+			else
+				return _mm256_cmpeq_epi64(a, b);
+		}
+	};
+#endif
+
+#if defined(_SIMPLELIB_SIMD_SSE2) || defined(_SIMPLELIB_SIMD_AVX2)
+	template <typename TIsa, typename T>
+	static int VectorIndexOf(const T* data, int count, T value)
+	{
+		typedef typename TIsa::V V;
+		const int perVector = TIsa::kBytes / (int)sizeof(T);
+		V needle = TIsa::template Splat<T>(value);
+
+		int i = 0;
+
+		// Four vectors at a time
+		for (; i + 4 * perVector <= count; i += 4 * perVector)
+		{
+			V e0 = TIsa::template Equal<T>(TIsa::Load(data + i), needle);
+			V e1 = TIsa::template Equal<T>(TIsa::Load(data + i + perVector), needle);
+			V e2 = TIsa::template Equal<T>(TIsa::Load(data + i + 2 * perVector), needle);
+			V e3 = TIsa::template Equal<T>(TIsa::Load(data + i + 3 * perVector), needle);
+			if (TIsa::Mask(TIsa::Or(TIsa::Or(e0, e1), TIsa::Or(e2, e3))) == 0)
+				continue;
+
+			// Which one?
+			V found[4] = { e0, e1, e2, e3 };
+			for (int v = 0; v < 4; v++)
+			{
+				uint32_t mask = TIsa::Mask(found[v]);
+				if (mask)
+					return i + v * perVector + Bit::TrailingZeros(mask) / (int)sizeof(T);
+			}
+		}
+
+		// Single vectors
+		for (; i + perVector <= count; i += perVector)
+		{
+			uint32_t mask = TIsa::Mask(TIsa::template Equal<T>(TIsa::Load(data + i), needle));
+			if (mask)
+				return i + Bit::TrailingZeros(mask) / (int)sizeof(T);
+		}
+
+		// Tail
+		return ScalarIndexOf(data, i, count, value);
+	}
+#endif
+};
+
+// A read-only copy of a sorted array, rearranged into Eytzinger (BFS,
+// "heap") order for fast repeated lower bound searches.
+//
+// Element k's children are at 2k and 2k+1, so the first few levels of the
+// tree share a handful of cache lines and the search can prefetch the
+// 16 possible nodes four levels ahead (16k to 16k+15) while it works on
+// the current one. The array is cache line aligned, so for power of two
+// sized elements those 16 nodes start a line and span as few lines as
+// they can (one for 4 byte elements, two for 8 byte ones). Much quicker
+// than binary search on arrays too big for the cache, at the cost of an
+// extra copy of the data plus an int per element (the original position,
+// so results are reported as indices into the sorted array).
+template <typename T, typename TAllocator = TMalloc>
+class EytzingerIndex : private AllocatorHolder<TAllocator>
+{
+	typedef AllocatorHolder<TAllocator> TAllocatorHolder;
+
+public:
+	EytzingerIndex()
+	{
+	}
+
+	explicit EytzingerIndex(const TAllocator& allocator)
+		: TAllocatorHolder(allocator)
+	{
+	}
+
+	using TAllocatorHolder::GetAllocator;
+
+	~EytzingerIndex()
+	{
+		Clear();
+	}
+
+	EytzingerIndex(const EytzingerIndex&) = delete;
+	EytzingerIndex& operator=(const EytzingerIndex&) = delete;
+
+	// Build the index from `count` elements sorted ascending by operator<.
+	// Returns false if memory couldn't be allocated.
+	bool Build(const T* sorted, int count)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "EytzingerIndex requires a trivially copyable element type");
+
+		Clear();
+		if (count == 0)
+			return true;
+
+		// 1-based, so element 0 is unused padding. Over-allocate so element
+		// 0 (and with it each group of 16 descendants) can be line aligned.
+		m_block = GetAllocator().Alloc((count + 1) * sizeof(T) + kCacheLine - 1);
+		m_rank = (int*)GetAllocator().Alloc((count + 1) * sizeof(int));
+		if (!m_block || !m_rank)
+		{
+			Clear();
+			return false;
+		}
+		m_data = (T*)(((uintptr_t)m_block + kCacheLine - 1) & ~(uintptr_t)(kCacheLine - 1));
+		m_count = count;
+
+		int next = 0;
+		Fill(sorted, next, 1);
+		return true;
+	}
+
+	void Clear()
+	{
+		if (m_block)
+			GetAllocator().Free(m_block);
+		if (m_rank)
+			GetAllocator().Free(m_rank);
+		m_block = nullptr;
+		m_data = nullptr;
+		m_rank = nullptr;
+		m_count = 0;
+	}
+
+	int GetCount() const
+	{
+		return m_count;
+	}
+
+	// Index in the original sorted array of the first element not less
+	// than key (or GetCount() if there's none)
+	int LowerBound(const T& key) const
+	{
+		int k = 1;
+		while (k <= m_count)
+		{
+			PrefetchDescendants(k);
+			k = 2 * k + (m_data[k] < key ? 1 : 0);
+		}
+
+		// Undo the final run of right turns (plus the last left turn) to
+		// get back to the node where the search last went left
+		k >>= Bit::TrailingZeros((uint32_t)~k) + 1;
+		return k == 0 ? m_count : m_rank[k];
+	}
+
+	// Check if the index contains an element equal to key
+	bool Contains(const T& key) const
+	{
+		int k = 1;
+		while (k <= m_count)
+		{
+			PrefetchDescendants(k);
+			k = 2 * k + (m_data[k] < key ? 1 : 0);
+		}
+		k >>= Bit::TrailingZeros((uint32_t)~k) + 1;
+		return k != 0 && !(key < m_data[k]);
+	}
+
+private:
+	static constexpr size_t kCacheLine = 64;
+
+	void* m_block = nullptr;
+	T* m_data = nullptr;
+	int* m_rank = nullptr;
+	int m_count = 0;
+
+	// Prefetch node k's descendants four levels down, if it has any (the
+	// pointer mustn't be formed past the end of the array)
+	void PrefetchDescendants(int k) const
+	{
+		size_t first = (size_t)k * 16;
+		if (first <= (size_t)m_count)
+			Prefetch(m_data + first);
+	}
+
+	// In-order walk of the implicit tree, handing out sorted elements
+	void Fill(const T* sorted, int& next, int k)
+	{
+		if (k > m_count)
+			return;
+		Fill(sorted, next, 2 * k);
+		m_data[k] = sorted[next];
+		m_rank[k] = next;
+		next++;
+		Fill(sorted, next, 2 * k + 1);
+	}
+
+	static void Prefetch(const void* p)
+	{
+#if defined(_SIMPLELIB_SIMD_SSE2) || defined(_SIMPLELIB_SIMD_AVX2)
+		_mm_prefetch((const char*)p, _MM_HINT_T0);
+#elif defined(__GNUC__)
+		__builtin_prefetch(p);
+#else
+		(void)p;
+#endif
+	}
+};
+
+}
@@ -0,0 +1,460 @@
+#pragma once
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <utility>
+
+#include "Compare.h"
+#include "Semantics.h"
+#include "PlacedConstructor.h"
+#include "Bit.h"
+
+#include "Allocator.h"
+
+namespace SimpleLib
+{
+
+// A list whose elements never move.
+//
+// Elements are stored in chunks that double in size - the first chunk
+// holds kFirstChunkSize elements, the next twice that and so on - so
+// growing just allocates another chunk and never copies (or invalidates
+// pointers to) existing elements. Indexing is still O(1): the chunk an
+// index falls in is found from its highest set bit.
+//
+// Use it in place of List<OwnedPtr<T>> when objects need stable addresses -
+// the objects are stored inline rather than in an allocation each. Pointers
+// to elements remain valid until the element is removed, or shifted by
+// InsertAt/RemoveAt (which, as for List, move every later element).
+//
+// The API mirrors List, minus the operations that rely on the elements
+// being contiguous (GetBuffer, sorting, binary search). Use GetChunk()
+// for bulk access.
+template <typename T, typename TAllocator = TMalloc>
+class SegmentedList : private AllocatorHolder<TAllocator>
+{
+	typedef typename get_semantics<T>::TSemantics TSemantics;
+	typedef typename TSemantics::TArg TArg;
+	typedef typename TSemantics::TStorage TStorage;
+	typedef AllocatorHolder<TAllocator> TAllocatorHolder;
+
+public:
+	// Number of elements in the first chunk (log2)
+	static const int kFirstChunkShift = 4;
+	static const int kFirstChunkSize = 1 << kFirstChunkShift;
+
+	// Enough chunks for any int capacity
+	static const int kMaxChunks = 31 - kFirstChunkShift;
+
+	// Constructor
+	SegmentedList()
+	{
+		memset(m_chunks, 0, sizeof(m_chunks));
+	}
+
+	// Constructor with a specific allocator instance
+	explicit SegmentedList(const TAllocator& allocator)
+		: TAllocatorHolder(allocator)
+	{
+		memset(m_chunks, 0, sizeof(m_chunks));
+	}
+
+	// Destructor
+	virtual ~SegmentedList()
+	{
+		Clear();
+		FreeChunks(0);
+	}
+
+	// Get the allocator this list allocates from
+	using TAllocatorHolder::GetAllocator;
+
+	// No copy
+	SegmentedList(const SegmentedList&) = delete;
+	SegmentedList& operator=(const SegmentedList&) = delete;
+
+	// Move (the chunks, and so the elements' addresses, move with it)
+	SegmentedList(SegmentedList&& other)
+		: TAllocatorHolder(other.GetAllocator())
+	{
+		TakeFrom(other);
+	}
+
+	// Move
+	SegmentedList& operator=(SegmentedList&& other)
+	{
+		if (this == &other)
+			return *this;
+
+		Clear();
+		FreeChunks(0);
+		this->SetAllocator(other.GetAllocator());
+		TakeFrom(other);
+		return *this;
+	}
+
+	// Ensure allocated capacity is at least requiredCapacity
+	bool SetCapacity(int requiredCapacity)
+	{
+		while (m_capacity < requiredCapacity)
+		{
+			if (!AddChunk())
+				return false;
+		}
+		return true;
+	}
+
+	// Get the number of elements that fit in the allocated chunks
+	int GetCapacity() const
+	{
+		return m_capacity;
+	}
+
+	// Release chunks that hold no elements
+	void FreeExtra()
+	{
+		int used = m_count == 0 ? 0 : ChunkOf(m_count - 1) + 1;
+		FreeChunks(used);
+	}
+
+	// Add
+	int Add(TArg val)
+	{
+		TStorage* p = AddRaw();
+		if (!p)
+			return -1;
+		Constructor(p, val);
+		return m_count - 1;
+	}
+
+	// Construct an element in place from `args` at the end of the list,
+	// returning a pointer to it (or nullptr if memory couldn't be
+	// allocated). The pointer stays valid until the element is removed.
+	template <typename... TArgs>
+	TStorage* Emplace(TArgs&&... args)
+	{
+		TStorage* p = AddRaw();
+		if (!p)
+			return nullptr;
+		return new ((void*)p) TStorage(std::forward<TArgs>(args)...);
+	}
+
+	// InsertAt (moves every later element up one slot)
+	bool InsertAt(int position, TArg val)
+	{
+		assert(position >= 0);
+		assert(position <= GetCount());
+
+		TStorage* p = AddRaw();
+		if (!p)
+			return false;
+
+		for (int i = m_count - 1; i > position; i--)
+			memcpy((void*)Slot(i), (void*)Slot(i - 1), sizeof(TStorage));
+
+		Constructor(Slot(position), val);
+		return true;
+	}
+
+	// Replace the element at a position
+	void ReplaceAt(int position, TArg val)
+	{
+		assert(position >= 0);
+		assert(position < GetCount());
+
+		Destructor(Slot(position));
+		Constructor(Slot(position), val);
+	}
+
+	// Swap two elements
+	void Swap(int posA, int posB)
+	{
+		assert(posA >= 0 && posA < GetCount());
+		assert(posB >= 0 && posB < GetCount());
+
+		if (posA == posB)
+			return;
+
+		char temp[sizeof(TStorage)];
+		memcpy(temp, (void*)Slot(posA), sizeof(TStorage));
+		memcpy((void*)Slot(posA), (void*)Slot(posB), sizeof(TStorage));
+		memcpy((void*)Slot(posB), temp, sizeof(TStorage));
+	}
+
+	// Remove a particular item
+	int Remove(TArg val)
+	{
+		int pos = IndexOf(val);
+		if (pos >= 0)
+			RemoveAt(pos);
+		return pos;
+	}
+
+	// RemoveAt (moves every later element down one slot)
+	void RemoveAt(int position)
+	{
+		RemoveAt(position, 1);
+	}
+
+	// Remove a range of elements
+	void RemoveAt(int position, int count)
+	{
+		if (count == 0)
+			return;
+
+		assert(position >= 0);
+		assert(position + count <= GetCount());
+
+		for (int i = 0; i < count; i++)
+			Destructor(Slot(position + i));
+		Close(position, count);
+	}
+
+	// Remove an element without destructing it, returning it
+	TArg DetachAt(int position)
+	{
+		assert(position >= 0);
+		assert(position < GetCount());
+
+		TArg val = TSemantics::Detach(*Slot(position));
+		Close(position, 1);
+		return val;
+	}
+
+	// Remove all elements (keeps the chunks for reuse)
+	void Clear()
+	{
+		for (int i = m_count - 1; i >= 0; i--)
+			Destructor(Slot(i));
+		m_count = 0;
+	}
+
+	// GetAt
+	TArg GetAt(int position) const
+	{
+		assert(position >= 0);
+		assert(position < GetCount());
+
+		return *Slot(position);
+	}
+
+	// Get reference to element
+	const TStorage& GetRefAt(int position) const
+	{
+		assert(position >= 0);
+		assert(position < GetCount());
+
+		return *Slot(position);
+	}
+
+	// Get reference to element
+	TStorage& GetRefAt(int position)
+	{
+		assert(position >= 0);
+		assert(position < GetCount());
+
+		return *Slot(position);
+	}
+
+	// operator[]
+	TArg operator[](int position) const
+	{
+		return GetAt(position);
+	}
+
+	// GetCount
+	int GetCount() const
+	{
+		return m_count;
+	}
+
+	// IsEmpty
+	bool IsEmpty() const
+	{
+		return m_count == 0;
+	}
+
+	// Get the number of chunks holding elements
+	int GetChunkCount() const
+	{
+		return m_count == 0 ? 0 : ChunkOf(m_count - 1) + 1;
+	}
+
+	// Get the elements in a chunk (for bulk access) and how many there are
+	TStorage* GetChunk(int chunk, int& count) const
+	{
+		assert(chunk >= 0 && chunk < GetChunkCount());
+
+		int start = ChunkStart(chunk);
+		int remaining = m_count - start;
+		count = remaining < ChunkSize(chunk) ? remaining : ChunkSize(chunk);
+		return m_chunks[chunk];
+	}
+
+	// Find index of an item (linear)
+	template <typename TCompare = SDefaultCompare>
+	int IndexOf(TArg val, int startAfter = -1) const
+	{
+		for (int i = startAfter + 1; i < m_count; i++)
+		{
+			if (TCompare::AreEqual(static_cast<TArg>(*Slot(i)), val))
+				return i;
+		}
+		return -1;
+	}
+
+	// Check if the list contains an item
+	bool Contains(TArg val) const
+	{
+		return IndexOf(val) >= 0;
+	}
+
+	// Push
+	void Push(TArg val)
+	{
+		Add(val);
+	}
+
+	// Pop
+	TArg Pop()
+	{
+		return DetachAt(GetCount() - 1);
+	}
+
+	class Iter
+	{
+	public:
+		TArg Get() { return *_value; };
+
+		bool Next() { return _owner->GetNext(*this); }
+
+	private:
+		Iter(const SegmentedList* owner, bool forward)
+		{
+			_owner = owner;
+			_forward = forward;
+		}
+
+		const TStorage* _value = nullptr;
+		const SegmentedList* _owner;
+		int _pos = -1;
+		bool _forward = true;
+		friend class SegmentedList;
+	};
+
+	Iter Iterate() const
+	{
+		return Iter(this, true);
+	}
+
+	Iter IterateReverse() const
+	{
+		Iter iter(this, false);
+		iter._pos = m_count;
+		return iter;
+	}
+
+	bool GetNext(Iter& iter) const
+	{
+		if (iter._forward)
+		{
+			iter._pos++;
+			if (iter._pos >= m_count)
+				return false;
+		}
+		else
+		{
+			iter._pos--;
+			if (iter._pos < 0)
+				return false;
+		}
+
+		iter._value = Slot(iter._pos);
+		return true;
+	}
+
+private:
+	// Chunk `k` holds kFirstChunkSize << k elements, starting at index
+	// kFirstChunkSize * (2^k - 1)
+	static int ChunkOf(int index)
+	{
+		return Bit::HighestBit((uint32_t)index + kFirstChunkSize) - kFirstChunkShift;
+	}
+
+	static int ChunkStart(int chunk)
+	{
+		return (int)(((uint32_t)kFirstChunkSize << chunk) - kFirstChunkSize);
+	}
+
+	static int ChunkSize(int chunk)
+	{
+		return kFirstChunkSize << chunk;
+	}
+
+	TStorage* Slot(int index) const
+	{
+		uint32_t n = (uint32_t)index + kFirstChunkSize;
+		int chunk = Bit::HighestBit(n) - kFirstChunkShift;
+		return m_chunks[chunk] + (n - ((uint32_t)kFirstChunkSize << chunk));
+	}
+
+	// Make room for one more element at the end, returning the raw slot
+	TStorage* AddRaw()
+	{
+		if (m_count == m_capacity && !AddChunk())
+			return nullptr;
+		return Slot(m_count++);
+	}
+
+	bool AddChunk()
+	{
+		int chunk = m_capacity == 0 ? 0 : ChunkOf(m_capacity);
+		if (chunk >= kMaxChunks)
+			return false;
+
+		TStorage* p = (TStorage*)GetAllocator().Alloc(ChunkSize(chunk) * sizeof(TStorage));
+		if (!p)
+			return false;
+
+		m_chunks[chunk] = p;
+		m_capacity += ChunkSize(chunk);
+		return true;
+	}
+
+	// Free chunks from `first` on
+	void FreeChunks(int first)
+	{
+		for (int i = first; i < kMaxChunks && m_chunks[i]; i++)
+		{
+			GetAllocator().Free(m_chunks[i]);
+			m_chunks[i] = nullptr;
+		}
+		m_capacity = first == 0 ? 0 : ChunkStart(first);
+	}
+
+	// Move the elements after a removed range down to close the gap
+	void Close(int position, int count)
+	{
+		for (int i = position + count; i < m_count; i++)
+			memcpy((void*)Slot(i - count), (void*)Slot(i), sizeof(TStorage));
+		m_count -= count;
+	}
+
+	void TakeFrom(SegmentedList& other)
+	{
+		memcpy(m_chunks, other.m_chunks, sizeof(m_chunks));
+		m_count = other.m_count;
+		m_capacity = other.m_capacity;
+
+		memset(other.m_chunks, 0, sizeof(other.m_chunks));
+		other.m_count = 0;
+		other.m_capacity = 0;
+	}
+
+	TStorage* m_chunks[kMaxChunks];
+	int m_count = 0;
+	int m_capacity = 0;
+};
+
+}
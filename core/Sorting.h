@@ -0,0 +1,861 @@
+#pragma once
+
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+#include <type_traits>
+
+#include "Allocator.h"
+
+namespace SimpleLib
+{
+
+// Header-only sorting algorithms used by List::Sort/StableSort/RadixSort
+// (and usable directly on any raw array).
+//
+// Comparisons are made through a `less(const T& a, const T& b)` callable
+// that's a template parameter rather than a function pointer, so lambdas
+// and SDefaultCompare based comparers inline straight into the sort loop
+// (qsort_r costs two indirect calls per comparison).
+//
+// Elements are relocated bitwise (memcpy of sizeof(T), which the compiler
+// turns into plain register moves) rather than through copy/move
+// constructors - the same convention List already uses when it memmove's
+// elements around in InsertAt/RemoveAt - so move-only storage types like
+// OwnedPtr<T> sort fine and no constructor/destructor is ever run.
+class Sorting
+{
+public:
+	// Sort `count` elements in place. Not stable.
+	//
+	// Pattern-defeating quicksort (after Orson Peters' pdqsort): median of
+	// 3 (or Tukey's ninther for larger partitions) pivot selection,
+	// insertion sort for small partitions, detection of already
+	// partitioned ranges (so sorted, reverse sorted and mostly sorted input
+	// runs in near linear time), three-way handling of runs of equal
+	// elements, and a heapsort fallback if too many unbalanced partitions
+	// are seen - guaranteeing O(n log n) worst case.
+	template <typename T, typename TLess>
+	static void Sort(T* data, int count, TLess less)
+	{
+		if (count < 2)
+			return;
+		SortLoop(data, data + count, less, Log2(count), true);
+	}
+
+	// Sort `count` elements in place, preserving the relative order of
+	// elements that compare equal.
+	//
+	// Bottom-up merge sort over insertion sorted runs, ping-ponging
+	// between the data and a scratch buffer of `count` elements (allocated
+	// from `allocator`). Returns false (with the data left unsorted, but
+	// intact) if the scratch buffer couldn't be allocated.
+	template <typename TAllocator = TMalloc, typename T, typename TLess>
+	static bool StableSort(T* data, int count, TLess less, TAllocator allocator = TAllocator())
+	{
+		if (count < 2)
+			return true;
+
+		// Short enough to just insertion sort?
+		if (count <= kStableRunLength)
+		{
+			InsertionSort(data, data + count, less);
+			return true;
+		}
+
+		T* scratch = (T*)allocator.Alloc(count * sizeof(T));
+		if (!scratch)
+			return false;
+
+		StableSort(data, count, less, scratch);
+
+		allocator.Free(scratch);
+		return true;
+	}
+
+	// StableSort using a caller supplied (uninitialized) scratch buffer of
+	// at least `count` elements
+	template <typename T, typename TLess>
+	static void StableSort(T* data, int count, TLess less, T* scratch)
+	{
+		if (count <= kStableRunLength)
+		{
+			InsertionSort(data, data + count, less);
+			return;
+		}
+
+		// Sort fixed length runs
+		for (int i = 0; i < count; i += kStableRunLength)
+		{
+			int end = i + kStableRunLength < count ? i + kStableRunLength : count;
+			InsertionSort(data + i, data + end, less);
+		}
+
+		// Merge runs of doubling width, alternating direction between the
+		// data and scratch buffers
+		T* src = data;
+		T* dst = scratch;
+		for (int width = kStableRunLength; width < count; width *= 2)
+		{
+			for (int lo = 0; lo < count; lo += 2 * width)
+			{
+				int mid = lo + width < count ? lo + width : count;
+				int hi = lo + 2 * width < count ? lo + 2 * width : count;
+				Merge(src + lo, src + mid, src + hi, dst + lo, less);
+			}
+
+			T* temp = src;
+			src = dst;
+			dst = temp;
+		}
+
+		// Make sure the final result ends up back in the caller's buffer
+		if (src != data)
+			memcpy((void*)data, (const void*)src, count * sizeof(T));
+	}
+
+	// Maps a radix sort key to an unsigned integer of the same size whose
+	// natural order matches the key's: signed integers have their sign bit
+	// flipped, floating point values have their sign bit flipped if positive
+	// or all bits flipped if negative (so -0.0 sorts before +0.0, and NaNs
+	// sort to the ends according to their sign bit) and pointers sort by
+	// address.
+	template <typename TKey>
+	struct RadixKey
+	{
+		static_assert(std::is_integral<TKey>::value || std::is_floating_point<TKey>::value || std::is_pointer<TKey>::value,
+			"Radix sort keys must be integral, floating point or pointer types");
+		static_assert(sizeof(TKey) <= 8, "Radix sort keys must be at most 64 bits");
+
+		typedef typename std::conditional<sizeof(TKey) == 1, uint8_t,
+			typename std::conditional<sizeof(TKey) == 2, uint16_t,
+			typename std::conditional<sizeof(TKey) == 4, uint32_t, uint64_t>::type>::type>::type TBits;
+
+		static TBits ToBits(TKey key)
+		{
+			const TBits signBit = (TBits)((TBits)1 << (sizeof(TBits) * 8 - 1));
+			if constexpr (std::is_pointer<TKey>::value)
+			{
+				return (TBits)(uintptr_t)key;
+			}
+			else if constexpr (std::is_floating_point<TKey>::value)
+			{
+				TBits bits;
+				memcpy(&bits, &key, sizeof(bits));
+				return (bits & signBit) ? (TBits)~bits : (TBits)(bits | signBit);
+			}
+			else if constexpr (std::is_signed<TKey>::value)
+			{
+				return (TBits)((TBits)key ^ signBit);
+			}
+			else
+			{
+				return (TBits)key;
+			}
+		}
+
+		// Extract one 8-bit digit (0 = least significant)
+		static int Digit(TBits bits, int pass)
+		{
+			return (int)((bits >> (pass * 8)) & 0xFF);
+		}
+	};
+
+	// Sort `count` elements by the integral, floating point or pointer key
+	// returned by `key(const T&)`, preserving the relative order of
+	// elements with equal keys.
+	//
+	// LSD radix sort with 8-bit digits. A single up-front pass over the
+	// data builds the histograms for every digit, and any digit that's the
+	// same for every element (eg: the high bytes of small integers, or all
+	// of them for already uniform data) is skipped without touching the
+	// data again. Each remaining digit is one scatter between the data and
+	// a `count` element scratch buffer allocated from `allocator`. Returns
+	// false (with the data left unsorted, but intact) if the scratch buffer
+	// couldn't be allocated.
+	//
+	// This is O(n * key size) with no comparisons at all, so it beats Sort
+	// for large arrays of small keys - but the scatter passes are cache
+	// unfriendly and each costs a full copy of the data, so comparison
+	// sorts win for small arrays, large elements and wide keys with little
+	// shared structure. Arrays of up to kRadixSortThreshold elements are
+	// just insertion sorted.
+	template <typename TAllocator = TMalloc, typename T, typename TKeyFn>
+	static bool RadixSort(T* data, int count, TKeyFn key, TAllocator allocator = TAllocator())
+	{
+		typedef RadixKey<typename std::decay<decltype(key(*data))>::type> TRadix;
+		typedef typename TRadix::TBits TBits;
+		const int passes = (int)sizeof(TBits);
+
+		if (count < 2)
+			return true;
+
+		if (count <= kRadixSortThreshold)
+		{
+			auto less = [&](const T& a, const T& b) {
+				return TRadix::ToBits(key(a)) < TRadix::ToBits(key(b));
+			};
+			InsertionSort(data, data + count, less);
+			return true;
+		}
+
+		// Histogram every digit in one pass
+		int counts[sizeof(TBits)][256];
+		memset(counts, 0, sizeof(counts));
+		for (int i = 0; i < count; i++)
+		{
+			TBits bits = TRadix::ToBits(key(data[i]));
+			for (int pass = 0; pass < passes; pass++)
+				counts[pass][TRadix::Digit(bits, pass)]++;
+		}
+
+		// Work out which digits actually vary
+		TBits first = TRadix::ToBits(key(data[0]));
+		bool anyPass = false;
+		bool skip[sizeof(TBits)];
+		for (int pass = 0; pass < passes; pass++)
+		{
+			skip[pass] = counts[pass][TRadix::Digit(first, pass)] == count;
+			if (!skip[pass])
+				anyPass = true;
+		}
+		if (!anyPass)
+			return true;
+
+		T* scratch = (T*)allocator.Alloc(count * sizeof(T));
+		if (!scratch)
+			return false;
+
+		T* src = data;
+		T* dst = scratch;
+		for (int pass = 0; pass < passes; pass++)
+		{
+			if (skip[pass])
+				continue;
+
+			// Counts to starting offsets
+			int* offsets = counts[pass];
+			int total = 0;
+			for (int digit = 0; digit < 256; digit++)
+			{
+				int n = offsets[digit];
+				offsets[digit] = total;
+				total += n;
+			}
+
+			// Scatter (in order, which is what keeps it stable)
+			for (int i = 0; i < count; i++)
+			{
+				int digit = TRadix::Digit(TRadix::ToBits(key(src[i])), pass);
+				Relocate(dst + offsets[digit]++, src + i);
+			}
+
+			T* temp = src;
+			src = dst;
+			dst = temp;
+		}
+
+		// Make sure the final result ends up back in the caller's buffer
+		if (src != data)
+			memcpy((void*)data, (const void*)src, count * sizeof(T));
+
+		allocator.Free(scratch);
+		return true;
+	}
+
+	// Arrays of up to this many elements are insertion sorted by RadixSort
+	static const int kRadixSortThreshold = 64;
+
+private:
+	// Partitions smaller than this are insertion sorted
+	static const int kInsertionSortThreshold = 24;
+
+	// Partitions larger than this use Tukey's ninther for pivot selection
+	static const int kNintherThreshold = 128;
+
+	// Maximum number of element moves a partial insertion sort makes before
+	// giving up on the "already nearly sorted" fast path
+	static const int kPartialInsertionSortLimit = 8;
+
+	// Length of the insertion sorted runs StableSort starts merging from
+	static const int kStableRunLength = 16;
+
+	// Number of elements examined per block by the branchless partition
+	static const int kPartitionBlockSize = 64;
+
+	// Uninitialized, correctly aligned storage for one element held
+	// outside the array during a relocation
+	template <typename T>
+	struct Hole
+	{
+		alignas(T) unsigned char bytes[sizeof(T)];
+
+		T& Get() { return *(T*)bytes; }
+	};
+
+	template <typename T>
+	static void Relocate(T* dest, const T* src)
+	{
+		memcpy((void*)dest, (const void*)src, sizeof(T));
+	}
+
+	template <typename T>
+	static void SwapItems(T* a, T* b)
+	{
+		Hole<T> temp;
+		Relocate(&temp.Get(), a);
+		Relocate(a, b);
+		Relocate(b, &temp.Get());
+	}
+
+	static int Log2(int n)
+	{
+		int log = 0;
+		while (n >>= 1)
+			log++;
+		return log;
+	}
+
+	// Stable insertion sort of [begin, end)
+	template <typename T, typename TLess>
+	static void InsertionSort(T* begin, T* end, TLess& less)
+	{
+		if (begin == end)
+			return;
+
+		for (T* cur = begin + 1; cur != end; cur++)
+		{
+			T* sift = cur;
+			T* sift1 = cur - 1;
+
+			if (less(*sift, *sift1))
+			{
+				Hole<T> temp;
+				Relocate(&temp.Get(), sift);
+
+				do
+				{
+					Relocate(sift--, sift1);
+				} while (sift != begin && less(temp.Get(), *--sift1));
+
+				Relocate(sift, &temp.Get());
+			}
+		}
+	}
+
+	// Insertion sort of [begin, end) that relies on the element before
+	// begin being <= every element in the range (ie: a previously placed
+	// pivot) to act as a sentinel, saving the bounds check
+	template <typename T, typename TLess>
+	static void UnguardedInsertionSort(T* begin, T* end, TLess& less)
+	{
+		if (begin == end)
+			return;
+
+		for (T* cur = begin + 1; cur != end; cur++)
+		{
+			T* sift = cur;
+			T* sift1 = cur - 1;
+
+			if (less(*sift, *sift1))
+			{
+				Hole<T> temp;
+				Relocate(&temp.Get(), sift);
+
+				do
+				{
+					Relocate(sift--, sift1);
+				} while (less(temp.Get(), *--sift1));
+
+				Relocate(sift, &temp.Get());
+			}
+		}
+	}
+
+	// Attempts an insertion sort of [begin, end), giving up (and returning
+	// false) once more than kPartialInsertionSortLimit elements have been
+	// moved. The range is always left as a valid permutation.
+	template <typename T, typename TLess>
+	static bool PartialInsertionSort(T* begin, T* end, TLess& less)
+	{
+		if (begin == end)
+			return true;
+
+		int limit = 0;
+		for (T* cur = begin + 1; cur != end; cur++)
+		{
+			if (limit > kPartialInsertionSortLimit)
+				return false;
+
+			T* sift = cur;
+			T* sift1 = cur - 1;
+
+			if (less(*sift, *sift1))
+			{
+				Hole<T> temp;
+				Relocate(&temp.Get(), sift);
+
+				do
+				{
+					Relocate(sift--, sift1);
+				} while (sift != begin && less(temp.Get(), *--sift1));
+
+				Relocate(sift, &temp.Get());
+				limit += (int)(cur - sift);
+			}
+		}
+
+		return true;
+	}
+
+	template <typename T, typename TLess>
+	static void Sort2(T* a, T* b, TLess& less)
+	{
+		if (less(*b, *a))
+			SwapItems(a, b);
+	}
+
+	template <typename T, typename TLess>
+	static void Sort3(T* a, T* b, T* c, TLess& less)
+	{
+		Sort2(a, b, less);
+		Sort2(b, c, less);
+		Sort2(a, b, less);
+	}
+
+	// Partitions [begin, end) around the pivot *begin. Elements equal to
+	// the pivot go to the right. Returns the pivot's final position, with
+	// alreadyPartitioned set if no elements needed to be swapped.
+	template <typename T, typename TLess>
+	static T* PartitionRight(T* begin, T* end, TLess& less, bool& alreadyPartitioned)
+	{
+		Hole<T> pivot;
+		Relocate(&pivot.Get(), begin);
+
+		T* first = begin;
+		T* last = end;
+
+		// Find the first element >= pivot (the median of 3 pivot selection
+		// guarantees one exists)
+		while (less(*++first, pivot.Get()))
+		{
+		}
+
+		// Find the last element < pivot. If nothing preceded first there's
+		// no sentinel guaranteeing one exists, so bounds check.
+		if (first - 1 == begin)
+		{
+			while (first < last && !less(*--last, pivot.Get()))
+			{
+			}
+		}
+		else
+		{
+			while (!less(*--last, pivot.Get()))
+			{
+			}
+		}
+
+		alreadyPartitioned = first >= last;
+
+		// Swap out of place pairs. The first pair found above guarantees
+		// the inner loops stay in bounds.
+		while (first < last)
+		{
+			SwapItems(first, last);
+			while (less(*++first, pivot.Get()))
+			{
+			}
+			while (!less(*--last, pivot.Get()))
+			{
+			}
+		}
+
+		// Put the pivot in its final place
+		T* pivotPos = first - 1;
+		Relocate(begin, pivotPos);
+		Relocate(pivotPos, &pivot.Get());
+		return pivotPos;
+	}
+
+	// Moves the `num` out of place pairs recorded in the offset blocks
+	// across to the other side
+	template <typename T>
+	static void SwapOffsets(T* first, T* last, const uint8_t* offsetsL, const uint8_t* offsetsR, int num, bool useSwaps)
+	{
+		if (useSwaps)
+		{
+			// Proper pairwise swaps are needed for descending input to
+			// stay O(n)
+			for (int i = 0; i < num; i++)
+				SwapItems(first + offsetsL[i], last - offsetsR[i]);
+		}
+		else if (num > 0)
+		{
+			// Otherwise a cyclic permutation halves the number of moves
+			T* l = first + offsetsL[0];
+			T* r = last - offsetsR[0];
+			Hole<T> temp;
+			Relocate(&temp.Get(), l);
+			Relocate(l, r);
+			for (int i = 1; i < num; i++)
+			{
+				l = first + offsetsL[i];
+				Relocate(r, l);
+				r = last - offsetsR[i];
+				Relocate(l, r);
+			}
+			Relocate(r, &temp.Get());
+		}
+	}
+
+	// Same contract as PartitionRight, but for cheap to compare keys
+	// (arithmetic and pointer types). Rather than swapping each out of
+	// place pair as it's found (a hard to predict branch per element on
+	// random data) it records the offsets of out of place elements from
+	// each end in small blocks - using the comparison result arithmetically
+	// rather than as a branch - then swaps them in bulk. After Edelkamp and
+	// Weiss, "BlockQuicksort: How Branch Mispredictions don't affect
+	// Quicksort".
+	template <typename T, typename TLess>
+	static T* PartitionRightBranchless(T* begin, T* end, TLess& less, bool& alreadyPartitioned)
+	{
+		Hole<T> pivot;
+		Relocate(&pivot.Get(), begin);
+
+		T* first = begin;
+		T* last = end;
+
+		while (less(*++first, pivot.Get()))
+		{
+		}
+
+		if (first - 1 == begin)
+		{
+			while (first < last && !less(*--last, pivot.Get()))
+			{
+			}
+		}
+		else
+		{
+			while (!less(*--last, pivot.Get()))
+			{
+			}
+		}
+
+		alreadyPartitioned = first >= last;
+		if (!alreadyPartitioned)
+		{
+			SwapItems(first, last);
+			first++;
+
+			uint8_t offsetsL[kPartitionBlockSize];
+			uint8_t offsetsR[kPartitionBlockSize];
+
+			T* offsetsLBase = first;
+			T* offsetsRBase = last;
+			int numL = 0;
+			int numR = 0;
+			int startL = 0;
+			int startR = 0;
+
+			while (first < last)
+			{
+				// Work out how many elements to consider for each block
+				int numUnknown = (int)(last - first);
+				int leftSplit = numL == 0 ? (numR == 0 ? numUnknown / 2 : numUnknown) : 0;
+				int rightSplit = numR == 0 ? (numUnknown - leftSplit) : 0;
+
+				// Fill the offset blocks with elements on the wrong side
+				if (leftSplit >= kPartitionBlockSize)
+					leftSplit = kPartitionBlockSize;
+				for (int i = 0; i < leftSplit; i++)
+				{
+					offsetsL[numL] = (uint8_t)i;
+					numL += !less(*first, pivot.Get());
+					first++;
+				}
+
+				if (rightSplit >= kPartitionBlockSize)
+					rightSplit = kPartitionBlockSize;
+				for (int i = 0; i < rightSplit; )
+				{
+					offsetsR[numR] = (uint8_t)++i;
+					numR += less(*--last, pivot.Get());
+				}
+
+				// Swap as many pairs as possible and update the blocks
+				int num = numL < numR ? numL : numR;
+				SwapOffsets(offsetsLBase, offsetsRBase, offsetsL + startL, offsetsR + startR, num, numL == numR);
+				numL -= num;
+				numR -= num;
+				startL += num;
+				startR += num;
+
+				if (numL == 0)
+				{
+					startL = 0;
+					offsetsLBase = first;
+				}
+
+				if (numR == 0)
+				{
+					startR = 0;
+					offsetsRBase = last;
+				}
+			}
+
+			// Everything's been classified - swap the leftovers from
+			// whichever block still has some into place
+			if (numL)
+			{
+				const uint8_t* offsets = offsetsL + startL;
+				while (numL--)
+					SwapItems(offsetsLBase + offsets[numL], --last);
+				first = last;
+			}
+			if (numR)
+			{
+				const uint8_t* offsets = offsetsR + startR;
+				while (numR--)
+				{
+					SwapItems(offsetsRBase - offsets[numR], first);
+					first++;
+				}
+				last = first;
+			}
+		}
+
+		T* pivotPos = first - 1;
+		Relocate(begin, pivotPos);
+		Relocate(pivotPos, &pivot.Get());
+		return pivotPos;
+	}
+
+	// As above but elements equal to the pivot go to the left. Used when
+	// the pivot is known to equal the element preceding this partition, in
+	// which case everything equal to it is already in its final place and
+	// only the right hand side needs further sorting.
+	template <typename T, typename TLess>
+	static T* PartitionLeft(T* begin, T* end, TLess& less)
+	{
+		Hole<T> pivot;
+		Relocate(&pivot.Get(), begin);
+
+		T* first = begin;
+		T* last = end;
+
+		while (less(pivot.Get(), *--last))
+		{
+		}
+
+		if (last + 1 == end)
+		{
+			while (first < last && !less(pivot.Get(), *++first))
+			{
+			}
+		}
+		else
+		{
+			while (!less(pivot.Get(), *++first))
+			{
+			}
+		}
+
+		while (first < last)
+		{
+			SwapItems(first, last);
+			while (less(pivot.Get(), *--last))
+			{
+			}
+			while (!less(pivot.Get(), *++first))
+			{
+			}
+		}
+
+		T* pivotPos = last;
+		Relocate(begin, pivotPos);
+		Relocate(pivotPos, &pivot.Get());
+		return pivotPos;
+	}
+
+	// Heap sort fallback for when the quicksort keeps picking bad pivots
+	template <typename T, typename TLess>
+	static void SiftDown(T* data, int root, int count, TLess& less)
+	{
+		Hole<T> temp;
+		Relocate(&temp.Get(), data + root);
+
+		while (true)
+		{
+			int child = 2 * root + 1;
+			if (child >= count)
+				break;
+			if (child + 1 < count && less(data[child], data[child + 1]))
+				child++;
+			if (!less(temp.Get(), data[child]))
+				break;
+			Relocate(data + root, data + child);
+			root = child;
+		}
+
+		Relocate(data + root, &temp.Get());
+	}
+
+	template <typename T, typename TLess>
+	static void HeapSort(T* begin, T* end, TLess& less)
+	{
+		int count = (int)(end - begin);
+		for (int i = count / 2 - 1; i >= 0; i--)
+			SiftDown(begin, i, count, less);
+		for (int i = count - 1; i > 0; i--)
+		{
+			SwapItems(begin, begin + i);
+			SiftDown(begin, 0, i, less);
+		}
+	}
+
+	template <typename T, typename TLess>
+	static void SortLoop(T* begin, T* end, TLess& less, int badAllowed, bool leftmost)
+	{
+		while (true)
+		{
+			int size = (int)(end - begin);
+
+			// Small partitions get insertion sorted
+			if (size < kInsertionSortThreshold)
+			{
+				if (leftmost)
+					InsertionSort(begin, end, less);
+				else
+					UnguardedInsertionSort(begin, end, less);
+				return;
+			}
+
+			// Choose pivot as median of 3 or pseudomedian of 9 and move it
+			// to *begin
+			int s2 = size / 2;
+			if (size > kNintherThreshold)
+			{
+				Sort3(begin, begin + s2, end - 1, less);
+				Sort3(begin + 1, begin + (s2 - 1), end - 2, less);
+				Sort3(begin + 2, begin + (s2 + 1), end - 3, less);
+				Sort3(begin + (s2 - 1), begin + s2, begin + (s2 + 1), less);
+				SwapItems(begin, begin + s2);
+			}
+			else
+			{
+				Sort3(begin + s2, begin, end - 1, less);
+			}
+
+			// If the pivot equals the element before this partition (which
+			// is <= everything in it) then every element equal to the pivot
+			// is already sorted - partition them out to the left and
+			// continue with just the right hand side
+			if (!leftmost && !less(*(begin - 1), *begin))
+			{
+				begin = PartitionLeft(begin, end, less) + 1;
+				continue;
+			}
+
+			bool alreadyPartitioned;
+			T* pivotPos;
+			if constexpr (std::is_arithmetic<T>::value || std::is_pointer<T>::value)
+				pivotPos = PartitionRightBranchless(begin, end, less, alreadyPartitioned);
+			else
+				pivotPos = PartitionRight(begin, end, less, alreadyPartitioned);
+
+			int lSize = (int)(pivotPos - begin);
+			int rSize = (int)(end - (pivotPos + 1));
+
+			if (lSize < size / 8 || rSize < size / 8)
+			{
+				// Highly unbalanced - if this has happened too often, switch
+				// to heapsort to guarantee O(n log n)
+				if (--badAllowed == 0)
+				{
+					HeapSort(begin, end, less);
+					return;
+				}
+
+				// Otherwise shuffle some elements around to break up
+				// whatever pattern is defeating the pivot selection
+				if (lSize >= kInsertionSortThreshold)
+				{
+					SwapItems(begin, begin + lSize / 4);
+					SwapItems(pivotPos - 1, pivotPos - lSize / 4);
+
+					if (lSize > kNintherThreshold)
+					{
+						SwapItems(begin + 1, begin + (lSize / 4 + 1));
+						SwapItems(begin + 2, begin + (lSize / 4 + 2));
+						SwapItems(pivotPos - 2, pivotPos - (lSize / 4 + 1));
+						SwapItems(pivotPos - 3, pivotPos - (lSize / 4 + 2));
+					}
+				}
+
+				if (rSize >= kInsertionSortThreshold)
+				{
+					SwapItems(pivotPos + 1, pivotPos + (1 + rSize / 4));
+					SwapItems(end - 1, end - rSize / 4);
+
+					if (rSize > kNintherThreshold)
+					{
+						SwapItems(pivotPos + 2, pivotPos + (2 + rSize / 4));
+						SwapItems(pivotPos + 3, pivotPos + (3 + rSize / 4));
+						SwapItems(end - 2, end - (1 + rSize / 4));
+						SwapItems(end - 3, end - (2 + rSize / 4));
+					}
+				}
+			}
+			else
+			{
+				// A well balanced partition that needed no swaps suggests
+				// the input is already (nearly) sorted - try to finish both
+				// sides off with a bounded insertion sort
+				if (alreadyPartitioned &&
+					PartialInsertionSort(begin, pivotPos, less) &&
+					PartialInsertionSort(pivotPos + 1, end, less))
+				{
+					return;
+				}
+			}
+
+			// Recurse into the left side and loop on the right, keeping
+			// the stack depth bounded by badAllowed
+			SortLoop(begin, pivotPos, less, badAllowed, leftmost);
+			begin = pivotPos + 1;
+			leftmost = false;
+		}
+	}
+
+	// Merge the sorted runs [lo, mid) and [mid, hi) into dest. Ties take
+	// from the left run, which is what makes StableSort stable.
+	template <typename T, typename TLess>
+	static void Merge(T* lo, T* mid, T* hi, T* dest, TLess& less)
+	{
+		// Already in order (common for partially sorted input)?
+		if (mid == hi || lo == mid || !less(*mid, *(mid - 1)))
+		{
+			memcpy((void*)dest, (const void*)lo, (hi - lo) * sizeof(T));
+			return;
+		}
+
+		T* a = lo;
+		T* b = mid;
+		while (a < mid && b < hi)
+		{
+			if (less(*b, *a))
+				Relocate(dest++, b++);
+			else
+				Relocate(dest++, a++);
+		}
+
+		if (a < mid)
+			memcpy((void*)dest, (const void*)a, (mid - a) * sizeof(T));
+		if (b < hi)
+			memcpy((void*)dest, (const void*)b, (hi - b) * sizeof(T));
+	}
+};
+
+}
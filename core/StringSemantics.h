@@ -5,10 +5,17 @@
 #include <wchar.h>
 #include <string.h>
 #include "HashUtils.h"
+#include "RefCount.h"
 
 namespace SimpleLib
 {
 
+	template <typename T, typename TRefCount = SRefCount>
+	class StringCore;
+
+	template <typename T>
+	class StringView;
+
 	template <typename T>
 	struct IStringWriter
 	{
@@ -114,7 +121,7 @@ namespace SimpleLib
 		}
 		static uint32_t Hash(const char* a)
 		{
-			return (int)hash_str(a);
+			return hash_str(a);
 		}
 
 		// char16_t
@@ -168,7 +175,7 @@ namespace SimpleLib
 
 		static uint32_t Hash(const char16_t* a)
 		{
-			return hash_buf(a, SChar<char16_t>::Length(a));
+			return hash_buf(a, SChar<char16_t>::Length(a) * sizeof(char16_t));
 		}
 
 		// wchar_t
@@ -207,7 +214,7 @@ namespace SimpleLib
 
 		static uint32_t Hash(const wchar_t* a)
 		{
-			return hash_buf(a, SChar<wchar_t>::Length(a));
+			return hash_buf(a, SChar<wchar_t>::Length(a) * sizeof(wchar_t));
 		}
 
 
@@ -262,7 +269,7 @@ namespace SimpleLib
 
 		static uint32_t Hash(const char32_t* a)
 		{
-			return hash_buf(a, SChar<char32_t>::Length(a));
+			return hash_buf(a, SChar<char32_t>::Length(a) * sizeof(char32_t));
 		}
 	};
 
@@ -311,20 +318,12 @@ namespace SimpleLib
 
 		// Case-folded hash so that strings which compare equal under
 		// AreEqual() above also hash to the same value (required for use
-		// as a Map/HashCore key comparer). Folds one character at a time
-		// via hash_buf's seed rather than building a lowercased copy.
+		// as a Map/HashCore key comparer). Folds a chunk at a time into a
+		// HashBuilder rather than building a lowercased copy, so it's the
+		// same as hashing the lower case string.
 		static uint32_t Hash(const char* a)
 		{
-			uint32_t h = 0x811c9dc5u;
-			if (a)
-			{
-				while (*a)
-				{
-					char lower = SChar<char>::ToLower(*a++);
-					h = hash_buf(&lower, sizeof(lower), h);
-				}
-			}
-			return h;
+			return HashFolded(a);
 		}
 
 		static int Compare(wchar_t a, wchar_t b)
@@ -384,16 +383,30 @@ namespace SimpleLib
 
 		static uint32_t Hash(const wchar_t* a)
 		{
-			uint32_t h = 0x811c9dc5u;
+			return HashFolded(a);
+		}
+
+	private:
+		template <typename T>
+		static uint32_t HashFolded(const T* a)
+		{
+			HashBuilder hash;
 			if (a)
 			{
+				T chunk[32];
+				int count = 0;
 				while (*a)
 				{
-					wchar_t lower = SChar<wchar_t>::ToLower(*a++);
-					h = hash_buf(&lower, sizeof(lower), h);
+					chunk[count++] = SChar<T>::ToLower(*a++);
+					if (count == 32)
+					{
+						hash.Append(chunk, sizeof(chunk));
+						count = 0;
+					}
 				}
+				hash.Append(chunk, count * sizeof(T));
 			}
-			return h;
+			return hash.Finish();
 		}
 
 	};
@@ -0,0 +1,513 @@
+#pragma once
+
+#include <string.h>
+#include <stdint.h>
+
+#include "Search.h"
+
+// The kernels below are always compiled for both SSE2 and AVX2 on x86 (the
+// AVX2 ones with a per function target attribute on GCC/Clang, so nothing
+// else needs building with -mavx2) and picked between at runtime.
+#if defined(_SIMPLELIB_SIMD_SSE2) || defined(_SIMPLELIB_SIMD_AVX2)
+	#define _SIMPLELIB_STRING_SIMD
+	#include <immintrin.h>
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#include <intrin.h>
+		#define _SIMPLELIB_TARGET_AVX2
+		#define _SIMPLELIB_NO_SANITIZE_ADDRESS __declspec(no_sanitize_address)
+	#else
+		#define _SIMPLELIB_TARGET_AVX2 __attribute__((target("avx2")))
+		#define _SIMPLELIB_NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+	#endif
+#endif
+
+namespace SimpleLib
+{
+
+// Vector instruction sets StringSimd can use, in order of preference
+enum class StringSimdLevel
+{
+	Scalar,
+	Sse2,
+	Avx2,
+};
+
+// Vectorized kernels for 8-bit (char) strings - character and substring
+// search, ASCII case conversion, case insensitive compare and whitespace
+// skipping. Used by the char specializations of StringCore, StringView
+// and Parse, and usable directly on any buffer.
+//
+// The instruction set is picked on first use from what the CPU supports
+// (AVX2, else SSE2 - always available on x64 - else plain C++). Define
+// _SIMPLELIB_NO_SIMD to always use the scalar code. Case folding is ASCII
+// only (ie: not locale dependent), so results never depend on which
+// kernel ran.
+class StringSimd
+{
+public:
+	// Get the instruction set in use
+	static StringSimdLevel GetLevel()
+	{
+		return CurrentLevel();
+	}
+
+	// Get the best instruction set the CPU supports
+	static StringSimdLevel GetSupportedLevel()
+	{
+		static const StringSimdLevel supported = Detect();
+		return supported;
+	}
+
+	// Restrict the kernels to an instruction set (clamped to what's
+	// supported), eg: to compare them or test the fallbacks. Not thread
+	// safe - call before any strings are being used on other threads.
+	static void SetLevel(StringSimdLevel level)
+	{
+		StringSimdLevel supported = GetSupportedLevel();
+		CurrentLevel() = level < supported ? level : supported;
+	}
+
+	// Index of the first `ch` in `length` characters, or -1.
+	//
+	// Just memchr - the C runtime's is already vectorized and picked by
+	// CPU at load time, and (page aligned, with wider unrolling) beats
+	// anything worth maintaining here.
+	static int IndexOf(const char* p, int length, char ch)
+	{
+		return IndexOfScalar(p, 0, length, ch);
+	}
+
+	// Index of the first occurrence of `find` in `length` characters, or
+	// -1 (also -1 if find is empty)
+	static int IndexOf(const char* p, int length, const char* find, int findLength)
+	{
+		if (findLength <= 0 || findLength > length)
+			return -1;
+		if (findLength == 1)
+			return IndexOf(p, length, find[0]);
+#if defined(_SIMPLELIB_STRING_SIMD)
+		switch (CurrentLevel())
+		{
+			case StringSimdLevel::Avx2: return IndexOfAvx2(p, length, find, findLength);
+			case StringSimdLevel::Sse2: return IndexOfSse2(p, length, find, findLength);
+			default: break;
+		}
+#endif
+		return IndexOfScalar(p, 0, length, find, findLength);
+	}
+
+	// Copy `length` characters converting 'a'-'z' to upper case (dest may
+	// be the same as src)
+	static void ToUpper(char* dest, const char* src, int length)
+	{
+		FoldCase(dest, src, length, 'a', 'z');
+	}
+
+	// Copy `length` characters converting 'A'-'Z' to lower case (dest may
+	// be the same as src)
+	static void ToLower(char* dest, const char* src, int length)
+	{
+		FoldCase(dest, src, length, 'A', 'Z');
+	}
+
+	// Compare `length` characters ignoring ASCII case. Returns <0, 0 or >0
+	// as the first differing character (lower cased, unsigned) of a is
+	// less than, equal to or greater than b's. Unlike strncasecmp, doesn't
+	// stop at a null character.
+	static int CompareI(const char* a, const char* b, int length)
+	{
+#if defined(_SIMPLELIB_STRING_SIMD)
+		switch (CurrentLevel())
+		{
+			case StringSimdLevel::Avx2: return CompareIAvx2(a, b, length);
+			case StringSimdLevel::Sse2: return CompareISse2(a, b, length);
+			default: break;
+		}
+#endif
+		return CompareIScalar(a, b, 0, length);
+	}
+
+	// Number of leading white space characters (as Parse::IsWhiteSpace) in
+	// `length` characters
+	static int SkipWhiteSpace(const char* p, int length)
+	{
+#if defined(_SIMPLELIB_STRING_SIMD)
+		switch (CurrentLevel())
+		{
+			case StringSimdLevel::Avx2: return SkipWhiteSpaceAvx2(p, length);
+			case StringSimdLevel::Sse2: return SkipWhiteSpaceSse2(p, length);
+			default: break;
+		}
+#endif
+		return SkipWhiteSpaceScalar(p, 0, length);
+	}
+
+	// Skip white space in a null terminated string, returning a pointer to
+	// the first other character (possibly the terminator).
+	//
+	// The vector loop reads whole aligned blocks, so may read past the
+	// terminator - but never into another page, so it can't fault (and
+	// it's excluded from AddressSanitizer checks).
+	static const char* SkipWhiteSpace(const char* p)
+	{
+		// Most runs are short (a space or an indent) - don't bother
+		// setting up vectors for those
+		for (int i = 0; i < 8; i++)
+		{
+			if (!IsWhiteSpace(*p))
+				return p;
+			p++;
+		}
+
+#if defined(_SIMPLELIB_STRING_SIMD)
+		switch (CurrentLevel())
+		{
+			case StringSimdLevel::Avx2: return SkipWhiteSpaceAvx2(p);
+			case StringSimdLevel::Sse2: return SkipWhiteSpaceSse2(p);
+			default: break;
+		}
+#endif
+		while (IsWhiteSpace(*p))
+			p++;
+		return p;
+	}
+
+private:
+	static StringSimdLevel& CurrentLevel()
+	{
+		static StringSimdLevel level = GetSupportedLevel();
+		return level;
+	}
+
+	static StringSimdLevel Detect()
+	{
+#if !defined(_SIMPLELIB_STRING_SIMD)
+		return StringSimdLevel::Scalar;
+#elif defined(__AVX2__)
+		return StringSimdLevel::Avx2;
+#elif defined(_MSC_VER) && !defined(__clang__)
+		// AVX2 needs both the CPU (leaf 7, EBX bit 5) and the OS (saving
+		// the YMM registers, XCR0 bits 1 and 2) to support it
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] >= 7)
+		{
+			__cpuid(info, 1);
+			bool osxsave = (info[2] & (1 << 27)) != 0;
+			bool avx = (info[2] & (1 << 28)) != 0;
+			__cpuidex(info, 7, 0);
+			bool avx2 = (info[1] & (1 << 5)) != 0;
+			if (osxsave && avx && avx2 && (_xgetbv(0) & 6) == 6)
+				return StringSimdLevel::Avx2;
+		}
+		return StringSimdLevel::Sse2;
+#else
+		// (checks OS support too)
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") ? StringSimdLevel::Avx2 : StringSimdLevel::Sse2;
+#endif
+	}
+
+	static bool IsWhiteSpace(char ch)
+	{
+		return ch == '\r' || ch == '\n' || ch == ' ' || ch == '\t';
+	}
+
+	static char FoldLower(char ch)
+	{
+		return (ch >= 'A' && ch <= 'Z') ? (char)(ch + ('a' - 'A')) : ch;
+	}
+
+	// Scalar versions (also do the tails the vector loops leave)
+
+	static int IndexOfScalar(const char* p, int start, int length, char ch)
+	{
+		const void* found = memchr(p + start, ch, length - start);
+		return found ? (int)((const char*)found - p) : -1;
+	}
+
+	static int IndexOfScalar(const char* p, int start, int length, const char* find, int findLength)
+	{
+		int stopPos = length - findLength;
+		for (int i = start; i <= stopPos; i++)
+		{
+			if (p[i] == find[0] && memcmp(p + i + 1, find + 1, findLength - 1) == 0)
+				return i;
+		}
+		return -1;
+	}
+
+	// Check the characters between the first and last (inline rather than
+	// memcmp - the call costs more than the compare for short needles)
+	static bool MatchesInner(const char* p, const char* find, int findLength)
+	{
+		for (int i = 1; i < findLength - 1; i++)
+		{
+			if (p[i] != find[i])
+				return false;
+		}
+		return true;
+	}
+
+	static void FoldCaseScalar(char* dest, const char* src, int start, int length, char first, char last)
+	{
+		for (int i = start; i < length; i++)
+		{
+			char ch = src[i];
+			dest[i] = (ch >= first && ch <= last) ? (char)(ch ^ 0x20) : ch;
+		}
+	}
+
+	static int CompareIScalar(const char* a, const char* b, int start, int length)
+	{
+		for (int i = start; i < length; i++)
+		{
+			int compare = (int)(uint8_t)FoldLower(a[i]) - (int)(uint8_t)FoldLower(b[i]);
+			if (compare != 0)
+				return compare;
+		}
+		return 0;
+	}
+
+	static int SkipWhiteSpaceScalar(const char* p, int start, int length)
+	{
+		int i = start;
+		while (i < length && IsWhiteSpace(p[i]))
+			i++;
+		return i;
+	}
+
+	static void FoldCase(char* dest, const char* src, int length, char first, char last)
+	{
+#if defined(_SIMPLELIB_STRING_SIMD)
+		switch (CurrentLevel())
+		{
+			case StringSimdLevel::Avx2: FoldCaseAvx2(dest, src, length, first, last); return;
+			case StringSimdLevel::Sse2: FoldCaseSse2(dest, src, length, first, last); return;
+			default: break;
+		}
+#endif
+		FoldCaseScalar(dest, src, 0, length, first, last);
+	}
+
+#if defined(_SIMPLELIB_STRING_SIMD)
+	// SSE2 kernels (16 characters at a time).
+	//
+	// Characters are compared as signed bytes, so a range test against
+	// ASCII letters can never match a byte >= 0x80.
+
+	static __m128i InRangeSse2(__m128i v, char first, char last)
+	{
+		return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(first - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8(last + 1)));
+	}
+
+	static __m128i FoldLowerSse2(__m128i v)
+	{
+		return _mm_or_si128(v, _mm_and_si128(InRangeSse2(v, 'A', 'Z'), _mm_set1_epi8(0x20)));
+	}
+
+	static __m128i IsWhiteSpaceSse2(__m128i v)
+	{
+		return _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+			_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+	}
+
+	// Candidates are positions where both the first and last characters
+	// of `find` match, which rejects almost everything without comparing
+	// the rest of it
+	static int IndexOfSse2(const char* p, int length, const char* find, int findLength)
+	{
+		__m128i first = _mm_set1_epi8(find[0]);
+		__m128i last = _mm_set1_epi8(find[findLength - 1]);
+		int i = 0;
+		for (; i + findLength - 1 + 16 <= length; i += 16)
+		{
+			__m128i eqFirst = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + i)), first);
+			__m128i eqLast = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + i + findLength - 1)), last);
+			uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(eqFirst, eqLast));
+			while (mask)
+			{
+				int pos = i + Bit::TrailingZeros(mask);
+				if (MatchesInner(p + pos, find, findLength))
+					return pos;
+				mask &= mask - 1;
+			}
+		}
+		return IndexOfScalar(p, i, length, find, findLength);
+	}
+
+	static void FoldCaseSse2(char* dest, const char* src, int length, char first, char last)
+	{
+		if (length < 16)
+		{
+			FoldCaseScalar(dest, src, 0, length, first, last);
+			return;
+		}
+
+		__m128i bit = _mm_set1_epi8(0x20);
+		for (int i = 0; ; i += 16)
+		{
+			// Finish with a vector overlapping the previous one (folding
+			// is idempotent, so this is fine even in place)
+			if (i + 16 > length)
+				i = length - 16;
+			__m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+			v = _mm_xor_si128(v, _mm_and_si128(InRangeSse2(v, first, last), bit));
+			_mm_storeu_si128((__m128i*)(dest + i), v);
+			if (i + 16 == length)
+				break;
+		}
+	}
+
+	static int CompareISse2(const char* a, const char* b, int length)
+	{
+		int i = 0;
+		for (; i + 16 <= length; i += 16)
+		{
+			__m128i va = FoldLowerSse2(_mm_loadu_si128((const __m128i*)(a + i)));
+			__m128i vb = FoldLowerSse2(_mm_loadu_si128((const __m128i*)(b + i)));
+			uint32_t diff = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) ^ 0xFFFF;
+			if (diff)
+			{
+				int pos = i + Bit::TrailingZeros(diff);
+				return CompareIScalar(a, b, pos, pos + 1);
+			}
+		}
+		return CompareIScalar(a, b, i, length);
+	}
+
+	static int SkipWhiteSpaceSse2(const char* p, int length)
+	{
+		int i = 0;
+		for (; i + 16 <= length; i += 16)
+		{
+			uint32_t other = (uint32_t)_mm_movemask_epi8(IsWhiteSpaceSse2(_mm_loadu_si128((const __m128i*)(p + i)))) ^ 0xFFFF;
+			if (other)
+				return i + Bit::TrailingZeros(other);
+		}
+		return SkipWhiteSpaceScalar(p, i, length);
+	}
+
+	_SIMPLELIB_NO_SANITIZE_ADDRESS static const char* SkipWhiteSpaceSse2(const char* p)
+	{
+		// Aligned loads, ignoring the bytes before p in the first one
+		const char* block = (const char*)((uintptr_t)p & ~(uintptr_t)15);
+		uint32_t ignore = (1u << (p - block)) - 1;
+		for (;;)
+		{
+			uint32_t other = ((uint32_t)_mm_movemask_epi8(IsWhiteSpaceSse2(_mm_load_si128((const __m128i*)block))) | ignore) ^ 0xFFFF;
+			if (other)
+				return block + Bit::TrailingZeros(other);
+			block += 16;
+			ignore = 0;
+		}
+	}
+
+	// AVX2 kernels (32 characters at a time, same algorithms as above)
+
+	_SIMPLELIB_TARGET_AVX2 static __m256i InRangeAvx2(__m256i v, char first, char last)
+	{
+		return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(first - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(last + 1), v));
+	}
+
+	_SIMPLELIB_TARGET_AVX2 static __m256i FoldLowerAvx2(__m256i v)
+	{
+		return _mm256_or_si256(v, _mm256_and_si256(InRangeAvx2(v, 'A', 'Z'), _mm256_set1_epi8(0x20)));
+	}
+
+	_SIMPLELIB_TARGET_AVX2 static __m256i IsWhiteSpaceAvx2(__m256i v)
+	{
+		return _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))));
+	}
+
+	_SIMPLELIB_TARGET_AVX2 static int IndexOfAvx2(const char* p, int length, const char* find, int findLength)
+	{
+		__m256i first = _mm256_set1_epi8(find[0]);
+		__m256i last = _mm256_set1_epi8(find[findLength - 1]);
+		int i = 0;
+		for (; i + findLength - 1 + 32 <= length; i += 32)
+		{
+			__m256i eqFirst = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + i)), first);
+			__m256i eqLast = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + i + findLength - 1)), last);
+			uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(eqFirst, eqLast));
+			while (mask)
+			{
+				int pos = i + Bit::TrailingZeros(mask);
+				if (MatchesInner(p + pos, find, findLength))
+					return pos;
+				mask &= mask - 1;
+			}
+		}
+		return IndexOfScalar(p, i, length, find, findLength);
+	}
+
+	_SIMPLELIB_TARGET_AVX2 static void FoldCaseAvx2(char* dest, const char* src, int length, char first, char last)
+	{
+		if (length < 32)
+		{
+			FoldCaseSse2(dest, src, length, first, last);
+			return;
+		}
+
+		__m256i bit = _mm256_set1_epi8(0x20);
+		for (int i = 0; ; i += 32)
+		{
+			if (i + 32 > length)
+				i = length - 32;
+			__m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+			v = _mm256_xor_si256(v, _mm256_and_si256(InRangeAvx2(v, first, last), bit));
+			_mm256_storeu_si256((__m256i*)(dest + i), v);
+			if (i + 32 == length)
+				break;
+		}
+	}
+
+	_SIMPLELIB_TARGET_AVX2 static int CompareIAvx2(const char* a, const char* b, int length)
+	{
+		int i = 0;
+		for (; i + 32 <= length; i += 32)
+		{
+			__m256i va = FoldLowerAvx2(_mm256_loadu_si256((const __m256i*)(a + i)));
+			__m256i vb = FoldLowerAvx2(_mm256_loadu_si256((const __m256i*)(b + i)));
+			uint32_t diff = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb));
+			if (diff)
+			{
+				int pos = i + Bit::TrailingZeros(diff);
+				return CompareIScalar(a, b, pos, pos + 1);
+			}
+		}
+		return CompareIScalar(a, b, i, length);
+	}
+
+	_SIMPLELIB_TARGET_AVX2 static int SkipWhiteSpaceAvx2(const char* p, int length)
+	{
+		int i = 0;
+		for (; i + 32 <= length; i += 32)
+		{
+			uint32_t other = ~(uint32_t)_mm256_movemask_epi8(IsWhiteSpaceAvx2(_mm256_loadu_si256((const __m256i*)(p + i))));
+			if (other)
+				return i + Bit::TrailingZeros(other);
+		}
+		return SkipWhiteSpaceScalar(p, i, length);
+	}
+
+	_SIMPLELIB_TARGET_AVX2 _SIMPLELIB_NO_SANITIZE_ADDRESS static const char* SkipWhiteSpaceAvx2(const char* p)
+	{
+		const char* block = (const char*)((uintptr_t)p & ~(uintptr_t)31);
+		uint32_t ignore = (uint32_t)((1ull << (p - block)) - 1);
+		for (;;)
+		{
+			uint32_t other = ~((uint32_t)_mm256_movemask_epi8(IsWhiteSpaceAvx2(_mm256_load_si256((const __m256i*)block))) | ignore);
+			if (other)
+				return block + Bit::TrailingZeros(other);
+			block += 32;
+			ignore = 0;
+		}
+	}
+#endif
+};
+
+}
@@ -0,0 +1,378 @@
+#pragma once
+
+#include <assert.h>
+#include <string.h>
+
+#include "StringSemantics.h"
+#include "Compare.h"
+#include "Parse.h"
+#include "StringSimd.h"
+#include "List.h"
+
+namespace SimpleLib
+{
+	/*
+	Non-owning view of a run of characters - a pointer and a length.
+
+	Slicing, trimming and splitting a view just makes more views, so text
+	can be tokenised without allocating. A view isn't null terminated (use
+	GetBuffer() and GetLength(), or ToString() to copy it) and is only
+	valid while the characters it points at are, so don't keep a view of
+	a temporary string.
+
+	A StringCore converts to a view implicitly, and a view can be used to
+	look up String keyed Maps and Sets without being converted to a
+	String (see is_lookup_key).
+	*/
+	template <typename T>
+	class StringView
+	{
+	public:
+		// Constructor (null view)
+		StringView()
+		{
+			m_psz = nullptr;
+			m_length = 0;
+		}
+
+		// View a null terminated string
+		StringView(const T* psz)
+		{
+			m_psz = psz;
+			m_length = psz ? SChar<T>::Length(psz) : 0;
+		}
+
+		// View `length` characters
+		StringView(const T* psz, int length)
+		{
+			assert(length >= 0);
+			assert(psz != nullptr || length == 0);
+			m_psz = psz;
+			m_length = length;
+		}
+
+		// View a string
+		template <typename TRefCount>
+		StringView(const StringCore<T, TRefCount>& str)
+		{
+			m_psz = str.sz();
+			m_length = str.GetLength();
+		}
+
+		// Get the characters (not null terminated)
+		const T* GetBuffer() const
+		{
+			return m_psz;
+		}
+
+		int GetLength() const
+		{
+			return m_length;
+		}
+
+		bool IsNull() const
+		{
+			return m_psz == nullptr;
+		}
+
+		bool IsEmpty() const
+		{
+			return m_length == 0;
+		}
+
+		T operator[](int iPos) const
+		{
+			assert(iPos >= 0 && iPos < m_length);
+			return m_psz[iPos];
+		}
+
+		// Copy the characters to a string
+		StringCore<T> ToString() const
+		{
+			return StringCore<T>(m_psz, m_length);
+		}
+
+		// Get a view of part of this view (a negative start counts from
+		// the end)
+		StringView SubString(int iStart, int iLength = -1) const
+		{
+			if (iStart < 0)
+				iStart = m_length + iStart;
+
+			if (iLength < 0)
+				iLength = m_length - iStart;
+
+			assert(iStart >= 0);
+			assert(iStart + iLength <= m_length);
+
+			return StringView(m_psz + iStart, iLength);
+		}
+
+		// Remove leading whitespace
+		StringView LTrim() const
+		{
+			int start = 0;
+			if constexpr (std::is_same<T, char>::value)
+			{
+				start = StringSimd::SkipWhiteSpace(m_psz, m_length);
+			}
+			else
+			{
+				while (start < m_length && Parse<T>::IsWhiteSpace(m_psz[start]))
+					start++;
+			}
+			return StringView(m_psz + start, m_length - start);
+		}
+
+		// Remove trailing whitespace
+		StringView RTrim() const
+		{
+			int end = m_length;
+			while (end > 0 && Parse<T>::IsWhiteSpace(m_psz[end - 1]))
+				end--;
+			return StringView(m_psz, end);
+		}
+
+		// Remove leading and trailing whitespace
+		StringView Trim() const
+		{
+			return LTrim().RTrim();
+		}
+
+		template <typename S = SCase>
+		int IndexOf(T find, int startOffset = 0) const
+		{
+			if constexpr (std::is_same<T, char>::value && std::is_same<S, SCase>::value)
+			{
+				if (startOffset >= m_length)
+					return -1;
+				int index = StringSimd::IndexOf(m_psz + startOffset, m_length - startOffset, find);
+				return index < 0 ? -1 : startOffset + index;
+			}
+			for (int i = startOffset; i < m_length; i++)
+			{
+				if (S::Compare(m_psz[i], find) == 0)
+					return i;
+			}
+			return -1;
+		}
+
+		template <typename S = SCase>
+		int IndexOf(StringView find, int startOffset = 0) const
+		{
+			if (find.m_length == 0)
+				return -1;
+
+			if constexpr (std::is_same<T, char>::value && std::is_same<S, SCase>::value)
+			{
+				if (startOffset >= m_length)
+					return -1;
+				int index = StringSimd::IndexOf(m_psz + startOffset, m_length - startOffset, find.m_psz, find.m_length);
+				return index < 0 ? -1 : startOffset + index;
+			}
+
+			int stopPos = m_length - find.m_length;
+			for (int i = startOffset; i <= stopPos; i++)
+			{
+				if (CompareChars<S>(m_psz + i, find.m_psz, find.m_length) == 0)
+					return i;
+			}
+			return -1;
+		}
+
+		template <typename S = SCase>
+		int IndexOfAny(const T* chars, int startOffset = 0) const
+		{
+			for (int i = startOffset; i < m_length; i++)
+			{
+				if (IsOneOf<S>(chars, m_psz[i]))
+					return i;
+			}
+			return -1;
+		}
+
+		template <typename S = SCase>
+		int LastIndexOf(StringView find, int startOffset = -1) const
+		{
+			if (find.m_length == 0)
+				return -1;
+
+			int stopPos = m_length - find.m_length;
+			if (startOffset < 0 || startOffset > stopPos)
+				startOffset = stopPos;
+
+			for (int i = startOffset; i >= 0; i--)
+			{
+				if (CompareChars<S>(m_psz + i, find.m_psz, find.m_length) == 0)
+					return i;
+			}
+			return -1;
+		}
+
+		template <typename S = SCase>
+		int LastIndexOfAny(const T* chars, int startOffset = -1) const
+		{
+			if (startOffset < 0)
+				startOffset = m_length - 1;
+
+			for (int i = startOffset; i >= 0; i--)
+			{
+				if (IsOneOf<S>(chars, m_psz[i]))
+					return i;
+			}
+			return -1;
+		}
+
+		template <typename S = SCase>
+		bool StartsWith(StringView find) const
+		{
+			if (find.m_length > m_length)
+				return false;
+			return CompareChars<S>(m_psz, find.m_psz, find.m_length) == 0;
+		}
+
+		template <typename S = SCase>
+		bool EndsWith(StringView find) const
+		{
+			if (find.m_length > m_length)
+				return false;
+			return CompareChars<S>(m_psz + m_length - find.m_length, find.m_psz, find.m_length) == 0;
+		}
+
+		template <typename S = SCase>
+		bool IsEqualTo(StringView other) const
+		{
+			if (m_length != other.m_length)
+				return false;
+			if (m_psz == nullptr || other.m_psz == nullptr)
+				return m_psz == other.m_psz;
+			return CompareChars<S>(m_psz, other.m_psz, m_length) == 0;
+		}
+
+		// Compare (null views sort first, then by character and length)
+		template <typename S = SCase>
+		int Compare(StringView other) const
+		{
+			if (m_psz == nullptr || other.m_psz == nullptr)
+				return (m_psz != nullptr) - (other.m_psz != nullptr);
+
+			int length = m_length < other.m_length ? m_length : other.m_length;
+			int compare = CompareChars<S>(m_psz, other.m_psz, length);
+			if (compare != 0)
+				return compare;
+			return m_length - other.m_length;
+		}
+
+		// Split on any of the separator characters, adding views of the
+		// parts to `parts`
+		template <typename S = SCase>
+		int Split(const T* separators, bool includeEmpty, List<StringView>& parts) const
+		{
+			parts.Clear();
+
+			if (m_psz == nullptr)
+				return 0;
+
+			int partStart = 0;
+			for (int i = 0; i < m_length; i++)
+			{
+				if (IsOneOf<S>(separators, m_psz[i]))
+				{
+					if (includeEmpty || i > partStart)
+						parts.Add(StringView(m_psz + partStart, i - partStart));
+					partStart = i + 1;
+				}
+			}
+
+			if (includeEmpty || m_length > partStart)
+				parts.Add(StringView(m_psz + partStart, m_length - partStart));
+
+			return parts.GetCount();
+		}
+
+		// Same hash as a string holding the same characters
+		static uint32_t Hash(const StringView& view)
+		{
+			return StringCore<T>::Hash(view.m_psz, view.m_length);
+		}
+
+		friend bool operator==(const StringView& a, const StringView& b)
+		{
+			return a.IsEqualTo(b);
+		}
+
+		friend bool operator!=(const StringView& a, const StringView& b)
+		{
+			return !a.IsEqualTo(b);
+		}
+
+		friend bool operator<(const StringView& a, const StringView& b)
+		{
+			return a.Compare(b) < 0;
+		}
+
+		friend bool operator>(const StringView& a, const StringView& b)
+		{
+			return a.Compare(b) > 0;
+		}
+
+		friend bool operator<=(const StringView& a, const StringView& b)
+		{
+			return a.Compare(b) <= 0;
+		}
+
+		friend bool operator>=(const StringView& a, const StringView& b)
+		{
+			return a.Compare(b) >= 0;
+		}
+
+	private:
+		// Compare `length` characters (both runs are known to be that long,
+		// so char views can use the vectorized case insensitive compare)
+		template <typename S>
+		static int CompareChars(const T* a, const T* b, int length)
+		{
+			if constexpr (std::is_same<T, char>::value && std::is_same<S, SCaseI>::value)
+			{
+				return StringSimd::CompareI(a, b, length);
+			}
+			else if constexpr (std::is_same<S, SCase>::value)
+			{
+				// All of both runs, embedded NULs included (as String equality
+				// and Hash do)
+				int compare = memcmp(a, b, length * sizeof(T));
+				if (compare == 0 || sizeof(T) == 1)
+					return compare;
+				while (*a == *b)
+				{
+					a++;
+					b++;
+				}
+				return *a < *b ? -1 : 1;
+			}
+			else
+			{
+				return S::Compare(a, b, length);
+			}
+		}
+
+		template <typename S>
+		static bool IsOneOf(const T* chars, T ch)
+		{
+			while (*chars)
+			{
+				if (S::Compare(*chars, ch) == 0)
+					return true;
+				chars++;
+			}
+			return false;
+		}
+
+		const T* m_psz;
+		int m_length;
+	};
+
+	// Views can look up string keys
+	template <typename T, typename TRefCount>
+	struct is_lookup_key<StringCore<T, TRefCount>, StringView<T>> : std::true_type {};
+}
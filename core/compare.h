@@ -7,8 +7,24 @@
 namespace SimpleLib
 {
 
-	template <typename T>
-	class StringCore;
+	// Lookup keys - specialize to let a TLookup find TKey entries in a Map
+	// or Set without being converted to a TKey (eg: a StringView looking up
+	// String keys). TLookup must hash the same as the equivalent key and
+	// compare equal to it with ==.
+	template <typename TKey, typename TLookup>
+	struct is_lookup_key : std::false_type {};
+
+	// Comparers that hash and compare a lookup key the same way as the keys
+	// they store - specialize to enable lookup keys with other comparers.
+	// Lookups through a comparer that doesn't support them fall back to
+	// the key type overloads.
+	template <typename TCompare, typename TLookup>
+	struct supports_lookup : std::false_type {};
+
+	// Lookup key usable with a Map or Set of TKey compared by TCompare
+	template <typename TKey, typename TCompare, typename TLookup>
+	struct can_lookup : std::bool_constant<
+		is_lookup_key<TKey, TLookup>::value && supports_lookup<TCompare, TLookup>::value> {};
 
 	// Detect if T has a static Hash(const T&) member
 	template <typename T, typename = void>
@@ -30,12 +46,19 @@ namespace SimpleLib
 		// Overload for StringCore<T> - compares string contents directly
 		// via SCase rather than the generic operator</> (which would
 		// otherwise need to be evaluated twice for a single comparison)
-		template <typename T>
-		static int Compare(const StringCore<T>& a, const StringCore<T>& b)
+		template <typename T, typename TRefCount>
+		static int Compare(const StringCore<T, TRefCount>& a, const StringCore<T, TRefCount>& b)
 		{
 			return SCase::Compare(a.sz(), b.sz());
 		}
 
+		// Compare a key with a lookup key (see is_lookup_key)
+		template <typename TKey, typename TLookup>
+		static bool AreEqual(const TKey& a, const TLookup& b)
+		{
+			return a == b;
+		}
+
 		template <typename T>
 		static bool AreEqual(const T& a, const T& b)
 		{
@@ -79,5 +102,10 @@ namespace SimpleLib
 		}
 	};
 
+	// The default comparer hashes and compares lookup keys via the lookup
+	// type's own Hash and == (see is_lookup_key)
+	template <typename TLookup>
+	struct supports_lookup<SDefaultCompare, TLookup> : std::true_type {};
+
 }
 
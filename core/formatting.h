@@ -1,11 +1,16 @@
 #pragma once
 
+#include <assert.h>
+#include <float.h>
+#include <math.h>
 #include <stdarg.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <type_traits>
 
 #include "StringSemantics.h"
 #include "StringBuilder.h"
+#include "Ryu.h"
 
 namespace SimpleLib
 {
@@ -14,6 +19,16 @@ namespace SimpleLib
 #pragma warning(disable: 4996)
 #endif
 
+// Format string literals are checked against their arguments at compile time
+// when consteval is available (C++20), otherwise by an assert when they're
+// used (and parsed again on every call) unless wrapped in SIMPLELIB_FORMAT,
+// which parses and checks them at compile time in C++17 too
+#ifdef __cpp_consteval
+#define _SIMPLELIB_FORMAT_CONSTEVAL consteval
+#else
+#define _SIMPLELIB_FORMAT_CONSTEVAL constexpr
+#endif
+
 template <typename T>
 struct IFormatOutput
 {
@@ -98,10 +113,109 @@ public:
 };
 
 
+template <typename T, typename... TArgs>
+class FormatString;
+
 // Number formatting helpers used by CString::Format
 class Formatting
 {
 public:
+	// What a Format argument is formatted as
+	enum class ArgKind
+	{
+		Integer,
+		Float,
+		String,
+		Pointer,
+		Null,
+		Unsupported,
+	};
+
+	// One parsed %... specification of a FormatString, and the literal
+	// text in front of it
+	struct SPEC
+	{
+		int literalStart = 0;
+		int literalEnd = 0;
+		bool literalEscapes = false;	// literal contains %% to collapse
+		char type = '\0';
+		char positiveSign = '\0';
+		bool left = false;
+		bool typePrefix = false;
+		bool zeroPrefix = false;
+		bool widthArg = false;
+		bool precisionArg = false;
+		int width = 0;
+		int precision = -1;
+	};
+
+	// What each argument of a FormatString is used for
+	enum ArgRole : unsigned char
+	{
+		kRoleIgnore,
+		kRoleValue,
+		kRoleWidth,
+		kRolePrecision,
+	};
+
+	// Typed Format - same syntax as FormatV (see below), but the format
+	// string is parsed into a FormatString up front (at compile time where
+	// consteval is available) and checked against the argument types, and
+	// the output is appended in spans rather than a character at a time.
+	// TOutput needs Append(const T*, int) and Append(T, int) - eg: a
+	// StringBuilder.
+	template <typename TOutput, typename T, typename... TFormatArgs, typename... TArgs>
+	static void Format(TOutput& out, const FormatString<T, TFormatArgs...>& format, const TArgs&... args)
+	{
+		static_assert(sizeof...(TFormatArgs) == sizeof...(TArgs), "Format string was built for different arguments");
+
+		STATE state;
+		(WriteArg(out, format, state, args), ...);
+		WriteLiteral(out, format.m_format, format.m_tailStart, format.m_tailEnd, format.m_tailEscapes);
+	}
+
+	// How an argument of type TArg is formatted
+	template <typename T, typename TArg>
+	static constexpr ArgKind KindOf()
+	{
+		typedef typename std::decay<TArg>::type A;
+		if constexpr (std::is_integral<A>::value || std::is_enum<A>::value)
+			return ArgKind::Integer;
+		else if constexpr (std::is_floating_point<A>::value)
+			return ArgKind::Float;
+		else if constexpr (std::is_same<A, T*>::value || std::is_same<A, const T*>::value || IsStringArg<T, A>::value)
+			return ArgKind::String;
+		else if constexpr (std::is_same<A, std::nullptr_t>::value)
+			return ArgKind::Null;
+		else if constexpr (std::is_pointer<A>::value)
+			return ArgKind::Pointer;
+		else
+			return ArgKind::Unsupported;
+	}
+
+	// Whether a format type character can format an argument kind
+	static constexpr bool Accepts(char type, ArgKind kind)
+	{
+		switch (type)
+		{
+		case 'c': case 'd': case 'i': case 'u': case 'x': case 'X': case 'o':
+			return kind == ArgKind::Integer;
+		case 'f': case 'g':
+			return kind == ArgKind::Float;
+		case 's':
+			return kind == ArgKind::String || kind == ArgKind::Null;
+		case 'p': case 'P':
+			return kind == ArgKind::Pointer || kind == ArgKind::String || kind == ArgKind::Null;
+		}
+		return false;
+	}
+
+	// Not constexpr, so reaching one while parsing a format string at compile
+	// time is a compile error naming the problem
+	static void Error_UnknownFormatType() { assert(false && "Unknown format type"); }
+	static void Error_ArgumentTypeDoesNotMatchFormat() { assert(false && "Argument type doesn't match format"); }
+	static void Error_TooFewArguments() { assert(false && "Too few arguments for format"); }
+	static void Error_TooManyArguments() { assert(false && "Too many arguments for format"); }
 
 	// Supported formats:
 	// %[-][+][ ][#][0][<width>][.<precision>][l|ll]<type>
@@ -528,10 +642,25 @@ public:
 		return (int)(p - szTemp);
 	}
 
-	// This floating point number formatter
+	// This floating point number formatter. Uses the shortest round trip
+	// digits (see Ryu.h) rather than sprintf wherever they give the same
+	// result.
 	template <typename T>
 	static int FormatDoubleG(T* buf, double value, int precision, T positiveSign)
 	{
+		if (isfinite(value) && precision <= 15)
+		{
+			// For precisions under 16 the shortest digits padded with zeros are
+			// what printf rounds to, as long as there are no more of them than
+			// the precision and the value is normal (so they're within 1.2e-16
+			// of it, relatively)
+			double magnitude = fabs(value);
+			int maxDigits = precision == 0 ? 1 : precision;
+			Ryu::DECIMAL decimal = Ryu::Shortest(value);
+			if ((magnitude >= DBL_MIN || magnitude == 0) && Ryu::DigitCount(decimal.digits) <= maxDigits)
+				return Ryu::Write(buf, signbit(value) ? (T)'-' : positiveSign, decimal, -4, maxDigits - 1, 2);
+		}
+
 		char szTemp[512];
 		if (positiveSign != '\0')
 		{
@@ -551,8 +680,530 @@ public:
 		*buf++ = '\0';
 		return (int)(p - szTemp);
 	}
+
+	// Format an unsigned integer in decimal, backwards from the end of a
+	// buffer two digits at a time, and return where it starts
+	template <typename T, typename TInt>
+	static T* FormatDecimal(T* end, TInt value)
+	{
+		static const char kDigitPairs[] =
+			"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+			"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+			"8081828384858687888990919293949596979899";
+
+		while (value >= 100)
+		{
+			int pair = (int)(value % 100) * 2;
+			value /= 100;
+			*--end = kDigitPairs[pair + 1];
+			*--end = kDigitPairs[pair];
+		}
+		if (value >= 10)
+		{
+			*--end = kDigitPairs[value * 2 + 1];
+			*--end = kDigitPairs[value * 2];
+		}
+		else
+		{
+			*--end = (T)('0' + value);
+		}
+		return end;
+	}
+
+	// Format an unsigned integer in base 8 or 16 (shift = 3 or 4) backwards
+	// from the end of a buffer, and return where it starts
+	template <typename T, typename TInt>
+	static T* FormatPowerOfTwo(T* end, TInt value, int shift, bool uppercase)
+	{
+		const char* digits = uppercase ? "0123456789ABCDEF" : "0123456789abcdef";
+		unsigned mask = (1u << shift) - 1;
+		do
+		{
+			*--end = digits[(unsigned)value & mask];
+			value >>= shift;
+		} while (value != 0);
+		return end;
+	}
+
+private:
+	template <typename T, typename A>
+	struct IsStringArg : std::false_type {};
+
+	template <typename T, typename TRefCount>
+	struct IsStringArg<T, StringCore<T, TRefCount>> : std::true_type {};
+
+	template <typename T>
+	struct IsStringArg<T, StringView<T>> : std::true_type {};
+
+	// Progress through the arguments of a typed Format
+	struct STATE
+	{
+		int arg = 0;
+		int spec = 0;
+		int width = 0;
+		int precision = -1;
+	};
+
+	template <typename TOutput, typename T, typename... TFormatArgs, typename TArg>
+	static void WriteArg(TOutput& out, const FormatString<T, TFormatArgs...>& format, STATE& state, const TArg& arg)
+	{
+		switch (format.m_roles[state.arg++])
+		{
+		case kRoleWidth:
+			if constexpr (std::is_integral<TArg>::value)
+				state.width = (int)arg;
+			break;
+
+		case kRolePrecision:
+			if constexpr (std::is_integral<TArg>::value)
+				state.precision = (int)arg;
+			break;
+
+		case kRoleValue:
+		{
+			const SPEC& spec = format.m_specs[state.spec++];
+			WriteLiteral(out, format.m_format, spec.literalStart, spec.literalEnd, spec.literalEscapes);
+
+			bool left = spec.left;
+			int width = spec.widthArg ? state.width : spec.width;
+			if (width < 0)
+			{
+				left = true;
+				width = -width;
+			}
+			int precision = spec.precisionArg ? state.precision : spec.precision;
+			WriteValue<T>(out, spec, width, precision, left, arg);
+			break;
+		}
+		}
+	}
+
+	// Append format[start, end), collapsing any %% escapes
+	template <typename TOutput, typename T>
+	static void WriteLiteral(TOutput& out, const T* format, int start, int end, bool escapes)
+	{
+		if (escapes)
+		{
+			for (int i = start; i < end; i++)
+			{
+				if (format[i] == '%')
+				{
+					out.Append(format + start, i + 1 - start);
+					start = ++i + 1;
+				}
+			}
+		}
+		if (end > start)
+			out.Append(format + start, end - start);
+	}
+
+	template <typename TOutput, typename T>
+	static void WritePadded(TOutput& out, const T* psz, int len, int width, bool left)
+	{
+		if (width <= len)
+		{
+			out.Append(psz, len);
+		}
+		else if (left)
+		{
+			out.Append(psz, len);
+			out.Append((T)' ', width - len);
+		}
+		else
+		{
+			out.Append((T)' ', width - len);
+			out.Append(psz, len);
+		}
+	}
+
+	template <typename T, typename TOutput, typename TArg>
+	static void WriteValue(TOutput& out, const SPEC& spec, int width, int precision, bool left, const TArg& arg)
+	{
+		constexpr ArgKind kind = KindOf<T, TArg>();
+		static_assert(kind != ArgKind::Unsupported, "Format can't format this argument type");
+
+		if constexpr (kind == ArgKind::Integer)
+		{
+			// Promoted the way they would be passed through "...", so eg:
+			// a negative char formats the same as a negative int
+			if constexpr (std::is_enum<TArg>::value)
+				WriteInteger<T>(out, spec, width, precision, left, +static_cast<typename std::underlying_type<TArg>::type>(arg));
+			else
+				WriteInteger<T>(out, spec, width, precision, left, +arg);
+		}
+		else if constexpr (kind == ArgKind::Float)
+		{
+			T szTemp[512];
+			T sign = (T)spec.positiveSign;
+			int len = spec.type == 'f'
+				? FormatDoubleF<T>(szTemp, (double)arg, precision < 0 ? 6 : precision, sign)
+				: FormatDoubleG<T>(szTemp, (double)arg, precision < 0 ? 6 : precision, sign);
+			WritePadded(out, szTemp, len, width, left);
+		}
+		else if constexpr (kind == ArgKind::String)
+		{
+			const T* psz;
+			int len;
+			if constexpr (std::is_pointer<typename std::decay<TArg>::type>::value)
+			{
+				psz = arg;
+				len = psz ? SChar<T>::Length(psz) : 0;
+			}
+			else if constexpr (std::is_same<TArg, StringView<T>>::value)
+			{
+				psz = arg.GetBuffer();
+				len = arg.GetLength();
+			}
+			else
+			{
+				psz = arg.sz();
+				len = arg.GetLength();
+			}
+
+			if (spec.type == 'p' || spec.type == 'P')
+				WritePointer<T>(out, spec, width, left, (size_t)psz);
+			else
+				WriteString(out, psz, len, width, precision, left);
+		}
+		else if constexpr (kind == ArgKind::Null)
+		{
+			if (spec.type == 'p' || spec.type == 'P')
+				WritePointer<T>(out, spec, width, left, 0);
+			else
+				WriteString<T>(out, nullptr, 0, width, precision, left);
+		}
+		else
+		{
+			WritePointer<T>(out, spec, width, left, (size_t)arg);
+		}
+	}
+
+	template <typename T, typename TOutput, typename TInt>
+	static void WriteInteger(TOutput& out, const SPEC& spec, int width, int precision, bool left, TInt value)
+	{
+		typedef typename std::make_unsigned<TInt>::type TUInt;
+
+		// Formatted backwards from the end
+		T szTemp[128];
+		T* end = szTemp + 128;
+		T* p;
+		if (precision > 100)
+			precision = 100;
+		if (width > 100 && spec.zeroPrefix)
+			width = 100;
+
+		switch (spec.type)
+		{
+		case 'c':
+		{
+			T ch = (T)value;
+			WritePadded(out, &ch, 1, width, left);
+			return;
+		}
+
+		case 'p':
+		case 'P':
+			WritePointer<T>(out, spec, width, left, (size_t)value);
+			return;
+
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'o':
+			if (spec.zeroPrefix)
+			{
+				precision = width;
+				width = 0;
+			}
+			if (spec.type == 'u')
+				p = FormatDecimal(end, (TUInt)value);
+			else
+				p = FormatPowerOfTwo(end, (TUInt)value, spec.type == 'o' ? 3 : 4, spec.type == 'X');
+			while (end - p < precision)
+				*--p = '0';
+			if (spec.typePrefix && spec.type != 'u')
+			{
+				if (spec.type != 'o')
+					*--p = spec.type;
+				*--p = '0';
+			}
+			break;
+
+		default:
+		{
+			// 'd', 'i' (and anything that didn't match when checked at run time)
+			bool negative = false;
+			T sign = '\0';
+			if constexpr (std::is_signed<TInt>::value)
+			{
+				negative = value < 0;
+				sign = negative ? (T)'-' : (T)spec.positiveSign;
+			}
+			if (spec.zeroPrefix)
+			{
+				precision = width;
+				width = 0;
+				if (sign)
+					precision--;
+			}
+			p = FormatDecimal(end, negative ? (TUInt)0 - (TUInt)value : (TUInt)value);
+			while (end - p < precision)
+				*--p = '0';
+			if (sign)
+				*--p = sign;
+			break;
+		}
+		}
+
+		WritePadded(out, p, (int)(end - p), width, left);
+	}
+
+	template <typename T, typename TOutput>
+	static void WriteString(TOutput& out, const T* psz, int len, int width, int precision, bool left)
+	{
+		T szNull[] = { '(', 'n', 'u', 'l', 'l', ')' };
+		if (psz == nullptr)
+		{
+			psz = szNull;
+			len = 6;
+		}
+		if (len > precision && precision > 0)
+			len = precision;
+		WritePadded(out, psz, len, width, left);
+	}
+
+	template <typename T, typename TOutput>
+	static void WritePointer(TOutput& out, const SPEC& spec, int width, bool left, size_t value)
+	{
+		T szTemp[32];
+		T* end = szTemp + 32;
+		T* p = FormatPowerOfTwo(end, value, 4, spec.type == 'P');
+		while (end - p < (int)sizeof(size_t) * 2)
+			*--p = '0';
+		if (spec.typePrefix)
+		{
+			*--p = spec.type == 'P' ? 'X' : 'x';
+			*--p = '0';
+		}
+		WritePadded(out, p, (int)(end - p), width, left);
+	}
+};
+
+
+// Wraps a format string that's only known at run time so it can be passed
+// to the typed Format functions (it's then parsed and checked each call)
+template <typename T>
+struct RuntimeFormat
+{
+	RuntimeFormat(const T* psz) : psz(psz)
+	{
+	}
+
+	const T* psz;
+};
+
+
+// A format string parsed for, and checked against, the argument types
+// TArgs - constructed implicitly from a string literal when passed to
+// Formatting::Format, StringBuilder::Format or String::Format
+template <typename T, typename... TArgs>
+class FormatString
+{
+public:
+	_SIMPLELIB_FORMAT_CONSTEVAL FormatString(const T* format)
+		: m_format(format)
+	{
+		Parse();
+	}
+
+	FormatString(RuntimeFormat<T> format)
+		: m_format(format.psz)
+	{
+		Parse();
+	}
+
+	constexpr const T* GetFormat() const
+	{
+		return m_format;
+	}
+
+private:
+	static constexpr int kArgCount = (int)sizeof...(TArgs);
+
+	constexpr void Parse()
+	{
+		const Formatting::ArgKind kinds[] = { Formatting::KindOf<T, TArgs>()..., Formatting::ArgKind::Unsupported };
+		const T* p = m_format;
+		int arg = 0;
+		int specCount = 0;
+		int literalStart = 0;
+		bool escapes = false;
+		int i = 0;
+		while (p[i] != '\0')
+		{
+			if (p[i] != '%')
+			{
+				i++;
+				continue;
+			}
+			if (p[i + 1] == '%')
+			{
+				escapes = true;
+				i += 2;
+				continue;
+			}
+
+			Formatting::SPEC spec;
+			spec.literalStart = literalStart;
+			spec.literalEnd = i;
+			spec.literalEscapes = escapes;
+			i++;
+
+			// Flags
+			for (;; i++)
+			{
+				if (p[i] == '#')
+					spec.typePrefix = true;
+				else if (p[i] == '-')
+					spec.left = true;
+				else if (p[i] == '+')
+					spec.positiveSign = '+';
+				else if (p[i] == ' ')
+					spec.positiveSign = spec.positiveSign ? spec.positiveSign : ' ';
+				else
+					break;
+			}
+			if (p[i] == '0')
+			{
+				spec.zeroPrefix = !spec.left;
+				i++;
+			}
+
+			// Width
+			if (p[i] == '*')
+			{
+				spec.widthArg = true;
+				if (!TakeArg(arg, Formatting::kRoleWidth, kinds[arg]))
+					return;
+				i++;
+			}
+			while ('0' <= p[i] && p[i] <= '9')
+				spec.width = spec.width * 10 + (int)(p[i++] - '0');
+
+			// Precision
+			if (p[i] == '.')
+			{
+				i++;
+				spec.zeroPrefix = false;
+				spec.precision = 0;
+				if (p[i] == '*')
+				{
+					spec.precisionArg = true;
+					if (!TakeArg(arg, Formatting::kRolePrecision, kinds[arg]))
+						return;
+					i++;
+				}
+				while ('0' <= p[i] && p[i] <= '9')
+					spec.precision = spec.precision * 10 + (int)(p[i++] - '0');
+			}
+
+			// Size modifiers aren't needed (the argument types are known) but
+			// are accepted so format strings can be shared with FormatV
+			if (p[i] == 'l')
+				i += p[i + 1] == 'l' ? 2 : 1;
+			if (p[i] == 'z')
+				i++;
+
+			spec.type = (char)p[i];
+			if (!Formatting::Accepts(spec.type, Formatting::ArgKind::Integer) &&
+				!Formatting::Accepts(spec.type, Formatting::ArgKind::Float) &&
+				!Formatting::Accepts(spec.type, Formatting::ArgKind::String))
+			{
+				Formatting::Error_UnknownFormatType();
+				return;
+			}
+			if (arg < kArgCount && !Formatting::Accepts(spec.type, kinds[arg]))
+				Formatting::Error_ArgumentTypeDoesNotMatchFormat();
+			if (!TakeArg(arg, Formatting::kRoleValue, Formatting::ArgKind::Integer))
+				return;
+			i++;
+
+			m_specs[specCount++] = spec;
+			literalStart = i;
+			escapes = false;
+		}
+
+		m_tailStart = literalStart;
+		m_tailEnd = i;
+		m_tailEscapes = escapes;
+		if (arg < kArgCount)
+			Formatting::Error_TooManyArguments();
+	}
+
+	// Assign the next argument a role (width and precision arguments must
+	// be integers)
+	constexpr bool TakeArg(int& arg, Formatting::ArgRole role, Formatting::ArgKind kind)
+	{
+		if (arg >= kArgCount)
+		{
+			Formatting::Error_TooFewArguments();
+			return false;
+		}
+		if (kind != Formatting::ArgKind::Integer)
+			Formatting::Error_ArgumentTypeDoesNotMatchFormat();
+		m_roles[arg++] = role;
+		return true;
+	}
+
+	const T* m_format;
+	Formatting::SPEC m_specs[kArgCount + 1] = {};
+	unsigned char m_roles[kArgCount + 1] = {};
+	int m_tailStart = 0;
+	int m_tailEnd = 0;
+	bool m_tailEscapes = false;
+
+	friend class Formatting;
 };
 
+
+// Names the FormatString a SIMPLELIB_FORMAT lambda should build
+template <typename TFormatString>
+struct FormatStringTag
+{
+	typedef TFormatString type;
+};
+
+// A format string literal that's parsed at compile time, once for each set
+// of argument types it's used with (see SIMPLELIB_FORMAT)
+template <typename TFn>
+struct CompiledFormat
+{
+	template <typename T, typename... TArgs>
+	const FormatString<T, TArgs...>& Get() const
+	{
+		return fn(FormatStringTag<FormatString<T, TArgs...>>());
+	}
+
+	TFn fn;
+};
+
+template <typename TFn>
+CompiledFormat<TFn> MakeCompiledFormat(TFn fn)
+{
+	return CompiledFormat<TFn>{ fn };
+}
+
+// Wraps a format string literal so it's parsed into a static constexpr
+// FormatString - checked at compile time and never parsed at run time,
+// whatever the language version, eg:
+//
+//     sb.Format(SIMPLELIB_FORMAT("%s: %d"), name, count);
+#define SIMPLELIB_FORMAT(format) \
+	::SimpleLib::MakeCompiledFormat([](auto tag) -> const typename decltype(tag)::type& { \
+		static constexpr typename decltype(tag)::type parsed(format); \
+		return parsed; \
+	})
+
 #ifdef _MSC_VER
 #pragma warning(pop)
 #endif
@@ -5,17 +5,21 @@
 #include <assert.h>
 
 #include "HashUtils.h"
+#include "Allocator.h"
 
 namespace SimpleLib
 {
 
 
 template <typename TAllocator>
-class HashCore
+class HashCore : private AllocatorHolder<TAllocator>
 {
+    typedef AllocatorHolder<TAllocator> TAllocatorHolder;
+
 public:
     // Constructor
-    HashCore(size_t keySize, size_t valueSize)
+    HashCore(size_t keySize, size_t valueSize, const TAllocator& allocator = TAllocator())
+        : TAllocatorHolder(allocator)
     {
         m_keySize = keySize;
         m_valueSize = valueSize;
@@ -34,8 +38,9 @@ public:
 	HashCore& operator=(const HashCore&) = delete;		
 
 
-	// Move
+	// Move (the allocator moves with the memory)
 	HashCore(HashCore&& other)
+        : TAllocatorHolder(other.GetAllocator())
 	{
         m_keySize = other.m_keySize;
         m_valueSize = other.m_valueSize;
@@ -60,6 +65,7 @@ public:
 
         Reset();
 
+        this->SetAllocator(other.GetAllocator());
         m_keySize = other.m_keySize;
         m_valueSize = other.m_valueSize;
         m_entrySize = other.m_entrySize;
@@ -84,10 +90,13 @@ public:
         Reset();
     }
 
+    // Get the allocator the entry table is allocated from
+    using TAllocatorHolder::GetAllocator;
+
     // Free and reset everything back to initial state
     void Reset()
     {
-        TAllocator::Free(m_entries);
+        GetAllocator().Free(m_entries);
         m_version = 0;
         m_freecount = 0;
         m_freelist = -1;
@@ -105,7 +114,7 @@ public:
         capacity = (int)next_prime_capacity(capacity);
 
         // Resize entries array
-        m_entries = (char*)TAllocator::ReAlloc(m_entries, capacity * (m_entrySize + sizeof(int)));
+        m_entries = (char*)GetAllocator().ReAlloc(m_entries, capacity * (m_entrySize + sizeof(int)));
         m_hashtable = (int*)(m_entries + capacity * (m_entrySize));
         m_capacity = capacity;
 
@@ -260,24 +269,33 @@ public:
     // Look up a key, returning null if not found or
     // pointer to value storage
     void* Find(const void* key) const
+    {
+        return Find(HashKey(key), [&](const void* entryKey) {
+            return KeyEq(entryKey, key);
+        });
+    }
+
+    // Look up a key by its hash and a test for equality with a stored key
+    // (for looking up with a key of another type, see is_lookup_key)
+    template <typename TKeyEq>
+    void* Find(uint32_t hash, TKeyEq keyEq) const
     {
         if (m_capacity == 0)
             return 0;
 
         // Hash
-        int hashcode = HashKey(key) & 0x7FFFFFFF;
+        int hashcode = hash & 0x7FFFFFFF;
         int bucket = hashcode % m_capacity;
 
         // Look for existing entry
         int index = m_hashtable[bucket];
-        int prev = -1;
         while (index >= 0)
         {
             // Get the entry at this slot
             entry* e = get_entry(index);
 
             // Same key?
-            if (e->hashcode == hashcode && KeyEq(e->data, key))
+            if (e->hashcode == hashcode && keyEq(e->data))
             {
                 return e->data + m_keySize;	
             }
@@ -1,37 +1,248 @@
 #pragma once
 
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#if defined(_MSC_VER) && defined(_M_X64) && !defined(__SIZEOF_INT128__)
+#include <intrin.h>
+#endif
+
 namespace SimpleLib
 {
 
-#include <stdint.h>
-#include <stddef.h>
+// Byte buffer hashing - wyhash (final version 4, Wang Yi, public domain).
+//
+// Reads 8 bytes at a time and runs three independent multiply lanes over
+// long inputs, so it's many times quicker than a byte at a time hash (like
+// the FNV-1a this replaced) on anything but the shortest keys, and passes
+// SMHasher. Not cryptographic - don't use it for hash tables keyed on
+// untrusted input unless the seed is secret.
+
+inline constexpr uint64_t kWySecret[4] = { 0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull };
+
+// 64 x 64 -> 128 bit multiply, low half in a, high half in b
+inline void wy_mum(uint64_t& a, uint64_t& b)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t)a * b;
+    a = (uint64_t)r;
+    b = (uint64_t)(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    a = _umul128(a, b, &b);
+#else
+    uint64_t ha = a >> 32, hb = b >> 32, la = (uint32_t)a, lb = (uint32_t)b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    a = lo;
+    b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+inline uint64_t wy_mix(uint64_t a, uint64_t b)
+{
+    wy_mum(a, b);
+    return a ^ b;
+}
+
+inline uint64_t wy_read8(const uint8_t* p)
+{
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+inline uint64_t wy_read4(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
 
-// FNV-1a 32-bit hash
-// seed lets a hash be continued/folded across multiple calls (e.g. hashing
-// a string one case-folded character at a time without a temporary buffer)
-inline uint32_t hash_buf(const void* data, size_t len, uint32_t seed = 0x811c9dc5u)
+// 1 to 3 bytes
+inline uint64_t wy_read3(const uint8_t* p, size_t len)
+{
+    return ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+}
+
+// Hash a 0 to 16 byte input
+inline uint64_t wy_short(const uint8_t* p, size_t len, uint64_t seed)
+{
+    uint64_t a, b;
+    if (len >= 4)
+    {
+        a = (wy_read4(p) << 32) | wy_read4(p + ((len >> 3) << 2));
+        b = (wy_read4(p + len - 4) << 32) | wy_read4(p + len - 4 - ((len >> 3) << 2));
+    }
+    else if (len > 0)
+    {
+        a = wy_read3(p, len);
+        b = 0;
+    }
+    else
+    {
+        a = b = 0;
+    }
+
+    a ^= kWySecret[1];
+    b ^= seed;
+    wy_mum(a, b);
+    return wy_mix(a ^ kWySecret[0] ^ len, b ^ kWySecret[1]);
+}
+
+// Hash the last 1 to 48 bytes (`remaining`, at p) of a longer input.
+// Reads up to 15 bytes before p.
+inline uint64_t wy_tail(const uint8_t* p, size_t remaining, size_t len, uint64_t seed)
+{
+    while (remaining > 16)
+    {
+        seed = wy_mix(wy_read8(p) ^ kWySecret[1], wy_read8(p + 8) ^ seed);
+        p += 16;
+        remaining -= 16;
+    }
+
+    uint64_t a = wy_read8(p + remaining - 16) ^ kWySecret[1];
+    uint64_t b = wy_read8(p + remaining - 8) ^ seed;
+    wy_mum(a, b);
+    return wy_mix(a ^ kWySecret[0] ^ len, b ^ kWySecret[1]);
+}
+
+// One 48 byte block of the three lane loop
+inline void wy_block(const uint8_t* p, uint64_t& seed, uint64_t& see1, uint64_t& see2)
+{
+    seed = wy_mix(wy_read8(p) ^ kWySecret[1], wy_read8(p + 8) ^ seed);
+    see1 = wy_mix(wy_read8(p + 16) ^ kWySecret[2], wy_read8(p + 24) ^ see1);
+    see2 = wy_mix(wy_read8(p + 32) ^ kWySecret[3], wy_read8(p + 40) ^ see2);
+}
+
+inline uint64_t wy_seed(uint64_t seed)
+{
+    return seed ^ wy_mix(seed ^ kWySecret[0], kWySecret[1]);
+}
+
+// 64-bit hash of a buffer
+inline uint64_t hash_buf64(const void* data, size_t len, uint64_t seed = 0)
 {
     const uint8_t* p = (const uint8_t*)data;
-    uint32_t h = seed;      // FNV offset basis by default
-    for (size_t i = 0; i < len; i++)
+    seed = wy_seed(seed);
+    if (len <= 16)
+        return wy_short(p, len, seed);
+
+    size_t remaining = len;
+    if (remaining > 48)
     {
-        h ^= p[i];
-        h *= 0x01000193u;          // FNV prime
+        uint64_t see1 = seed, see2 = seed;
+        do
+        {
+            wy_block(p, seed, see1, see2);
+            p += 48;
+            remaining -= 48;
+        } while (remaining > 48);
+        seed ^= see1 ^ see2;
     }
-    return h;
+    return wy_tail(p, remaining, len, seed);
+}
+
+// Fold a 64-bit hash to 32 bits
+inline uint32_t hash_fold32(uint64_t hash)
+{
+    return (uint32_t)hash ^ (uint32_t)(hash >> 32);
+}
+
+// 32-bit hash of a buffer (what Map, Set and String use)
+inline uint32_t hash_buf(const void* data, size_t len, uint64_t seed = 0)
+{
+    return hash_fold32(hash_buf64(data, len, seed));
 }
 
 // Convenience wrapper for null-terminated strings
 inline uint32_t hash_str(const char* s)
 {
-    uint32_t h = 0x811c9dc5u;
-    while (*s)
+    return hash_buf(s, strlen(s));
+}
+
+// Incremental hashing - appending data in any number of pieces gives the
+// same result as hash_buf64/hash_buf on all of it at once, eg: to hash a
+// string one case folded chunk at a time without a temporary copy.
+class HashBuilder
+{
+public:
+    HashBuilder(uint64_t seed = 0)
     {
-        h ^= (uint8_t)*s++;
-        h *= 0x01000193u;
+        m_seed = wy_seed(seed);
+        m_see1 = m_seed;
+        m_see2 = m_seed;
+        m_length = 0;
+        m_pending = 0;
     }
-    return h;
-}
+
+    void Append(const void* data, size_t len)
+    {
+        const uint8_t* p = (const uint8_t*)data;
+        m_length += len;
+
+        while (len > 0)
+        {
+            // A block is only hashed once there's data after it (the last
+            // 1 to 48 bytes always go through wy_tail)
+            if (m_pending == kBlock)
+            {
+                wy_block(m_buf + kKeep, m_seed, m_see1, m_see2);
+                memcpy(m_buf, m_buf + kBlock, kKeep);
+                m_pending = 0;
+            }
+
+            // Hash whole blocks straight from the input
+            if (m_pending == 0 && len > kBlock)
+            {
+                do
+                {
+                    wy_block(p, m_seed, m_see1, m_see2);
+                    p += kBlock;
+                    len -= kBlock;
+                } while (len > kBlock);
+                memcpy(m_buf, p - kKeep, kKeep);
+            }
+
+            size_t n = kBlock - m_pending;
+            if (n > len)
+                n = len;
+            memcpy(m_buf + kKeep + m_pending, p, n);
+            m_pending += n;
+            p += n;
+            len -= n;
+        }
+    }
+
+    uint64_t Finish64() const
+    {
+        if (m_length <= 16)
+            return wy_short(m_buf + kKeep, m_length, m_seed);
+
+        uint64_t seed = m_seed;
+        if (m_length > kBlock)
+            seed ^= m_see1 ^ m_see2;
+        return wy_tail(m_buf + kKeep, m_pending, m_length, seed);
+    }
+
+    uint32_t Finish() const
+    {
+        return hash_fold32(Finish64());
+    }
+
+private:
+    static const size_t kBlock = 48;
+    static const size_t kKeep = 16;     // Bytes kept from the previous block, for wy_tail
+
+    uint64_t m_seed;
+    uint64_t m_see1;
+    uint64_t m_see2;
+    size_t m_length;
+    size_t m_pending;
+    uint8_t m_buf[kKeep + kBlock];
+};
 
 
 // 32-bit integer hash
@@ -8,6 +8,9 @@
 #include "Semantics.h"
 #include "PlacedConstructor.h"
 #include "Delegate.h"
+#include "Sorting.h"
+#include "Search.h"
+#include "Query.h"
 
 #include "Allocator.h"
 
@@ -17,11 +20,12 @@ namespace SimpleLib
 
 // List
 template <typename T, typename TAllocator = TMalloc>
-class List
+class List : private AllocatorHolder<TAllocator>
 {
 	typedef typename get_semantics<T>::TSemantics TSemantics;
 	typedef typename TSemantics::TArg TArg;
 	typedef typename TSemantics::TStorage TStorage;
+	typedef AllocatorHolder<TAllocator> TAllocatorHolder;
 
 	public:
 	// Constructor
@@ -29,20 +33,31 @@ class List
 	{
 	}
 
+	// Constructor with a specific allocator instance (for stateful
+	// allocators, eg: a handle to an arena)
+	explicit List(const TAllocator& allocator)
+		: TAllocatorHolder(allocator)
+	{
+	}
+
 	// Destructor
 	virtual ~List()
 	{
 		Clear();
 		if (m_data)
-			TAllocator::Free(m_data);
+			GetAllocator().Free(m_data);
 	}
 
+	// Get the allocator this list allocates from
+	using TAllocatorHolder::GetAllocator;
+
 	// No copy
 	List(const List&) = delete;
 	List& operator=(const List&) = delete;		
 
-	// Move
+	// Move (the allocator moves with the memory)
 	List(List&& other)
+		: TAllocatorHolder(other.GetAllocator())
 	{
 		m_count = other.m_count;
 		m_capacity = other.m_capacity;
@@ -60,8 +75,9 @@ class List
 			return *this;
 
 		if (m_data)
-			TAllocator::Free(m_data);
+			GetAllocator().Free(m_data);
 
+		this->SetAllocator(other.GetAllocator());
 		m_count = other.m_count;
 		m_capacity = other.m_capacity;
 		m_data = other.m_data;
@@ -89,7 +105,7 @@ class List
 		{
 			// Reallocate memory
 			assert(m_capacity != 0);
-			m_data = (TStorage*)TAllocator::ReAlloc((void*)m_data, iNewCapacity * sizeof(TStorage));
+			m_data = (TStorage*)GetAllocator().ReAlloc((void*)m_data, iNewCapacity * sizeof(TStorage));
 			if (!m_data)
 				return false;
 		}
@@ -97,7 +113,7 @@ class List
 		{
 			// Allocate memory
 			assert(m_capacity == 0);
-			m_data = (TStorage*)TAllocator::Alloc(iNewCapacity * sizeof(TStorage));
+			m_data = (TStorage*)GetAllocator().Alloc(iNewCapacity * sizeof(TStorage));
 			if (!m_data)
 				return false;
 		}
@@ -120,6 +136,21 @@ class List
 		return true;
 	}
 
+	// Grow the list by `count` elements without constructing them, returning
+	// a pointer to the first new (raw) element or nullptr if the memory
+	// couldn't be allocated. Every new element must be constructed in place
+	// (eg: with Constructor()) before the list is next used - this is for
+	// filling a presized list directly, possibly from several threads at
+	// once (see Parallel::Map/Filter).
+	TStorage* AddUninitialized(int count)
+	{
+		if (!SetCapacity(m_count + count))
+			return nullptr;
+		TStorage* p = m_data + m_count;
+		m_count += count;
+		return p;
+	}
+
 	// Release extra memory
 	void FreeExtra()
 	{
@@ -130,12 +161,12 @@ class List
 		// Free or realloc memory...
 		if (m_count == 0)
 		{
-			TAllocator::Free(m_data);
+			GetAllocator().Free(m_data);
 			m_data = nullptr;
 		}
 		else
 		{
-			m_data = (TStorage*)TAllocator::ReAlloc(m_data, m_count * sizeof(TStorage));
+			m_data = (TStorage*)GetAllocator().ReAlloc(m_data, m_count * sizeof(TStorage));
 		}
 
 		// Store new capacity
@@ -471,6 +502,12 @@ class List
         return iter;
     }
 
+    // Lazy query over the list's elements (see Query.h)
+    Query<QueryArraySource<TStorage, TArg>> AsQuery() const
+    {
+        return Query<QueryArraySource<TStorage, TArg>>(QueryArraySource<TStorage, TArg>(m_data, m_count));
+    }
+
 	bool GetNext(Iter& iter) const
     {
         if (iter._forward)
@@ -558,78 +595,149 @@ public:
 		return false;
 	}
 
-private:
-	struct sort_ctx_s
-	{
-		int (*callback)(TArg a, TArg b, void* user);
-		void* user;
-	};
-
-#ifdef _MSC_VER
-	static int sort_function_s(void* pvctx, const void* a, const void* b)
-#else
-	static int sort_function_s(const void* a, const void* b, void* pvctx)
-#endif
+	// Binary search a list sorted ascending by TCompare (the default
+	// comparer unless specified) for key. Returns true if found, with index
+	// set to the first matching element - or false with index set to where
+	// key would be inserted to keep the list sorted. Uses a branchless
+	// search (see Search::LowerBound).
+	template <typename TCompare = SDefaultCompare>
+	bool BinarySearch(int& index, TArg key) const
 	{
-		sort_ctx_s& ctx = *(sort_ctx_s*)pvctx;
-		return ctx.callback(*(TStorage*)a, *(TStorage*)b, ctx.user);
+		index = Search::LowerBound(m_data, m_count, key, [](const TStorage& elem, const TArg& k) {
+			return KeyLess<TCompare>(static_cast<const TArg&>(elem), k);
+		});
+		return index < m_count && !KeyLess<TCompare>(key, static_cast<const TArg&>(m_data[index]));
 	}
 
 public:
+	// Sort using a C style compare callback with user context (negative if
+	// a comes before b, 0 if equal, positive if a comes after b)
 	void Sort(int (*callback)(TArg a, TArg b, void* user), void* user)
 	{
-		sort_ctx_s ctx;
-		ctx.callback = callback;
-		ctx.user = user;
-		#ifdef _MSC_VER
-		qsort_s(m_data, m_count, sizeof(TStorage), sort_function_s, &ctx);
-		#else
-		qsort_r(m_data, m_count, sizeof(TStorage), sort_function_s, &ctx);
-		#endif
+		Sorting::Sort(m_data, m_count, [=](const TStorage& a, const TStorage& b) {
+			return callback(a, b, user) < 0;
+		});
 	}
 
-private:
-	struct sort_ctx
-	{
-		int (*callback)(TArg a, TArg b);
-	};
-
-#ifdef _MSC_VER
-	static int sort_function(void* pvctx, const void* a, const void* b)
-#else
-	static int sort_function(const void* a, const void* b, void* pvctx)
-#endif
+	// Sort using a C style compare callback
+	void Sort(int (*callback)(TArg a, TArg b))
 	{
-		sort_ctx& ctx = *(sort_ctx*)pvctx;
-		return ctx.callback(*(TStorage*)a, *(TStorage*)b);
+		Sorting::Sort(m_data, m_count, [=](const TStorage& a, const TStorage& b) {
+			return callback(a, b) < 0;
+		});
 	}
 
-public:
-	void Sort(int (*callback)(TArg a, TArg b))
+	// Sort using any callable (eg. a lambda) with the same convention as
+	// the callbacks above. Unlike a function pointer, the comparison is
+	// inlined into the sort loop. (Function pointers still pick the
+	// overload above since a non-template is preferred on an exact match)
+	template <typename TCompare>
+	void Sort(TCompare compare)
 	{
-		sort_ctx ctx;
-		ctx.callback = callback;
-		#ifdef _MSC_VER
-		qsort_s(m_data, m_count, sizeof(TStorage), sort_function, &ctx);
-		#else
-		qsort_r(m_data, m_count, sizeof(TStorage), sort_function, &ctx);
-		#endif
+		Sorting::Sort(m_data, m_count, [&](const TStorage& a, const TStorage& b) {
+			return compare(static_cast<const TArg&>(a), static_cast<const TArg&>(b)) < 0;
+		});
 	}
 
 	// Sort using the default comparer
 	template <typename TCompare = SDefaultCompare>
 	void Sort()
 	{
-		Sort([](TArg a, TArg b) {
-			return TCompare::Compare(a, b);
+		Sorting::Sort(m_data, m_count, [](const TStorage& a, const TStorage& b) {
+			return CompareLess<TCompare>(a, b);
 		});
 	}
 
+	// Stable sort variants of the above - elements that compare equal keep
+	// their relative order. Needs a temporary buffer the size of the list
+	// (from the list's allocator), returns false if it couldn't be allocated.
+	bool StableSort(int (*callback)(TArg a, TArg b, void* user), void* user)
+	{
+		return Sorting::StableSort(m_data, m_count, [=](const TStorage& a, const TStorage& b) {
+			return callback(a, b, user) < 0;
+		}, GetAllocator());
+	}
+
+	bool StableSort(int (*callback)(TArg a, TArg b))
+	{
+		return Sorting::StableSort(m_data, m_count, [=](const TStorage& a, const TStorage& b) {
+			return callback(a, b) < 0;
+		}, GetAllocator());
+	}
+
+	template <typename TCompare>
+	bool StableSort(TCompare compare)
+	{
+		return Sorting::StableSort(m_data, m_count, [&](const TStorage& a, const TStorage& b) {
+			return compare(static_cast<const TArg&>(a), static_cast<const TArg&>(b)) < 0;
+		}, GetAllocator());
+	}
+
+	template <typename TCompare = SDefaultCompare>
+	bool StableSort()
+	{
+		return Sorting::StableSort(m_data, m_count, [](const TStorage& a, const TStorage& b) {
+			return CompareLess<TCompare>(a, b);
+		}, GetAllocator());
+	}
+
+	// Stable sort by an integral, floating point or pointer key returned by
+	// `key(TArg)` using a radix sort (see Sorting::RadixSort). Usually much
+	// faster than a comparison sort for large lists of small keys. Needs a
+	// temporary buffer the size of the list (from the list's allocator), returns false
+	// if it couldn't be allocated.
+	template <typename TKeyFn>
+	bool RadixSort(TKeyFn key)
+	{
+		return Sorting::RadixSort(m_data, m_count, [&](const TStorage& a) {
+			return key(static_cast<const TArg&>(a));
+		}, GetAllocator());
+	}
+
+	// Radix sort using the elements themselves as the keys
+	bool RadixSort()
+	{
+		return Sorting::RadixSort(m_data, m_count, [](const TStorage& a) {
+			return static_cast<const TArg&>(a);
+		}, GetAllocator());
+	}
+
+private:
+	// Less-than predicate for a comparer. For the default comparer
+	// Compare(a, b) < 0 is just a < b, but compilers don't reliably fold
+	// the three way compare back down and it costs a second, badly
+	// predicted, branch per comparison - so use operator< directly.
+	template <typename TCompare>
+	static bool KeyLess(const TArg& a, const TArg& b)
+	{
+		if constexpr (std::is_same<TCompare, SDefaultCompare>::value)
+			return a < b;
+		else
+			return TCompare::Compare(a, b) < 0;
+	}
+
+	template <typename TCompare>
+	static bool CompareLess(const TStorage& a, const TStorage& b)
+	{
+		return KeyLess<TCompare>(static_cast<const TArg&>(a), static_cast<const TArg&>(b));
+	}
+
 public:
 	// Find index of an item(linear)
 	template <typename TCompare = SDefaultCompare>
 	int IndexOf(TArg val, int iStartAfter = -1) const
 	{
+		// Plain integers, floats and pointers compared with the default
+		// comparer can be scanned with vector compares
+		if constexpr (std::is_same<TCompare, SDefaultCompare>::value && Search::is_scannable<TStorage>::value)
+		{
+			int start = iStartAfter + 1;
+			if (start >= m_count)
+				return -1;
+			int index = Search::IndexOf(m_data + start, m_count - start, (TStorage)val);
+			return index < 0 ? -1 : start + index;
+		}
+
 		// Find an item
 		for (int i = iStartAfter + 1; i < m_count; i++)
 		{
@@ -655,7 +763,7 @@ public:
 
 	List Filter(Delegate<bool(TArg val)> predicate)
 	{
-		List r;
+		List r(GetAllocator());
 		for (int i=0; i<GetCount(); i++)
 		{
 			if (predicate(GetAt(i)))
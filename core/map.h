@@ -5,6 +5,7 @@
 #include "HashCore.h"
 #include "PlacedConstructor.h"
 #include "Allocator.h"
+#include "Query.h"
 
 namespace SimpleLib
 {
@@ -24,6 +25,13 @@ public:
     {
     }
 
+    // Constructor with a specific allocator instance (for stateful
+    // allocators, eg: a handle to an arena)
+    explicit Map(const TAllocator& allocator)
+        : core(allocator)
+    {
+    }
+
     // Destructor
     virtual ~Map()
     {
@@ -109,14 +117,6 @@ public:
 
         bool Next() { return _owner->GetNext(*this); }
 
-    private:
-        Iter(Map* owner, bool forward, int version)
-        {
-            _owner = owner;
-            _forward = forward;
-            _version = version;
-        }
-
         Iter(const Iter& other)
         {
             _owner = other._owner;
@@ -127,28 +127,43 @@ public:
             _value = other._value;
         }
 
+    private:
+        Iter(const Map* owner, bool forward, int version)
+        {
+            _owner = owner;
+            _forward = forward;
+            _version = version;
+        }
+
         const TKeyStorage* _key = nullptr;
         const TValueStorage* _value = nullptr;
-        Map* _owner;
+        const Map* _owner;
         int _pos = -1;
         int _version = 0;
         bool _forward = false;
         friend class Map;
     };
 
-    Iter Iterate()
+    Iter Iterate() const
     {
         return Iter(this, true, core.get_table_version());
     }
 
-    Iter IterateReverse()
+    Iter IterateReverse() const
     {
         Iter iter(this, false, core.get_table_version());
         iter._pos = core.get_table_count();
         return iter;
     }
 
-    bool GetNext(Iter& iter)
+    // Lazy query over the map's entries, as QueryPair<TKeyArg, TValueArg>
+    // items (see Query.h)
+    Query<QueryMapSource<Iter, TKeyArg, TValueArg>> AsQuery() const
+    {
+        return Query<QueryMapSource<Iter, TKeyArg, TValueArg>>(QueryMapSource<Iter, TKeyArg, TValueArg>(Iterate()));
+    }
+
+    bool GetNext(Iter& iter) const
     {
         // Check not modified
         assert(core.get_table_version() == iter._version);
@@ -255,13 +270,52 @@ public:
         return core.Find(&Key) != nullptr;
     }
 
+    // Get an item using a lookup key (eg: a StringView for String keys, see
+    // can_lookup), return default if doesn't exist
+    template <typename TLookup, typename = std::enable_if_t<can_lookup<TKey, TKeyCompare, TLookup>::value>>
+    TValueArg Get(const TLookup& Key, TValueArg Default) const
+    {
+        const TValueStorage* val = FindLookup(Key);
+        if (val)
+        {
+            return *val;
+        }
+        return Default;
+    }
+
+    // Find an item using a lookup key
+    template <typename TLookup, typename = std::enable_if_t<can_lookup<TKey, TKeyCompare, TLookup>::value>>
+    bool TryGetValue(const TLookup& Key, TValueArg& Value) const
+    {
+        const TValueStorage* val = FindLookup(Key);
+        if (val)
+        {
+            Value = *val;
+            return true;
+        }
+        return false;
+    }
+
+    // Check if a map contains a lookup key
+    template <typename TLookup, typename = std::enable_if_t<can_lookup<TKey, TKeyCompare, TLookup>::value>>
+    bool ContainsKey(const TLookup& Key) const
+    {
+        return FindLookup(Key) != nullptr;
+    }
+
+    // Get the allocator this map allocates from
+    decltype(auto) GetAllocator() const
+    {
+        return core.GetAllocator();
+    }
+
     // Implementation
 private:
     class Core : public HashCore<TAllocator>
     {
     public:
-        Core() :
-            HashCore(sizeof(TKeyStorage), sizeof(TValueStorage))
+        Core(const TAllocator& allocator = TAllocator()) :
+            HashCore(sizeof(TKeyStorage), sizeof(TValueStorage), allocator)
         {
         };
         virtual ~Core()
@@ -292,6 +346,14 @@ private:
     Core core;
 
 private:
+    template <typename TLookup>
+    const TValueStorage* FindLookup(const TLookup& Key) const
+    {
+        return (const TValueStorage*)core.Find(TKeyCompare::Hash(Key), [&](const void* entryKey) {
+            return TKeyCompare::AreEqual(*(const TKeyStorage*)entryKey, Key);
+        });
+    }
+
     // Internal helper to add item to map
     void AddInternal(TKeyArg Key, TValueArg Value, bool replace)
     {
@@ -5,6 +5,7 @@
 #include "HashCore.h"
 #include "PlacedConstructor.h"
 #include "Allocator.h"
+#include "Query.h"
 
 namespace SimpleLib
 {
@@ -21,6 +22,13 @@ public:
     {
     }
 
+    // Constructor with a specific allocator instance (for stateful
+    // allocators, eg: a handle to an arena)
+    explicit Set(const TAllocator& allocator)
+        : core(allocator)
+    {
+    }
+
     Set(Set&& other)
         : core(SimpleLib::move(other.core))
     {
@@ -116,14 +124,6 @@ public:
 
         bool Next() { return _owner->GetNext(*this); }
 
-    private:
-        Iter(const Set* owner, bool forward, int version)
-        {
-            _owner = owner;
-            _forward = forward;
-            _version = version;
-        }
-
         Iter(const Iter& other)
         {
             _owner = other._owner;
@@ -133,6 +133,14 @@ public:
             _key = other._key;
         }
 
+    private:
+        Iter(const Set* owner, bool forward, int version)
+        {
+            _owner = owner;
+            _forward = forward;
+            _version = version;
+        }
+
         const TStorage* _key = nullptr;
         const Set* _owner;
         int _pos = -1;
@@ -153,6 +161,12 @@ public:
         return iter;
     }
 
+    // Lazy query over the set's items (see Query.h)
+    Query<Iter> AsQuery() const
+    {
+        return Query<Iter>(Iterate());
+    }
+
     bool GetNext(Iter& iter) const
     {
         // Check not modified
@@ -199,9 +213,25 @@ public:
         return core.Find(&Key) != nullptr;
     }
 
+    // Check if a Set contains a lookup key (eg: a StringView for String
+    // keys, see can_lookup)
+    template <typename TLookup, typename = std::enable_if_t<can_lookup<T, TCompare, TLookup>::value>>
+    bool Contains(const TLookup& Key) const
+    {
+        return core.Find(TCompare::Hash(Key), [&](const void* entryKey) {
+            return TCompare::AreEqual(*(const TStorage*)entryKey, Key);
+        }) != nullptr;
+    }
+
+    // Get the allocator this set allocates from
+    decltype(auto) GetAllocator() const
+    {
+        return core.GetAllocator();
+    }
+
     static Set Union(const Set& a, const Set& b)
     {
-        Set r;
+        Set r(a.core.GetAllocator());
         r.AddMany(a);
         r.AddMany(b);
         return r;
@@ -209,7 +239,7 @@ public:
 
     static Set Intersection(const Set& a, const Set& b)
     {
-        Set r;
+        Set r(a.core.GetAllocator());
         for (auto iter = a.Iterate(); iter.Next(); )
         {
             if (b.Contains(iter.Get()))
@@ -221,7 +251,7 @@ public:
     // Items in `a` that are not in `b`
     static Set Difference(const Set& a, const Set& b)
     {
-        Set r;
+        Set r(a.core.GetAllocator());
         for (auto iter = a.Iterate(); iter.Next(); )
         {
             if (!b.Contains(iter.Get()))
@@ -235,8 +265,8 @@ private:
     class Core : public HashCore<TAllocator>
     {
     public:
-        Core() :
-            HashCore(sizeof(TStorage), 0)
+        Core(const TAllocator& allocator = TAllocator()) :
+            HashCore(sizeof(TStorage), 0, allocator)
         {
         };
         virtual ~Core()
@@ -2,9 +2,15 @@
 
 #include <assert.h>
 
+#include "RefCount.h"
+
 namespace SimpleLib
 {
-	template <typename T>
+	// Reference counted pointer that deletes the object when the last
+	// SharedPtr to it is released. TRefCount selects how references are
+	// counted (see RefCount.h) - use AtomicSharedPtr when copies are made
+	// and released on more than one thread.
+	template <typename T, typename TRefCount = SRefCount>
 	class SharedPtr
 	{
 	public:
@@ -80,45 +86,52 @@ namespace SimpleLib
 			return !(*this == other);
 		}
 
-		bool operator==(const SharedPtr<T>& other) const
+		bool operator==(const SharedPtr& other) const
 		{
 			return static_cast<const void*>(_pControl ? _pControl->_ptr : nullptr) == 
 					static_cast<const void*>(other._pControl ? other._pControl->_ptr : nullptr);
 		}
 
-		bool operator!=(const SharedPtr<T>& other) const 
+		bool operator!=(const SharedPtr& other) const 
 		{
 			return !(*this == other);
 		}
 
-		const SharedPtr<T>& operator=(const SharedPtr<T>& other)
+		const SharedPtr& operator=(const SharedPtr& other)
 		{
+			// AddRef first in case it's the same object
+			if (other._pControl)
+				other._pControl->AddRef();
+
 			if (_pControl)
 				_pControl->Release();
 
 			_pControl = other._pControl;
-
-			if (_pControl)
-				_pControl->AddRef();
 			return *this;
 		}
 
-		SharedPtr<T>& operator=(SharedPtr<T>&& Other)
+		SharedPtr& operator=(SharedPtr&& Other)
 		{
-			_pControl = Other._pControl;
-			Other._pControl = nullptr;
+			if (this != &Other)
+			{
+				if (_pControl)
+					_pControl->Release();
+				_pControl = Other._pControl;
+				Other._pControl = nullptr;
+			}
+			return *this;
 		}
 		
 	private:
 		struct CONTROL
 		{
-			int _nRef;
+			typename TRefCount::TCount _nRef;
 			T* _ptr;
 
 			CONTROL(T* ptr)
 			{
 				_ptr = ptr;
-				_nRef = 1;
+				TRefCount::Init(_nRef);
 			}
 
 			~CONTROL()
@@ -129,17 +142,20 @@ namespace SimpleLib
 
 			void AddRef()
 			{
-				_nRef++;
+				TRefCount::AddRef(_nRef);
 			}
 
 			void Release()
 			{
-				_nRef--;
-				if (_nRef == 0)
+				if (TRefCount::Release(_nRef))
 					delete this;
 			}
 		};
 
 		CONTROL* _pControl;
 	};
+
+	// SharedPtr whose copies can be made and released on any thread
+	template <typename T>
+	using AtomicSharedPtr = SharedPtr<T, SAtomicRefCount>;
 }
@@ -5,63 +5,99 @@
 #include <string.h>
 #include <stdarg.h>
 #include <stddef.h>
+#include <atomic>
 
 #include "List.h"
 #include "StringBuilder.h"
 #include "Parse.h"
+#include "RefCount.h"
+#include "StringView.h"
 
 
 namespace SimpleLib
 {
 	/*
 	Simple immutable string class stores a string.
+
+	Short strings (up to kInlineCapacity characters - 23 chars for a
+	String on 64-bit platforms) are stored inside the object itself, so
+	creating, copying and destroying them never touches the heap. Longer
+	strings are kept in a shared, reference counted heap buffer so copies
+	are still cheap.
+
+	TRefCount selects how the heap buffer is reference counted (see
+	RefCount.h) - AtomicString's copies can be shared across threads.
 	*/
 
-	template <typename T>
+	template <typename T, typename TRefCount>
 	class StringCore
 	{
 	public:
 		// Constructor
 		StringCore()
 		{
-			m_pData = nullptr;
+			SetNull();
 		}
 
 		// Copy Constructor
-		StringCore(const StringCore<T>& other)
+		StringCore(const StringCore& other)
 		{
-			m_pData = nullptr;
-			Assign(other);
+			CopyFrom(other);
 		}
 
 		// Move Constructor
-		StringCore(StringCore<T>&& other)
+		StringCore(StringCore&& other)
 		{
-			m_pData = other.m_pData;
-			other.m_pData = nullptr;
+			memcpy(m_inline, other.m_inline, sizeof(m_inline));
+			other.SetNull();
 		}
 
 		// Constructor
 		StringCore(const T* psz, int iLength)
 		{
-			m_pData = AllocStringData(psz, iLength);
+			Init(psz, iLength);
 		}
 
 		// Constructor
 		StringCore(const T* psz)
 		{
-			if (psz == nullptr)
-				m_pData = nullptr;
-			else
-				m_pData = AllocStringData(psz, -1);
+			Init(psz, -1);
+		}
+
+		// Copy from a string with another reference count policy (the
+		// characters are copied, the buffers can't be shared)
+		template <typename TOtherRefCount>
+		explicit StringCore(const StringCore<T, TOtherRefCount>& other)
+		{
+			Init(other.sz(), other.GetLength());
+		}
+
+		// Copy the characters of a view
+		explicit StringCore(const StringView<T>& view)
+		{
+			Init(view.GetBuffer(), view.GetLength());
 		}
 
 		// Constructor
-		StringCore(const StringBuilder<T>& builder)
+		template <typename TAllocator>
+		StringCore(const StringBuilder<T, TAllocator>& builder)
 		{
-			int length;
-			const T* psz = builder.Finish(&length);
-			m_pData = AllocStringData(psz, length);
+			if (builder.IsContiguous())
+			{
+				int length;
+				const T* psz = builder.Finish(&length);
+				Init(psz, length);
+				return;
+			}
+
+			// Copy a chunked builder's chunks straight in rather than
+			// flattening them first
+			T* p = Init(builder.GetLength());
+			builder.ForEachChunk([&](const T* chunk, int length) {
+				memcpy(p, chunk, length * sizeof(T));
+				p += length;
+				return true;
+			});
 		}
 
 		// Destructor
@@ -71,25 +107,29 @@ namespace SimpleLib
 		}
 
 		// Types
-		typedef StringCore<T> _CString;
+		typedef StringCore _CString;
 
 		// Assignment
-		StringCore<T>& operator=(const StringCore<T>& Other)
+		StringCore& operator=(const StringCore& Other)
 		{
 			Assign(Other);
 			return *this;
 		}
 
 		// Move Assignment
-		StringCore<T>& operator=(StringCore<T>&& Other)
+		StringCore& operator=(StringCore&& Other)
 		{
-			m_pData = Other.m_pData;
-			Other.m_pData = nullptr;
+			if (this != &Other)
+			{
+				Clear();
+				memcpy(m_inline, Other.m_inline, sizeof(m_inline));
+				Other.SetNull();
+			}
 			return *this;
 		}
 
 		// Assignment
-		StringCore<T>& operator=(const T* psz) 
+		StringCore& operator=(const T* psz) 
 		{
 			Assign(psz, -1);
 			return *this;
@@ -98,9 +138,9 @@ namespace SimpleLib
 		// operator[]
 		const T operator[] (int iPos)
 		{
-			assert(m_pData);
-			assert(iPos >= 0 && iPos < m_pData->m_iLength);
-			return m_pData->m_sz[iPos];
+			assert(!IsNull());
+			assert(iPos >= 0 && iPos < GetLength());
+			return sz()[iPos];
 		}
 
 		// const T* operator
@@ -109,32 +149,32 @@ namespace SimpleLib
 			return sz();
 		}
 
-		bool operator ==(const StringCore<T>& b) const
+		bool operator ==(const StringCore& b) const
 		{
-			return this->IsEqualTo(b.sz());
+			return Equals(b);
 		}
 
-		bool operator !=(const StringCore<T>& b) const
+		bool operator !=(const StringCore& b) const
 		{
-			return !this->IsEqualTo(b.sz());
+			return !Equals(b);
 		}
 
-		bool operator <(const StringCore<T>& b) const
+		bool operator <(const StringCore& b) const
 		{
 			return SCase::Compare(sz(), b.sz()) < 0;
 		}
 
-		bool operator >(const StringCore<T>& b) const
+		bool operator >(const StringCore& b) const
 		{
 			return SCase::Compare(sz(), b.sz()) > 0;
 		}
 
-		bool operator <=(const StringCore<T>& b) const
+		bool operator <=(const StringCore& b) const
 		{
 			return SCase::Compare(sz(), b.sz()) <= 0;
 		}
 
-		bool operator >=(const StringCore<T>& b) const
+		bool operator >=(const StringCore& b) const
 		{
 			return SCase::Compare(sz(), b.sz()) >= 0;
 		}
@@ -145,7 +185,7 @@ namespace SimpleLib
 			return IsNullOrEmpty(sz());
 		}
 
-		StringCore<T> operator+(const StringCore<T>& other) const
+		StringCore operator+(const StringCore& other) const
 		{
 			StringBuilder<T> builder;
 			builder.Append(sz(), GetLength());
@@ -153,16 +193,16 @@ namespace SimpleLib
 			return builder;
 		}
 
-		StringCore<T> operator+=(const T* psz)
+		StringCore operator+=(const T* psz)
 		{
 			StringBuilder<T> builder;
 			builder.Append(sz(), GetLength());
 			builder.Append(psz);
-			*this = StringCore<T>(builder);
+			*this = StringCore(builder);
 			return *this;
 		}
 
-		StringCore<T> operator+=(const StringCore<T>& other)
+		StringCore operator+=(const StringCore& other)
 		{
 			*this = *this + other;
 			return *this;
@@ -180,26 +220,27 @@ namespace SimpleLib
 		// Get null terminated string
 		const T* sz() const
 		{
+			if (IsInline())
+				return m_inline;
 			return m_pData ? m_pData->m_sz : nullptr;
 		}
 
 		void Clear()
 		{
-			if (m_pData)
+			if (!IsInline() && m_pData)
 			{
 				assert(m_pData->m_sz[m_pData->m_iLength] == '\0');
-				m_pData->m_iRef--;
-				if (m_pData->m_iRef == 0)
+				if (TRefCount::Release(m_pData->m_iRef))
 				{
-					free(m_pData);
+					TMalloc::Free(m_pData);
 				}
-				m_pData = nullptr;
 			}
+			SetNull();
 		}
 
 		bool IsNull() const
 		{
-			return m_pData == nullptr;
+			return !IsInline() && m_pData == nullptr;
 		}
 
 		bool IsEmpty() const
@@ -207,76 +248,90 @@ namespace SimpleLib
 			return GetLength() == 0;
 		}
 
-		bool Assign(const StringCore<T>& Other)
+		bool Assign(const StringCore& Other)
 		{
+			if (this == &Other)
+				return true;
 			Clear();
-			m_pData = Other.m_pData;
-			if (m_pData)
-				m_pData->m_iRef++;
+			CopyFrom(Other);
 			return true;
 		}
 
 		void Assign(const T* psz, int iLength = -1)
 		{
-			// Clear old value
-			Clear();
-
-			// Store new
-			m_pData = AllocStringData(psz, iLength);
+			// Build the new value first, psz might point into this string
+			StringCore temp(psz, iLength);
+			*this = SimpleLib::move(temp);
 		}
 
 		int GetLength() const
 		{
+			if (IsInline())
+				return kInlineCapacity - (int)m_inline[kInlineUnits - 1];
 			return m_pData ? m_pData->m_iLength : 0;
 		}
 
-		StringCore<T> ToUpper()
+		StringCore ToUpper()
 		{
-			if (m_pData == nullptr)
-				return StringCore<T>();
+			if (IsNull())
+				return StringCore();
 
 			// Allocate new string buffer
-			StringData* pNew = AllocStringData(nullptr, GetLength());
+			StringCore result;
+			int length = GetLength();
+			T* pDest = result.Init(length);
 
-			// Get source/dest
+			// Get source
 			const T* pSrc = sz();
-			T* pDest = pNew->m_sz;
 
-			// Copy and to upper
-			int length = GetLength();
-			for (int i=0; i<length; i++)
+			// Copy and to upper (char strings fold ASCII only, a vector at a time)
+			if constexpr (std::is_same<T, char>::value)
+			{
+				StringSimd::ToUpper(pDest, pSrc, length);
+			}
+			else
 			{
-				*pDest++ = SChar<T>::ToUpper(*pSrc++);
+				for (int i=0; i<length; i++)
+				{
+					*pDest++ = SChar<T>::ToUpper(*pSrc++);
+				}
 			}
 
 			// Return new string
-			return StringCore<T>::WithData(pNew);
+			return result;
 		}
 
-		StringCore<T> ToLower()
+		StringCore ToLower()
 		{
-			if (m_pData == nullptr)
-				return StringCore<T>();
+			if (IsNull())
+				return StringCore();
 
 			// Allocate new string buffer
-			StringData* pNew = AllocStringData(nullptr, GetLength());
+			StringCore result;
+			int length = GetLength();
+			T* pDest = result.Init(length);
 
-			// Get source/dest
+			// Get source
 			const T* pSrc = sz();
-			T* pDest = pNew->m_sz;
 
-			// Copy and to upper
-			int length = GetLength();
-			for (int i=0; i<length; i++)
+			// Copy and to lower (char strings fold ASCII only, a vector at a time)
+			if constexpr (std::is_same<T, char>::value)
 			{
-				*pDest++ = SChar<T>::ToLower(*pSrc++);
+				StringSimd::ToLower(pDest, pSrc, length);
+			}
+			else
+			{
+				for (int i=0; i<length; i++)
+				{
+					*pDest++ = SChar<T>::ToLower(*pSrc++);
+				}
 			}
 
 			// Return new string
-			return StringCore<T>::WithData(pNew);
+			return result;
 		}
 
-		StringCore<T> SubString(int iStart, int iLength = -1)
+		StringCore SubString(int iStart, int iLength = -1)
 		{
 			int thisLength = GetLength();
 
@@ -289,36 +344,56 @@ namespace SimpleLib
 			assert(iStart >= 0);
 			assert(iStart + iLength <= thisLength);
 
-			return StringCore<T>(m_pData->m_sz + iStart, iLength);
+			return StringCore(sz() + iStart, iLength);
+		}
+
+		// Get a view of the whole string
+		StringView<T> View() const
+		{
+			return StringView<T>(*this);
+		}
+
+		// Get a view of part of the string (like SubString, but without
+		// copying - the view is only valid while this string is)
+		StringView<T> Slice(int iStart, int iLength = -1) const
+		{
+			return View().SubString(iStart, iLength);
 		}
 
 		// Remove leading whitespace, returning *this if there was none
-		StringCore<T> LTrim() const
+		StringCore LTrim() const
 		{
-			if (m_pData == nullptr)
+			if (IsNull())
 				return *this;
 
-			int length = m_pData->m_iLength;
-			const T* p = m_pData->m_sz;
+			int length = GetLength();
+			const T* p = sz();
 
 			int start = 0;
-			while (start < length && Parse<T>::IsWhiteSpace(p[start]))
-				start++;
+			if constexpr (std::is_same<T, char>::value)
+			{
+				start = StringSimd::SkipWhiteSpace(p, length);
+			}
+			else
+			{
+				while (start < length && Parse<T>::IsWhiteSpace(p[start]))
+					start++;
+			}
 
 			if (start == 0)
 				return *this;
 
-			return StringCore<T>(p + start, length - start);
+			return StringCore(p + start, length - start);
 		}
 
 		// Remove trailing whitespace, returning *this if there was none
-		StringCore<T> RTrim() const
+		StringCore RTrim() const
 		{
-			if (m_pData == nullptr)
+			if (IsNull())
 				return *this;
 
-			int length = m_pData->m_iLength;
-			const T* p = m_pData->m_sz;
+			int length = GetLength();
+			const T* p = sz();
 
 			int end = length;
 			while (end > 0 && Parse<T>::IsWhiteSpace(p[end - 1]))
@@ -327,11 +402,11 @@ namespace SimpleLib
 			if (end == length)
 				return *this;
 
-			return StringCore<T>(p, end);
+			return StringCore(p, end);
 		}
 
 		// Remove leading and trailing whitespace, returning *this if there was none
-		StringCore<T> Trim() const
+		StringCore Trim() const
 		{
 			return LTrim().RTrim();
 		}
@@ -340,13 +415,22 @@ namespace SimpleLib
 		int IndexOf(T find, int startOffset = 0) const
 		{
 			// Check bounds
-			if (m_pData == nullptr || m_pData->m_iLength == 0)
+			int length = GetLength();
+			if (length == 0)
 				return -1;
 
-			// Find it
-			for (int i = startOffset; i <= m_pData->m_iLength; i++)
+			// Find it (including the terminator, so finding '\0' gives the length)
+			const T* p = sz();
+			if constexpr (std::is_same<T, char>::value && std::is_same<S, SCase>::value)
 			{
-				if (S::Compare(m_pData->m_sz[i], find) == 0)
+				if (startOffset > length)
+					return -1;
+				int index = StringSimd::IndexOf(p + startOffset, length + 1 - startOffset, find);
+				return index < 0 ? -1 : startOffset + index;
+			}
+			for (int i = startOffset; i <= length; i++)
+			{
+				if (S::Compare(p[i], find) == 0)
 					return i;
 			}
 
@@ -357,17 +441,25 @@ namespace SimpleLib
 		int IndexOf(const T* find, int startOffset = 0) const
 		{
 			// Check bounds
-			if (find == nullptr || *find == 0 || m_pData == nullptr || m_pData->m_iLength == 0)
+			if (find == nullptr || *find == 0 || GetLength() == 0)
 				return -1;
 
 			// Get search string length
 			int srcLen = SChar<T>::Length(find);
 
 			// Find it
-			int stopPos = m_pData->m_iLength - srcLen;
+			const T* p = sz();
+			if constexpr (std::is_same<T, char>::value && std::is_same<S, SCase>::value)
+			{
+				if (startOffset > GetLength())
+					return -1;
+				int index = StringSimd::IndexOf(p + startOffset, GetLength() - startOffset, find, srcLen);
+				return index < 0 ? -1 : startOffset + index;
+			}
+			int stopPos = GetLength() - srcLen;
 			for (int i = startOffset; i <= stopPos; i++)
 			{
-				if (S::Compare(m_pData->m_sz + i, find, srcLen) == 0)
+				if (S::Compare(p + i, find, srcLen) == 0)
 					return i;
 			}
 
@@ -377,12 +469,14 @@ namespace SimpleLib
 		template <class S = SCase>
 		int IndexOfAny(const T* chars, int startOffset = 0) const
 		{
-			if (m_pData == nullptr)
+			if (IsNull())
 				return -1;
 
-			for (int i=startOffset; i<m_pData->m_iLength; i++)
+			const T* p = sz();
+			int length = GetLength();
+			for (int i=startOffset; i<length; i++)
 			{
-				if (IsOneOf<S>(chars, m_pData->m_sz[i]))
+				if (IsOneOf<S>(chars, p[i]))
 					return i;
 			}
 
@@ -405,19 +499,20 @@ namespace SimpleLib
 		int LastIndexOf(const T* find, int startOffset = -1) const
 		{
 			// Check bounds
-			if (find == nullptr || *find == 0 || m_pData == nullptr || m_pData->m_iLength == 0)
+			if (find == nullptr || *find == 0 || GetLength() == 0)
 				return -1;
 
 			// Get search string length
 			int srcLen = SChar<T>::Length(find);
 
 			if (startOffset < 0)
-				startOffset = m_pData->m_iLength - 1;
+				startOffset = GetLength() - 1;
 
 			// Find it
+			const T* p = sz();
 			for (int i = startOffset; i >= 0; i--)
 			{
-				if (S::Compare(m_pData->m_sz + i, find, srcLen) == 0)
+				if (S::Compare(p + i, find, srcLen) == 0)
 					return i;
 			}
 
@@ -427,15 +522,16 @@ namespace SimpleLib
 		template <class S = SCase>
 		int LastIndexOfAny(const T* chars, int startOffset = -1) const
 		{
-			if (m_pData == nullptr)
+			if (IsNull())
 				return -1;
 
 			if (startOffset < 0)
-				startOffset = m_pData->m_iLength - 1;
+				startOffset = GetLength() - 1;
 
+			const T* p = sz();
 			for (int i=startOffset; i>=0; i--)
 			{
-				if (IsOneOf<S>(chars, m_pData->m_sz[i]))
+				if (IsOneOf<S>(chars, p[i]))
 				{
 					return i;
 				}
@@ -445,7 +541,7 @@ namespace SimpleLib
 		}
 
 		template <class S = SCase>
-		StringCore<T> Replace(const T* find, const T* replace, int maxReplacements = -1, int startOffset = 0)
+		StringCore Replace(const T* find, const T* replace, int maxReplacements = -1, int startOffset = 0)
 		{
 			// Start offset past end of string?
 			assert(startOffset <= GetLength());
@@ -477,24 +573,24 @@ namespace SimpleLib
 		template <class S = SCase>
 		bool StartsWith(const T* find) const
 		{
-			if (m_pData == nullptr)
+			if (IsNull())
 				return false;
-			return S::Compare(m_pData->m_sz, find, SChar<T>::Length(find)) == 0;
+			return S::Compare(sz(), find, SChar<T>::Length(find)) == 0;
 		}
 
 		template <class S = SCase>
 		bool EndsWith(const T* find) const
 		{
-			if (m_pData == nullptr)
+			if (IsNull())
 				return false;
 			int findLen = SChar<T>::Length(find);
-			int startPos = m_pData->m_iLength  - findLen;
+			int startPos = GetLength() - findLen;
 			if (startPos < 0)
 				return false;
-			return S::Compare(m_pData->m_sz + startPos, find, findLen) == 0;
+			return S::Compare(sz() + startPos, find, findLen) == 0;
 		}
 
-		static StringCore<T> Join(List<StringCore<T>>& parts, T separator)
+		static StringCore Join(List<StringCore>& parts, T separator)
 		{
 			StringBuilder<T> sb;
 			for (int i=0; i<parts.GetCount(); i++)
@@ -506,7 +602,7 @@ namespace SimpleLib
 			return sb.Finish();
 		}
 
-		static StringCore<T> Join(List<StringCore<T>>& parts, const T* separator)
+		static StringCore Join(List<StringCore>& parts, const T* separator)
 		{
 			StringBuilder<T> sb;
 			for (int i=0; i<parts.GetCount(); i++)
@@ -518,17 +614,24 @@ namespace SimpleLib
 			return sb.Finish();
 		}
 
+		// Split into views of this string (valid while this string is)
+		template <typename S = SCase>
+		int Split(const T* separators, bool includeEmpty, List<StringView<T>>& parts) const
+		{
+			return View().template Split<S>(separators, includeEmpty, parts);
+		}
+
 		template <typename S = SCase>
-		int Split(const T* separators, bool includeEmpty, List<StringCore<T>>& parts) const
+		int Split(const T* separators, bool includeEmpty, List<StringCore>& parts) const
 		{
 			// Clear buffer
 			parts.Clear();
 
-			if (m_pData == nullptr)
+			if (IsNull())
 				return 0;
 
 			// Get start of string
-			const T* p = m_pData->m_sz;
+			const T* p = sz();
 			if (!p)
 				return 0;
 
@@ -539,7 +642,7 @@ namespace SimpleLib
 				if (IsOneOf<S>(separators, *p))
 				{
 					if (includeEmpty || p > pPart)
-						parts.Add(StringCore<T>(pPart, (int)(p - pPart)));
+						parts.Add(StringCore(pPart, (int)(p - pPart)));
 
 					pPart = p + 1;
 					p = pPart;
@@ -551,21 +654,28 @@ namespace SimpleLib
 			}
 
 			if (includeEmpty || p > pPart)
-				parts.Add(StringCore<T>(pPart, (int)(p - pPart)));
+				parts.Add(StringCore(pPart, (int)(p - pPart)));
 
 			return parts.GetCount();
 		}
 
-		static StringCore<T> Format(const T* pFormat, ...)
+		template <typename... TArgs>
+		static StringCore Format(const FormatString<T, typename std::decay<TArgs>::type...>& format, const TArgs&... args)
 		{
-			va_list args;
-			va_start(args, pFormat);
-			StringCore<T> result = FormatV(pFormat, args);
-			va_end(args);
-			return result;
+			StringBuilder<T> buf;
+			Formatting::Format(buf, format, args...);
+			return buf.Finish();
+		}
+
+		template <typename TFn, typename... TArgs>
+		static StringCore Format(const CompiledFormat<TFn>& format, const TArgs&... args)
+		{
+			StringBuilder<T> buf;
+			buf.Format(format, args...);
+			return buf.Finish();
 		}
 
-		static StringCore<T> FormatV(const T* pFormat, va_list args)
+		static StringCore FormatV(const T* pFormat, va_list args)
 		{
 			StringBuilder<T> buf;
 			buf.FormatV(pFormat, args);
@@ -582,14 +692,14 @@ namespace SimpleLib
 
 			// Copy it
 			if (srclen)
-				memcpy(buf, m_pData->m_sz, srclen * sizeof(T));
+				memcpy(buf, sz(), srclen * sizeof(T));
 			buf[srclen] = '\0';
 			return true;
 		}
 
 		T* AllocCopy(int withLengthInChars=0)
 		{
-			if (m_pData == nullptr)
+			if (IsNull())
 			{
 				return nullptr;
 			}
@@ -599,50 +709,148 @@ namespace SimpleLib
 				if (withLengthInChars != 0 && withLengthInChars < length)
 					return nullptr;
 				T* dest = (T*)malloc(length * sizeof(T));
-				memcpy(dest, m_pData->m_sz, length * sizeof(T));
+				memcpy(dest, sz(), length * sizeof(T));
 				return dest;
 			}
 		}
 
+	// Heap strings cache their hash the first time it's asked for (the
+	// buffer is immutable and shared by every copy), so repeatedly looking
+	// up a long key only hashes it once
 	static uint32_t Hash(const StringCore& str)
 	{
-		return hash_buf(str.sz(), str.GetLength() * sizeof(T));
+		if (str.IsInline() || str.m_pData == nullptr)
+			return Hash(str.sz(), str.GetLength());
+
+		// (relaxed is enough - every thread would compute the same value)
+		uint32_t hash = str.m_pData->m_hash.load(std::memory_order_relaxed);
+		if (hash == 0)
+		{
+			hash = Hash(str.m_pData->m_sz, str.m_pData->m_iLength);
+			str.m_pData->m_hash.store(hash, std::memory_order_relaxed);
+		}
+		return hash;
+	}
+
+	// Hash `length` characters the same way as a string holding them
+	static uint32_t Hash(const T* psz, int length)
+	{
+		return hash_buf(psz, length * sizeof(T));
 	}
 
 	protected:
 		struct StringData
 		{
-			int m_iRef;
+			typename TRefCount::TCount m_iRef;
 			int m_iLength;
+			std::atomic<uint32_t> m_hash;		// 0 until Hash() is first called
 			T	m_sz[1];
 		};
 
-		static StringData* AllocStringData(const T* psz, int length)
+	public:
+		// Longest string stored inline (without a heap allocation)
+		static constexpr int kInlineUnits = (int)(3 * sizeof(void*) / sizeof(T));
+		static constexpr int kInlineCapacity = kInlineUnits - 1;
+
+	protected:
+		// The last unit of m_inline says which representation is in use -
+		// kHeapTag for a heap (or null) string in m_pData, otherwise the
+		// string is inline and it holds the number of unused characters,
+		// which is zero (doubling as the null terminator) when it's full
+		static constexpr T kHeapTag = (T)-1;
+
+		bool IsInline() const
+		{
+			return m_inline[kInlineUnits - 1] != kHeapTag;
+		}
+
+		void SetNull()
+		{
+			m_pData = nullptr;
+			m_inline[kInlineUnits - 1] = kHeapTag;
+		}
+
+		// Set up storage for `length` characters (and the null terminator),
+		// returning where to write them
+		T* Init(int length)
+		{
+			if (length <= kInlineCapacity)
+			{
+				m_inline[length] = '\0';
+				m_inline[kInlineUnits - 1] = (T)(kInlineCapacity - length);
+				return m_inline;
+			}
+
+			StringData* p = (StringData*)TMalloc::Alloc(sizeof(StringData) + length * sizeof(T));
+			TRefCount::Init(p->m_iRef);
+			p->m_iLength = length;
+			new (&p->m_hash) std::atomic<uint32_t>(0);
+			p->m_sz[length] = '\0';
+			m_pData = p;
+			m_inline[kInlineUnits - 1] = kHeapTag;
+			return p->m_sz;
+		}
+
+		void Init(const T* psz, int length)
 		{
 			if (psz == nullptr && length <= 0)
-				return nullptr;
+			{
+				SetNull();
+				return;
+			}
 			if (length < 0)
 				length = SChar<T>::Length(psz);
-			StringData* p = (StringData*)malloc(sizeof(StringData) + length * sizeof(T));
-			p->m_iRef = 1;
-			p->m_iLength = length;
+			T* p = Init(length);
 			if (psz)
-				memcpy(p->m_sz, psz, length * sizeof(T));
-			p->m_sz[length] = '\0';
-			return p;
+				memcpy(p, psz, length * sizeof(T));
 		}
 
-		static StringCore<T> WithData(StringData* pData)
+		// Same length and characters (a null string only equals another
+		// null string). Two heap strings that have both had their hash
+		// cached are rejected without comparing their characters if the
+		// hashes differ.
+		bool Equals(const StringCore& b) const
 		{
-			StringCore<T> s;
-			s.m_pData = pData;
-			return s;
+			if (IsNull() || b.IsNull())
+				return IsNull() && b.IsNull();
+
+			int length = GetLength();
+			if (length != b.GetLength())
+				return false;
+
+			if (!IsInline() && !b.IsInline())
+			{
+				if (m_pData == b.m_pData)
+					return true;
+				uint32_t hash = m_pData->m_hash.load(std::memory_order_relaxed);
+				uint32_t otherHash = b.m_pData->m_hash.load(std::memory_order_relaxed);
+				if (hash != 0 && otherHash != 0 && hash != otherHash)
+					return false;
+			}
+
+			return memcmp(sz(), b.sz(), length * sizeof(T)) == 0;
 		}
 
-		StringData* m_pData;
+		// Share another string's value (this string must be clear)
+		void CopyFrom(const StringCore& other)
+		{
+			memcpy(m_inline, other.m_inline, sizeof(m_inline));
+			if (!IsInline() && m_pData)
+				TRefCount::AddRef(m_pData->m_iRef);
+		}
+
+		union
+		{
+			StringData* m_pData;
+			T m_inline[kInlineUnits];
+		};
 	};
 
 	typedef StringCore<char> String;
 	typedef StringCore<wchar_t> WString;
 	typedef StringCore<char32_t> String32;
+
+	// Strings whose copies can be made and released on any thread
+	typedef StringCore<char, SAtomicRefCount> AtomicString;
+	typedef StringCore<wchar_t, SAtomicRefCount> AtomicWString;
 }
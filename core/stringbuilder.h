@@ -5,17 +5,25 @@
 
 #include "Formatting.h"
 #include "StringSemantics.h"
+#include "Allocator.h"
 
 namespace SimpleLib
 {
-	template <typename T>
-	class StringCore;
-
 	// Simple StringBuilder class that uses embedded short buffer but switches
-	// to dynamic allocations for longer strings
-	template <typename T>
-	class StringBuilder : public IStringWriter<T>
+	// to dynamic allocations (from TAllocator) for longer strings.
+	//
+	// By default the content is kept in one buffer that doubles as it grows
+	// (so building a huge string copies it about twice over and needs up to
+	// 1.5x its size at the peak). SetChunkSize() switches to appending into
+	// a chain of fixed size chunks instead - nothing is ever copied to grow,
+	// and the content can be written out chunk by chunk (ForEachChunk, or
+	// Stream::Write) without ever being made contiguous. Anything needing a
+	// contiguous string (Finish, sz, Detach...) flattens the chunks first.
+	template <typename T, typename TAllocator = TMalloc>
+	class StringBuilder : public IStringWriter<T>, private AllocatorHolder<TAllocator>
 	{
+		typedef AllocatorHolder<TAllocator> TAllocatorHolder;
+
 	public:
 		// Constructor
 		StringBuilder()
@@ -23,8 +31,29 @@ namespace SimpleLib
 			m_iLength = 0;
 			m_pMem = m_shortBuffer;
 			m_iCapacity = sizeof(m_shortBuffer) / sizeof(T);
+			m_iChunkSize = 0;
+			m_iSealedLength = 0;
+			m_pFirstChunk = nullptr;
+			m_pLastChunk = nullptr;
 		}
 
+		// Constructor with a specific allocator instance (for stateful
+		// allocators, eg: a handle to an arena)
+		explicit StringBuilder(const TAllocator& allocator)
+			: TAllocatorHolder(allocator)
+		{
+			m_iLength = 0;
+			m_pMem = m_shortBuffer;
+			m_iCapacity = sizeof(m_shortBuffer) / sizeof(T);
+			m_iChunkSize = 0;
+			m_iSealedLength = 0;
+			m_pFirstChunk = nullptr;
+			m_pLastChunk = nullptr;
+		}
+
+		// Get the allocator this builder allocates from
+		using TAllocatorHolder::GetAllocator;
+
 		// Destructor
 		virtual ~StringBuilder()
 		{
@@ -32,31 +61,101 @@ namespace SimpleLib
 		}
 
 		// Reset the stringbuilder, releasing any dynamically allocated buffer
+		// (stays chunked if SetChunkSize was called)
 		void Reset()
 		{
+			FreeChunks();
 			if (m_pMem != m_shortBuffer)
-				free(m_pMem);
+				GetAllocator().Free(m_pMem);
 			m_iLength = 0;
 			m_pMem = m_shortBuffer;
 			m_iCapacity = sizeof(m_shortBuffer) / sizeof(T);
 		}
 
-		// Clear, keeping memory buffer
+		// Clear, keeping memory buffer (the last chunk if chunked)
 		void Clear()
 		{
+			FreeChunks();
 			m_iLength = 0;
 		}
 
-		int GetLength()
+		int GetLength() const
 		{
-			return m_iLength;
+			return m_iSealedLength + m_iLength;
 		}
 
 		void Truncate(int newLength)
 		{
 			assert(newLength >= 0);
-			assert(newLength <= m_iLength);
-			m_iLength = newLength;
+			assert(newLength <= GetLength());
+
+			// Drop whole chunks past the new end, making the one it's in
+			// current again
+			while (newLength < m_iSealedLength)
+			{
+				CHUNK* pChunk = m_pLastChunk;
+				GetAllocator().Free(m_pMem);
+				m_pMem = pChunk->pMem;
+				m_iLength = pChunk->length;
+				m_iCapacity = pChunk->capacity;
+				m_iSealedLength -= pChunk->length;
+				m_pLastChunk = pChunk->pPrev;
+				if (m_pLastChunk)
+					m_pLastChunk->pNext = nullptr;
+				else
+					m_pFirstChunk = nullptr;
+				GetAllocator().Free(pChunk);
+			}
+
+			m_iLength = newLength - m_iSealedLength;
+		}
+
+		// Append into chunks of `chunkSize` characters rather than growing
+		// one buffer (0 to go back to one buffer, flattening any chunks).
+		// Appends longer than a chunk get a chunk of their own.
+		void SetChunkSize(int chunkSize)
+		{
+			assert(chunkSize >= 0);
+			m_iChunkSize = chunkSize;
+			if (chunkSize == 0)
+				Flatten(0);
+		}
+
+		int GetChunkSize() const
+		{
+			return m_iChunkSize;
+		}
+
+		// True if the content is in one buffer (always, unless chunked)
+		bool IsContiguous() const
+		{
+			return m_pFirstChunk == nullptr;
+		}
+
+		// Number of pieces ForEachChunk will pass to its callback
+		int GetChunkCount() const
+		{
+			int count = m_iLength > 0 ? 1 : 0;
+			for (CHUNK* pChunk = m_pFirstChunk; pChunk; pChunk = pChunk->pNext)
+				count++;
+			return count;
+		}
+
+		// Call fn(const T* p, int length) for each piece of the content in
+		// order, without flattening (eg: to write it to a file, or to fill
+		// an iovec array for writev - see GetChunkCount). fn returns false
+		// to stop, in which case so does this.
+		template <typename TFn>
+		bool ForEachChunk(TFn fn) const
+		{
+			for (CHUNK* pChunk = m_pFirstChunk; pChunk; pChunk = pChunk->pNext)
+			{
+				if (!fn((const T*)pChunk->pMem, pChunk->length))
+					return false;
+			}
+			if (m_iLength > 0)
+				return fn((const T*)m_pMem, m_iLength);
+			return true;
 		}
 
 		// Rescans the content for a NUL terminator and sets the builder's
@@ -65,6 +164,13 @@ namespace SimpleLib
 		// Returns *this so it can be chained eg: sb.SyncLength().ToString()
 		StringBuilder& SyncLength()
 		{
+			// Flattened chunks have no terminator of their own
+			if (m_pFirstChunk != nullptr)
+			{
+				if (!Flatten(1))
+					return *this;
+				m_pMem[m_iLength] = '\0';
+			}
 			int length = SChar<T>::Length(m_pMem);
 			assert(length <= m_iCapacity);
 			m_iLength = length;
@@ -106,6 +212,19 @@ namespace SimpleLib
 			memcpy(dest, psz, sizeof(T) * length);
 		}
 
+		// Append a view
+		void Append(const StringView<T>& view)
+		{
+			Append(view.GetBuffer(), view.GetLength());
+		}
+
+		// Append a string (without measuring it again)
+		template <typename TRefCount>
+		void Append(const StringCore<T, TRefCount>& str)
+		{
+			Append(str.sz(), str.GetLength());
+		}
+
 		StringBuilder& operator += (T ch)
 		{
 			Append(&ch, 1);
@@ -124,28 +243,20 @@ namespace SimpleLib
 		//     allocated
 		T* Reserve(int length)
 		{
-			if (m_iLength + length > m_iCapacity)
+			if (m_iLength + length > m_iCapacity && m_iChunkSize > 0)
+			{
+				if (!NextChunk(length))
+					return nullptr;
+			}
+			else if (m_iLength + length > m_iCapacity)
 			{
 				// Work out new capacity
 				int newCapacity = m_iCapacity;
 				while (newCapacity < m_iLength + length)
 					newCapacity *= 2;
 
-				if (m_pMem == m_shortBuffer)
-				{
-					T* pNew = (T*)malloc(sizeof(T) * newCapacity);
-					if (pNew == nullptr)
-						return nullptr;
-					m_pMem = pNew;
-					memcpy(m_pMem, m_shortBuffer, m_iLength * sizeof(T));
-				}
-				else
-				{
-					T* pNew = (T*)realloc(m_pMem, sizeof(T) * newCapacity);
-					if (pNew == nullptr)
-						return nullptr;
-					m_pMem = pNew;
-				}
+				if (!GrowBuffer(newCapacity))
+					return nullptr;
 			}
 
 			// Take room
@@ -172,6 +283,11 @@ namespace SimpleLib
 		// Finish building and return the current string and its length
 		T* Finish(int* piLength) const
 		{
+			if (!const_cast<StringBuilder*>(this)->Flatten(1))
+			{
+				*piLength = 0;
+				return nullptr;
+			}
 			if (m_iLength == 0 || (m_iLength > 0 && m_pMem[m_iLength - 1] != '\0'))
 			{
 				const_cast<StringBuilder*>(this)->Append((T)'\0');
@@ -186,6 +302,9 @@ namespace SimpleLib
 			return StringCore<T>(*this);
 		}
 
+		// Detach the built string, the caller takes ownership and must
+		// release it through the builder's allocator (ie: free() for the
+		// default TMalloc)
 		T* Detach()
 		{
 			// Make sure null terminated
@@ -195,14 +314,16 @@ namespace SimpleLib
 			// Can't just detach short buffer, so alloc
 			if (m_pMem == m_shortBuffer)
 			{
-				T* retv = (T*)malloc(length + 1);
-				memcpy(retv, m_pMem, length + 1);
+				T* retv = (T*)GetAllocator().Alloc(sizeof(T) * (length + 1));
+				memcpy(retv, m_pMem, sizeof(T) * (length + 1));
 				m_iLength = 0;
 				return retv;
 			}
 			else
 			{
+				// Take the buffer before resetting so Reset() doesn't free it
 				T* retv = m_pMem;
+				m_pMem = m_shortBuffer;
 				Reset();
 				return retv;
 			}
@@ -264,19 +385,161 @@ namespace SimpleLib
 			Formatting::FormatV(&fw, pFormat, args);
 		}
 
-		void Format(const T* pFormat, ...)
+		// Append formatted text (see Formatting::Format; wrap a format string
+		// that isn't a literal in a RuntimeFormat)
+		template <typename... TArgs>
+		void Format(const FormatString<T, typename std::decay<TArgs>::type...>& format, const TArgs&... args)
 		{
-			va_list args;
-			va_start(args, pFormat);
-			FormatV(pFormat, args);
-			va_end(args);
+			Formatting::Format(*this, format, args...);
+		}
+
+		// Append formatted text using a format string parsed at compile time
+		// (see SIMPLELIB_FORMAT)
+		template <typename TFn, typename... TArgs>
+		void Format(const CompiledFormat<TFn>& format, const TArgs&... args)
+		{
+			Formatting::Format(*this, format.template Get<T, typename std::decay<TArgs>::type...>(), args...);
 		}
 
 
 	private:
+		// A full chunk (the one being appended to is m_pMem)
+		struct CHUNK
+		{
+			CHUNK* pPrev;
+			CHUNK* pNext;
+			T* pMem;
+			int length;
+			int capacity;
+		};
+
+		// Grow the current buffer in place (never sealing it as a chunk) to
+		// `capacity` characters
+		bool GrowBuffer(int capacity)
+		{
+			if (m_pMem == m_shortBuffer)
+			{
+				T* pNew = (T*)GetAllocator().Alloc(sizeof(T) * capacity);
+				if (pNew == nullptr)
+					return false;
+				memcpy(pNew, m_shortBuffer, m_iLength * sizeof(T));
+				m_pMem = pNew;
+			}
+			else
+			{
+				T* pNew = (T*)GetAllocator().ReAlloc(m_pMem, sizeof(T) * capacity);
+				if (pNew == nullptr)
+					return false;
+				m_pMem = pNew;
+			}
+			m_iCapacity = capacity;
+			return true;
+		}
+
+		// Start a new chunk with room for at least `length` characters
+		bool NextChunk(int length)
+		{
+			int capacity = m_iChunkSize > length ? m_iChunkSize : length;
+
+			// The short buffer can't be kept as a chunk, so its content moves
+			// to the first one. Likewise an empty buffer that's too small is
+			// just replaced.
+			if (m_pMem == m_shortBuffer || m_iLength == 0)
+			{
+				if (capacity < m_iLength + length)
+					capacity = m_iLength + length;
+				T* pNew = (T*)GetAllocator().Alloc(sizeof(T) * capacity);
+				if (pNew == nullptr)
+					return false;
+				memcpy(pNew, m_pMem, m_iLength * sizeof(T));
+				if (m_pMem != m_shortBuffer)
+					GetAllocator().Free(m_pMem);
+				m_pMem = pNew;
+				m_iCapacity = capacity;
+				return true;
+			}
+
+			CHUNK* pChunk = (CHUNK*)GetAllocator().Alloc(sizeof(CHUNK));
+			T* pNew = (T*)GetAllocator().Alloc(sizeof(T) * capacity);
+			if (pChunk == nullptr || pNew == nullptr)
+			{
+				if (pChunk)
+					GetAllocator().Free(pChunk);
+				if (pNew)
+					GetAllocator().Free(pNew);
+				return false;
+			}
+
+			// Seal the current buffer
+			pChunk->pPrev = m_pLastChunk;
+			pChunk->pNext = nullptr;
+			pChunk->pMem = m_pMem;
+			pChunk->length = m_iLength;
+			pChunk->capacity = m_iCapacity;
+			if (m_pLastChunk)
+				m_pLastChunk->pNext = pChunk;
+			else
+				m_pFirstChunk = pChunk;
+			m_pLastChunk = pChunk;
+			m_iSealedLength += m_iLength;
+
+			m_pMem = pNew;
+			m_iLength = 0;
+			m_iCapacity = capacity;
+			return true;
+		}
+
+		// Copy any chunks into one buffer, with room for `extra` more
+		// characters (growing the current buffer in place when there are
+		// none, so a following Append can't start a new chunk)
+		bool Flatten(int extra)
+		{
+			if (m_pFirstChunk == nullptr)
+				return m_iLength + extra <= m_iCapacity || GrowBuffer(m_iLength + extra);
+
+			int length = GetLength();
+			T* pNew = (T*)GetAllocator().Alloc(sizeof(T) * (length + extra));
+			if (pNew == nullptr)
+				return false;
+
+			T* p = pNew;
+			ForEachChunk([&](const T* pChunk, int chunkLength) {
+				memcpy(p, pChunk, chunkLength * sizeof(T));
+				p += chunkLength;
+				return true;
+			});
+
+			FreeChunks();
+			GetAllocator().Free(m_pMem);
+			m_pMem = pNew;
+			m_iLength = length;
+			m_iCapacity = length + extra;
+			return true;
+		}
+
+		// Free the full chunks (not the current buffer)
+		void FreeChunks()
+		{
+			CHUNK* pChunk = m_pFirstChunk;
+			while (pChunk)
+			{
+				CHUNK* pNext = pChunk->pNext;
+				GetAllocator().Free(pChunk->pMem);
+				GetAllocator().Free(pChunk);
+				pChunk = pNext;
+			}
+			m_pFirstChunk = nullptr;
+			m_pLastChunk = nullptr;
+			m_iSealedLength = 0;
+		}
+
 		T* m_pMem;
-		int m_iLength;
+		int m_iLength;				// In m_pMem
 		int m_iCapacity;
+		int m_iChunkSize;			// 0 when not chunked
+		int m_iSealedLength;		// Total length of the full chunks
+		CHUNK* m_pFirstChunk;
+		CHUNK* m_pLastChunk;
 		T m_shortBuffer[128];
 	};
 
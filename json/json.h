@@ -4,10 +4,7 @@
 #include "../Core/Sharedptr.h"
 #include "../Core/List.h"
 #include "../Core/Map.h"
-
-#ifdef _SIMPLELIB_USE_RYU
-#include <ryu.h>
-#endif
+#include "../Core/Ryu.h"
 
 namespace SimpleLib
 {
@@ -272,15 +269,20 @@ namespace SimpleLib
                     break;
 
                 case JsonKind::Number:
-#ifdef _SIMPLELIB_USE_RYU
-                    char szTemp[128];
-                    d2s_buffered(value.AsNumber(), szTemp);
-                    remove_exponent_if_shorter(szTemp);
-                    buf.Append(szTemp);
-#else
-                    buf.Format("%.17g", value.AsNumber());
-#endif
+                {
+                    // As JavaScript would (JSON has no NaN or infinity)
+                    double number = value.AsNumber();
+                    if (isfinite(number))
+                    {
+                        char szTemp[Ryu::kMaxChars];
+                        buf.Append(szTemp, Ryu::Format(szTemp, number));
+                    }
+                    else
+                    {
+                        buf.Append("null");
+                    }
                     break;
+                }
 
                 case JsonKind::StringCore:
                     EscapeString(buf, value.AsString());
@@ -377,86 +379,5 @@ namespace SimpleLib
         {
         }
         */
-
-        static void remove_exponent_if_shorter(char* psz)
-        {
-            // Scan the string looking for dot position and exponent position
-            char* p = psz;
-            char* pszDot = nullptr;
-            char* pszExp = nullptr;
-            while (*p)
-            {
-                if (*p == '.')
-                    pszDot = p;
-                if (*p == 'e' || *p == 'E')
-                    pszExp = p;
-                p++;
-            }
-            if (!pszExp)        // Not exponent format, quit
-                return;
-
-            // Get the exponent
-            int e = atoi(pszExp+1);
-
-            // Conversion depends on dp position and e
-            if (e == 0)
-            {
-                // Just truncate and be done
-                *pszExp = '\0';
-                return;
-            }
-
-            // Work out where to move the decimal point to
-            if (!pszDot)
-                pszDot = pszExp;
-            const char* pszNewDotPos = pszDot + e;
-
-            if (e > 0 && e <= 20)
-            {
-
-                // If it's past the end of the current string, then there's no point
-                if (pszNewDotPos > p)
-                    return;
-
-                // Move it, and add trailing zeros
-                for (int i=0; i<e; i++)
-                {
-                    *pszDot = pszDot + 1 < pszExp ? pszDot[1] : '0';
-                    pszDot++;
-                }
-                if (pszDot < pszExp)
-                {
-                    *pszDot = '.';
-                    *pszExp = '\0';
-                }
-                else
-                {
-                    *pszDot = '\0';
-                }
-                return;
-            }
-            else if (e >= -6 && e < 0)
-            {
-                if (pszNewDotPos <= psz)
-                {
-                    // Make room
-                    int shift = (int)(psz - pszNewDotPos + 1);
-                    memmove(psz + shift, psz, p - psz + 1);
-                    memset(psz, '0', shift);
-                    pszExp += shift;
-                    pszDot += shift;
-                }
-
-                for (int i=0; i < -e; i++)
-                {
-                    *pszDot = pszDot[-1];
-                    pszDot--;
-                }
-
-                *pszDot = '.';
-                *pszExp = '\0';
-                return;
-            }
-        }
     };
 }
\ No newline at end of file
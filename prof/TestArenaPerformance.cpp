@@ -0,0 +1,73 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+#include "Timing.h"
+#include <stdio.h>
+using namespace SimpleLib;
+
+namespace
+{
+	// Simulates the work of one request: a handful of short lived
+	// containers that are all thrown away at the end
+	template <typename TAllocator>
+	int Request(int seed, const TAllocator& allocator)
+	{
+		int result = 0;
+		for (int j = 0; j < 8; j++)
+		{
+			List<int, TAllocator> list(allocator);
+			for (int i = 0; i < 200; i++)
+				list.Add(seed + i);
+
+			Map<int, int, SDefaultCompare, TAllocator> map(allocator);
+			for (int i = 0; i < 50; i++)
+				map.Add(seed + i * 7, i);
+
+			StringBuilder<char, TAllocator> sb(allocator);
+			for (int i = 0; i < 40; i++)
+				sb.Append("key=value;");
+
+			result += list.GetCount() + map.GetCount() + sb.GetLength();
+		}
+		return result;
+	}
+}
+
+Fact("Arena Performance")
+{
+	const int reps = 20000;
+	volatile int sink = 0;
+
+	double tMalloc = Time<std::micro>(reps, [&](int i) {
+		sink = Request(i, TMalloc());
+	});
+
+	Arena arena;
+	double tArena = Time<std::micro>(reps, [&](int i) {
+		ArenaScope scope(arena);
+		sink = Request(i, ArenaAllocator(&arena));
+	});
+
+	// Raw allocation rate (a few reps, so the arena's blocks are warm after
+	// the first)
+	const int count = 1000000;
+	double tRawMalloc = Time<std::micro>(5, [&](int) {
+		void** ptrs = (void**)malloc(count * sizeof(void*));
+		for (int i = 0; i < count; i++)
+			ptrs[i] = malloc(16 + (i & 63));
+		for (int i = 0; i < count; i++)
+			free(ptrs[i]);
+		free(ptrs);
+	});
+	double tRawArena = Time<std::micro>(5, [&](int) {
+		ArenaScope scope(arena);
+		for (int i = 0; i < count; i++)
+			sink = (int)(uintptr_t)arena.Alloc(16 + (i & 63));
+	});
+
+	printf("Arena Performance: per request (8 x List + Map + StringBuilder)\n");
+	printf("  %-24s %10.2fus\n", "malloc", tMalloc);
+	printf("  %-24s %10.2fus\n", "arena + scope", tArena);
+	printf("Arena Performance: %d small allocations + free\n", count);
+	printf("  %-24s %10.2fms\n", "malloc/free", tRawMalloc / 1000);
+	printf("  %-24s %10.2fms\n", "arena/rewind", tRawArena / 1000);
+}
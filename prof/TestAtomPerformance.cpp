@@ -0,0 +1,50 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+#include "../Threading.h"
+#include "Timing.h"
+#include <stdio.h>
+using namespace SimpleLib;
+
+Fact("Atom Performance")
+{
+	// Parameter style names
+	const int count = 256;
+	List<String> names;
+	List<Atom> atoms;
+	char buf[64];
+	for (int i = 0; i < count; i++)
+	{
+		snprintf(buf, sizeof(buf), "module%i.parameter.name%i", i % 16, i);
+		names.Add(String(buf));
+		atoms.Add(Atom(buf));
+	}
+
+	Map<String, int> stringMap;
+	Map<Atom, int> atomMap;
+	for (int i = 0; i < count; i++)
+	{
+		stringMap.Set(names[i], i);
+		atomMap.Set(atoms[i], i);
+	}
+
+	const int reps = 10000000;
+	volatile int sink = 0;
+
+	double tString = Time(reps, [&](int i) {
+		sink = stringMap.Get(names.GetRefAt((i * 7) & (count - 1)));
+	});
+	double tAtom = Time(reps, [&](int i) {
+		sink = atomMap.Get(atoms.GetRefAt((i * 7) & (count - 1)));
+	});
+
+	// Turning text into an atom (eg: a JSON key) costs a lookup of its own
+	double tIntern = Time(reps, [&](int i) {
+		const String& name = names.GetRefAt((i * 7) & (count - 1));
+		sink = Atom(name.sz(), name.GetLength()).GetLength();
+	});
+
+	printf("Atom Performance: Map lookup, %d keys of ~26 chars\n", count);
+	printf("  %-24s %10.2fns\n", "Map<String>", tString);
+	printf("  %-24s %10.2fns\n", "Map<Atom>", tAtom);
+	printf("  %-24s %10.2fns\n", "Atom from text", tIntern);
+}
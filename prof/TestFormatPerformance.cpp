@@ -0,0 +1,106 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+#include "Timing.h"
+#include <stdio.h>
+using namespace SimpleLib;
+
+namespace
+{
+	// The va_list path StringBuilder::Format used to take
+	void FormatV(StringBuilder<char>& sb, const char* format, ...)
+	{
+		va_list args;
+		va_start(args, format);
+		sb.FormatV(format, args);
+		va_end(args);
+	}
+
+	void Report(const char* label, double tFormat, double tFormatV, double tSnprintf)
+	{
+		printf("  %-34s Format %7.1fns  FormatV %7.1fns (%4.1fx)  snprintf %7.1fns (%4.1fx)\n",
+			label, tFormat, tFormatV, tFormatV / tFormat, tSnprintf, tSnprintf / tFormat);
+	}
+}
+
+Fact("Format Performance")
+{
+	printf("Format Performance:\n");
+
+	const int reps = 2000000;
+	StringBuilder<char> sb;
+	char buf[256];
+	volatile int sink = 0;
+
+	Report("one integer \"%d\"",
+		Time(reps, [&](int i) { sb.Clear(); sb.Format("%d", i * 997); sink = sb.GetLength(); }),
+		Time(reps, [&](int i) { sb.Clear(); FormatV(sb, "%d", i * 997); sink = sb.GetLength(); }),
+		Time(reps, [&](int i) { sink = snprintf(buf, sizeof(buf), "%d", i * 997); }));
+
+	const char* levels[] = { "info", "warning", "error", "debug" };
+	String component("connection-pool");
+	Report("log line (strings, ints, padding)",
+		Time(reps, [&](int i) {
+			sb.Clear();
+			sb.Format("[%-7s] %s: request %d from client %08x took %6dus\n", levels[i & 3], component, i, i * 2654435761u, i % 100000);
+			sink = sb.GetLength();
+		}),
+		Time(reps, [&](int i) {
+			sb.Clear();
+			FormatV(sb, "[%-7s] %s: request %d from client %08x took %6dus\n", levels[i & 3], component.sz(), i, i * 2654435761u, i % 100000);
+			sink = sb.GetLength();
+		}),
+		Time(reps, [&](int i) {
+			sink = snprintf(buf, sizeof(buf), "[%-7s] %s: request %d from client %08x took %6dus\n", levels[i & 3], component.sz(), i, i * 2654435761u, i % 100000);
+		}));
+
+	Report("log line, SIMPLELIB_FORMAT",
+		Time(reps, [&](int i) {
+			sb.Clear();
+			sb.Format(SIMPLELIB_FORMAT("[%-7s] %s: request %d from client %08x took %6dus\n"), levels[i & 3], component, i, i * 2654435761u, i % 100000);
+			sink = sb.GetLength();
+		}),
+		Time(reps, [&](int i) {
+			sb.Clear();
+			FormatV(sb, "[%-7s] %s: request %d from client %08x took %6dus\n", levels[i & 3], component.sz(), i, i * 2654435761u, i % 100000);
+			sink = sb.GetLength();
+		}),
+		Time(reps, [&](int i) {
+			sink = snprintf(buf, sizeof(buf), "[%-7s] %s: request %d from client %08x took %6dus\n", levels[i & 3], component.sz(), i, i * 2654435761u, i % 100000);
+		}));
+
+	Report("JSON-ish object, 4 integers",
+		Time(reps, [&](int i) {
+			sb.Clear();
+			sb.Format("{ \"x\": %d, \"y\": %d, \"w\": %d, \"h\": %d }", i, -i, i & 1023, i >> 4);
+			sink = sb.GetLength();
+		}),
+		Time(reps, [&](int i) {
+			sb.Clear();
+			FormatV(sb, "{ \"x\": %d, \"y\": %d, \"w\": %d, \"h\": %d }", i, -i, i & 1023, i >> 4);
+			sink = sb.GetLength();
+		}),
+		Time(reps, [&](int i) {
+			sink = snprintf(buf, sizeof(buf), "{ \"x\": %d, \"y\": %d, \"w\": %d, \"h\": %d }", i, -i, i & 1023, i >> 4);
+		}));
+
+	Report("JSON number \"%.17g\"",
+		Time(reps, [&](int i) { sb.Clear(); sb.Format("%.17g", i * 0.001); sink = sb.GetLength(); }),
+		Time(reps, [&](int i) { sb.Clear(); FormatV(sb, "%.17g", i * 0.001); sink = sb.GetLength(); }),
+		Time(reps, [&](int i) { sink = snprintf(buf, sizeof(buf), "%.17g", i * 0.001); }));
+
+	unsigned char d[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+	Report("guid (11 hex fields)",
+		Time(reps, [&](int i) {
+			sb.Clear();
+			sb.Format("%.8x-%.4x-%.4x-%.2x%.2x-%.2x%.2x%.2x%.2x%.2x%.2x", i, i & 0xFFFF, 0x4000, d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7]);
+			sink = sb.GetLength();
+		}),
+		Time(reps, [&](int i) {
+			sb.Clear();
+			FormatV(sb, "%.8x-%.4x-%.4x-%.2x%.2x-%.2x%.2x%.2x%.2x%.2x%.2x", i, i & 0xFFFF, 0x4000, d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7]);
+			sink = sb.GetLength();
+		}),
+		Time(reps, [&](int i) {
+			sink = snprintf(buf, sizeof(buf), "%.8x-%.4x-%.4x-%.2x%.2x-%.2x%.2x%.2x%.2x%.2x%.2x", i, i & 0xFFFF, 0x4000, d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7]);
+		}));
+}
@@ -0,0 +1,143 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+#include "Timing.h"
+#include <stdio.h>
+#include <math.h>
+using namespace SimpleLib;
+
+namespace
+{
+	// The byte at a time FNV-1a hash_buf used to be, for comparison
+	uint32_t Fnv1a(const void* data, size_t len)
+	{
+		const uint8_t* p = (const uint8_t*)data;
+		uint32_t h = 0x811c9dc5u;
+		for (size_t i = 0; i < len; i++)
+		{
+			h ^= p[i];
+			h *= 0x01000193u;
+		}
+		return h;
+	}
+
+	void Throughput(const uint8_t* data, size_t length)
+	{
+		volatile uint32_t sink = 0;
+		int reps = (int)(200000000 / (length + 16));
+
+		// Vary the data slightly each time so the hash can't be hoisted
+		double tFnv = Time(reps, [&](int i) { sink = Fnv1a(data + (i & 7), length); });
+		double tWy = Time(reps, [&](int i) { sink = hash_buf(data + (i & 7), length); });
+		double tBuilder = Time(reps, [&](int i) {
+			HashBuilder builder;
+			builder.Append(data + (i & 7), length / 2);
+			builder.Append(data + (i & 7) + length / 2, length - length / 2);
+			sink = builder.Finish();
+		});
+
+		printf("  %8d bytes: fnv1a %8.2fns (%5.2f GB/s)  hash_buf %8.2fns (%5.2f GB/s)  HashBuilder (2 pieces) %8.2fns\n",
+			(int)length, tFnv, length / tFnv, tWy, length / tWy, tBuilder);
+	}
+
+	// Chi squared of the bucket counts against a uniform distribution,
+	// normalised so ~1.0 is what a random function would give
+	template <typename THash>
+	double BucketScore(int keyCount, int bucketBits, THash hash)
+	{
+		int buckets = 1 << bucketBits;
+		List<int> counts;
+		for (int i = 0; i < buckets; i++)
+			counts.Add(0);
+
+		char key[32];
+		for (int i = 0; i < keyCount; i++)
+		{
+			int length = snprintf(key, sizeof(key), "key%d", i);
+			counts.GetRefAt(hash(key, length) & (buckets - 1))++;
+		}
+
+		double expected = (double)keyCount / buckets;
+		double chi = 0;
+		for (int i = 0; i < buckets; i++)
+			chi += (counts[i] - expected) * (counts[i] - expected) / expected;
+		return chi / (buckets - 1);
+	}
+
+	// Worst bias of any output bit when flipping any single input bit (0
+	// is ideal, 0.5 means an output bit never or always changes)
+	template <typename THash>
+	double AvalancheBias(int length, THash hash)
+	{
+		const int trials = 2000;
+		uint32_t state = 12345;
+		double worst = 0;
+		uint8_t key[64];
+
+		for (int inBit = 0; inBit < length * 8; inBit++)
+		{
+			int flips[32] = {};
+			for (int t = 0; t < trials; t++)
+			{
+				for (int i = 0; i < length; i++)
+				{
+					state = state * 1664525u + 1013904223u;
+					key[i] = (uint8_t)(state >> 24);
+				}
+				uint32_t a = hash(key, length);
+				key[inBit / 8] ^= (uint8_t)(1 << (inBit % 8));
+				uint32_t b = hash(key, length);
+				for (int o = 0; o < 32; o++)
+					flips[o] += ((a ^ b) >> o) & 1;
+			}
+			for (int o = 0; o < 32; o++)
+			{
+				double bias = fabs((double)flips[o] / trials - 0.5);
+				if (bias > worst)
+					worst = bias;
+			}
+		}
+		return worst;
+	}
+}
+
+Fact("Hash Performance")
+{
+	printf("Hash Performance:\n");
+
+	uint8_t* data = (uint8_t*)malloc((1 << 20) + 8);
+	for (int i = 0; i < (1 << 20) + 8; i++)
+		data[i] = (uint8_t)(i * 131 + (i >> 8));
+
+	for (size_t length : { 4, 8, 16, 24, 32, 64, 256, 4096, 1 << 20 })
+		Throughput(data, length);
+	free(data);
+
+	// Sequential keys ("key0", "key1"...) into a power of two table - the
+	// low bits are what hash tables use
+	auto fnv = [](const void* p, size_t n) { return Fnv1a(p, n); };
+	auto wy = [](const void* p, size_t n) { return hash_buf(p, n); };
+	printf("  bucket chi^2 (1.0 ideal, 100000 sequential keys, 4096 buckets): fnv1a %.3f  hash_buf %.3f\n",
+		BucketScore(100000, 12, fnv), BucketScore(100000, 12, wy));
+	printf("  worst avalanche bias (0 ideal, 8 byte keys):  fnv1a %.3f  hash_buf %.3f\n",
+		AvalancheBias(8, fnv), AvalancheBias(8, wy));
+	printf("  worst avalanche bias (0 ideal, 24 byte keys): fnv1a %.3f  hash_buf %.3f\n",
+		AvalancheBias(24, fnv), AvalancheBias(24, wy));
+
+	// String keyed map lookups, reusing the key strings (hashing long keys
+	// dominates unless their hash is cached)
+	for (int keyLength : { 8, 64, 256, 1024 })
+	{
+		List<String> keys;
+		Map<String, int> map;
+		char buf[1100];
+		for (int i = 0; i < 1000; i++)
+		{
+			snprintf(buf, sizeof(buf), "%0*d", keyLength, i * 7919);
+			keys.Add(String(buf));
+			map.Set(keys[i], i);
+		}
+		volatile int sink = 0;
+		double t = Time(1000000, [&](int i) { sink = map.Get(keys.GetRefAt(i % 1000), -1); });
+		printf("  Map<String> lookup, %4d char keys: %.2fns\n", keyLength, t);
+	}
+}
@@ -0,0 +1,95 @@
+#include "../UnitTesting.h"
+#include "../Threading.h"
+#include "Timing.h"
+#include <stdio.h>
+#include <thread>
+#include <atomic>
+using namespace SimpleLib;
+
+namespace
+{
+	struct Message
+	{
+		Message(int value) : value(value) {}
+		int value;
+		char payload[52];
+	};
+
+	// Producer allocates messages, consumer frees them on another thread
+	template <typename TNew, typename TDelete>
+	double ProducerConsumer(int count, TNew allocMessage, TDelete freeMessage)
+	{
+		const int kInFlight = 1024;
+		Message* volatile ring[kInFlight] = {};
+		std::atomic<int> produced{ 0 };
+		std::atomic<int> consumed{ 0 };
+
+		return Time<std::milli>(1, [&](int) {
+			std::thread consumer([&]() {
+				for (int i = 0; i < count; i++)
+				{
+					while (consumed.load(std::memory_order_relaxed) >= produced.load(std::memory_order_acquire))
+						std::this_thread::yield();
+					freeMessage(ring[i % kInFlight]);
+					consumed.store(i + 1, std::memory_order_release);
+				}
+			});
+			for (int i = 0; i < count; i++)
+			{
+				while (produced.load(std::memory_order_relaxed) - consumed.load(std::memory_order_acquire) >= kInFlight)
+					std::this_thread::yield();
+				ring[i % kInFlight] = allocMessage(i);
+				produced.store(i + 1, std::memory_order_release);
+			}
+			consumer.join();
+		});
+	}
+}
+
+Fact("ObjectPool Performance")
+{
+	const int count = 2000000;
+	Message** items = new Message*[1000];
+
+	printf("ObjectPool Performance: %d x 64 byte messages\n", count);
+
+	// Same thread, batches of 1000 alive at once
+	double tNew = Time<std::milli>(1, [&](int) {
+		for (int i = 0; i < count; i += 1000)
+		{
+			for (int j = 0; j < 1000; j++)
+				items[j] = new Message(j);
+			for (int j = 0; j < 1000; j++)
+				delete items[j];
+		}
+	});
+
+	ObjectPool<Message> pool;
+	pool.Prewarm(1000);
+	double tPool = Time<std::milli>(1, [&](int) {
+		for (int i = 0; i < count; i += 1000)
+		{
+			for (int j = 0; j < 1000; j++)
+				items[j] = pool.New(j);
+			for (int j = 0; j < 1000; j++)
+				pool.Delete(items[j]);
+		}
+	});
+
+	printf("  %-32s %10.2fms\n", "new/delete (same thread)", tNew);
+	printf("  %-32s %10.2fms\n", "ObjectPool (same thread)", tPool);
+
+	// Cross thread
+	double tNewCross = ProducerConsumer(count,
+		[](int i) { return new Message(i); },
+		[](Message* m) { delete m; });
+	double tPoolCross = ProducerConsumer(count,
+		[&](int i) { return pool.New(i); },
+		[&](Message* m) { pool.Delete(m); });
+
+	printf("  %-32s %10.2fms\n", "new/delete (cross thread)", tNewCross);
+	printf("  %-32s %10.2fms\n", "ObjectPool (cross thread)", tPoolCross);
+	printf("  pool capacity after: %d\n", pool.GetCapacity());
+
+	delete[] items;
+}
@@ -0,0 +1,51 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+#include "../Threading.h"
+#include "Timing.h"
+#include <stdio.h>
+using namespace SimpleLib;
+
+namespace
+{
+	// Grow a list one element at a time, then make random reads across it
+	// (which is where huge pages save TLB misses)
+	template <typename TAllocator>
+	void Measure(const char* name, int count)
+	{
+		volatile int64_t sink = 0;
+		double tGrow = Time<std::milli>(3, [&](int) {
+			List<int64_t, TAllocator> list;
+			for (int i = 0; i < count; i++)
+				list.Add(i);
+			sink = list[count - 1];
+		});
+
+		List<int64_t, TAllocator> list;
+		for (int i = 0; i < count; i++)
+			list.Add(i);
+		const int reads = 20000000;
+		double tRead = Time<std::milli>(1, [&](int) {
+			uint32_t state = 1;
+			int64_t sum = 0;
+			for (int i = 0; i < reads; i++)
+			{
+				state ^= state << 13;
+				state ^= state >> 17;
+				state ^= state << 5;
+				sum += list[(int)(state % (uint32_t)count)];
+			}
+			sink = sum;
+		}) * 1000000.0 / reads;
+
+		printf("  %-24s %10.1fms %10.2fns\n", name, tGrow, tRead);
+	}
+}
+
+Fact("PageAllocator Performance")
+{
+	const int count = 64 * 1024 * 1024;
+	printf("PageAllocator Performance: List<int64_t> of %d (grow, random read)\n", count);
+	Measure<TMalloc>("TMalloc", count);
+	Measure<TPageAlloc<>>("TPageAlloc", count);
+	Measure<TPageAlloc<HugePageMode::Transparent>>("TPageAlloc Transparent", count);
+}
@@ -0,0 +1,76 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+#include "Timing.h"
+#include <stdio.h>
+using namespace SimpleLib;
+
+Fact("Query Performance")
+{
+	const int count = 1000000;
+	const int reps = 20;
+
+	List<int> list;
+	for (int i = 0; i < count; i++)
+		list.Add(i);
+
+	// Pipeline: keep multiples of 3, square them, keep those ending in 1
+	long long expected = 0;
+	int expectedCount = 0;
+	for (int i = 0; i < count; i++)
+	{
+		if (i % 3 == 0 && ((long long)i * i) % 10 == 1)
+		{
+			expected += (long long)i * i;
+			expectedCount++;
+		}
+	}
+
+	printf("Query Performance: %d ints, where/select/where\n", count);
+
+	double tEager = Time<std::milli>(reps, [&](int) {
+		List<int> a = list.Filter([](int x) { return x % 3 == 0; });
+		List<long long> b = a.Map<long long>([](int x) { return (long long)x * x; });
+		List<long long> c = b.Filter([](long long x) { return x % 10 == 1; });
+		Assert(c.GetCount() == expectedCount);
+	});
+
+	auto query = list.AsQuery()
+		.Where([](int x) { return x % 3 == 0; })
+		.Select([](int x) { return (long long)x * x; })
+		.Where([](long long x) { return x % 10 == 1; });
+
+	double tToList = Time<std::milli>(reps, [&](int) {
+		List<long long> c = query.ToList();
+		Assert(c.GetCount() == expectedCount);
+	});
+
+	double tCount = Time<std::milli>(reps, [&](int) {
+		Assert(query.Count() == expectedCount);
+	});
+
+	double tForEach = Time<std::milli>(reps, [&](int) {
+		long long sum = 0;
+		query.ForEach([&](long long x) { sum += x; });
+		Assert(sum == expected);
+	});
+
+	double tLoop = Time<std::milli>(reps, [&](int) {
+		long long sum = 0;
+		for (int i = 0; i < list.GetCount(); i++)
+		{
+			int x = list[i];
+			if (x % 3 != 0)
+				continue;
+			long long sq = (long long)x * x;
+			if (sq % 10 == 1)
+				sum += sq;
+		}
+		Assert(sum == expected);
+	});
+
+	printf("  %-34s %8.3fms\n", "Filter/Map/Filter (eager)", tEager);
+	printf("  %-34s %8.3fms\n", "Query ToList", tToList);
+	printf("  %-34s %8.3fms\n", "Query Count", tCount);
+	printf("  %-34s %8.3fms\n", "Query ForEach (sum)", tForEach);
+	printf("  %-34s %8.3fms\n", "Hand written loop (sum)", tLoop);
+}
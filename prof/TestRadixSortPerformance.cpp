@@ -0,0 +1,100 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+#include "../Threading.h"
+#include "Timing.h"
+#include <stdio.h>
+using namespace SimpleLib;
+
+namespace
+{
+	// Small deterministic PRNG (xorshift32) so the generated data - and
+	// therefore the timing - is reproducible between runs
+	class Rng
+	{
+	public:
+		Rng(uint32_t seed) : m_state(seed ? seed : 1) {}
+
+		uint32_t Next()
+		{
+			m_state ^= m_state << 13;
+			m_state ^= m_state >> 17;
+			m_state ^= m_state << 5;
+			return m_state;
+		}
+
+	private:
+		uint32_t m_state;
+	};
+
+	// Generate `count` keys of type T. Pattern 0 is full range random
+	// values, pattern 1 is small values (0..999, so radix sort can skip the
+	// constant high bytes)
+	template <typename T>
+	void Fill(List<T>& list, int count, int pattern)
+	{
+		Rng rng(6789);
+		list.Clear();
+		for (int i = 0; i < count; i++)
+		{
+			uint64_t bits = ((uint64_t)rng.Next() << 32) | rng.Next();
+			if (pattern == 1)
+				list.Add((T)(bits % 1000));
+			else if constexpr (sizeof(T) == 8)
+				list.Add((T)bits);
+			else
+				list.Add((T)(uint32_t)bits);
+		}
+	}
+
+	template <typename T, typename TFn>
+	double TimeSort(List<T>& list, int count, int pattern, TFn fn)
+	{
+		Fill(list, count, pattern);
+		double ms = Time<std::milli>(1, [&](int) { fn(); });
+
+		for (int i = 1; i < list.GetCount(); i++)
+			Assert(!(list[i] < list[i - 1]));
+
+		return ms;
+	}
+
+	template <typename T>
+	void Run(const char* typeName)
+	{
+		const int sizes[] = { 100, 1000, 10000, 100000, 1000000, 4000000 };
+		const char* patterns[] = { "random", "0..999" };
+
+		List<T> list;
+		for (int pattern = 0; pattern < 2; pattern++)
+		{
+			printf("  %s, %s:\n", typeName, patterns[pattern]);
+			printf("    %10s %10s %10s %10s %10s\n", "count", "Sort()", "Stable", "Radix", "Parallel");
+
+			for (int size : sizes)
+			{
+				// Repeat small sizes so the timings are measurable
+				int reps = size < 100000 ? 1000000 / size : 1;
+
+				double tSort = 0, tStable = 0, tRadix = 0, tParallel = 0;
+				for (int rep = 0; rep < reps; rep++)
+				{
+					tSort += TimeSort(list, size, pattern, [&]() { list.Sort(); });
+					tStable += TimeSort(list, size, pattern, [&]() { list.StableSort(); });
+					tRadix += TimeSort(list, size, pattern, [&]() { list.RadixSort(); });
+					tParallel += TimeSort(list, size, pattern, [&]() { Parallel::RadixSort(list); });
+				}
+
+				printf("    %10d %8.3fms %8.3fms %8.3fms %8.3fms\n", size,
+					tSort / reps, tStable / reps, tRadix / reps, tParallel / reps);
+			}
+		}
+	}
+}
+
+Fact("Radix Sort Performance")
+{
+	printf("Radix Sort Performance (%d threads, times per sort):\n", WorkerSet::Default().GetConcurrency());
+	Run<uint32_t>("uint32_t");
+	Run<int64_t>("int64_t");
+	Run<float>("float");
+}
@@ -0,0 +1,73 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+#include "../Json.h"
+#include "Timing.h"
+#include <stdio.h>
+using namespace SimpleLib;
+
+namespace
+{
+	uint64_t NextRandom(uint64_t& state)
+	{
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	}
+}
+
+Fact("Ryu Performance")
+{
+	printf("Ryu Performance:\n");
+
+	// Prices (few digits) and random doubles (17 digits, any exponent)
+	const int count = 100000;
+	List<double> prices;
+	List<double> randoms;
+	uint64_t state = 12345;
+	for (int i = 0; i < count; i++)
+	{
+		prices.Add((double)(NextRandom(state) % 1000000) / 100);
+		uint64_t bits = NextRandom(state) & 0x7FEFFFFFFFFFFFFFull;
+		double value;
+		memcpy(&value, &bits, sizeof(value));
+		randoms.Add(value);
+	}
+
+	char buf[64];
+	volatile int sink = 0;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		List<double>& values = pass == 0 ? prices : randoms;
+		double tRyu = Time(count * 10, [&](int i) { sink = Ryu::Format(buf, values[i % count]); });
+		double tSnprintf = Time(count * 10, [&](int i) { sink = snprintf(buf, sizeof(buf), "%.17g", values[i % count]); });
+		printf("  %-14s Ryu::Format %6.1fns  snprintf(\"%%.17g\") %6.1fns (%4.1fx)\n",
+			pass == 0 ? "prices:" : "random doubles:", tRyu, tSnprintf, tSnprintf / tRyu);
+	}
+
+	// A JSON array of numbers, against what Stringify used to do per number
+	for (int pass = 0; pass < 2; pass++)
+	{
+		List<double>& values = pass == 0 ? prices : randoms;
+		JSONArray* array = new JSONArray();
+		for (int i = 0; i < count; i++)
+			array->Add(JSONValue(values[i]));
+		JSONValue json(array);
+
+		double tStringify = Time(10, [&](int) { sink = JSON::Stringify(json, 0).GetLength(); });
+		double tBefore = Time(10, [&](int) {
+			StringBuilder<char> sb;
+			sb.Append('[');
+			for (int i = 0; i < count; i++)
+			{
+				if (i > 0)
+					sb.Append(',');
+				sb.Append(buf, snprintf(buf, sizeof(buf), "%.17g", values[i]));
+			}
+			sb.Append(']');
+			sink = sb.GetLength();
+		});
+		printf("  JSON::Stringify, %d %-14s %7.2fms  with \"%%.17g\" %7.2fms (%4.1fx)\n",
+			count, pass == 0 ? "prices:" : "random doubles:", tStringify / 1e6, tBefore / 1e6, tBefore / tStringify);
+	}
+}
@@ -0,0 +1,105 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+#include "Timing.h"
+#include <stdio.h>
+using namespace SimpleLib;
+
+namespace
+{
+	// Small deterministic PRNG (xorshift32) so the generated data - and
+	// therefore the timing - is reproducible between runs
+	class Rng
+	{
+	public:
+		Rng(uint32_t seed) : m_state(seed ? seed : 1) {}
+
+		uint32_t Next()
+		{
+			m_state ^= m_state << 13;
+			m_state ^= m_state >> 17;
+			m_state ^= m_state << 5;
+			return m_state;
+		}
+
+	private:
+		uint32_t m_state;
+	};
+
+	int CompareIntToKey(int elem, int key, void*)
+	{
+		return elem > key ? 1 : elem < key ? -1 : 0;
+	}
+
+}
+
+Fact("Search Performance")
+{
+	// Linear membership tests
+	{
+		const int count = 10000;
+		const int reps = 20000;
+		List<int> list;
+		for (int i = 0; i < count; i++)
+			list.Add(i * 3);
+
+		volatile int sink = 0;
+		double tScalar = Time(reps, [&](int i) {
+			int key = (i * 7919) % (count * 3);
+			const int* data = list.GetBuffer();
+			int found = -1;
+			for (int j = 0; j < count; j++)
+			{
+				if (data[j] == key)
+				{
+					found = j;
+					break;
+				}
+			}
+			sink = found;
+		});
+		double tSimd = Time(reps, [&](int i) {
+			sink = list.IndexOf((i * 7919) % (count * 3));
+		});
+
+		printf("Search Performance: IndexOf on %d ints\n", count);
+		printf("  %-24s %10.1fns\n", "scalar loop", tScalar);
+		printf("  %-24s %10.1fns\n", "List::IndexOf", tSimd);
+	}
+
+	// Sorted searches
+	const int sizes[] = { 1000, 100000, 10000000 };
+	printf("Search Performance: sorted lookups (ns per lookup)\n");
+	printf("  %10s %12s %12s %12s\n", "count", "classic", "branchless", "eytzinger");
+	for (int count : sizes)
+	{
+		List<int> list;
+		for (int i = 0; i < count; i++)
+			list.Add(i * 2);
+
+		EytzingerIndex<int> eytzinger;
+		Assert(eytzinger.Build(list.GetBuffer(), count));
+
+		const int reps = 2000000;
+		List<int> keys;
+		Rng rng(42);
+		for (int i = 0; i < 4096; i++)
+			keys.Add((int)(rng.Next() % (uint32_t)(count * 2)));
+
+		volatile int sink = 0;
+		double tClassic = Time(reps, [&](int i) {
+			int index;
+			list.BinarySearch(index, keys[i & 4095], CompareIntToKey);
+			sink = index;
+		});
+		double tBranchless = Time(reps, [&](int i) {
+			int index;
+			list.BinarySearch(index, keys[i & 4095]);
+			sink = index;
+		});
+		double tEytzinger = Time(reps, [&](int i) {
+			sink = eytzinger.LowerBound(keys[i & 4095]);
+		});
+
+		printf("  %10d %10.1fns %10.1fns %10.1fns\n", count, tClassic, tBranchless, tEytzinger);
+	}
+}
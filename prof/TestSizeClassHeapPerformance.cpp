@@ -0,0 +1,88 @@
+#include "../UnitTesting.h"
+#include "../Threading.h"
+#include "Timing.h"
+#include <stdio.h>
+#include <thread>
+#include <atomic>
+using namespace SimpleLib;
+
+namespace
+{
+	size_t SizeFor(int i)
+	{
+		// Mostly small, occasionally larger
+		return (i & 15) == 0 ? 1024 + (i % 3000) : 16 + (i * 7) % 240;
+	}
+
+	// Producer allocates, consumer frees on another thread
+	template <typename TAlloc, typename TFree>
+	double ProducerConsumer(int count, TAlloc alloc, TFree release)
+	{
+		const int kInFlight = 1024;
+		void* volatile ring[kInFlight] = {};
+		std::atomic<int> produced{ 0 };
+		std::atomic<int> consumed{ 0 };
+
+		return Time<std::milli>(1, [&](int) {
+			std::thread consumer([&]() {
+				for (int i = 0; i < count; i++)
+				{
+					while (consumed.load(std::memory_order_relaxed) >= produced.load(std::memory_order_acquire))
+						std::this_thread::yield();
+					release(ring[i % kInFlight]);
+					consumed.store(i + 1, std::memory_order_release);
+				}
+			});
+			for (int i = 0; i < count; i++)
+			{
+				while (produced.load(std::memory_order_relaxed) - consumed.load(std::memory_order_acquire) >= kInFlight)
+					std::this_thread::yield();
+				ring[i % kInFlight] = alloc(SizeFor(i));
+				produced.store(i + 1, std::memory_order_release);
+			}
+			consumer.join();
+		});
+	}
+}
+
+Fact("SizeClassHeap Performance")
+{
+	const int count = 2000000;
+	void** ptrs = new void*[1000];
+	SizeClassHeap heap;
+
+	printf("SizeClassHeap Performance: %d mixed size allocations\n", count);
+
+	double tMalloc = Time<std::milli>(1, [&](int) {
+		for (int i = 0; i < count; i += 1000)
+		{
+			for (int j = 0; j < 1000; j++)
+				ptrs[j] = malloc(SizeFor(i + j));
+			for (int j = 0; j < 1000; j++)
+				free(ptrs[j]);
+		}
+	});
+	double tHeap = Time<std::milli>(1, [&](int) {
+		for (int i = 0; i < count; i += 1000)
+		{
+			for (int j = 0; j < 1000; j++)
+				ptrs[j] = heap.Alloc(SizeFor(i + j));
+			for (int j = 0; j < 1000; j++)
+				heap.Free(ptrs[j]);
+		}
+	});
+	printf("  %-32s %10.2fms\n", "malloc/free (same thread)", tMalloc);
+	printf("  %-32s %10.2fms\n", "SizeClassHeap (same thread)", tHeap);
+
+	double tMallocCross = ProducerConsumer(count,
+		[](size_t size) { return malloc(size); },
+		[](void* p) { free(p); });
+	double tHeapCross = ProducerConsumer(count,
+		[&](size_t size) { return heap.Alloc(size); },
+		[&](void* p) { heap.Free(p); });
+	printf("  %-32s %10.2fms\n", "malloc/free (cross thread)", tMallocCross);
+	printf("  %-32s %10.2fms\n", "SizeClassHeap (cross thread)", tHeapCross);
+	printf("  slabs: %d (%dKB)\n", heap.GetSlabCount(), heap.GetSlabCount() * (int)(SizeClassHeap::kSlabSize / 1024));
+
+	delete[] ptrs;
+}
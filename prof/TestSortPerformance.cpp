@@ -0,0 +1,116 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+#include "Timing.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+using namespace SimpleLib;
+
+namespace
+{
+	// Small deterministic PRNG (xorshift32) so the generated data - and
+	// therefore the timing - is reproducible between runs
+	class Rng
+	{
+	public:
+		Rng(uint32_t seed) : m_state(seed ? seed : 1) {}
+
+		uint32_t Next()
+		{
+			m_state ^= m_state << 13;
+			m_state ^= m_state >> 17;
+			m_state ^= m_state << 5;
+			return m_state;
+		}
+
+	private:
+		uint32_t m_state;
+	};
+
+	// qsort_r/qsort_s compare callback (argument order differs between the
+	// two, same as the old List::Sort trampolines)
+#ifdef _MSC_VER
+	int QsortCompare(void* /*ctx*/, const void* a, const void* b)
+#else
+	int QsortCompare(const void* a, const void* b, void* /*ctx*/)
+#endif
+	{
+		int x = *(const int*)a;
+		int y = *(const int*)b;
+		return x > y ? 1 : x < y ? -1 : 0;
+	}
+
+	int CompareInts(int a, int b)
+	{
+		return a > b ? 1 : a < b ? -1 : 0;
+	}
+
+	void Fill(List<int>& list, int count, int pattern)
+	{
+		Rng rng(12345);
+		list.Clear();
+		for (int i = 0; i < count; i++)
+		{
+			switch (pattern)
+			{
+				case 0: list.Add((int)rng.Next()); break;					// random
+				case 1: list.Add(i); break;									// sorted
+				case 2: list.Add(count - i); break;							// reversed
+				case 3: list.Add((int)(rng.Next() % 16)); break;			// few unique
+				default: list.Add(i % 1000 == 0 ? (int)rng.Next() : i); break;	// nearly sorted
+			}
+		}
+	}
+
+	template <typename TFn>
+	double TimeSort(List<int>& list, int count, int pattern, TFn fn)
+	{
+		Fill(list, count, pattern);
+		double ms = Time<std::milli>(1, [&](int) { fn(); });
+
+		for (int i = 1; i < list.GetCount(); i++)
+			Assert(list[i - 1] <= list[i]);
+
+		return ms;
+	}
+}
+
+Fact("Sort Performance")
+{
+	const int count = 1000000;
+	const char* patterns[] = { "random", "sorted", "reversed", "few unique", "nearly sorted" };
+
+	List<int> list;
+
+	printf("Sort Performance: %d ints\n", count);
+	printf("  %-14s %10s %10s %10s %10s %10s\n", "pattern", "qsort_r", "std::sort", "Sort()", "Sort(fn)", "Stable");
+
+	for (int pattern = 0; pattern < 5; pattern++)
+	{
+		double tQsort = TimeSort(list, count, pattern, [&]() {
+#ifdef _MSC_VER
+			qsort_s(list.GetBuffer(), list.GetCount(), sizeof(int), QsortCompare, nullptr);
+#else
+			qsort_r(list.GetBuffer(), list.GetCount(), sizeof(int), QsortCompare, nullptr);
+#endif
+		});
+
+		double tStd = TimeSort(list, count, pattern, [&]() {
+			std::sort(list.GetBuffer(), list.GetBuffer() + list.GetCount());
+		});
+
+		double tSort = TimeSort(list, count, pattern, [&]() {
+			list.Sort();
+		});
+
+		double tSortFn = TimeSort(list, count, pattern, [&]() {
+			list.Sort(CompareInts);
+		});
+
+		double tStable = TimeSort(list, count, pattern, [&]() {
+			list.StableSort();
+		});
+
+		printf("  %-14s %8.2fms %8.2fms %8.2fms %8.2fms %8.2fms\n", patterns[pattern], tQsort, tStd, tSort, tSortFn, tStable);
+	}
+}
@@ -0,0 +1,116 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+#include <stdio.h>
+#include <chrono>
+using namespace SimpleLib;
+
+namespace
+{
+	// Tracks the peak number of bytes allocated through it (the size of
+	// each block is stored in front of it)
+	struct PeakStats
+	{
+		size_t live;
+		size_t peak;
+	};
+
+	PeakStats peakStats;
+
+	struct TPeakMalloc
+	{
+		static void* Alloc(size_t size)
+		{
+			size_t* p = (size_t*)malloc(size + sizeof(size_t));
+			*p = size;
+			Track(size);
+			return p + 1;
+		}
+
+		static void* ReAlloc(void* ptr, size_t size)
+		{
+			if (!ptr)
+				return Alloc(size);
+			size_t* p = (size_t*)ptr - 1;
+			size_t oldSize = *p;
+
+			// Count the old and new blocks as both live at the peak, as
+			// they are whenever realloc can't grow in place
+			Track(size);
+			p = (size_t*)realloc(p, size + sizeof(size_t));
+			peakStats.live -= oldSize;
+			*p = size;
+			return p + 1;
+		}
+
+		static void Free(void* ptr)
+		{
+			if (!ptr)
+				return;
+			size_t* p = (size_t*)ptr - 1;
+			peakStats.live -= *p;
+			free(p);
+		}
+
+		static void Track(size_t size)
+		{
+			peakStats.live += size;
+			if (peakStats.live > peakStats.peak)
+				peakStats.peak = peakStats.live;
+		}
+	};
+
+	double Now()
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+	}
+
+	// Build `length` characters of JSON-ish lines, then consume them either
+	// chunk by chunk (as writing to a file would) or as one string
+	void Run(const char* label, int chunkSize, int length, bool flatten)
+	{
+		peakStats = PeakStats();
+		double start = Now();
+
+		volatile size_t sink = 0;
+		{
+			StringBuilder<char, TPeakMalloc> sb;
+			sb.SetChunkSize(chunkSize);
+			int i = 0;
+			while (sb.GetLength() < length)
+			{
+				sb.Append("    { \"id\": ");
+				sb.Format("%d", i++);
+				sb.Append(", \"name\": \"some value\", \"active\": true },\n");
+			}
+
+			if (flatten)
+			{
+				sink = strlen(sb.sz());
+			}
+			else
+			{
+				sb.ForEachChunk([&](const char* p, int chunkLength) {
+					sink += p[chunkLength - 1];
+					return true;
+				});
+			}
+		}
+
+		double ms = Now() - start;
+		printf("  %-28s %4dMB: %8.1fms  peak memory %6.1fMB (%.2fx)\n", label, (length + 4096) >> 20, ms,
+			peakStats.peak / 1048576.0, (double)peakStats.peak / length);
+	}
+}
+
+Fact("StringBuilder Performance")
+{
+	printf("StringBuilder Performance:\n");
+	for (int mb : { 16, 256 })
+	{
+		// (just under a power of two, the one buffer case's best case)
+		int length = (mb << 20) - 4096;
+		Run("one buffer", 0, length, false);
+		Run("64K chunks, streamed out", 65536, length, false);
+		Run("64K chunks, flattened", 65536, length, true);
+	}
+}
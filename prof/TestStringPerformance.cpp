@@ -0,0 +1,77 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+#include "Timing.h"
+#include <stdio.h>
+using namespace SimpleLib;
+
+namespace
+{
+	// Times constructing (or copying) a batch of strings and then destroying
+	// them, keeping the batch alive so the allocations can't be optimised away
+	void Report(const char* label, int length, int reps, const char* const* keys)
+	{
+		volatile int sink = 0;
+		String* batch = (String*)malloc(1024 * sizeof(String));
+
+		double tConstruct = Time(reps, [&](int) {
+			for (int i = 0; i < 1024; i++)
+				new (batch + i) String(keys[i]);
+			for (int i = 0; i < 1024; i++)
+			{
+				sink = batch[i].GetLength();
+				batch[i].~String();
+			}
+		}) / 1024;
+
+		String source(keys[0]);
+		double tCopy = Time(reps, [&](int) {
+			for (int i = 0; i < 1024; i++)
+				new (batch + i) String(source);
+			for (int i = 0; i < 1024; i++)
+			{
+				sink = batch[i].GetLength();
+				batch[i].~String();
+			}
+		}) / 1024;
+
+		// Filling a list of keys, as a parser building objects would
+		double tList = Time(reps, [&](int) {
+			List<String> list;
+			for (int i = 0; i < 1024; i++)
+				list.Add(String(keys[i]));
+			sink = list.GetCount();
+		}) / 1024;
+
+		free(batch);
+
+		printf("  %-8s (%2d chars)  construct+destroy %7.2fns  copy+destroy %7.2fns  add to list %7.2fns\n",
+			label, length, tConstruct, tCopy, tList);
+	}
+
+	void Run(int length, const char* label)
+	{
+		// A table of distinct keys of the given length
+		char* buf = (char*)malloc(1024 * (length + 1));
+		const char* keys[1024];
+		for (int i = 0; i < 1024; i++)
+		{
+			char* key = buf + i * (length + 1);
+			for (int j = 0; j < length; j++)
+				key[j] = 'a' + (i * 7 + j) % 26;
+			key[length] = '\0';
+			keys[i] = key;
+		}
+
+		Report(label, length, 10000, keys);
+		free(buf);
+	}
+}
+
+Fact("String Performance")
+{
+	printf("String Performance: (inline capacity %d chars)\n", String::kInlineCapacity);
+	Run(8, "inline");
+	Run(String::kInlineCapacity, "inline");
+	Run(String::kInlineCapacity + 1, "heap");
+	Run(64, "heap");
+}
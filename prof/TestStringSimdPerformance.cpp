@@ -0,0 +1,74 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+#include "../Core/StringSimd.h"
+#include "Timing.h"
+#include <stdio.h>
+using namespace SimpleLib;
+
+namespace
+{
+	const char* LevelName(StringSimdLevel level)
+	{
+		switch (level)
+		{
+			case StringSimdLevel::Avx2: return "avx2";
+			case StringSimdLevel::Sse2: return "sse2";
+			default: return "scalar";
+		}
+	}
+
+	// Times each kernel over `length` characters, reporting GB/s
+	void Run(StringSimdLevel level, int length, int reps)
+	{
+		StringSimd::SetLevel(level);
+		if (StringSimd::GetLevel() != level)
+			return;
+
+		// Mixed case text with the things being looked for only at the end
+		char* text = (char*)malloc(length + 1);
+		char* other = (char*)malloc(length + 1);
+		char* dest = (char*)malloc(length + 1);
+		for (int i = 0; i < length; i++)
+			text[i] = "Lorem ipsum dolor sit amet, consectetur adipiscing elit "[i % 56];
+		memcpy(text + length - 8, "#needle#", 8);
+		text[length] = '\0';
+		for (int i = 0; i < length; i++)
+			other[i] = (char)(text[i] >= 'a' && text[i] <= 'z' ? text[i] - 32 : text[i]);
+		other[length] = '\0';
+
+		char* spaces = (char*)malloc(length + 1);
+		memset(spaces, ' ', length - 1);
+		spaces[length - 1] = 'x';
+		spaces[length] = '\0';
+
+		volatile int sink = 0;
+		double gb = length / 1e9;
+
+		double tChar = Time(reps, [&](int) { sink = StringSimd::IndexOf(text, length, '#'); });
+		double tFind = Time(reps, [&](int) { sink = StringSimd::IndexOf(text, length, "needle", 6); });
+		double tUpper = Time(reps, [&](int) { StringSimd::ToUpper(dest, text, length); sink = dest[0]; });
+		double tCompare = Time(reps, [&](int) { sink = StringSimd::CompareI(text, other, length); });
+		double tSkip = Time(reps, [&](int) { const char* p = spaces; Parse<char>::SkipWhiteSpace(p); sink = (int)(p - spaces); });
+
+		printf("  %-6s %7d chars: find char %6.2f GB/s  find string %6.2f GB/s  to upper %6.2f GB/s  compare ci %6.2f GB/s  skip white %6.2f GB/s\n",
+			LevelName(level), length, gb / (tChar * 1e-9), gb / (tFind * 1e-9), gb / (tUpper * 1e-9), gb / (tCompare * 1e-9), gb / (tSkip * 1e-9));
+
+		free(text);
+		free(other);
+		free(dest);
+		free(spaces);
+	}
+}
+
+Fact("StringSimd Performance")
+{
+	printf("StringSimd Performance: (supported %s)\n", LevelName(StringSimd::GetSupportedLevel()));
+	for (int length : { 4096, 1 << 20 })
+	{
+		int reps = (int)(400000000LL / length);
+		Run(StringSimdLevel::Scalar, length, reps);
+		Run(StringSimdLevel::Sse2, length, reps);
+		Run(StringSimdLevel::Avx2, length, reps);
+	}
+	StringSimd::SetLevel(StringSimd::GetSupportedLevel());
+}
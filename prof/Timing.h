@@ -0,0 +1,15 @@
+#pragma once
+
+#include <chrono>
+
+// Average time taken by fn(i) over calls for i = 0 to reps - 1, in TUnit
+// (nanoseconds by default - eg: Time<std::milli> for milliseconds)
+template <typename TUnit = std::nano, typename TFn>
+double Time(int reps, TFn fn)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < reps; i++)
+		fn(i);
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, TUnit>(end - start).count() / reps;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdlib.h>
+
+// Stateful allocator that counts allocations into a caller supplied stats
+// block - used by the container tests to check allocator instances are
+// carried through and every allocation is returned to the right one.
+struct AllocStats
+{
+	int allocs;
+	int frees;
+	int live;
+};
+
+class CountingAllocator
+{
+public:
+	CountingAllocator() : m_stats(nullptr) {}
+	CountingAllocator(AllocStats* stats) : m_stats(stats) {}
+
+	void* Alloc(size_t size)
+	{
+		m_stats->allocs++;
+		m_stats->live++;
+		return malloc(size);
+	}
+	void* ReAlloc(void* ptr, size_t size)
+	{
+		if (!ptr)
+			return Alloc(size);
+		return realloc(ptr, size);
+	}
+	void Free(void* ptr)
+	{
+		if (!ptr)
+			return;
+		m_stats->frees++;
+		m_stats->live--;
+		free(ptr);
+	}
+
+	AllocStats* m_stats;
+};
@@ -0,0 +1,187 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+using namespace SimpleLib;
+
+Fact("Arena Alloc Respects Alignment")
+{
+	Arena arena(256);
+	for (int i = 0; i < 100; i++)
+	{
+		size_t alignment = (size_t)1 << (i % 7);
+		void* p = arena.Alloc(i % 13 + 1, alignment);
+		Assert(p != nullptr);
+		Assert(((uintptr_t)p & (alignment - 1)) == 0);
+	}
+
+	// Default alignment
+	arena.Alloc(1);
+	Assert(((uintptr_t)arena.Alloc(8) & (Arena::kDefaultAlignment - 1)) == 0);
+}
+
+Fact("Arena Allocations Don't Overlap")
+{
+	Arena arena(128);
+	unsigned char* blocks[200];
+	for (int i = 0; i < 200; i++)
+	{
+		blocks[i] = (unsigned char*)arena.Alloc(i % 50 + 1);
+		memset(blocks[i], i, i % 50 + 1);
+	}
+	for (int i = 0; i < 200; i++)
+	{
+		for (int j = 0; j < i % 50 + 1; j++)
+			Assert(blocks[i][j] == (unsigned char)i);
+	}
+}
+
+Fact("Arena Large Allocation")
+{
+	Arena arena(256);
+	arena.Alloc(10);
+	char* p = (char*)arena.Alloc(10000);
+	Assert(p != nullptr);
+	memset(p, 1, 10000);
+	Assert(arena.GetCapacity() >= 10256);
+}
+
+Fact("Arena Zero Block Size")
+{
+	Arena arena(0);
+	char* p = (char*)arena.Alloc(1000);
+	Assert(p != nullptr);
+	memset(p, 1, 1000);
+	Assert(arena.GetCapacity() >= 1000);
+}
+
+Fact("Arena Impossibly Large Allocation Fails")
+{
+	Arena arena(256);
+	Assert(arena.Alloc(10) != nullptr);
+	Assert(arena.Alloc(SIZE_MAX - 16) == nullptr);
+	Assert(arena.Alloc(SIZE_MAX / 2 + 1) == nullptr);
+
+	// Still usable afterwards
+	Assert(arena.Alloc(10) != nullptr);
+}
+
+Fact("Arena Rewind Reuses Memory")
+{
+	Arena arena(1024);
+	arena.Alloc(100);
+
+	ArenaMark mark = arena.Mark();
+	void* first = arena.Alloc(100);
+	for (int i = 0; i < 100; i++)
+		arena.Alloc(100);
+	size_t capacity = arena.GetCapacity();
+	Assert(arena.GetUsed() > 10000);
+
+	arena.Rewind(mark);
+	Assert(arena.Alloc(100) == first);
+	Assert(arena.GetUsed() < 1024);
+
+	// Refilling reuses the existing blocks
+	for (int i = 0; i < 100; i++)
+		arena.Alloc(100);
+	Assert(arena.GetCapacity() == capacity);
+}
+
+Fact("Arena Mark Before First Allocation")
+{
+	Arena arena(1024);
+	ArenaMark mark = arena.Mark();
+	void* p = arena.Alloc(10);
+	arena.Rewind(mark);
+	Assert(arena.GetUsed() == 0);
+	Assert(arena.Alloc(10) == p);
+}
+
+Fact("Arena FreeAll And Reset")
+{
+	Arena arena(1024);
+	void* p = arena.Alloc(10);
+	for (int i = 0; i < 50; i++)
+		arena.Alloc(100);
+
+	arena.FreeAll();
+	Assert(arena.GetUsed() == 0);
+	Assert(arena.Alloc(10) == p);
+	Assert(arena.GetCapacity() > 0);
+
+	arena.Reset();
+	Assert(arena.GetCapacity() == 0);
+	Assert(arena.GetUsed() == 0);
+}
+
+Fact("Arena Resize And Free Most Recent")
+{
+	Arena arena(1024);
+	void* a = arena.Alloc(10);
+	void* b = arena.Alloc(10);
+
+	// Only the most recent allocation can be resized/freed
+	Assert(!arena.Resize(a, 10, 20));
+	Assert(arena.Resize(b, 10, 500));
+	Assert(!arena.Resize(b, 500, 5000));
+
+	arena.Free(b, 500);
+	Assert(arena.Alloc(10) == b);
+}
+
+Fact("ArenaScope Rewinds")
+{
+	Arena arena(1024);
+	arena.Alloc(10);
+	size_t used = arena.GetUsed();
+	{
+		ArenaScope scope(arena);
+		for (int i = 0; i < 50; i++)
+			arena.Alloc(100);
+		Assert(arena.GetUsed() > used);
+	}
+	Assert(arena.GetUsed() == used);
+}
+
+Fact("List And Map With ArenaAllocator")
+{
+	Arena arena(4096);
+	{
+		ArenaScope scope(arena);
+
+		List<int, ArenaAllocator> list(&arena);
+		for (int i = 0; i < 10000; i++)
+			list.Add(i);
+		for (int i = 0; i < 10000; i++)
+			Assert(list[i] == i);
+		Assert(list.GetAllocator().GetArena() == &arena);
+
+		Map<int, int, SDefaultCompare, ArenaAllocator> map(&arena);
+		for (int i = 0; i < 1000; i++)
+			map.Add(i, i * 2);
+		for (int i = 0; i < 1000; i++)
+			Assert(map.Get(i) == i * 2);
+
+		StringBuilder<char, ArenaAllocator> sb(&arena);
+		for (int i = 0; i < 100; i++)
+			sb.Append("0123456789");
+		Assert(sb.GetLength() == 1000);
+	}
+	Assert(arena.GetUsed() == 0);
+}
+
+Fact("ArenaAllocator ReAlloc Grows Most Recent In Place")
+{
+	Arena arena(4096);
+	ArenaAllocator allocator(&arena);
+	allocator.Alloc(16);
+	char* p = (char*)allocator.Alloc(100);
+	memset(p, 7, 100);
+	Assert(allocator.ReAlloc(p, 1000) == p);
+
+	// Not the most recent any more, so it must move
+	allocator.Alloc(16);
+	char* q = (char*)allocator.ReAlloc(p, 2000);
+	Assert(q != p);
+	for (int i = 0; i < 100; i++)
+		Assert(q[i] == 7);
+}
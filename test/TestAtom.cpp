@@ -0,0 +1,149 @@
+#include <thread>
+#include "../UnitTesting.h"
+#include "../Core.h"
+#include "../Threading.h"
+using namespace SimpleLib;
+
+Fact("Atom Equal Strings Are Identical")
+{
+	Atom a("gain");
+	Atom b(String("gain"));
+	Atom c("gain and more", 4);
+	Atom d("pan");
+
+	Assert(a == b);
+	Assert(a == c);
+	Assert(a.sz() == b.sz());
+	Assert(a != d);
+	Assert(strcmp(a.sz(), "gain") == 0);
+	Assert(a.GetLength() == 4);
+	Assert(a.ToString().IsEqualTo("gain"));
+
+	// Hash is cached and matches String's
+	Assert(Atom::Hash(a) == String::Hash(String("gain")));
+	Assert(a.GetHash() == c.GetHash());
+}
+
+Fact("Atom Null And Empty")
+{
+	Atom null;
+	Assert(null.IsNull());
+	Assert(null.sz() == nullptr);
+	Assert(null.GetLength() == 0);
+	Assert(Atom((const char*)nullptr).IsNull());
+	Assert(Atom(String()).IsNull());
+
+	Atom empty("");
+	Assert(!empty.IsNull());
+	Assert(empty.GetLength() == 0);
+	Assert(empty == Atom(String("")));
+	Assert(empty != null);
+}
+
+Fact("Atom Find Doesn't Intern")
+{
+	Assert(Atom::Find("Atom Find Doesn't Intern - never interned").IsNull());
+	Assert(Atom::Find("Atom Find Doesn't Intern - never interned").IsNull());
+
+	Atom a("Atom Find Doesn't Intern - interned");
+	Assert(Atom::Find("Atom Find Doesn't Intern - interned") == a);
+	Assert(Atom::Find("Atom Find Doesn't Intern - interned and more", 35) == a);
+}
+
+Fact("Atom Ordering Is By Text")
+{
+	Assert(Atom("apple") < Atom("banana"));
+	Assert(Atom("banana") > Atom("apple"));
+	Assert(!(Atom("apple") < Atom("apple")));
+	Assert(Atom() < Atom(""));
+}
+
+Fact("Atom As Map Key")
+{
+	Map<Atom, int> map;
+	map.Set(Atom("x"), 1);
+	map.Set(Atom("y"), 2);
+	map.Set(Atom("x"), 3);
+
+	Assert(map.GetCount() == 2);
+	Assert(map.Get(Atom("x")) == 3);
+	Assert(map.Get(Atom("y")) == 2);
+	Assert(!map.ContainsKey(Atom("z")));
+}
+
+Fact("AtomTable Private Table")
+{
+	AtomTable table(256);
+
+	Atom a = table.Intern("private");
+	Assert(a == table.Intern("private"));
+	Assert(a == table.Find("private"));
+	Assert(a != Atom("private"));
+	Assert(table.Find("missing").IsNull());
+	Assert(table.Intern(nullptr).IsNull());
+	Assert(table.GetCount() == 1);
+
+	// Grows past the initial capacity, keeping existing atoms
+	char buf[32];
+	for (int i = 0; i < 5000; i++)
+	{
+		snprintf(buf, sizeof(buf), "name%i", i);
+		table.Intern(buf);
+	}
+	Assert(table.GetCount() == 5001);
+	Assert(table.Find("private") == a);
+	for (int i = 0; i < 5000; i++)
+	{
+		snprintf(buf, sizeof(buf), "name%i", i);
+		Atom atom = table.Find(buf);
+		Assert(!atom.IsNull());
+		Assert(strcmp(atom.sz(), buf) == 0);
+	}
+}
+
+Fact("AtomTable Concurrent Intern")
+{
+	AtomTable table;
+
+	// Every thread interns the same names, racing to add each one (and
+	// growing the table under the others)
+	const int count = 5000;
+	Atom results[4][count];
+	std::thread threads[4];
+	for (int t = 0; t < 4; t++)
+	{
+		threads[t] = std::thread([&, t]() {
+			char buf[32];
+			for (int i = 0; i < count; i++)
+			{
+				int n = (i * 7 + t * 13) % count;
+				snprintf(buf, sizeof(buf), "name%i", n);
+				results[t][n] = table.Intern(buf);
+			}
+		});
+	}
+	for (int t = 0; t < 4; t++)
+		threads[t].join();
+
+	Assert(table.GetCount() == count);
+	for (int i = 0; i < count; i++)
+	{
+		Assert(!results[0][i].IsNull());
+		for (int t = 1; t < 4; t++)
+			Assert(results[t][i] == results[0][i]);
+	}
+}
+
+#ifdef _SIMPLELIB_REALTIME_GUARD
+
+Fact("Atom Lookup Doesn't Lock Or Allocate")
+{
+	Atom gain("gain");
+
+	RealTimeScope scope;
+	Assert(Atom("gain") == gain);
+	Assert(Atom::Find("gain") == gain);
+	Assert(RealTimeGuard::GetViolationCount() == 0);
+}
+
+#endif
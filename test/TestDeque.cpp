@@ -0,0 +1,184 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+using namespace SimpleLib;
+
+namespace
+{
+	class Tracked
+	{
+	public:
+		Tracked(int value = 0) : Value(value) { s_instances++; }
+		Tracked(const Tracked& other) : Value(other.Value) { s_instances++; }
+		~Tracked() { s_instances--; }
+
+		int Value;
+
+		inline static int s_instances = 0;
+	};
+}
+
+Fact("Deque Push Pop Both Ends")
+{
+	Deque<int> deque;
+	Assert(deque.IsEmpty());
+
+	deque.PushBack(1);
+	deque.PushBack(2);
+	deque.PushFront(0);
+	deque.PushFront(-1);
+	Assert(deque.GetCount() == 4);
+	Assert(deque.GetFront() == -1);
+	Assert(deque.GetBack() == 2);
+	for (int i = 0; i < 4; i++)
+		Assert(deque[i] == i - 1);
+
+	Assert(deque.PopFront() == -1);
+	Assert(deque.PopBack() == 2);
+	Assert(deque.PopFront() == 0);
+	Assert(deque.PopBack() == 1);
+	Assert(deque.IsEmpty());
+}
+
+Fact("Deque Grows While Wrapped")
+{
+	Deque<int> deque;
+
+	// Rotate the head part way round, then grow while wrapped
+	for (int i = 0; i < 10; i++)
+		deque.PushBack(-1);
+	deque.RemoveFront(10);
+	for (int i = 0; i < 1000; i++)
+		deque.PushBack(i);
+	Assert(deque.GetCount() == 1000);
+	for (int i = 0; i < 1000; i++)
+		Assert(deque[i] == i);
+
+	// Same from the front
+	Deque<int> front;
+	for (int i = 0; i < 1000; i++)
+		front.PushFront(i);
+	for (int i = 0; i < 1000; i++)
+		Assert(front[i] == 999 - i);
+}
+
+Fact("Deque Capacity Stays Power Of Two")
+{
+	Deque<int> deque;
+	Assert(deque.SetCapacity(100));
+	Assert(deque.GetCapacity() == 128);
+	for (int i = 0; i < 128; i++)
+		deque.PushBack(i);
+	Assert(deque.GetCapacity() == 128);
+	deque.PushBack(128);
+	Assert(deque.GetCapacity() == 256);
+}
+
+Fact("Deque Sliding Window")
+{
+	Deque<int> window;
+	int sum = 0;
+	for (int i = 0; i < 10000; i++)
+	{
+		window.PushBack(i);
+		sum += i;
+		if (window.GetCount() > 8)
+			sum -= window.PopFront();
+		if (i >= 7)
+			Assert(sum == 8 * i - 28);
+	}
+
+	// Never grew beyond the window
+	Assert(window.GetCapacity() == 16);
+}
+
+Fact("Deque Spans And CopyTo")
+{
+	Deque<int> deque;
+	deque.SetCapacity(16);
+	for (int i = 0; i < 12; i++)
+		deque.PushBack(-1);
+	deque.RemoveFront(12);
+	for (int i = 0; i < 10; i++)
+		deque.PushBack(i);
+
+	int* first;
+	int* second;
+	int firstCount;
+	int secondCount;
+	deque.GetSpans(first, firstCount, second, secondCount);
+	Assert(firstCount == 4);
+	Assert(secondCount == 6);
+	for (int i = 0; i < firstCount; i++)
+		Assert(first[i] == i);
+	for (int i = 0; i < secondCount; i++)
+		Assert(second[i] == firstCount + i);
+
+	int copy[10];
+	deque.CopyTo(copy, 0, 10);
+	for (int i = 0; i < 10; i++)
+		Assert(copy[i] == i);
+	deque.CopyTo(copy, 2, 5);
+	Assert(copy[0] == 2 && copy[4] == 6);
+
+	// Unwrapped
+	Deque<int> flat;
+	flat.PushBack(1);
+	flat.GetSpans(first, firstCount, second, secondCount);
+	Assert(firstCount == 1 && first[0] == 1 && secondCount == 0);
+}
+
+Fact("Deque Iterate")
+{
+	Deque<int> deque;
+	for (int i = 0; i < 50; i++)
+		deque.PushFront(49 - i);
+
+	int expected = 0;
+	for (auto iter = deque.Iterate(); iter.Next(); )
+		Assert(iter.Get() == expected++);
+	Assert(expected == 50);
+	for (auto iter = deque.IterateReverse(); iter.Next(); )
+		Assert(iter.Get() == --expected);
+
+	Assert(deque.IndexOf(20) == 20);
+	Assert(deque.Contains(49));
+	Assert(!deque.Contains(50));
+}
+
+Fact("Deque Constructs And Destructs Objects")
+{
+	{
+		Deque<Tracked> deque;
+		for (int i = 0; i < 100; i++)
+		{
+			deque.PushBack(Tracked(i));
+			deque.PushFront(Tracked(-i));
+		}
+		Assert(Tracked::s_instances == 200);
+		deque.RemoveFront(10);
+		deque.RemoveBack(10);
+		Assert(Tracked::s_instances == 180);
+		Assert(deque.GetFront().Value == -89);
+		Assert(deque.GetBack().Value == 89);
+	}
+	Assert(Tracked::s_instances == 0);
+}
+
+Fact("Deque Move")
+{
+	Deque<int> a;
+	for (int i = 0; i < 100; i++)
+		a.PushBack(i);
+
+	Deque<int> b(SimpleLib::move(a));
+	Assert(a.GetCount() == 0);
+	Assert(b.GetCount() == 100);
+
+	Deque<int> c;
+	c.PushBack(1);
+	c = SimpleLib::move(b);
+	Assert(c.GetCount() == 100);
+	Assert(c[99] == 99);
+	c.PushBack(100);
+	Assert(a.IsEmpty() && b.IsEmpty());
+}
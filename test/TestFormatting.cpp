@@ -0,0 +1,173 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+using namespace SimpleLib;
+
+namespace
+{
+	// The va_list formatter, for comparing against
+	String FormatV(const char* format, ...)
+	{
+		va_list args;
+		va_start(args, format);
+		String result = String::FormatV(format, args);
+		va_end(args);
+		return result;
+	}
+
+	enum Color
+	{
+		Red,
+		Green,
+		Blue,
+	};
+}
+
+Fact("Format Matches FormatV For Integers")
+{
+	const int values[] = { 0, 1, -1, 7, 42, -42, 99, 100, 12345, -12345, 2147483647, -2147483647 - 1 };
+	for (int v : values)
+	{
+		Assert(String::Format("%d", v).IsEqualTo(FormatV("%d", v)));
+		Assert(String::Format("%i|", v).IsEqualTo(FormatV("%i|", v)));
+		Assert(String::Format("%8d", v).IsEqualTo(FormatV("%8d", v)));
+		Assert(String::Format("%-8d|", v).IsEqualTo(FormatV("%-8d|", v)));
+		Assert(String::Format("%08d", v).IsEqualTo(FormatV("%08d", v)));
+		Assert(String::Format("%+d", v).IsEqualTo(FormatV("%+d", v)));
+		Assert(String::Format("% 6d", v).IsEqualTo(FormatV("% 6d", v)));
+		Assert(String::Format("%.5d", v).IsEqualTo(FormatV("%.5d", v)));
+		Assert(String::Format("%u", (unsigned)v).IsEqualTo(FormatV("%u", (unsigned)v)));
+		Assert(String::Format("%x", v).IsEqualTo(FormatV("%x", v)));
+		Assert(String::Format("%#X", v).IsEqualTo(FormatV("%#X", v)));
+		Assert(String::Format("%o", v).IsEqualTo(FormatV("%o", v)));
+		Assert(String::Format("%#010x", v).IsEqualTo(FormatV("%#010x", v)));
+	}
+
+	long long big = -1234567890123456789ll;
+	Assert(String::Format("%lld", big).IsEqualTo("-1234567890123456789"));
+	Assert(String::Format("%llu", 18446744073709551615ull).IsEqualTo("18446744073709551615"));
+	Assert(String::Format("%zu", (size_t)12345).IsEqualTo("12345"));
+	Assert(String::Format("%llx", big).IsEqualTo(FormatV("%llx", big)));
+}
+
+Fact("Format Promotes Small Integers Like Varargs")
+{
+	char ch = (char)0xC3;
+	Assert(String::Format("%d", ch).IsEqualTo(FormatV("%d", ch)));
+	Assert(String::Format("%X", ch).IsEqualTo(FormatV("%X", ch)));
+	Assert(String::Format("%d %d", true, false).IsEqualTo("1 0"));
+	Assert(String::Format("%d", (short)-5).IsEqualTo("-5"));
+	Assert(String::Format("%d", Blue).IsEqualTo("2"));
+	Assert(String::Format("%c%c", 'a' + 1, 'Z').IsEqualTo("bZ"));
+}
+
+Fact("Format Strings")
+{
+	String str("String");
+	StringView<char> view(str.sz() + 1, 3);
+	const char* nothing = nullptr;
+
+	Assert(String::Format("[%s] [%s] [%s]", "literal", str, view).IsEqualTo("[literal] [String] [tri]"));
+	Assert(String::Format("[%8s] [%-8s] [%.3s]", str, str, str).IsEqualTo("[  String] [String  ] [Str]"));
+	Assert(String::Format("%s %s", nothing, nullptr).IsEqualTo("(null) (null)"));
+
+	// Strings longer than the short buffer
+	StringBuilder<char> sb;
+	sb.Append('x', 300);
+	String longer(sb);
+	Assert(String::Format("<%s>", longer).GetLength() == 302);
+}
+
+Fact("Format Floats And Pointers")
+{
+	Assert(String::Format("%f", 1.5).IsEqualTo(FormatV("%f", 1.5)));
+	Assert(String::Format("%.3f|%10.2f|%-10.2f|", 3.14159, 2.5, -2.5).IsEqualTo(FormatV("%.3f|%10.2f|%-10.2f|", 3.14159, 2.5, -2.5)));
+	Assert(String::Format("%.17g", 0.1).IsEqualTo(FormatV("%.17g", 0.1)));
+	Assert(String::Format("%g %g", 1e100, 1.0f).IsEqualTo("1e+100 1"));
+	Assert(String::Format("%+.1f", 1.25).IsEqualTo("+1.2"));
+
+	int x = 0;
+	Assert(String::Format("%p", &x).IsEqualTo(FormatV("%p", &x)));
+	Assert(String::Format("%#P", &x).IsEqualTo(FormatV("%#P", &x)));
+	Assert(String::Format("%p", nullptr).IsEqualTo(FormatV("%p", (void*)nullptr)));
+}
+
+Fact("Format Escapes And Literals")
+{
+	Assert(String::Format("").IsEqualTo(""));
+	Assert(String::Format("no args").IsEqualTo("no args"));
+	Assert(String::Format("100%%").IsEqualTo("100%"));
+	Assert(String::Format("%%%d%%%%", 5).IsEqualTo("%5%%"));
+	Assert(String::Format("a%%b%dc%%d%de", 1, 2).IsEqualTo("a%b1c%d2e"));
+	Assert(String::Format("%d%d%d", 1, 2, 3).IsEqualTo("123"));
+}
+
+Fact("Format Width And Precision Arguments")
+{
+	Assert(String::Format("[%*d]", 5, 42).IsEqualTo("[   42]"));
+	Assert(String::Format("[%*d]", -5, 42).IsEqualTo("[42   ]"));
+	Assert(String::Format("[%.*s]", 2, "hello").IsEqualTo("[he]"));
+	Assert(String::Format("[%*.*f]", 8, 3, 3.14159).IsEqualTo("[   3.142]"));
+	Assert(String::Format("%0*d", 6, 42).IsEqualTo(FormatV("%0*d", 6, 42)));
+}
+
+Fact("Format Runtime Format Strings")
+{
+	const char* formats[] = { "%d-%s", "[%s]:%d" };
+	Assert(String::Format(RuntimeFormat<char>("%d"), 7).IsEqualTo("7"));
+
+	Assert(String::Format(RuntimeFormat<char>(formats[0]), 1, "x").IsEqualTo("1-x"));
+	Assert(String::Format(RuntimeFormat<char>(formats[1]), "y", 2).IsEqualTo("[y]:2"));
+
+	// A format string can be parsed once and reused
+	FormatString<char, int, int> pair("(%d, %d)");
+	StringBuilder<char> sb;
+	for (int i = 0; i < 3; i++)
+		sb.Format(pair, i, i * i);
+	Assert(strcmp(sb.sz(), "(0, 0)(1, 1)(2, 4)") == 0);
+	Assert(strcmp(pair.GetFormat(), "(%d, %d)") == 0);
+}
+
+// Parsing a literal is a constant expression, so a mismatch here would fail
+// to compile
+static_assert((FormatString<char, int, const char*>("%-5d|%s"), true), "Format string parses at compile time");
+static_assert(FormatString<wchar_t, double, int>(L"%8.3f %x").GetFormat()[0] == L'%', "Wide format string parses at compile time");
+
+Fact("Format Compiled Format Strings")
+{
+	Assert(String::Format(SIMPLELIB_FORMAT("%d-%s"), 1, "x").IsEqualTo("1-x"));
+	Assert(WString::Format(SIMPLELIB_FORMAT(L"%s=%05d"), L"n", 42).IsEqualTo(L"n=00042"));
+
+	// Parsed once, for each set of argument types it's used with
+	auto format = SIMPLELIB_FORMAT("[%s:%d]");
+	const void* first = &format.Get<char, const char*, int>();
+	const void* second = &format.Get<char, const char*, int>();
+	Assert(first == second);
+	StringBuilder<char> sb;
+	for (int i = 0; i < 3; i++)
+		sb.Format(format, String("a"), i);
+	sb.Format(format, "b", 'c');
+	Assert(strcmp(sb.sz(), "[a:0][a:1][a:2][b:99]") == 0);
+}
+
+Fact("Format Wide Strings")
+{
+	WString name(L"Wide");
+	WString result = WString::Format(L"%s=%d %5s|%-3c|%x", name, -12, L"ab", L'z', 255);
+	Assert(result.IsEqualTo(L"Wide=-12    ab|z  |ff"));
+}
+
+Fact("Format Appends To StringBuilder")
+{
+	StringBuilder<char> sb;
+	sb.Append("start ");
+	sb.Format("%d:%s", 1, "one");
+	sb.Format(" %d:%s", 2, String("two"));
+	Assert(strcmp(sb.sz(), "start 1:one 2:two") == 0);
+
+	// Also through any output with the two Append overloads
+	StringBuilder<char> sb2;
+	FormatStringWriter<char> writer(&sb2);
+	IFormatOutput<char>& output = writer;
+	Formatting::Format(output, FormatString<char, int, const char*>("%05d %s"), 42, "x");
+	Assert(strcmp(sb2.sz(), "00042 x") == 0);
+}
@@ -0,0 +1,87 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+using namespace SimpleLib;
+
+namespace
+{
+	const char* messages[] = {
+		"",
+		"a",
+		"abc",
+		"message digest",
+		"abcdefghijklmnopqrstuvwxyz",
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789",
+		"12345678901234567890123456789012345678901234567890123456789012345678901234567890",
+	};
+}
+
+Fact("Hash Matches wyhash Test Vectors")
+{
+	// From the reference implementation (seed = index)
+	const uint64_t expected[] = {
+		0x93228a4de0eec5a2ull,
+		0xc5bac3db178713c4ull,
+		0xa97f2f7b1d9b3314ull,
+		0x786d1f1df3801df4ull,
+		0xdca5a8138ad37c87ull,
+		0xb9e734f117cfaf70ull,
+		0x6cc5eab49a92d617ull,
+	};
+
+	for (int i = 0; i < 7; i++)
+		Assert(hash_buf64(messages[i], strlen(messages[i]), i) == expected[i]);
+}
+
+Fact("Hash Seed Changes Result")
+{
+	Assert(hash_buf("hello", 5) == hash_buf("hello", 5, 0));
+	Assert(hash_buf("hello", 5, 1) != hash_buf("hello", 5, 0));
+	Assert(hash_buf("hello", 5) == hash_fold32(hash_buf64("hello", 5)));
+	Assert(hash_str("hello") == hash_buf("hello", 5));
+}
+
+Fact("HashBuilder Matches One Shot Hash")
+{
+	char data[300];
+	for (int i = 0; i < 300; i++)
+		data[i] = (char)(i * 31 + 7);
+
+	// Every length either side of the 16 and 48 byte boundaries, in pieces
+	// of every size
+	for (size_t length = 0; length < 300; length += (length < 100 ? 1 : 17))
+	{
+		uint64_t expected = hash_buf64(data, length, 42);
+		for (size_t piece = 1; piece <= 100; piece += (piece < 50 ? 1 : 7))
+		{
+			HashBuilder builder(42);
+			for (size_t offset = 0; offset < length; offset += piece)
+				builder.Append(data + offset, offset + piece > length ? length - offset : piece);
+			Assert(builder.Finish64() == expected);
+			Assert(builder.Finish() == hash_fold32(expected));
+		}
+	}
+}
+
+Fact("Hash Consistent Across String Types")
+{
+	String str("Some key that is longer than sixteen bytes");
+	Assert(String::Hash(str) == hash_buf(str.sz(), str.GetLength()));
+	Assert(SCase::Hash(str.sz()) == String::Hash(str));
+	Assert(StringView<char>::Hash(str.View()) == String::Hash(str));
+
+	// Wide strings hash all their bytes
+	WString wide(L"Wide key");
+	Assert(WString::Hash(wide) == hash_buf(wide.sz(), wide.GetLength() * sizeof(wchar_t)));
+	Assert(SCase::Hash(wide.sz()) == WString::Hash(wide));
+	Assert(SCase::Hash(L"Wide kez") != SCase::Hash(L"Wide key"));
+}
+
+Fact("Hash Case Insensitive Is Hash Of Lower Case")
+{
+	const char* mixed = "The Quick Brown Fox Jumps Over The Lazy Dog, Several Times Over To Make It Long";
+	String lower = String(mixed).ToLower();
+	Assert(SCaseI::Hash(mixed) == SCase::Hash(lower.sz()));
+	Assert(SCaseI::Hash(mixed) == SCaseI::Hash(lower.sz()));
+	Assert(SCaseI::Hash("ABC") == SCaseI::Hash("abc"));
+	Assert(SCaseI::Hash("") == hash_buf("", 0));
+}
@@ -228,3 +228,225 @@ Fact("HighWaterHeapSet Concurrent Alloc Free Does Not Corrupt Data")
 
 	Assert(!corrupted);
 }
+
+Fact("HighWaterHeapSet Failed Alloc Requests Growth And Maintain Grows")
+{
+	// 4 x Alloc(16) fit per 128 byte bucket
+	HighWaterHeapSet pool(1, 128);
+	void* ptrs[5];
+	for (int i = 0; i < 4; i++)
+		ptrs[i] = pool.Alloc(16);
+	Assert(pool.Alloc(16) == nullptr);
+	Assert(pool.IsGrowthNeeded());
+
+	HighWaterHeapSetStats stats;
+	pool.GetStats(stats);
+	Assert(stats.buckets == 1);
+	Assert(stats.failedAllocs == 1);
+
+	pool.Maintain();
+	Assert(!pool.IsGrowthNeeded());
+	pool.GetStats(stats);
+	Assert(stats.buckets == 2);
+	Assert(stats.bucketsAdded == 1);
+
+	ptrs[4] = pool.Alloc(16);
+	Assert(ptrs[4] != nullptr);
+	for (int i = 0; i < 5; i++)
+		pool.Free(ptrs[i]);
+}
+
+Fact("HighWaterHeapSet OnGrowthNeeded Called Once Per Request")
+{
+	class NotifyingSet : public HighWaterHeapSet
+	{
+	public:
+		NotifyingSet() : HighWaterHeapSet(1, 128) {}
+		virtual void OnGrowthNeeded() override
+		{
+			notifications++;
+		}
+		int notifications = 0;
+	};
+
+	NotifyingSet pool;
+	void* ptrs[4];
+	for (int i = 0; i < 4; i++)
+		ptrs[i] = pool.Alloc(16);
+	Assert(pool.Alloc(16) == nullptr);
+	Assert(pool.Alloc(16) == nullptr);
+	Assert(pool.notifications == 1);
+
+	pool.Maintain();
+	for (int i = 0; i < 4; i++)
+		pool.Free(ptrs[i]);
+}
+
+Fact("HighWaterHeapSet Trigger Level Requests Growth When Reserve Low")
+{
+	HighWaterHeapSet pool(1, 256);
+	HighWaterHeapSetPolicy policy;
+	policy.growTriggerLevel = 0.5f;
+	pool.SetPolicy(policy);
+
+	// 32 bytes per Alloc(16), so the fifth passes the 128 byte trigger
+	void* ptrs[5];
+	for (int i = 0; i < 4; i++)
+		ptrs[i] = pool.Alloc(16);
+	Assert(!pool.IsGrowthNeeded());
+	ptrs[4] = pool.Alloc(16);
+	Assert(pool.IsGrowthNeeded());
+
+	for (int i = 0; i < 5; i++)
+		pool.Free(ptrs[i]);
+}
+
+Fact("HighWaterHeapSet Maintain Tops Up And Shrinks Reserve")
+{
+	HighWaterHeapSet pool(6, 128);
+	HighWaterHeapSetPolicy policy;
+	policy.maxReserveBuckets = 2;
+	pool.SetPolicy(policy);
+
+	pool.Maintain();
+	HighWaterHeapSetStats stats;
+	pool.GetStats(stats);
+	Assert(stats.buckets == 2);
+	Assert(stats.reserveBuckets == 2);
+	Assert(stats.bucketsFreed == 4);
+
+	policy.minReserveBuckets = 3;
+	policy.maxReserveBuckets = 4;
+	pool.SetPolicy(policy);
+	pool.Maintain();
+	pool.GetStats(stats);
+	Assert(stats.reserveBuckets == 3);
+	Assert(stats.capacity == 3 * 128);
+
+	// Never beyond maxBuckets
+	policy.minReserveBuckets = 10;
+	policy.maxBuckets = 5;
+	pool.SetPolicy(policy);
+	pool.Maintain();
+	pool.GetStats(stats);
+	Assert(stats.buckets == 5);
+}
+
+Fact("HighWaterHeapSet Maintain Shrinks While Other Threads Allocate")
+{
+	const int kThreads = 4;
+	const int kIterations = 50000;
+	const uint32_t kAllocSize = 16;
+
+	// Small buckets, so they're constantly filling, draining and going
+	// back to the reserve while Maintain() grows and shrinks it
+	HighWaterHeapSet pool(4, 64);
+	std::atomic<bool> corrupted{ false };
+	std::atomic<int> running{ kThreads };
+
+	std::thread threads[kThreads];
+	for (int t = 0; t < kThreads; t++)
+	{
+		threads[t] = std::thread([&, t]() {
+			unsigned char pattern = (unsigned char)(t * 41 + 7);
+			for (int i = 0; i < kIterations; i++)
+			{
+				void* p = pool.Alloc(kAllocSize);
+				if (!p)
+				{
+					std::this_thread::yield();
+					continue;
+				}
+
+				memset(p, pattern, kAllocSize);
+				unsigned char* bytes = (unsigned char*)p;
+				for (size_t b = 0; b < kAllocSize; b++)
+				{
+					if (bytes[b] != pattern)
+						corrupted = true;
+				}
+				pool.Free(p);
+			}
+			running--;
+		});
+	}
+
+	HighWaterHeapSetPolicy policy;
+	for (int cycle = 0; running > 0; cycle++)
+	{
+		policy.minReserveBuckets = (cycle & 1) ? 6 : 0;
+		policy.maxReserveBuckets = (cycle & 1) ? -1 : 0;
+		policy.growTriggerLevel = (cycle & 2) ? 0.5f : 0.75f;
+		pool.SetPolicy(policy);
+		pool.Maintain();
+	}
+
+	for (auto& th : threads)
+		th.join();
+	Assert(!corrupted);
+
+	HighWaterHeapSetStats stats;
+	pool.GetStats(stats);
+	Assert(stats.bucketsFreed > 0);
+	Assert(stats.bucketsAdded > 0);
+}
+
+Fact("HighWaterHeapSet Stats Track Fill Level And Recycling")
+{
+	HighWaterHeapSet pool(2, 128);
+	void* ptrs[4];
+	for (int i = 0; i < 4; i++)
+		ptrs[i] = pool.Alloc(16);
+
+	HighWaterHeapSetStats stats;
+	pool.GetStats(stats);
+	Assert(stats.capacity == 256);
+	Assert(stats.used == 128);
+	Assert(stats.recycles == 0);
+
+	// Overflow into the second bucket fills the first...
+	void* extra = pool.Alloc(16);
+	Assert(extra != nullptr);
+	Assert(HighWaterHeap::FromAllocation(extra) != HighWaterHeap::FromAllocation(ptrs[0]));
+
+	// ...and draining it counts as a recycle
+	for (int i = 0; i < 4; i++)
+		pool.Free(ptrs[i]);
+	pool.GetStats(stats);
+	Assert(stats.recycles == 1);
+	Assert(stats.maxRecycleMs >= 0);
+	Assert(stats.used == 32);
+
+	// Filling while the reserve wasn't low doesn't ask for growth
+	pool.Maintain();
+	pool.GetStats(stats);
+	Assert(stats.buckets == 2);
+
+	pool.Free(extra);
+}
+
+Fact("HighWaterHeapSet Steady Fill And Drain Cycles Don't Grow")
+{
+	HighWaterHeapSet pool(3, 128);
+
+	// Each cycle fills one bucket and overflows into the next, then
+	// drains both - with the default policy the set should stay the same
+	// size however many times that happens
+	for (int cycle = 0; cycle < 100; cycle++)
+	{
+		void* ptrs[5];
+		for (int i = 0; i < 5; i++)
+		{
+			ptrs[i] = pool.Alloc(16);
+			Assert(ptrs[i] != nullptr);
+		}
+		for (int i = 0; i < 5; i++)
+			pool.Free(ptrs[i]);
+		pool.Maintain();
+
+		HighWaterHeapSetStats stats;
+		pool.GetStats(stats);
+		Assert(stats.buckets == 3);
+		Assert(stats.bucketsAdded == 0);
+	}
+}
@@ -1,5 +1,6 @@
 #include "../UnitTesting.h"
 #include "../Core.h"
+#include "CountingAllocator.h"
 using namespace SimpleLib;
 
 // Tracks live instances so we can verify the list correctly constructs and
@@ -66,6 +67,69 @@ Fact("List Add And IndexOf")
 	Assert(!list.Contains(999));
 }
 
+Fact("List IndexOf Vectorized Types")
+{
+	// Every match position (including the unrolled, single vector and
+	// scalar tail parts of the scan) for a range of element sizes
+	const int count = 203;
+
+	List<int8_t> bytes;
+	List<int16_t> shorts;
+	List<int> ints;
+	List<int64_t> longs;
+	List<double> doubles;
+	List<InstanceCounter*> pointers;
+	InstanceCounter objects[count];
+	for (int i = 0; i < count; i++)
+	{
+		bytes.Add((int8_t)(i % 100));
+		shorts.Add((int16_t)(i * 300));
+		ints.Add(i * 100000);
+		longs.Add((int64_t)i << 40);
+		doubles.Add(i * 0.5);
+		pointers.Add(&objects[i]);
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		Assert(bytes.IndexOf((int8_t)(i % 100)) == i % 100);
+		Assert(shorts.IndexOf((int16_t)(i * 300)) == i);
+		Assert(ints.IndexOf(i * 100000) == i);
+		Assert(longs.IndexOf((int64_t)i << 40) == i);
+		Assert(doubles.IndexOf(i * 0.5) == i);
+		Assert(pointers.IndexOf(&objects[i]) == i);
+	}
+
+	// Start after
+	Assert(bytes.IndexOf(5, 5) == 105);
+	Assert(bytes.IndexOf(5, 105) == -1);
+	Assert(ints.IndexOf(0, count - 1) == -1);
+
+	// 64-bit values that match in only one 32-bit half
+	Assert(longs.IndexOf(((int64_t)1 << 40) + 1) == -1);
+	Assert(longs.IndexOf(0x100) == -1);
+	Assert(!ints.Contains(-1));
+}
+
+Fact("List IndexOf Floats Uses Equality Semantics")
+{
+	List<float> list;
+	for (int i = 0; i < 100; i++)
+		list.Add((float)i);
+	list.Add(-0.0f);
+
+	// 0.0 == -0.0, so the first zero is found either way
+	Assert(list.IndexOf(0.0f) == 0);
+	Assert(list.IndexOf(-0.0f) == 0);
+	Assert(list.IndexOf(99.0f) == 99);
+	Assert(list.IndexOf(0.5f) == -1);
+
+	// NaN never compares equal
+	float nan = 0.0f / 0.0f;
+	list.Add(nan);
+	Assert(list.IndexOf(nan) == -1);
+}
+
 Fact("List Iterate")
 {
 	List<int> list;
@@ -735,6 +799,236 @@ Fact("List Sort With Context")
 	Assert(list[2] == 1);
 }
 
+// Small deterministic PRNG (xorshift32) for the larger sort tests
+static uint32_t NextRandom(uint32_t& state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+static bool IsSortedAscending(const List<int>& list)
+{
+	for (int i = 1; i < list.GetCount(); i++)
+	{
+		if (list[i - 1] > list[i])
+			return false;
+	}
+	return true;
+}
+
+Fact("List Sort Lambda")
+{
+	List<int> list;
+	list.Add(1);
+	list.Add(3);
+	list.Add(2);
+
+	int iSign = -1;
+	list.Sort([&](int a, int b) { return (a > b ? 1 : a < b ? -1 : 0) * iSign; });
+	Assert(list[0] == 3);
+	Assert(list[1] == 2);
+	Assert(list[2] == 1);
+}
+
+Fact("List Sort Large Inputs With Patterns")
+{
+	const int count = 10000;
+	uint32_t seed = 12345;
+
+	// Random, sorted, reversed, all equal, few distinct values and
+	// sawtooth - the shapes that defeat naive quicksort pivot selection
+	for (int pattern = 0; pattern < 6; pattern++)
+	{
+		List<int> list;
+		long long sum = 0;
+		for (int i = 0; i < count; i++)
+		{
+			int val;
+			switch (pattern)
+			{
+				case 0: val = (int)(NextRandom(seed) % 100000); break;
+				case 1: val = i; break;
+				case 2: val = count - i; break;
+				case 3: val = 7; break;
+				case 4: val = (int)(NextRandom(seed) % 4); break;
+				default: val = i % 100; break;
+			}
+			list.Add(val);
+			sum += val;
+		}
+
+		list.Sort();
+		Assert(IsSortedAscending(list));
+
+		// Still a permutation of the input
+		long long sortedSum = 0;
+		for (int i = 0; i < list.GetCount(); i++)
+			sortedSum += list[i];
+		Assert(sortedSum == sum);
+		Assert(list.GetCount() == count);
+	}
+}
+
+Fact("List Sort Of Owned Pointers")
+{
+	InstanceCounter::s_iInstances = 0;
+	{
+		List<OwnedPtr<InstanceCounter>> list;
+		uint32_t seed = 999;
+		for (int i = 0; i < 500; i++)
+			list.Add(new InstanceCounter((int)(NextRandom(seed) % 1000)));
+
+		// Elements are relocated bitwise, so nothing is copied or deleted
+		list.Sort([](InstanceCounter* a, InstanceCounter* b) { return a->Value - b->Value; });
+		Assert(InstanceCounter::s_iInstances == 500);
+
+		for (int i = 1; i < list.GetCount(); i++)
+			Assert(list[i - 1]->Value <= list[i]->Value);
+	}
+	Assert(InstanceCounter::s_iInstances == 0);
+}
+
+Fact("List StableSort Preserves Order Of Equal Elements")
+{
+	struct Item
+	{
+		int key;
+		int order;
+	};
+
+	List<Item> list;
+	uint32_t seed = 42;
+	for (int i = 0; i < 1000; i++)
+		list.Add(Item{ (int)(NextRandom(seed) % 10), i });
+
+	Assert(list.StableSort([](const Item& a, const Item& b) { return a.key - b.key; }));
+
+	for (int i = 1; i < list.GetCount(); i++)
+	{
+		Assert(list[i - 1].key <= list[i].key);
+		if (list[i - 1].key == list[i].key)
+			Assert(list[i - 1].order < list[i].order);
+	}
+}
+
+Fact("List StableSort Default Compare")
+{
+	List<int> list;
+	uint32_t seed = 7;
+	for (int i = 0; i < 100; i++)
+		list.Add((int)(NextRandom(seed) % 50));
+
+	Assert(list.StableSort());
+	Assert(IsSortedAscending(list));
+
+	List<String> strings;
+	strings.Add(String("cherry"));
+	strings.Add(String("apple"));
+	strings.Add(String("banana"));
+	Assert(strings.StableSort());
+	Assert(strings[0].IsEqualTo("apple"));
+	Assert(strings[1].IsEqualTo("banana"));
+	Assert(strings[2].IsEqualTo("cherry"));
+}
+
+Fact("List RadixSort Signed Ints")
+{
+	uint32_t seed = 4321;
+
+	// Small (insertion sorted), large random, large all-equal and large
+	// with only the low byte varying (most passes skipped)
+	for (int pattern = 0; pattern < 4; pattern++)
+	{
+		List<int> list;
+		int count = pattern == 0 ? 50 : 20000;
+		long long sum = 0;
+		for (int i = 0; i < count; i++)
+		{
+			int val;
+			switch (pattern)
+			{
+				case 2: val = -5; break;
+				case 3: val = (int)(NextRandom(seed) % 256); break;
+				default: val = (int)NextRandom(seed); break;
+			}
+			list.Add(val);
+			sum += val;
+		}
+
+		Assert(list.RadixSort());
+		Assert(IsSortedAscending(list));
+
+		long long sortedSum = 0;
+		for (int i = 0; i < list.GetCount(); i++)
+			sortedSum += list[i];
+		Assert(sortedSum == sum);
+	}
+}
+
+Fact("List RadixSort Floats And Doubles")
+{
+	List<float> floats;
+	List<double> doubles;
+	uint32_t seed = 77;
+	for (int i = 0; i < 5000; i++)
+	{
+		float val = ((int)(NextRandom(seed) % 20001) - 10000) / 7.0f;
+		floats.Add(val);
+		doubles.Add(val * 1e100);
+	}
+	floats.Add(-0.0f);
+	floats.Add(0.0f);
+
+	Assert(floats.RadixSort());
+	Assert(doubles.RadixSort());
+	for (int i = 1; i < floats.GetCount(); i++)
+		Assert(floats[i - 1] <= floats[i]);
+	for (int i = 1; i < doubles.GetCount(); i++)
+		Assert(doubles[i - 1] <= doubles[i]);
+}
+
+Fact("List RadixSort By Key Is Stable")
+{
+	struct Item
+	{
+		int64_t key;
+		int order;
+	};
+
+	List<Item> list;
+	uint32_t seed = 31;
+	for (int i = 0; i < 10000; i++)
+		list.Add({ (int64_t)(NextRandom(seed) % 100) - 50, i });
+
+	Assert(list.RadixSort([](const Item& item) { return item.key; }));
+	for (int i = 1; i < list.GetCount(); i++)
+	{
+		Assert(list[i - 1].key <= list[i].key);
+		if (list[i - 1].key == list[i].key)
+			Assert(list[i - 1].order < list[i].order);
+	}
+}
+
+Fact("List RadixSort Of Owned Pointers")
+{
+	InstanceCounter::s_iInstances = 0;
+	{
+		List<OwnedPtr<InstanceCounter>> list;
+		uint32_t seed = 5;
+		for (int i = 0; i < 500; i++)
+			list.Add(new InstanceCounter((int)(NextRandom(seed) % 1000) - 500));
+
+		Assert(list.RadixSort([](InstanceCounter* p) { return p->Value; }));
+		Assert(InstanceCounter::s_iInstances == 500);
+
+		for (int i = 1; i < list.GetCount(); i++)
+			Assert(list[i - 1]->Value <= list[i]->Value);
+	}
+	Assert(InstanceCounter::s_iInstances == 0);
+}
+
 Fact("List BinarySearch")
 {
 	List<int> list;
@@ -847,6 +1141,33 @@ Fact("List BinarySearch Lambda With Different Key Type")
 	Assert(!list.BinarySearch(index, "fig", compare) && index == 4);
 }
 
+Fact("List BinarySearch Default Compare")
+{
+	List<int> list;
+	for (int i = 0; i < 1000; i++)
+		list.Add(i * 2);
+
+	int index;
+	for (int i = 0; i < 1000; i++)
+	{
+		Assert(list.BinarySearch(index, i * 2) && index == i);
+		Assert(!list.BinarySearch(index, i * 2 + 1) && index == i + 1);
+	}
+	Assert(!list.BinarySearch(index, -1) && index == 0);
+
+	// Finds the first of several equal elements
+	List<int> dups;
+	dups.Add(1);
+	dups.Add(5);
+	dups.Add(5);
+	dups.Add(5);
+	dups.Add(9);
+	Assert(dups.BinarySearch(index, 5) && index == 1);
+
+	List<int> empty;
+	Assert(!empty.BinarySearch(index, 5) && index == 0);
+}
+
 Fact("List Stack Operations")
 {
 	List<int> list;
@@ -1244,3 +1565,45 @@ Fact("List IterateReverse Empty List")
 	auto it = list.IterateReverse();
 	Assert(!it.Next());
 }
+
+Fact("List With Stateful Allocator")
+{
+	// Stateless allocators add nothing to the list
+	Assert(sizeof(List<int, CountingAllocator>) == sizeof(List<int>) + sizeof(CountingAllocator));
+
+	AllocStats stats = {};
+	{
+		List<int, CountingAllocator> list{ CountingAllocator(&stats) };
+		for (int i = 0; i < 1000; i++)
+			list.Add(999 - i);
+		Assert(stats.live == 1);
+		Assert(list.GetAllocator().m_stats == &stats);
+
+		// Scratch memory comes from the list's allocator too
+		Assert(list.StableSort());
+		Assert(stats.allocs == 2);
+		Assert(stats.live == 1);
+		for (int i = 0; i < 1000; i++)
+			Assert(list[i] == i);
+
+		// Filtered list shares the allocator
+		auto evens = list.Filter([](int x) { return x % 2 == 0; });
+		Assert(evens.GetAllocator().m_stats == &stats);
+		Assert(stats.live == 2);
+
+		// Moving hands over the allocator with the memory
+		List<int, CountingAllocator> moved(SimpleLib::move(list));
+		Assert(moved.GetAllocator().m_stats == &stats);
+		Assert(moved.GetCount() == 1000);
+
+		AllocStats other = {};
+		List<int, CountingAllocator> assigned{ CountingAllocator(&other) };
+		assigned.Add(1);
+		assigned = SimpleLib::move(moved);
+		Assert(other.live == 0);
+		Assert(assigned.GetAllocator().m_stats == &stats);
+		Assert(stats.live == 2);
+	}
+	Assert(stats.live == 0);
+	Assert(stats.allocs == stats.frees);
+}
@@ -1,5 +1,6 @@
 #include "../UnitTesting.h"
 #include "../Core.h"
+#include "CountingAllocator.h"
 using namespace SimpleLib;
 
 // Tracks live instances so we can verify the map correctly constructs and
@@ -449,3 +450,25 @@ Fact("Map IterateReverse Empty Map")
 	auto it = map.IterateReverse();
 	Assert(!it.Next());
 }
+
+Fact("Map With Stateful Allocator")
+{
+	Assert(sizeof(Map<int, int, SDefaultCompare, CountingAllocator>) == sizeof(Map<int, int>) + sizeof(CountingAllocator));
+
+	AllocStats stats = {};
+	{
+		Map<int, int, SDefaultCompare, CountingAllocator> map{ CountingAllocator(&stats) };
+		for (int i = 0; i < 100; i++)
+			map.Add(i, i * 10);
+		Assert(stats.live == 1);
+		Assert(map.GetAllocator().m_stats == &stats);
+		Assert(map.Get(42) == 420);
+
+		Map<int, int, SDefaultCompare, CountingAllocator> moved(SimpleLib::move(map));
+		Assert(moved.GetAllocator().m_stats == &stats);
+		Assert(moved.Get(99) == 990);
+		Assert(stats.live == 1);
+	}
+	Assert(stats.live == 0);
+	Assert(stats.allocs == stats.frees);
+}
@@ -345,3 +345,35 @@ Fact("MemoryStream WriteTo And ReadFrom")
 	Assert(restored.IsEqual(src));
 }
 
+
+Fact("MemoryStream Write StringBuilder")
+{
+	StringBuilder<char> sb;
+	sb.SetChunkSize(100);
+	for (int i = 0; i < 100; i++)
+		sb.Format("line %d\n", i);
+	Assert(!sb.IsContiguous());
+
+	// Written chunk by chunk, leaving the builder chunked
+	MemoryStream ms;
+	Assert(ms.Create() == 0);
+	Stream& stream = ms;
+	Assert(stream.Write(sb) == 0);
+	Assert(!sb.IsContiguous());
+	Assert(ms.GetLength() == sb.GetLength());
+	Assert(memcmp(ms.GetBuffer(), sb.ToString().sz(), sb.GetLength()) == 0);
+
+	// Contiguous builders too
+	StringBuilder<char> small;
+	small.Append("Hello");
+	Assert(stream.Write(small) == 0);
+	Assert(ms.GetLength() == sb.GetLength() + 5);
+
+	// A single chunk filled exactly to capacity
+	StringBuilder<char> full;
+	full.SetChunkSize(64);
+	full.Append('x', 64);
+	Assert(stream.Write(full) == 0);
+	Assert(ms.GetLength() == sb.GetLength() + 5 + 64);
+	Assert(memcmp((const char*)ms.GetBuffer() + ms.GetLength() - 64, full.sz(), 64) == 0);
+}
@@ -0,0 +1,199 @@
+#include <thread>
+#include <atomic>
+#include "../UnitTesting.h"
+#include "../Threading.h"
+using namespace SimpleLib;
+
+namespace
+{
+	struct PoolMessage
+	{
+		PoolMessage(int value) : value(value), check(~value)
+		{
+			liveCount++;
+		}
+		~PoolMessage()
+		{
+			liveCount--;
+		}
+		int value;
+		int check;
+		char payload[40];
+
+		// Constructed and destructed on different threads
+		static std::atomic<int> liveCount;
+	};
+	std::atomic<int> PoolMessage::liveCount{ 0 };
+}
+
+Fact("ObjectPool Alloc Free Reuses Slots")
+{
+	ObjectPool<PoolMessage> pool(16);
+	void* a = pool.Alloc();
+	Assert(a != nullptr);
+	pool.Free(a);
+	Assert(pool.Alloc() == a);
+	Assert(pool.GetCapacity() == 16);
+}
+
+Fact("ObjectPool Slots Are Distinct And Aligned")
+{
+	ObjectPool<PoolMessage> pool(16);
+	PoolMessage* items[1000];
+	for (int i = 0; i < 1000; i++)
+	{
+		items[i] = pool.New(i);
+		Assert(((uintptr_t)items[i] & (alignof(PoolMessage) - 1)) == 0);
+	}
+	Assert(PoolMessage::liveCount == 1000);
+	for (int i = 0; i < 1000; i++)
+	{
+		Assert(items[i]->value == i);
+		Assert(items[i]->check == ~i);
+	}
+	for (int i = 0; i < 1000; i++)
+		pool.Delete(items[i]);
+	Assert(PoolMessage::liveCount == 0);
+
+	// Freed slots get reused rather than growing the pool
+	int capacity = pool.GetCapacity();
+	for (int i = 0; i < 1000; i++)
+		items[i] = pool.New(i);
+	Assert(pool.GetCapacity() == capacity);
+	for (int i = 0; i < 1000; i++)
+		pool.Delete(items[i]);
+}
+
+Fact("ObjectPool Prewarm And TryAlloc")
+{
+	ObjectPool<PoolMessage> pool(64);
+	Assert(pool.TryAlloc() == nullptr);
+
+	Assert(pool.Prewarm(200));
+	int capacity = pool.GetCapacity();
+	Assert(capacity >= 200);
+
+	void* items[200];
+	for (int i = 0; i < 200; i++)
+	{
+		items[i] = pool.TryAlloc();
+		Assert(items[i] != nullptr);
+	}
+	for (int i = 0; i < 200; i++)
+		pool.Free(items[i]);
+	Assert(pool.GetCapacity() == capacity);
+}
+
+Fact("ObjectPool Cross Thread Free")
+{
+	// Producer allocates, consumer frees - the slots must find their way
+	// back to the producer without the pool growing without bound
+	ObjectPool<PoolMessage> pool(64);
+	const int kCount = 200000;
+	const int kInFlight = 256;
+
+	PoolMessage* volatile ring[kInFlight] = {};
+	std::atomic<int> produced{ 0 };
+	std::atomic<int> consumed{ 0 };
+	std::atomic<bool> corrupted{ false };
+
+	std::thread consumer([&]() {
+		for (int i = 0; i < kCount; i++)
+		{
+			while (consumed.load() >= produced.load())
+				std::this_thread::yield();
+			PoolMessage* msg = ring[i % kInFlight];
+			if (msg->value != i || msg->check != ~i)
+				corrupted = true;
+			pool.Delete(msg);
+			consumed.store(i + 1);
+		}
+		pool.FlushThreadCache();
+	});
+
+	for (int i = 0; i < kCount; i++)
+	{
+		while (produced.load() - consumed.load() >= kInFlight)
+			std::this_thread::yield();
+		ring[i % kInFlight] = pool.New(i);
+		produced.store(i + 1);
+	}
+
+	consumer.join();
+	Assert(!corrupted);
+	Assert(PoolMessage::liveCount == 0);
+	Assert(pool.GetCapacity() <= kInFlight * 4);
+}
+
+Fact("ObjectPool Concurrent Alloc Free")
+{
+	ObjectPool<PoolMessage> pool(32);
+	const int kThreads = 4;
+	const int kIterations = 20000;
+	std::atomic<bool> corrupted{ false };
+
+	std::thread threads[kThreads];
+	for (int t = 0; t < kThreads; t++)
+	{
+		threads[t] = std::thread([&, t]() {
+			PoolMessage* held[50];
+			for (int i = 0; i < kIterations; i++)
+			{
+				int n = i % 50;
+				int value = t * kIterations + i;
+				held[n] = pool.New(value);
+				if (n == 49)
+				{
+					for (int j = 0; j < 50; j++)
+					{
+						int expected = t * kIterations + i - 49 + j;
+						if (held[j]->value != expected || held[j]->check != ~expected)
+							corrupted = true;
+						pool.Delete(held[j]);
+					}
+				}
+			}
+			pool.FlushThreadCache();
+		});
+	}
+	for (int t = 0; t < kThreads; t++)
+		threads[t].join();
+
+	Assert(!corrupted);
+	Assert(PoolMessage::liveCount == 0);
+}
+
+Fact("ObjectPool Destroyed While Other Threads Still Hold Caches")
+{
+	// The worker uses the pool (so it has a cache) and then stays alive,
+	// without flushing, while the pool is destroyed - then goes on to use
+	// a new pool, which mustn't see the old pool's cache
+	std::atomic<int> stage{ 0 };
+	ObjectPool<PoolMessage>* pool = new ObjectPool<PoolMessage>(16);
+	std::atomic<bool> failed{ false };
+
+	std::thread worker([&]() {
+		PoolMessage* msg = pool->New(1);
+		pool->Delete(msg);
+		stage = 1;
+		while (stage.load() != 2)
+			std::this_thread::yield();
+
+		ObjectPool<PoolMessage> other(16);
+		msg = other.New(2);
+		if (msg->value != 2 || msg->check != ~2)
+			failed = true;
+		other.Delete(msg);
+	});
+
+	while (stage.load() != 1)
+		std::this_thread::yield();
+	PoolMessage* msg = pool->New(3);
+	pool->Delete(msg);
+	delete pool;
+	stage = 2;
+
+	worker.join();
+	Assert(!failed);
+	Assert(PoolMessage::liveCount == 0);
+}
@@ -0,0 +1,119 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+#include "../Threading.h"
+using namespace SimpleLib;
+
+namespace
+{
+	typedef TPageAlloc<HugePageMode::None, 65536> TSmallThresholdAlloc;
+
+	void Fill(void* p, size_t size, uint8_t seed)
+	{
+		uint8_t* bytes = (uint8_t*)p;
+		for (size_t i = 0; i < size; i++)
+			bytes[i] = (uint8_t)(i * 31 + seed);
+	}
+
+	bool Check(void* p, size_t size, uint8_t seed)
+	{
+		uint8_t* bytes = (uint8_t*)p;
+		for (size_t i = 0; i < size; i++)
+		{
+			if (bytes[i] != (uint8_t)(i * 31 + seed))
+				return false;
+		}
+		return true;
+	}
+}
+
+Fact("PageAllocator Small Blocks Use Heap")
+{
+	void* p = TSmallThresholdAlloc::Alloc(100);
+	Assert(p != nullptr);
+	Assert(((uintptr_t)p & 15) == 0);
+	Assert(!TSmallThresholdAlloc::IsMapped(p));
+	Assert(TSmallThresholdAlloc::GetMappedSize(p) == 0);
+	Fill(p, 100, 1);
+
+	p = TSmallThresholdAlloc::ReAlloc(p, 1000);
+	Assert(!TSmallThresholdAlloc::IsMapped(p));
+	Assert(Check(p, 100, 1));
+	TSmallThresholdAlloc::Free(p);
+	TSmallThresholdAlloc::Free(nullptr);
+}
+
+Fact("PageAllocator Large Blocks Are Mapped")
+{
+	void* p = TSmallThresholdAlloc::Alloc(100000);
+	Assert(p != nullptr);
+	Assert(((uintptr_t)p & 15) == 0);
+	Assert(TSmallThresholdAlloc::IsMapped(p));
+	Assert(TSmallThresholdAlloc::GetMappedSize(p) >= 100000);
+	Assert(TSmallThresholdAlloc::GetMappedSize(p) % Platform::vmPageSize() == 0);
+	Assert(!TSmallThresholdAlloc::IsHugePages(p));
+	Fill(p, 100000, 2);
+	Assert(Check(p, 100000, 2));
+	TSmallThresholdAlloc::Free(p);
+}
+
+Fact("PageAllocator ReAlloc Preserves Contents")
+{
+	// Small to mapped
+	void* p = TSmallThresholdAlloc::Alloc(1000);
+	Fill(p, 1000, 3);
+	p = TSmallThresholdAlloc::ReAlloc(p, 200000);
+	Assert(TSmallThresholdAlloc::IsMapped(p));
+	Assert(Check(p, 1000, 3));
+
+	// Mapped growth, through several remaps
+	Fill(p, 200000, 4);
+	size_t size = 200000;
+	while (size < 64 * 1024 * 1024)
+	{
+		size_t newSize = size * 2;
+		p = TSmallThresholdAlloc::ReAlloc(p, newSize);
+		Assert(p != nullptr);
+		Assert(Check(p, 200000, 4));
+		size = newSize;
+	}
+	Assert(TSmallThresholdAlloc::GetMappedSize(p) >= size);
+
+	// Shrinking stays mapped
+	p = TSmallThresholdAlloc::ReAlloc(p, 1000);
+	Assert(TSmallThresholdAlloc::IsMapped(p));
+	Assert(Check(p, 1000, 4));
+	TSmallThresholdAlloc::Free(p);
+}
+
+Fact("PageAllocator Huge Page Modes")
+{
+	typedef TPageAlloc<HugePageMode::Transparent> TTransparent;
+	void* p = TTransparent::Alloc(1024 * 1024);
+	Assert(TTransparent::IsMapped(p));
+	Assert(TTransparent::GetMappedSize(p) % Platform::vmHugePageSize() == 0);
+	Fill(p, 1024 * 1024, 5);
+	p = TTransparent::ReAlloc(p, 5 * 1024 * 1024);
+	Assert(Check(p, 1024 * 1024, 5));
+	TTransparent::Free(p);
+
+	// Explicit huge pages fall back to normal mappings if none are reserved
+	typedef TPageAlloc<HugePageMode::Explicit> TExplicit;
+	p = TExplicit::Alloc(3 * 1024 * 1024);
+	Assert(p != nullptr);
+	Assert(TExplicit::IsMapped(p));
+	Assert(TExplicit::GetMappedSize(p) % Platform::vmHugePageSize() == 0);
+	Fill(p, 3 * 1024 * 1024, 6);
+	p = TExplicit::ReAlloc(p, 7 * 1024 * 1024);
+	Assert(Check(p, 3 * 1024 * 1024, 6));
+	TExplicit::Free(p);
+}
+
+Fact("PageAllocator List")
+{
+	List<int, TPageAlloc<>> list;
+	for (int i = 0; i < 1000000; i++)
+		list.Add(i);
+	Assert(TPageAlloc<>::IsMapped(list.GetBuffer()));
+	for (int i = 0; i < 1000000; i++)
+		Assert(list[i] == i);
+}
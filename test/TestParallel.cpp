@@ -0,0 +1,249 @@
+#include <atomic>
+#include "../UnitTesting.h"
+#include "../Core.h"
+#include "../Threading.h"
+using namespace SimpleLib;
+
+static uint32_t NextRandom(uint32_t& state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+Fact("WorkerSet Runs Every Index Once")
+{
+	WorkerSet workers(3);
+	Assert(workers.GetConcurrency() == 4);
+
+	const int count = 1000;
+	std::atomic<int> hits[count];
+	for (int i = 0; i < count; i++)
+		hits[i] = 0;
+
+	// Several jobs back to back on the same workers
+	for (int job = 0; job < 5; job++)
+	{
+		workers.Run(count, [&](int index) {
+			hits[index]++;
+		});
+	}
+
+	for (int i = 0; i < count; i++)
+		Assert(hits[i] == 5);
+}
+
+Fact("WorkerSet Nested Run Executes Inline")
+{
+	WorkerSet workers(2);
+	std::atomic<int> total{ 0 };
+
+	workers.Run(4, [&](int) {
+		workers.Run(10, [&](int) {
+			total++;
+		});
+	});
+
+	Assert(total == 40);
+}
+
+Fact("WorkerSet With No Workers Runs On Caller")
+{
+	WorkerSet workers(0);
+	size_t caller = Thread::GetCurrentId();
+	bool allOnCaller = true;
+
+	workers.Run(10, [&](int) {
+		if (Thread::GetCurrentId() != caller)
+			allOnCaller = false;
+	});
+
+	Assert(allOnCaller);
+}
+
+Fact("Parallel RadixSort")
+{
+	WorkerSet workers(3);
+	uint32_t seed = 2024;
+
+	// Enough data for several chunks
+	List<int> list;
+	for (int i = 0; i < Parallel::kMinRadixChunkSize * 4; i++)
+		list.Add((int)NextRandom(seed));
+
+	List<int> expected;
+	expected.AddRange(list);
+	Assert(expected.RadixSort());
+
+	Assert(Parallel::RadixSort(list, workers));
+	for (int i = 0; i < list.GetCount(); i++)
+		Assert(list[i] == expected[i]);
+}
+
+Fact("Parallel RadixSort By Key Is Stable")
+{
+	struct Item
+	{
+		uint32_t key;
+		int order;
+	};
+
+	WorkerSet workers(3);
+	uint32_t seed = 99;
+
+	List<Item> list;
+	for (int i = 0; i < Parallel::kMinRadixChunkSize * 3 + 17; i++)
+		list.Add({ NextRandom(seed) % 5000, i });
+
+	Assert(Parallel::RadixSort(list, [](const Item& item) { return item.key; }, workers));
+	for (int i = 1; i < list.GetCount(); i++)
+	{
+		Assert(list[i - 1].key <= list[i].key);
+		if (list[i - 1].key == list[i].key)
+			Assert(list[i - 1].order < list[i].order);
+	}
+}
+
+Fact("Parallel For Visits Every Index Once")
+{
+	WorkerSet workers(3);
+
+	// Cheap items (mostly finished by the probe) and expensive ones (split
+	// into many chunks)
+	for (int expensive = 0; expensive < 2; expensive++)
+	{
+		const int count = 20000;
+		List<int> hits;
+		hits.SetCount(count, 0);
+		int* buffer = hits.GetBuffer();
+
+		Parallel::For(count, [&](int index) {
+			if (expensive)
+			{
+				volatile int spin = 0;
+				for (int i = 0; i < 2000; i++)
+					spin += i;
+			}
+			buffer[index]++;
+		}, workers);
+
+		for (int i = 0; i < count; i++)
+			Assert(hits[i] == 1);
+	}
+}
+
+Fact("Parallel Map")
+{
+	WorkerSet workers(3);
+
+	List<int> list;
+	for (int i = 0; i < 100000; i++)
+		list.Add(i);
+
+	List<double> halves = Parallel::Map(list, [](int v) { return v / 2.0; }, workers);
+	Assert(halves.GetCount() == list.GetCount());
+	for (int i = 0; i < halves.GetCount(); i++)
+		Assert(halves[i] == i / 2.0);
+
+	List<String> strings = Parallel::Map(list, [](int v) { return String::Format("%i", v); }, workers);
+	Assert(strings.GetCount() == list.GetCount());
+	Assert(strings[0].IsEqualTo("0"));
+	Assert(strings[99999].IsEqualTo("99999"));
+
+	List<int> empty;
+	Assert(Parallel::Map(empty, [](int v) { return v; }, workers).GetCount() == 0);
+}
+
+Fact("Parallel Filter Preserves Order")
+{
+	WorkerSet workers(3);
+
+	List<int> list;
+	uint32_t seed = 11;
+	for (int i = 0; i < 200000; i++)
+		list.Add((int)(NextRandom(seed) % 1000));
+
+	List<int> expected = list.Filter([](int v) { return v % 3 == 0; });
+	List<int> actual = Parallel::Filter(list, [](int v) { return v % 3 == 0; }, workers);
+
+	Assert(actual.GetCount() == expected.GetCount());
+	for (int i = 0; i < actual.GetCount(); i++)
+		Assert(actual[i] == expected[i]);
+
+	Assert(Parallel::Filter(list, [](int) { return false; }, workers).GetCount() == 0);
+	Assert(Parallel::Filter(list, [](int) { return true; }, workers).GetCount() == list.GetCount());
+}
+
+Fact("Parallel Reduce")
+{
+	WorkerSet workers(3);
+
+	List<int> list;
+	for (int i = 1; i <= 100000; i++)
+		list.Add(i);
+
+	long long sum = Parallel::Reduce(list, 0LL,
+		[](long long acc, int v) { return acc + v; },
+		[](long long a, long long b) { return a + b; },
+		workers);
+	Assert(sum == 100000LL * 100001 / 2);
+
+	int max = Parallel::Reduce(list, 0, [](int a, int b) { return a > b ? a : b; }, workers);
+	Assert(max == 100000);
+
+	// Non-commutative combine - chunk results must be combined in order
+	List<String> letters;
+	for (int i = 0; i < 5000; i++)
+		letters.Add(String::Format("%c", 'a' + i % 26));
+	String joined = Parallel::Reduce(letters, String(),
+		[](String acc, const String& s) { return acc + s; },
+		[](String a, String b) { return a + b; },
+		workers);
+	Assert(joined.GetLength() == 5000);
+	for (int i = 0; i < 5000; i++)
+		Assert(joined[i] == 'a' + i % 26);
+}
+
+Fact("Parallel Sort")
+{
+	WorkerSet workers(3);
+	uint32_t seed = 55;
+
+	// Odd sizes so the runs don't divide evenly
+	List<int> list;
+	for (int i = 0; i < Parallel::kMinSortChunkSize * 5 + 123; i++)
+		list.Add((int)(NextRandom(seed) % 100000) - 50000);
+
+	Assert(Parallel::Sort(list, workers));
+	for (int i = 1; i < list.GetCount(); i++)
+		Assert(list[i - 1] <= list[i]);
+
+	Assert(Parallel::Sort(list, [](int a, int b) { return b - a; }, workers));
+	for (int i = 1; i < list.GetCount(); i++)
+		Assert(list[i - 1] >= list[i]);
+}
+
+Fact("Parallel StableSort Preserves Order Of Equal Elements")
+{
+	struct Item
+	{
+		int key;
+		int order;
+	};
+
+	WorkerSet workers(3);
+	uint32_t seed = 8;
+
+	List<Item> list;
+	for (int i = 0; i < Parallel::kMinSortChunkSize * 3 + 7; i++)
+		list.Add({ (int)(NextRandom(seed) % 100), i });
+
+	Assert(Parallel::StableSort(list, [](const Item& a, const Item& b) { return a.key - b.key; }, workers));
+	for (int i = 1; i < list.GetCount(); i++)
+	{
+		Assert(list[i - 1].key <= list[i].key);
+		if (list[i - 1].key == list[i].key)
+			Assert(list[i - 1].order < list[i].order);
+	}
+}
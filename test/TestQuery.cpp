@@ -0,0 +1,175 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+using namespace SimpleLib;
+
+static List<int> Range(int from, int count)
+{
+	List<int> list;
+	for (int i = 0; i < count; i++)
+		list.Add(from + i);
+	return list;
+}
+
+Fact("Query Where Select ToList")
+{
+	List<int> list = Range(1, 10);
+
+	List<int> result = list.AsQuery()
+		.Where([](int x) { return x % 2 == 0; })
+		.Select([](int x) { return x * 10; })
+		.ToList();
+
+	Assert(result.GetCount() == 5);
+	Assert(result[0] == 20);
+	Assert(result[1] == 40);
+	Assert(result[4] == 100);
+
+	// Source list unaffected
+	Assert(list.GetCount() == 10);
+}
+
+Fact("Query Select To Different Type")
+{
+	List<int> list = Range(1, 3);
+
+	List<String> result = list.AsQuery()
+		.Select([](int x) { return String::Format("#%i", x); })
+		.ToList();
+
+	Assert(result.GetCount() == 3);
+	Assert(result[0].IsEqualTo("#1"));
+	Assert(result[2].IsEqualTo("#3"));
+}
+
+Fact("Query Is Lazy And Single Pass")
+{
+	List<int> list = Range(0, 100);
+	int selected = 0;
+	int tested = 0;
+
+	auto query = list.AsQuery()
+		.Select([&](int x) { selected++; return x * 2; })
+		.Where([&](int x) { tested++; return x > 10; })
+		.Take(3);
+
+	// Building the query does nothing
+	Assert(selected == 0);
+	Assert(tested == 0);
+
+	List<int> result = query.ToList();
+	Assert(result.GetCount() == 3);
+	Assert(result[0] == 12);
+	Assert(result[2] == 16);
+
+	// Stops as soon as Take is satisfied, and the selector runs once per
+	// item even though both Where and ToList read it
+	Assert(selected == 9);
+	Assert(tested == 9);
+}
+
+Fact("Query Take And Skip")
+{
+	List<int> list = Range(0, 10);
+
+	List<int> result = list.AsQuery().Skip(3).Take(4).ToList();
+	Assert(result.GetCount() == 4);
+	Assert(result[0] == 3);
+	Assert(result[3] == 6);
+
+	Assert(list.AsQuery().Skip(20).Count() == 0);
+	Assert(list.AsQuery().Take(0).Count() == 0);
+	Assert(list.AsQuery().Take(100).Count() == 10);
+}
+
+Fact("Query Zip")
+{
+	List<int> a = Range(1, 5);
+	List<int> b = Range(10, 3);
+
+	List<int> sums = a.AsQuery().Zip(b.AsQuery(), [](int x, int y) { return x + y; }).ToList();
+	Assert(sums.GetCount() == 3);
+	Assert(sums[0] == 11);
+	Assert(sums[1] == 13);
+	Assert(sums[2] == 15);
+}
+
+Fact("Query GroupBy Groups Consecutive Keys")
+{
+	List<int> list;
+	int values[] = { 1, 3, 5, 2, 4, 7, 8, 10, 12 };
+	for (int v : values)
+		list.Add(v);
+
+	List<int> keys;
+	List<int> sizes;
+	List<int> sums;
+	for (auto groups = list.AsQuery().GroupBy([](int x) { return x % 2; }); groups.Next(); )
+	{
+		auto& group = groups.Get();
+		keys.Add(group.Key);
+		sizes.Add(group.Items.Count());
+
+		int sum = 0;
+		group.Items.ForEach([&](int x) { sum += x; });
+		sums.Add(sum);
+	}
+
+	Assert(keys.GetCount() == 4);
+	Assert(keys[0] == 1 && sizes[0] == 3 && sums[0] == 9);
+	Assert(keys[1] == 0 && sizes[1] == 2 && sums[1] == 6);
+	Assert(keys[2] == 1 && sizes[2] == 1 && sums[2] == 7);
+	Assert(keys[3] == 0 && sizes[3] == 3 && sums[3] == 30);
+}
+
+Fact("Query Empty Sources")
+{
+	List<int> list;
+	Assert(!list.AsQuery().Any());
+	Assert(list.AsQuery().Where([](int) { return true; }).ToList().GetCount() == 0);
+	Assert(list.AsQuery().GroupBy([](int x) { return x; }).Count() == 0);
+}
+
+Fact("Query Can Be Iterated More Than Once")
+{
+	List<int> list = Range(1, 5);
+	auto query = list.AsQuery().Where([](int x) { return x > 2; });
+
+	Assert(query.Count() == 3);
+	Assert(query.Count() == 3);
+
+	int total = 0;
+	for (auto iter = query.Iterate(); iter.Next(); )
+		total += iter.Get();
+	Assert(total == 12);
+}
+
+Fact("Query Over Map")
+{
+	Map<String, int> map;
+	map.Add("apple", 5);
+	map.Add("banana", 12);
+	map.Add("cherry", 7);
+
+	const Map<String, int>& readOnly = map;
+	List<String> big = readOnly.AsQuery()
+		.Where([](const QueryPair<String, int>& e) { return e.Value > 6; })
+		.Select([](const QueryPair<String, int>& e) { return e.Key; })
+		.ToList();
+
+	Assert(big.GetCount() == 2);
+	Assert(big.Contains("banana"));
+	Assert(big.Contains("cherry"));
+}
+
+Fact("Query Over Set")
+{
+	Set<int> set;
+	for (int i = 0; i < 20; i++)
+		set.Add(i);
+
+	int count = set.AsQuery().Where([](int x) { return x % 5 == 0; }).Count();
+	Assert(count == 4);
+
+	List<int> doubled = set.AsQuery().Select([](int x) { return x * 2; }).ToList();
+	Assert(doubled.GetCount() == 20);
+}
@@ -0,0 +1,147 @@
+#include <thread>
+#include "../UnitTesting.h"
+#include "../Core.h"
+#include "../Threading.h"
+using namespace SimpleLib;
+
+namespace
+{
+	int trapCount = 0;
+	RealTimeViolationKind trapKind;
+
+	void TestTrapHandler(const RealTimeViolation& violation)
+	{
+		// Handler runs unmarked, so it may allocate
+		List<int> list;
+		list.Add(1);
+		trapCount++;
+		trapKind = violation.kind;
+	}
+}
+
+Fact("RealTimeGuard Marks Thread")
+{
+	Assert(!RealTimeGuard::IsRealTimeThread());
+	{
+		RealTimeScope scope;
+		Assert(RealTimeGuard::IsRealTimeThread());
+		{
+			RealTimeScope nested;
+			Assert(RealTimeGuard::IsRealTimeThread());
+		}
+		Assert(RealTimeGuard::IsRealTimeThread());
+	}
+	Assert(!RealTimeGuard::IsRealTimeThread());
+}
+
+// The checks are only compiled in with _SIMPLELIB_REALTIME_GUARD (defined
+// in test.mk.js)
+#ifdef _SIMPLELIB_REALTIME_GUARD
+
+Fact("RealTimeGuard Counts Allocations")
+{
+	List<int> reserved;
+	reserved.SetCapacity(100);
+
+	void* p = nullptr;
+	{
+		RealTimeScope scope;
+
+		// Within capacity, no allocation
+		for (int i = 0; i < 100; i++)
+			reserved.Add(i);
+		TMalloc::Free(nullptr);
+		Assert(RealTimeGuard::GetViolationCount() == 0);
+
+		// Growing allocates
+		reserved.SetCapacity(1000);
+		p = TMalloc::Alloc(10);
+		Assert(RealTimeGuard::GetViolationCount(RealTimeViolationKind::Alloc) == 2);
+
+		TMalloc::Free(p);
+		Assert(RealTimeGuard::GetViolationCount(RealTimeViolationKind::Free) == 1);
+
+		String str("Hello World, too long to be stored inline");
+		Assert(RealTimeGuard::GetViolationCount() == 4);
+	}
+
+	RealTimeViolation violation;
+	Assert(RealTimeGuard::GetFirstViolation(violation));
+	Assert(violation.kind == RealTimeViolationKind::Alloc);
+	Assert(violation.callSite != nullptr);
+	Assert(RealTimeGuard::GetViolationCount() == 5);
+
+	// Not counted once unmarked, and counts reset on the next Enter
+	p = TMalloc::Alloc(10);
+	TMalloc::Free(p);
+	Assert(RealTimeGuard::GetViolationCount() == 5);
+	RealTimeScope scope;
+	Assert(RealTimeGuard::GetViolationCount() == 0);
+	Assert(!RealTimeGuard::GetFirstViolation(violation));
+}
+
+Fact("RealTimeGuard Counts Mutex And Semaphore Waits")
+{
+	Mutex mutex;
+	Semaphore sema(2);
+	{
+		RealTimeScope scope;
+
+		Assert(mutex.TryEnter());
+		mutex.Leave();
+		Assert(sema.Wait(0));
+		Assert(RealTimeGuard::GetViolationCount() == 0);
+
+		mutex.Enter();
+		mutex.Leave();
+		Assert(sema.Wait(1000));
+		Assert(RealTimeGuard::GetViolationCount(RealTimeViolationKind::MutexEnter) == 1);
+		Assert(RealTimeGuard::GetViolationCount(RealTimeViolationKind::SemaphoreWait) == 1);
+	}
+}
+
+Fact("RealTimeGuard Only Affects Marked Thread")
+{
+	RealTimeScope scope;
+
+	int otherCount = -1;
+	std::thread other([&]() {
+		void* p = TMalloc::Alloc(100);
+		TMalloc::Free(p);
+		otherCount = RealTimeGuard::GetViolationCount();
+	});
+	other.join();
+
+	Assert(otherCount == 0);
+}
+
+Fact("RealTimeGuard Trap Mode Calls Handler")
+{
+	RealTimeGuard::SetTrapHandler(TestTrapHandler);
+	trapCount = 0;
+	{
+		RealTimeScope scope(RealTimeMode::Trap);
+		Mutex mutex;
+		mutex.Enter();
+		mutex.Leave();
+		Assert(trapCount == 1);
+		Assert(trapKind == RealTimeViolationKind::MutexEnter);
+		Assert(RealTimeGuard::IsRealTimeThread());
+	}
+	RealTimeGuard::SetTrapHandler(nullptr);
+
+	Assert(trapCount == 1);
+	Assert(RealTimeGuard::GetViolationCount() == 1);
+}
+
+#endif
+
+RealTimeFact("RealTimeGuard Fact Body Sorts Without Allocating")
+{
+	int data[256];
+	for (int i = 0; i < 256; i++)
+		data[i] = (i * 7919) % 256;
+	Sorting::Sort(data, 256, [](int a, int b) { return a < b; });
+	for (int i = 0; i < 256; i++)
+		Assert(data[i] == i);
+}
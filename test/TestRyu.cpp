@@ -0,0 +1,195 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+#include "../Json.h"
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+using namespace SimpleLib;
+
+namespace
+{
+	String FormatJs(double value)
+	{
+		char buf[Ryu::kMaxChars];
+		int length = Ryu::Format(buf, value);
+		Assert(length == (int)strlen(buf));
+		return String(buf);
+	}
+
+	String FormatJs(float value)
+	{
+		char buf[Ryu::kMaxChars];
+		Ryu::Format(buf, value);
+		return String(buf);
+	}
+
+	uint64_t NextRandom(uint64_t& state)
+	{
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	}
+
+	// The fewest significant digits that read back as value, by trying each
+	template <typename TFloat>
+	int BruteForceDigits(TFloat value, TFloat (*parse)(const char*))
+	{
+		char buf[64];
+		for (int digits = 1; digits < 17; digits++)
+		{
+			snprintf(buf, sizeof(buf), "%.*e", digits - 1, (double)value);
+			if (parse(buf) == value)
+				return digits;
+		}
+		return 17;
+	}
+
+	double ParseDouble(const char* psz)
+	{
+		return strtod(psz, nullptr);
+	}
+
+	float ParseFloat(const char* psz)
+	{
+		return strtof(psz, nullptr);
+	}
+
+	// Shortest round trips, and is no longer than the shortest that does
+	template <typename TFloat>
+	bool IsShortestRoundTrip(TFloat value, TFloat (*parse)(const char*))
+	{
+		char buf[64];
+		Ryu::DECIMAL decimal = Ryu::Shortest(value);
+		snprintf(buf, sizeof(buf), "%llue%d", (unsigned long long)decimal.digits, decimal.exponent);
+		return parse(buf) == (value < 0 ? -value : value) &&
+			Ryu::DigitCount(decimal.digits) == BruteForceDigits(value < 0 ? -value : value, parse) &&
+			(decimal.digits % 10 != 0 || decimal.digits == 0);
+	}
+}
+
+Fact("Ryu Formats Doubles Like JavaScript")
+{
+	Assert(FormatJs(0.0).IsEqualTo("0"));
+	Assert(FormatJs(-0.0).IsEqualTo("0"));
+	Assert(FormatJs(1.0).IsEqualTo("1"));
+	Assert(FormatJs(-2.5).IsEqualTo("-2.5"));
+	Assert(FormatJs(0.1).IsEqualTo("0.1"));
+	Assert(FormatJs(0.1 + 0.2).IsEqualTo("0.30000000000000004"));
+	Assert(FormatJs(1.0 / 3).IsEqualTo("0.3333333333333333"));
+	Assert(FormatJs(100.0).IsEqualTo("100"));
+	Assert(FormatJs(123456789012345680.0).IsEqualTo("123456789012345680"));
+	Assert(FormatJs(1e20).IsEqualTo("100000000000000000000"));
+	Assert(FormatJs(1e21).IsEqualTo("1e+21"));
+	Assert(FormatJs(1.5e300).IsEqualTo("1.5e+300"));
+	Assert(FormatJs(0.000001).IsEqualTo("0.000001"));
+	Assert(FormatJs(0.0000015).IsEqualTo("0.0000015"));
+	Assert(FormatJs(1e-7).IsEqualTo("1e-7"));
+	Assert(FormatJs(5e-324).IsEqualTo("5e-324"));
+	Assert(FormatJs(DBL_MAX).IsEqualTo("1.7976931348623157e+308"));
+	Assert(FormatJs(DBL_MIN).IsEqualTo("2.2250738585072014e-308"));
+	Assert(FormatJs(9007199254740993.0).IsEqualTo("9007199254740992"));
+	Assert(FormatJs(HUGE_VAL).IsEqualTo("Infinity"));
+	Assert(FormatJs(-HUGE_VAL).IsEqualTo("-Infinity"));
+	Assert(FormatJs(nan("")).IsEqualTo("NaN"));
+}
+
+Fact("Ryu Formats Floats")
+{
+	Assert(FormatJs(0.1f).IsEqualTo("0.1"));
+	Assert(FormatJs(1.0f / 3).IsEqualTo("0.33333334"));
+	Assert(FormatJs(16777216.0f).IsEqualTo("16777216"));
+	Assert(FormatJs(FLT_MAX).IsEqualTo("3.4028235e+38"));
+	Assert(FormatJs(FLT_MIN).IsEqualTo("1.1754944e-38"));
+	Assert(FormatJs(1e-45f).IsEqualTo("1e-45"));
+}
+
+Fact("Ryu Shortest Round Trips")
+{
+	uint64_t state = 88172645463325252ull;
+	for (int i = 0; i < 20000; i++)
+	{
+		// Random bit patterns cover every exponent, subnormals included
+		uint64_t bits = NextRandom(state);
+		double value;
+		memcpy(&value, &bits, sizeof(value));
+		if (isfinite(value))
+			Assert(IsShortestRoundTrip(value, ParseDouble));
+
+		uint32_t bits32 = (uint32_t)bits;
+		float value32;
+		memcpy(&value32, &bits32, sizeof(value32));
+		if (isfinite(value32))
+			Assert(IsShortestRoundTrip(value32, ParseFloat));
+	}
+
+	for (int i = 1; i < 2000; i++)
+	{
+		Assert(IsShortestRoundTrip((double)i, ParseDouble));
+		Assert(IsShortestRoundTrip(i * 0.001, ParseDouble));
+		Assert(IsShortestRoundTrip(1.0 / i, ParseDouble));
+		Assert(IsShortestRoundTrip(i * 0.1f, ParseFloat));
+	}
+}
+
+Fact("Ryu Format %g Matches printf")
+{
+	uint64_t state = 12345;
+	char expected[64];
+	for (int i = 0; i < 5000; i++)
+	{
+		// Short decimals (which take the shortest digits path) and random doubles
+		double value = (i & 1)
+			? (double)(int64_t)(NextRandom(state) % 2000001 - 1000000) / 1000
+			: (double)(NextRandom(state) >> 11) * 0x1p-53 * pow(10.0, (double)(i % 40) - 20);
+
+		for (int precision : { 1, 3, 6, 10, 15 })
+		{
+			snprintf(expected, sizeof(expected), "%.*g", precision, value);
+			Assert(String::Format("%.*g", precision, value).IsEqualTo(expected));
+		}
+		snprintf(expected, sizeof(expected), "%+g", value);
+		Assert(String::Format("%+g", value).IsEqualTo(expected));
+	}
+
+	// Subnormals keep printf's digits
+	snprintf(expected, sizeof(expected), "%g", 5e-324);
+	Assert(String::Format("%g", 5e-324).IsEqualTo(expected));
+	Assert(String::Format("%g|%g", -0.0, 0.0).IsEqualTo("-0|0"));
+}
+
+Fact("Ryu Format %.17g Matches printf")
+{
+	// All 17 digits, as printf gives - not the shortest round trip
+	Assert(String::Format("%.17g", 0.1).IsEqualTo("0.10000000000000001"));
+
+	const double fixed[] = { 1.0 / 3, 1e16, 1e17, 0.0001, 0.00001, -2.5, 0.0 };
+	char expected[64];
+	for (double value : fixed)
+	{
+		snprintf(expected, sizeof(expected), "%.17g", value);
+		Assert(String::Format("%.17g", value).IsEqualTo(expected));
+	}
+
+	uint64_t state = 777;
+	for (int i = 0; i < 5000; i++)
+	{
+		uint64_t bits = NextRandom(state);
+		double value;
+		memcpy(&value, &bits, sizeof(value));
+		if (!isfinite(value))
+			continue;
+		snprintf(expected, sizeof(expected), "%.17g", value);
+		Assert(String::Format("%.17g", value).IsEqualTo(expected));
+	}
+}
+
+Fact("Ryu JSON Numbers")
+{
+	JSONArray* array = new JSONArray();
+	array->Add(JSONValue(0.1));
+	array->Add(JSONValue(-1e21));
+	array->Add(JSONValue(42));
+	array->Add(JSONValue(HUGE_VAL));
+	Assert(JSON::Stringify(JSONValue(array), 0).IsEqualTo("[0.1,-1e+21,42,null]"));
+}
@@ -0,0 +1,92 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+using namespace SimpleLib;
+
+Fact("Search IndexOf")
+{
+	uint32_t data[100];
+	for (int i = 0; i < 100; i++)
+		data[i] = i * 7;
+
+	for (int count = 0; count <= 100; count++)
+	{
+		for (int i = 0; i < 100; i++)
+			Assert(Search::IndexOf(data, count, (uint32_t)(i * 7)) == (i < count ? i : -1));
+	}
+}
+
+Fact("Search LowerBound")
+{
+	int data[64];
+	for (int i = 0; i < 64; i++)
+		data[i] = i * 2;
+	auto less = [](int a, int b) { return a < b; };
+
+	for (int count = 0; count <= 64; count++)
+	{
+		for (int key = -1; key <= 130; key++)
+		{
+			// Reference linear lower bound
+			int expected = 0;
+			while (expected < count && data[expected] < key)
+				expected++;
+			Assert(Search::LowerBound(data, count, key, less) == expected);
+		}
+	}
+}
+
+Fact("EytzingerIndex LowerBound And Contains")
+{
+	for (int count = 0; count <= 70; count++)
+	{
+		List<int> sorted;
+		for (int i = 0; i < count; i++)
+			sorted.Add(i * 3 + 1);
+
+		EytzingerIndex<int> index;
+		Assert(index.Build(sorted.GetBuffer(), count));
+		Assert(index.GetCount() == count);
+
+		for (int key = 0; key <= count * 3 + 2; key++)
+		{
+			int expected = 0;
+			while (expected < count && sorted[expected] < key)
+				expected++;
+			Assert(index.LowerBound(key) == expected);
+			Assert(index.Contains(key) == (key % 3 == 1 && key < count * 3));
+		}
+	}
+}
+
+Fact("EytzingerIndex With Duplicates")
+{
+	int data[] = { 1, 2, 2, 2, 3, 5, 5, 8 };
+	EytzingerIndex<int> index;
+	Assert(index.Build(data, 8));
+
+	Assert(index.LowerBound(2) == 1);
+	Assert(index.LowerBound(5) == 5);
+	Assert(index.LowerBound(4) == 5);
+	Assert(index.LowerBound(9) == 8);
+	Assert(index.Contains(8));
+	Assert(!index.Contains(4));
+}
+
+Fact("EytzingerIndex Of 8 Byte Elements")
+{
+	List<double> sorted;
+	for (int i = 0; i < 1000; i++)
+		sorted.Add(i * 0.5);
+
+	// Build twice so the aligned block is also freed and reallocated
+	EytzingerIndex<double> index;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		Assert(index.Build(sorted.GetBuffer(), sorted.GetCount()));
+		Assert(index.LowerBound(-1.0) == 0);
+		Assert(index.LowerBound(100.25) == 201);
+		Assert(index.LowerBound(1000.0) == 1000);
+		Assert(index.Contains(499.5));
+		Assert(!index.Contains(0.25));
+	}
+}
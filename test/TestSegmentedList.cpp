@@ -0,0 +1,219 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+using namespace SimpleLib;
+
+namespace
+{
+	class Tracked
+	{
+	public:
+		Tracked(int value = 0) : Value(value) { s_instances++; }
+		Tracked(const Tracked& other) : Value(other.Value) { s_instances++; }
+		~Tracked() { s_instances--; }
+
+		int Value;
+
+		inline static int s_instances = 0;
+	};
+
+	class NonCopyable
+	{
+	public:
+		NonCopyable(int a, int b) : Sum(a + b) {}
+		NonCopyable(const NonCopyable&) = delete;
+
+		int Sum;
+	};
+}
+
+Fact("SegmentedList Add GetAt")
+{
+	SegmentedList<int> list;
+	Assert(list.IsEmpty());
+	for (int i = 0; i < 100000; i++)
+		Assert(list.Add(i) == i);
+	Assert(list.GetCount() == 100000);
+	for (int i = 0; i < 100000; i++)
+	{
+		Assert(list[i] == i);
+		Assert(list.GetRefAt(i) == i);
+	}
+}
+
+Fact("SegmentedList Element Addresses Are Stable")
+{
+	SegmentedList<int> list;
+	list.Add(0);
+	int* first = &list.GetRefAt(0);
+
+	List<int*> addresses;
+	for (int i = 1; i < 10000; i++)
+	{
+		list.Add(i);
+		addresses.Add(&list.GetRefAt(i));
+	}
+
+	Assert(&list.GetRefAt(0) == first);
+	Assert(*first == 0);
+	for (int i = 1; i < 10000; i++)
+	{
+		Assert(addresses[i - 1] == &list.GetRefAt(i));
+		Assert(*addresses[i - 1] == i);
+	}
+}
+
+Fact("SegmentedList Chunks Double In Size")
+{
+	SegmentedList<int> list;
+	for (int i = 0; i < 1000; i++)
+		list.Add(i);
+
+	int total = 0;
+	int expected = SegmentedList<int>::kFirstChunkSize;
+	for (int c = 0; c < list.GetChunkCount(); c++)
+	{
+		int count;
+		int* chunk = list.GetChunk(c, count);
+		Assert(chunk[0] == total);
+		if (c < list.GetChunkCount() - 1)
+			Assert(count == expected);
+		total += count;
+		expected *= 2;
+	}
+	Assert(total == 1000);
+}
+
+Fact("SegmentedList Insert Remove")
+{
+	SegmentedList<int> list;
+	for (int i = 0; i < 50; i++)
+		list.Add(i);
+
+	Assert(list.InsertAt(0, -1));
+	Assert(list.InsertAt(20, 100));
+	Assert(list.GetCount() == 52);
+	Assert(list[0] == -1);
+	Assert(list[1] == 0);
+	Assert(list[20] == 100);
+	Assert(list[21] == 19);
+	Assert(list[51] == 49);
+
+	list.RemoveAt(20);
+	list.RemoveAt(0);
+	for (int i = 0; i < 50; i++)
+		Assert(list[i] == i);
+
+	list.RemoveAt(10, 30);
+	Assert(list.GetCount() == 20);
+	Assert(list[9] == 9);
+	Assert(list[10] == 40);
+
+	Assert(list.Remove(40) == 10);
+	Assert(list.IndexOf(41) == 10);
+	Assert(list.Contains(5));
+	Assert(!list.Contains(40));
+
+	list.Swap(0, 1);
+	Assert(list[0] == 1 && list[1] == 0);
+	list.ReplaceAt(0, 7);
+	Assert(list[0] == 7);
+
+	Assert(list.Pop() == 49);
+	list.Push(99);
+	Assert(list[list.GetCount() - 1] == 99);
+}
+
+Fact("SegmentedList Constructs And Destructs Objects")
+{
+	{
+		SegmentedList<Tracked> list;
+		for (int i = 0; i < 100; i++)
+			list.Add(Tracked(i));
+		Assert(Tracked::s_instances == 100);
+
+		list.RemoveAt(10, 10);
+		Assert(Tracked::s_instances == 90);
+		Assert(list.GetRefAt(10).Value == 20);
+	}
+	Assert(Tracked::s_instances == 0);
+}
+
+Fact("SegmentedList Emplace")
+{
+	SegmentedList<NonCopyable> list;
+	NonCopyable* p = list.Emplace(1, 2);
+	Assert(p->Sum == 3);
+	for (int i = 0; i < 1000; i++)
+		list.Emplace(i, i);
+	Assert(p == &list.GetRefAt(0));
+	Assert(list.GetRefAt(1000).Sum == 1998);
+}
+
+Fact("SegmentedList Iterate")
+{
+	SegmentedList<int> list;
+	for (int i = 0; i < 100; i++)
+		list.Add(i);
+
+	int expected = 0;
+	for (auto iter = list.Iterate(); iter.Next(); )
+		Assert(iter.Get() == expected++);
+	Assert(expected == 100);
+
+	for (auto iter = list.IterateReverse(); iter.Next(); )
+		Assert(iter.Get() == --expected);
+	Assert(expected == 0);
+}
+
+Fact("SegmentedList Capacity Clear FreeExtra")
+{
+	SegmentedList<int> list;
+	Assert(list.SetCapacity(100));
+	Assert(list.GetCapacity() >= 100);
+	int capacity = list.GetCapacity();
+
+	for (int i = 0; i < 100; i++)
+		list.Add(i);
+	Assert(list.GetCapacity() == capacity);
+
+	list.Clear();
+	Assert(list.GetCount() == 0);
+	Assert(list.GetCapacity() == capacity);
+
+	list.Add(1);
+	list.FreeExtra();
+	Assert(list.GetCapacity() == SegmentedList<int>::kFirstChunkSize);
+	Assert(list[0] == 1);
+}
+
+Fact("SegmentedList Move")
+{
+	SegmentedList<int> a;
+	for (int i = 0; i < 100; i++)
+		a.Add(i);
+	int* p = &a.GetRefAt(50);
+
+	SegmentedList<int> b(SimpleLib::move(a));
+	Assert(a.GetCount() == 0);
+	Assert(b.GetCount() == 100);
+	Assert(&b.GetRefAt(50) == p);
+
+	SegmentedList<int> c;
+	c.Add(1);
+	c = SimpleLib::move(b);
+	Assert(c.GetCount() == 100);
+	Assert(c[99] == 99);
+}
+
+Fact("SegmentedList Stateful Allocator")
+{
+	Arena arena;
+	{
+		SegmentedList<int, ArenaAllocator> list{ ArenaAllocator(&arena) };
+		for (int i = 0; i < 1000; i++)
+			list.Add(i);
+		Assert(list.GetAllocator().GetArena() == &arena);
+		Assert(list[999] == 999);
+	}
+	Assert(arena.GetUsed() > 0);
+}
@@ -1,5 +1,6 @@
 #include "../UnitTesting.h"
 #include "../Core.h"
+#include "CountingAllocator.h"
 using namespace SimpleLib;
 
 // A hashable/comparable element that also tracks live instances, so we can
@@ -480,3 +481,29 @@ Fact("Set Difference Identical Sets Is Empty")
 	Set<int> d = Set<int>::Difference(a, b);
 	Assert(d.IsEmpty());
 }
+
+Fact("Set With Stateful Allocator")
+{
+	Assert(sizeof(Set<int, SDefaultCompare, CountingAllocator>) == sizeof(Set<int>) + sizeof(CountingAllocator));
+
+	AllocStats stats = {};
+	{
+		typedef Set<int, SDefaultCompare, CountingAllocator> TSet;
+		TSet a{ CountingAllocator(&stats) };
+		TSet b{ CountingAllocator(&stats) };
+		for (int i = 0; i < 50; i++)
+		{
+			a.Add(i);
+			b.Add(i + 25);
+		}
+		Assert(stats.live == 2);
+
+		// Set operations allocate the result from the first operand's allocator
+		TSet u = TSet::Union(a, b);
+		Assert(u.GetAllocator().m_stats == &stats);
+		Assert(u.GetCount() == 75);
+		Assert(stats.live == 3);
+	}
+	Assert(stats.live == 0);
+	Assert(stats.allocs == stats.frees);
+}
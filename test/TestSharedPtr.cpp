@@ -0,0 +1,97 @@
+#include <thread>
+#include <atomic>
+#include "../UnitTesting.h"
+#include "../Core.h"
+using namespace SimpleLib;
+
+namespace
+{
+	struct SharedThing
+	{
+		SharedThing(int value) : value(value)
+		{
+			s_instances++;
+		}
+
+		~SharedThing()
+		{
+			s_instances--;
+		}
+
+		int value;
+		inline static std::atomic<int> s_instances{ 0 };
+	};
+}
+
+Fact("SharedPtr Deletes When Last Reference Released")
+{
+	{
+		SharedPtr<SharedThing> a(new SharedThing(1));
+		SharedPtr<SharedThing> b(a);
+		Assert(a == b);
+		Assert(SharedThing::s_instances == 1);
+
+		a = nullptr;
+		Assert(SharedThing::s_instances == 1);
+		Assert(b->value == 1);
+	}
+	Assert(SharedThing::s_instances == 0);
+}
+
+Fact("SharedPtr Assignment")
+{
+	{
+		SharedPtr<SharedThing> a(new SharedThing(1));
+		SharedPtr<SharedThing> b(new SharedThing(2));
+
+		// Self assignment keeps the object
+		a = a;
+		Assert(a->value == 1);
+
+		// Copy assignment releases the old object
+		b = a;
+		Assert(SharedThing::s_instances == 1);
+		Assert(b->value == 1);
+
+		// Move assignment releases the old object
+		SharedPtr<SharedThing> c(new SharedThing(3));
+		c = SimpleLib::move(a);
+		Assert(!a);
+		Assert(c->value == 1);
+		Assert(SharedThing::s_instances == 1);
+	}
+	Assert(SharedThing::s_instances == 0);
+}
+
+Fact("AtomicSharedPtr Copies Across Threads")
+{
+	{
+		AtomicSharedPtr<SharedThing> shared(new SharedThing(42));
+
+		// Each thread makes and releases many copies of the same pointer
+		std::atomic<int> sum{ 0 };
+		List<std::thread*> threads;
+		for (int t = 0; t < 4; t++)
+		{
+			threads.Add(new std::thread([&]() {
+				for (int i = 0; i < 100000; i++)
+				{
+					AtomicSharedPtr<SharedThing> copy(shared);
+					AtomicSharedPtr<SharedThing> other;
+					other = copy;
+					if (i == 0)
+						sum += other->value;
+				}
+			}));
+		}
+		for (int t = 0; t < threads.GetCount(); t++)
+		{
+			threads[t]->join();
+			delete threads[t];
+		}
+
+		Assert(sum == 42 * 4);
+		Assert(SharedThing::s_instances == 1);
+	}
+	Assert(SharedThing::s_instances == 0);
+}
@@ -0,0 +1,165 @@
+#include <thread>
+#include <atomic>
+#include "../UnitTesting.h"
+#include "../Core.h"
+#include "../Threading.h"
+using namespace SimpleLib;
+
+Fact("SizeClassHeap Size Classes")
+{
+	// Every size maps to the smallest class that fits
+	for (size_t size = 1; size <= SizeClassHeap::kMaxSmallSize; size++)
+	{
+		int sizeClass = SizeClassHeap::SizeToClass(size);
+		Assert(sizeClass >= 0 && sizeClass < SizeClassHeap::kClassCount);
+		Assert(SizeClassHeap::ClassToSize(sizeClass) >= size);
+		if (sizeClass > 0)
+			Assert(SizeClassHeap::ClassToSize(sizeClass - 1) < size);
+	}
+	Assert(SizeClassHeap::SizeToClass(SizeClassHeap::kMaxSmallSize) == SizeClassHeap::kClassCount - 1);
+}
+
+Fact("SizeClassHeap Alloc Free")
+{
+	SizeClassHeap heap;
+	for (size_t size = 1; size < 20000; size = size * 3 / 2 + 1)
+	{
+		unsigned char* p = (unsigned char*)heap.Alloc(size);
+		Assert(p != nullptr);
+		Assert(((uintptr_t)p & 15) == 0);
+		Assert(heap.GetSize(p) >= size);
+		memset(p, 0xAB, size);
+		heap.Free(p);
+	}
+
+	// Freed blocks are reused
+	void* a = heap.Alloc(40);
+	heap.Free(a);
+	Assert(heap.Alloc(40) == a);
+}
+
+Fact("SizeClassHeap Blocks Don't Overlap")
+{
+	SizeClassHeap heap;
+	unsigned char* blocks[3000];
+	for (int i = 0; i < 3000; i++)
+	{
+		size_t size = (i * 37) % 600 + 1;
+		blocks[i] = (unsigned char*)heap.Alloc(size);
+		memset(blocks[i], i & 0xFF, size);
+	}
+	for (int i = 0; i < 3000; i++)
+	{
+		size_t size = (i * 37) % 600 + 1;
+		for (size_t j = 0; j < size; j++)
+			Assert(blocks[i][j] == (i & 0xFF));
+		heap.Free(blocks[i]);
+	}
+}
+
+Fact("SizeClassHeap ReAlloc")
+{
+	SizeClassHeap heap;
+	char* p = (char*)heap.ReAlloc(nullptr, 20);
+	strcpy(p, "Hello World");
+
+	// Same class stays in place
+	Assert(heap.ReAlloc(p, 32) == p);
+
+	// Bigger class moves, keeping content
+	p = (char*)heap.ReAlloc(p, 5000);
+	Assert(strcmp(p, "Hello World") == 0);
+	p = (char*)heap.ReAlloc(p, 100000);
+	Assert(strcmp(p, "Hello World") == 0);
+	Assert(heap.GetSize(p) == 100000);
+	p = (char*)heap.ReAlloc(p, 16);
+	Assert(strcmp(p, "Hello World") == 0);
+	heap.Free(p);
+}
+
+Fact("SizeClassHeap Large Blocks")
+{
+	// Blocks just past the small sizes are mapped in pages, many at once
+	SizeClassHeap heap;
+	unsigned char* blocks[500];
+	for (int i = 0; i < 500; i++)
+	{
+		size_t size = SizeClassHeap::kMaxSmallSize + 1 + i * 97;
+		blocks[i] = (unsigned char*)heap.Alloc(size);
+		Assert(blocks[i] != nullptr);
+		Assert(((uintptr_t)blocks[i] & 15) == 0);
+		Assert(heap.GetSize(blocks[i]) == size);
+		memset(blocks[i], i & 0xFF, size);
+	}
+	for (int i = 0; i < 500; i++)
+	{
+		size_t size = SizeClassHeap::kMaxSmallSize + 1 + i * 97;
+		Assert(blocks[i][0] == (i & 0xFF) && blocks[i][size - 1] == (i & 0xFF));
+		heap.Free(blocks[i]);
+	}
+	Assert(heap.GetSlabCount() == 0);
+}
+
+Fact("SizeClassHeap As Container Allocator")
+{
+	SizeClassHeap heap;
+	{
+		List<int, SizeClassAllocator> list(&heap);
+		for (int i = 0; i < 10000; i++)
+			list.Add(i);
+		for (int i = 0; i < 10000; i++)
+			Assert(list[i] == i);
+
+		Map<int, int, SDefaultCompare, SizeClassAllocator> map(&heap);
+		for (int i = 0; i < 1000; i++)
+			map.Add(i, -i);
+		Assert(map.Get(500) == -500);
+	}
+
+	List<int, TSizeClassAlloc> list;
+	for (int i = 0; i < 100; i++)
+		list.Add(i);
+	Assert(list[99] == 99);
+}
+
+Fact("SizeClassHeap Cross Thread Free Recycles")
+{
+	// Producer allocates, consumer frees - blocks must flow back so the
+	// heap doesn't grow with the number of messages
+	SizeClassHeap heap;
+	const int kCount = 200000;
+	const int kInFlight = 256;
+
+	void* volatile ring[kInFlight] = {};
+	std::atomic<int> produced{ 0 };
+	std::atomic<int> consumed{ 0 };
+	std::atomic<bool> corrupted{ false };
+
+	std::thread consumer([&]() {
+		for (int i = 0; i < kCount; i++)
+		{
+			while (consumed.load() >= produced.load())
+				std::this_thread::yield();
+			int* p = (int*)ring[i % kInFlight];
+			if (*p != i)
+				corrupted = true;
+			heap.Free(p);
+			consumed.store(i + 1);
+		}
+		heap.FlushThreadCache();
+	});
+
+	for (int i = 0; i < kCount; i++)
+	{
+		while (produced.load() - consumed.load() >= kInFlight)
+			std::this_thread::yield();
+		int* p = (int*)heap.Alloc(16 + (i % 4) * 16);
+		*p = i;
+		ring[i % kInFlight] = p;
+		produced.store(i + 1);
+	}
+	consumer.join();
+
+	Assert(!corrupted);
+	Assert(heap.GetSlabCount() <= 8);
+}
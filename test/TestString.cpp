@@ -1,3 +1,4 @@
+#include <thread>
 #include "../UnitTesting.h"
 #include "../Core.h"
 using namespace SimpleLib;
@@ -24,7 +25,7 @@ Fact("StringCore IndexOf")
 Fact("StringCore Copy Constructor")
 {
 	// Copy constructor
-	String str("Hello");
+	String str("Hello World, too long to be stored inline");
 	String str2(str);
 	Assert(static_cast<const char*>(str)==static_cast<const char*>(str2));			// Pointers should be same
 }
@@ -73,7 +74,7 @@ Fact("StringCore Trim")
 	Assert(String("   ").Trim().IsEqualTo(""));
 
 	// No whitespace at all - should return the same underlying data, not a copy
-	String noWhiteSpace("Hello World");
+	String noWhiteSpace("Hello World, too long to be stored inline");
 	Assert(static_cast<const char*>(noWhiteSpace.Trim()) == static_cast<const char*>(noWhiteSpace));
 	Assert(static_cast<const char*>(noWhiteSpace.LTrim()) == static_cast<const char*>(noWhiteSpace));
 	Assert(static_cast<const char*>(noWhiteSpace.RTrim()) == static_cast<const char*>(noWhiteSpace));
@@ -176,10 +177,10 @@ Fact("StringCore Move Assignment")
 
 Fact("StringCore Copy Assignment")
 {
-	String a("Hello");
+	String a("Hello World, too long to be stored inline");
 	String b;
 	b = a;
-	Assert(b.IsEqualTo("Hello"));
+	Assert(b.IsEqualTo("Hello World, too long to be stored inline"));
 	Assert(static_cast<const char*>(a) == static_cast<const char*>(b));	// Pointers should be same (ref-counted)
 }
 
@@ -407,4 +408,179 @@ Fact("StringCore Hash")
 {
 	Assert(String::Hash(String("Hello")) == String::Hash(String("Hello")));
 	Assert(String::Hash(String("Hello")) != String::Hash(String("World")));
-}
\ No newline at end of file
+}
+
+Fact("StringCore Hash Is Cached And Shared By Copies")
+{
+	const char* text = "A key long enough to be stored on the heap rather than inline";
+	String a(text);
+	String copy(a);
+	uint32_t expected = String::Hash(text, (int)strlen(text));
+
+	// Same value first time (computed) and after (cached), from any copy
+	Assert(String::Hash(a) == expected);
+	Assert(String::Hash(a) == expected);
+	Assert(String::Hash(copy) == expected);
+	Assert(String::Hash(String(text)) == expected);
+	Assert(SCase::Hash(a.sz()) == expected);
+}
+
+Fact("StringCore Equality")
+{
+	const char* text = "A key long enough to be stored on the heap rather than inline";
+	String a(text);
+	String b(text);
+	String c("A key long enough to be stored on the heap rather than inlinE");
+
+	Assert(a == b);
+	Assert(a != c);
+
+	// Still right once hashes are cached (equal hashes still compare the
+	// characters, different ones reject)
+	String::Hash(a);
+	String::Hash(c);
+	Assert(a != c);
+	Assert(c != a);
+	String::Hash(b);
+	Assert(a == b);
+
+	// Inline vs heap, and lengths
+	Assert(String("short") == String("short"));
+	Assert(String("short") != String("shorter"));
+	Assert(String(text, 30) != a);
+
+	// Null only equals null
+	Assert(String() == String());
+	Assert(String() != String(""));
+	Assert(String("") == String(""));
+}
+
+Fact("StringCore Short Strings Are Inline")
+{
+	// Boundaries either side of the inline capacity
+	const char* letters = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	for (int length = 0; length <= String::kInlineCapacity + 2; length++)
+	{
+		String str(letters, length);
+		Assert(!str.IsNull());
+		Assert(str.GetLength() == length);
+		Assert(strncmp(str.sz(), letters, length) == 0);
+		Assert(str.sz()[length] == '\0');
+
+		// Copies share the buffer for heap strings, have their own for inline
+		String copy(str);
+		Assert(copy.IsEqualTo(str));
+		Assert((copy.sz() == str.sz()) == (length > String::kInlineCapacity));
+
+		// Moving leaves the source null
+		String moved(SimpleLib::move(copy));
+		Assert(copy.IsNull());
+		Assert(moved.IsEqualTo(str));
+		Assert(String::Hash(moved) == String::Hash(String(letters, length)));
+	}
+
+	Assert(String().IsNull());
+	Assert(String("").GetLength() == 0);
+	Assert(WString(L"Hello").IsEqualTo(L"Hello"));
+	Assert(WString(L"Hello").ToUpper().IsEqualTo(L"HELLO"));
+}
+
+Fact("StringCore Assignment")
+{
+	String shortStr("short");
+	String longStr("a string too long to be stored inline");
+
+	String str;
+	str = shortStr;
+	Assert(str.IsEqualTo("short"));
+	str = longStr;
+	Assert(str.IsEqualTo(longStr));
+	Assert(str.sz() == longStr.sz());
+	str = shortStr;
+	Assert(str.IsEqualTo("short"));
+
+	// Self assignment
+	str = str;
+	Assert(str.IsEqualTo("short"));
+	longStr = longStr;
+	Assert(longStr.IsEqualTo("a string too long to be stored inline"));
+
+	// Assigning from the string's own buffer
+	str = longStr.sz() + 2;
+	Assert(str.IsEqualTo("string too long to be stored inline"));
+	str = str.sz() + 7;
+	Assert(str.IsEqualTo("too long to be stored inline"));
+
+	// Move assignment releases the old value
+	str = String("moved");
+	Assert(str.IsEqualTo("moved"));
+	longStr = SimpleLib::move(str);
+	Assert(longStr.IsEqualTo("moved"));
+	Assert(str.IsNull());
+
+	str.Clear();
+	Assert(str.IsNull());
+}
+
+#ifdef _SIMPLELIB_REALTIME_GUARD
+
+Fact("StringCore Short Strings Don't Allocate")
+{
+	String longStr("a string too long to be stored inline");
+
+	RealTimeScope scope;
+	{
+		String a("identifier");
+		String b(a);
+		String c = b.ToUpper();
+		String d = longStr.SubString(0, 8);
+		Assert(c.IsEqualTo("IDENTIFIER"));
+		Assert(d.IsEqualTo("a string"));
+	}
+	Assert(RealTimeGuard::GetViolationCount() == 0);
+
+	// Long strings allocate once and copies share
+	{
+		String a("another string too long to be inline");
+		String b(a);
+	}
+	Assert(RealTimeGuard::GetViolationCount(RealTimeViolationKind::Alloc) == 1);
+	Assert(RealTimeGuard::GetViolationCount(RealTimeViolationKind::Free) == 1);
+}
+
+#endif
+
+Fact("AtomicString Shares Across Threads")
+{
+	AtomicString shared("a string long enough to live in a shared heap buffer");
+
+	// Threads make and release copies of the same buffer
+	std::thread threads[4];
+	int lengths[4] = { 0 };
+	for (int t = 0; t < 4; t++)
+	{
+		threads[t] = std::thread([&, t]() {
+			for (int i = 0; i < 100000; i++)
+			{
+				AtomicString copy(shared);
+				AtomicString other;
+				other = copy;
+				lengths[t] = other.GetLength();
+			}
+		});
+	}
+	for (int t = 0; t < 4; t++)
+		threads[t].join();
+
+	for (int t = 0; t < 4; t++)
+		Assert(lengths[t] == shared.GetLength());
+	Assert(shared.IsEqualTo("a string long enough to live in a shared heap buffer"));
+
+	// Converting between policies copies the characters
+	String plain(shared);
+	Assert(plain.IsEqualTo(shared.sz()));
+	Assert(plain.sz() != shared.sz());
+	AtomicString back(plain);
+	Assert(back.IsEqualTo(plain.sz()));
+	Assert(AtomicString(String()).IsNull());
+}
@@ -1,5 +1,6 @@
 #include "../UnitTesting.h"
 #include "../Core.h"
+#include "CountingAllocator.h"
 using namespace SimpleLib;
 
 Fact("StringBuilder Finish Returns Null Terminated String")
@@ -37,6 +38,37 @@ Fact("StringBuilder Finish Does Not Reset Builder")
 	Assert(strcmp(p1, "Hello") == 0);
 }
 
+Fact("StringBuilder Detach Short Wide String")
+{
+	// Copied out of the short buffer, so must be sized in characters
+	StringBuilder<wchar_t> sb;
+	sb.Append(L"Hello World");
+
+	wchar_t* psz = sb.Detach();
+	Assert(SCase::Compare(psz, L"Hello World") == 0);
+	Assert(sb.GetLength() == 0);
+	free(psz);
+}
+
+Fact("StringBuilder Detach Long String Hands Over Buffer")
+{
+	// The heap buffer itself is handed over, so mustn't also be freed by
+	// the builder
+	StringBuilder<char> sb;
+	for (int i = 0; i < 100; i++)
+		sb.Append("0123456789");
+
+	char* psz = sb.Detach();
+	Assert(strlen(psz) == 1000);
+	Assert(strncmp(psz + 990, "0123456789", 10) == 0);
+
+	// Builder is empty and still usable
+	Assert(sb.GetLength() == 0);
+	sb.Append("Again");
+	Assert(strcmp(sb.sz(), "Again") == 0);
+	free(psz);
+}
+
 Fact("StringBuilder GetBuffer Resets And Reserves")
 {
 	StringBuilder<char> sb;
@@ -98,3 +130,223 @@ Fact("StringBuilder SyncLength Returns Self For Chaining")
 	String str = sb.SyncLength().ToString();
 	Assert(str.IsEqualTo("chained"));
 }
+
+Fact("StringBuilder With Stateful Allocator")
+{
+	AllocStats stats = {};
+	{
+		StringBuilder<char, CountingAllocator> sb{ CountingAllocator(&stats) };
+
+		// Short strings stay in the embedded buffer
+		sb.Append("Hello");
+		Assert(stats.allocs == 0);
+
+		for (int i = 0; i < 100; i++)
+			sb.Append(" World");
+		Assert(stats.live == 1);
+		Assert(sb.GetLength() == 605);
+
+		String str = sb.ToString();
+		Assert(str.GetLength() == 605);
+
+		// Detached buffers belong to the caller but come from the builder's allocator
+		char* p = sb.Detach();
+		Assert(stats.live == 1);
+		Assert(strncmp(p, "Hello World", 11) == 0);
+		sb.GetAllocator().Free(p);
+		Assert(stats.live == 0);
+	}
+	Assert(stats.allocs == stats.frees);
+}
+
+namespace
+{
+	// Concatenates a builder's chunks, checking none are empty
+	String JoinChunks(const StringBuilder<char>& sb, int* pCount)
+	{
+		StringBuilder<char> joined;
+		*pCount = 0;
+		sb.ForEachChunk([&](const char* p, int length) {
+			Assert(length > 0);
+			joined.Append(p, length);
+			(*pCount)++;
+			return true;
+		});
+		return joined.ToString();
+	}
+}
+
+Fact("StringBuilder Chunked Appends Without Copying")
+{
+	AllocStats stats = {};
+	{
+		StringBuilder<char, CountingAllocator> sb{ CountingAllocator(&stats) };
+		sb.SetChunkSize(1000);
+		Assert(sb.IsContiguous());
+
+		// Fill well past the short buffer and a few chunks
+		for (int i = 0; i < 500; i++)
+			sb.Append("0123456789");
+		Assert(sb.GetLength() == 5000);
+		Assert(!sb.IsContiguous());
+		Assert(sb.GetChunkCount() == 5);
+
+		// A chunk (buffer plus its list entry) per 1000 chars, never a realloc
+		Assert(stats.live == 5 + 4);
+
+		// An append bigger than a chunk gets a chunk of its own
+		char big[2500];
+		memset(big, 'x', sizeof(big));
+		sb.Append(big, sizeof(big));
+		Assert(sb.GetLength() == 7500);
+		Assert(sb.GetChunkCount() == 6);
+	}
+	Assert(stats.allocs == stats.frees);
+}
+
+Fact("StringBuilder Chunked SyncLength")
+{
+	StringBuilder<char> sb;
+	sb.SetChunkSize(64);
+	for (int i = 0; i < 20; i++)
+		sb.Append("0123456789");
+	Assert(!sb.IsContiguous());
+
+	// Flattens, and stops at the end of the content
+	sb.SyncLength();
+	Assert(sb.IsContiguous());
+	Assert(sb.GetLength() == 200);
+	Assert(memcmp(sb.sz() + 190, "0123456789", 11) == 0);
+}
+
+Fact("StringBuilder Chunked ForEachChunk Gives Content In Order")
+{
+	StringBuilder<char> sb;
+	sb.SetChunkSize(64);
+	String expected;
+	{
+		StringBuilder<char> flat;
+		for (int i = 0; i < 1000; i++)
+		{
+			sb.Format("%d,", i);
+			flat.Format("%d,", i);
+		}
+		expected = flat.ToString();
+	}
+
+	int count;
+	Assert(JoinChunks(sb, &count) == expected);
+	Assert(count == sb.GetChunkCount());
+	Assert(count > 50);
+
+	// ToString copies the chunks without flattening the builder
+	Assert(sb.ToString() == expected);
+	Assert(!sb.IsContiguous());
+
+	// Stopping early
+	int seen = 0;
+	Assert(!sb.ForEachChunk([&](const char*, int) { return ++seen < 3; }));
+	Assert(seen == 3);
+}
+
+Fact("StringBuilder Chunked Flattens When Contiguous Content Needed")
+{
+	StringBuilder<char> sb;
+	sb.SetChunkSize(16);
+	for (int i = 0; i < 200; i++)
+		sb.Append('a' + i % 26);
+	Assert(!sb.IsContiguous());
+
+	int length;
+	const char* psz = sb.Finish(&length);
+	Assert(length == 200);
+	Assert(sb.IsContiguous());
+	Assert((int)strlen(psz) == 200);
+	Assert(psz[27] == 'b');
+
+	// Still chunked afterwards
+	sb.Truncate(200);
+	for (int i = 0; i < 100; i++)
+		sb.Append('z');
+	Assert(!sb.IsContiguous());
+	Assert(sb.GetLength() == 300);
+
+	char* detached = sb.Detach();
+	Assert((int)strlen(detached) == 300);
+	Assert(detached[0] == 'a' && detached[299] == 'z');
+	free(detached);
+	Assert(sb.GetLength() == 0);
+
+	// Switching back to one buffer flattens
+	for (int i = 0; i < 10; i++)
+		sb.Append("0123456789012345678901234567890123456789");
+	Assert(!sb.IsContiguous());
+	sb.SetChunkSize(0);
+	Assert(sb.IsContiguous());
+	Assert(sb.GetLength() == 400);
+	Assert(strncmp(sb.sz() + 390, "0123456789", 10) == 0);
+}
+
+Fact("StringBuilder Chunked Exactly Full Chunk Finishes In Place")
+{
+	// One chunk filled to capacity - terminating it mustn't start a new
+	// (empty) chunk and return that instead
+	StringBuilder<char> sb;
+	sb.SetChunkSize(256);
+	sb.Append('x', 200);
+	sb.Append('y', 56);
+	Assert(sb.GetChunkCount() == 1);
+
+	int length;
+	const char* psz = sb.Finish(&length);
+	Assert(length == 256);
+	Assert((int)strlen(psz) == 256);
+	Assert(sb.IsContiguous());
+	Assert((int)strlen(sb.sz()) == 256);
+	Assert(sb.sz()[0] == 'x' && sb.sz()[255] == 'y');
+
+	char* detached = sb.Detach();
+	Assert((int)strlen(detached) == 256);
+	Assert(detached[199] == 'x' && detached[200] == 'y');
+	free(detached);
+
+	// The same when the first chunk is sized by the append
+	sb.SetChunkSize(64);
+	sb.Append('z', 200);
+	Assert(sb.GetChunkCount() == 1);
+	Assert((int)strlen(sb.sz()) == 200);
+	detached = sb.Detach();
+	Assert((int)strlen(detached) == 200);
+	free(detached);
+}
+
+Fact("StringBuilder Chunked Truncate Across Chunks")
+{
+	StringBuilder<char> sb;
+	sb.SetChunkSize(200);
+	for (int i = 0; i < 1000; i++)
+		sb.Append((char)('a' + i % 26));
+	Assert(sb.GetChunkCount() == 5);
+
+	// Within the last chunk, then back into earlier ones
+	sb.Truncate(950);
+	Assert(sb.GetLength() == 950);
+	sb.Truncate(450);
+	Assert(sb.GetLength() == 450);
+	Assert(sb.GetChunkCount() == 3);
+	sb.Truncate(400);
+	Assert(sb.GetChunkCount() == 2);
+
+	// Appending carries on from there
+	sb.Append("!");
+	String str = sb.ToString();
+	Assert(str.GetLength() == 401);
+	Assert(str.sz()[399] == 'a' + 399 % 26);
+	Assert(str.sz()[400] == '!');
+
+	sb.Clear();
+	Assert(sb.GetLength() == 0);
+	Assert(sb.GetChunkCount() == 0);
+	sb.Append("after clear");
+	Assert(sb.ToString() == String("after clear"));
+}
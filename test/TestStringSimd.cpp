@@ -0,0 +1,234 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+#include "../Core/StringSimd.h"
+using namespace SimpleLib;
+
+namespace
+{
+	const StringSimdLevel levels[] = { StringSimdLevel::Scalar, StringSimdLevel::Sse2, StringSimdLevel::Avx2 };
+
+	// Runs a check under each instruction set the CPU supports, restoring
+	// the default afterwards
+	template <typename TFn>
+	void ForEachLevel(TFn fn)
+	{
+		for (StringSimdLevel level : levels)
+		{
+			if (level > StringSimdLevel::Scalar && level > StringSimd::GetSupportedLevel())
+				continue;
+			StringSimd::SetLevel(level);
+			fn();
+		}
+		StringSimd::SetLevel(StringSimd::GetSupportedLevel());
+	}
+
+	int NaiveIndexOf(const char* p, int length, const char* find, int findLength)
+	{
+		for (int i = 0; i + findLength <= length; i++)
+		{
+			if (memcmp(p + i, find, findLength) == 0)
+				return i;
+		}
+		return -1;
+	}
+
+	char NaiveLower(char ch)
+	{
+		return (ch >= 'A' && ch <= 'Z') ? (char)(ch + 32) : ch;
+	}
+}
+
+Fact("StringSimd Level Defaults To Supported")
+{
+	Assert(StringSimd::GetLevel() == StringSimd::GetSupportedLevel());
+
+	StringSimd::SetLevel(StringSimdLevel::Scalar);
+	Assert(StringSimd::GetLevel() == StringSimdLevel::Scalar);
+	StringSimd::SetLevel(StringSimdLevel::Avx2);
+	Assert(StringSimd::GetLevel() == StringSimd::GetSupportedLevel());
+}
+
+Fact("StringSimd IndexOf Char Every Position And Alignment")
+{
+	char buf[200];
+	ForEachLevel([&]() {
+		for (int offset = 0; offset < 8; offset++)
+		{
+			for (int length = 0; length < 150; length += 7)
+			{
+				char* p = buf + offset;
+				memset(p, 'a', length);
+				Assert(StringSimd::IndexOf(p, length, 'x') == -1);
+				for (int pos = 0; pos < length; pos++)
+				{
+					p[pos] = 'x';
+					Assert(StringSimd::IndexOf(p, length, 'x') == pos);
+					if (pos + 1 < length)
+					{
+						p[length - 1] = 'x';
+						Assert(StringSimd::IndexOf(p, length, 'x') == pos);
+						p[length - 1] = 'a';
+					}
+					p[pos] = 'a';
+				}
+
+				// Doesn't look past the end
+				p[length] = 'x';
+				Assert(StringSimd::IndexOf(p, length, 'x') == -1);
+			}
+		}
+	});
+}
+
+Fact("StringSimd IndexOf Substring Matches Naive Search")
+{
+	// Text with plenty of near misses (partial matches and candidates
+	// whose first and last characters match)
+	char text[300];
+	for (int i = 0; i < 300; i++)
+		text[i] = "abcab"[(i * 7 + i / 11) % 5];
+
+	const char* finds[] = { "ab", "abc", "bca", "abcab", "aab", "cabcabc", "abcabcabcabcabcabcabcabcabcabcabcabc", "zz", "a" };
+
+	ForEachLevel([&]() {
+		for (const char* find : finds)
+		{
+			int findLength = (int)strlen(find);
+			for (int start = 0; start < 40; start++)
+			{
+				for (int length = 0; length + start <= 300; length += 13)
+				{
+					int expected = NaiveIndexOf(text + start, length, find, findLength);
+					Assert(StringSimd::IndexOf(text + start, length, find, findLength) == expected);
+				}
+			}
+		}
+
+		// Match right at the end of a long run
+		char buf[100];
+		memset(buf, 'a', 100);
+		memcpy(buf + 95, "xyzzy", 5);
+		Assert(StringSimd::IndexOf(buf, 100, "xyzzy", 5) == 95);
+		Assert(StringSimd::IndexOf(buf, 99, "xyzzy", 5) == -1);
+		Assert(StringSimd::IndexOf(buf, 100, "", 0) == -1);
+	});
+}
+
+Fact("StringSimd Case Conversion Is ASCII Only")
+{
+	char src[256];
+	for (int i = 0; i < 256; i++)
+		src[i] = (char)i;
+
+	ForEachLevel([&]() {
+		for (int start = 0; start < 8; start++)
+		{
+			for (int length = 0; length + start <= 256; length += 5)
+			{
+				char upper[256];
+				char lower[256];
+				StringSimd::ToUpper(upper, src + start, length);
+				StringSimd::ToLower(lower, src + start, length);
+				for (int i = 0; i < length; i++)
+				{
+					char ch = src[start + i];
+					Assert(upper[i] == ((ch >= 'a' && ch <= 'z') ? (char)(ch - 32) : ch));
+					Assert(lower[i] == NaiveLower(ch));
+				}
+			}
+		}
+
+		// In place
+		char text[] = "The Quick Brown Fox Jumps Over The Lazy Dog, \xC9t\xC9!";
+		StringSimd::ToUpper(text, text, (int)strlen(text));
+		Assert(strcmp(text, "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG, \xC9T\xC9!") == 0);
+	});
+}
+
+Fact("StringSimd CompareI")
+{
+	char a[200];
+	char b[200];
+	for (int i = 0; i < 200; i++)
+	{
+		a[i] = "Hello World [@`{]"[i % 17];
+		b[i] = NaiveLower(a[i]);
+	}
+
+	ForEachLevel([&]() {
+		for (int length = 0; length < 200; length += 3)
+		{
+			Assert(StringSimd::CompareI(a, b, length) == 0);
+
+			// Differences at every position, including '@' vs '`' and
+			// '[' vs '{' which differ by case folding's 0x20
+			for (int pos = 0; pos < length; pos++)
+			{
+				char save = b[pos];
+				b[pos] = (char)(NaiveLower(a[pos]) + 1);
+				Assert(StringSimd::CompareI(a, b, length) < 0);
+				Assert(StringSimd::CompareI(b, a, length) > 0);
+				b[pos] = save;
+			}
+		}
+
+		// High characters compare unsigned
+		Assert(StringSimd::CompareI("a\xC9", "A\x41", 2) > 0);
+
+		// Null characters don't stop the compare
+		Assert(StringSimd::CompareI("a\0b", "A\0c", 3) < 0);
+	});
+}
+
+Fact("StringSimd SkipWhiteSpace")
+{
+	char buf[200];
+	ForEachLevel([&]() {
+		for (int offset = 0; offset < 32; offset++)
+		{
+			for (int run = 0; run < 100; run += 3)
+			{
+				char* p = buf + offset;
+				for (int i = 0; i < run; i++)
+					p[i] = " \t\r\n"[i % 4];
+				p[run] = 'x';
+				p[run + 1] = '\0';
+
+				Assert(StringSimd::SkipWhiteSpace(p, run + 1) == run);
+				Assert(StringSimd::SkipWhiteSpace(p, run) == run);
+				Assert(StringSimd::SkipWhiteSpace(p) == p + run);
+
+				// Stops at the terminator
+				p[run] = '\0';
+				Assert(StringSimd::SkipWhiteSpace(p) == p + run);
+			}
+		}
+	});
+}
+
+Fact("StringSimd Used By String Methods")
+{
+	String str("  \t Some text to search, with SOME upper case, some lower case and some padding at the end   ");
+	StringView<char> view = str.View();
+
+	ForEachLevel([&]() {
+		Assert(str.IndexOf('p') == str.View().IndexOf('p'));
+		Assert(str.IndexOf('p') == 36);
+		Assert(str.IndexOf('p', 73) == -1);
+		Assert(str.IndexOf('\0') == str.GetLength());
+		Assert(str.IndexOf("some") == 47);
+		Assert(str.IndexOf("some", 50) == 67);
+		Assert(view.IndexOf(StringView<char>("padding")) == 72);
+		Assert(view.IndexOf<SCaseI>(StringView<char>("SOME")) == 4);
+		Assert(view.IndexOf<SCaseI>(StringView<char>("some"), 5) == 30);
+		Assert(view.Trim().StartsWith<SCaseI>("SOME TEXT"));
+		Assert(view.Trim().EndsWith<SCaseI>("AT THE END"));
+		Assert(str.LTrim().StartsWith("Some"));
+		Assert(str.ToUpper().IndexOf("SOME TEXT") == 4);
+		Assert(str.ToLower().IndexOf("some upper") == 30);
+
+		const char* p = "  \t\r\n   \t   x";
+		Assert(Parse<char>::SkipWhiteSpace(p));
+		Assert(*p == 'x');
+	});
+}
@@ -0,0 +1,206 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+#include "../Stream/MemoryStream.h"
+using namespace SimpleLib;
+
+Fact("StringView Construction")
+{
+	StringView<char> null;
+	Assert(null.IsNull());
+	Assert(null.IsEmpty());
+
+	StringView<char> view("Hello World");
+	Assert(!view.IsNull());
+	Assert(view.GetLength() == 11);
+	Assert(view[4] == 'o');
+
+	StringView<char> part("Hello World", 5);
+	Assert(part.GetLength() == 5);
+	Assert(part == "Hello");
+
+	// Views of a string share its characters
+	String str("Hello World, too long to be stored inline");
+	StringView<char> strView = str;
+	Assert(strView.GetBuffer() == str.sz());
+	Assert(strView.GetLength() == str.GetLength());
+	Assert(str.View() == strView);
+
+	// Copying back to a string
+	Assert(part.ToString().IsEqualTo("Hello"));
+	Assert(String(part).IsEqualTo("Hello"));
+	Assert(null.ToString().IsNull());
+}
+
+Fact("StringView Slicing And Trimming")
+{
+	String str("  Hello World  ");
+
+	StringView<char> slice = str.Slice(2, 5);
+	Assert(slice == "Hello");
+	Assert(slice.GetBuffer() == str.sz() + 2);
+	Assert(str.Slice(-7) == "World  ");
+
+	StringView<char> trimmed = str.View().Trim();
+	Assert(trimmed == "Hello World");
+	Assert(trimmed.GetBuffer() == str.sz() + 2);
+	Assert(str.View().LTrim() == "Hello World  ");
+	Assert(str.View().RTrim() == "  Hello World");
+	Assert(StringView<char>("   ").Trim().IsEmpty());
+
+	Assert(trimmed.SubString(6) == "World");
+	Assert(trimmed.SubString(0, 5).SubString(1, 3) == "ell");
+}
+
+Fact("StringView Queries")
+{
+	StringView<char> view = StringView<char>("xxHello World, Hello Worldxx", 28).SubString(2, 24);
+	Assert(view == "Hello World, Hello World");
+
+	Assert(view.IndexOf('o') == 4);
+	Assert(view.IndexOf('o', 5) == 7);
+	Assert(view.IndexOf('x') == -1);
+	Assert(view.IndexOf("World") == 6);
+	Assert(view.IndexOf("World", 7) == 19);
+	Assert(view.IndexOf("Worldxx") == -1);
+	Assert(view.IndexOf<SCaseI>("WORLD") == 6);
+	Assert(view.LastIndexOf("Hello") == 13);
+	Assert(view.LastIndexOf("Hello", 12) == 0);
+	Assert(view.IndexOfAny(",!") == 11);
+	Assert(view.LastIndexOfAny("lo") == 22);
+
+	Assert(view.StartsWith("Hello"));
+	Assert(!view.StartsWith("World"));
+	Assert(view.EndsWith("World"));
+	Assert(!view.EndsWith("Worldxx"));
+	Assert(view.EndsWith<SCaseI>("WORLD"));
+}
+
+Fact("StringView Compare And Hash")
+{
+	StringView<char> a("apple pie", 5);
+	StringView<char> b("apples");
+
+	Assert(a == "apple");
+	Assert(a != b);
+	Assert(a < b);
+	Assert(b > a);
+	Assert(a <= "apple");
+	Assert(a.Compare("apple") == 0);
+	Assert(a.Compare("applf") != 0);
+	Assert(StringView<char>() < a);
+	Assert(a.IsEqualTo<SCaseI>("APPLE"));
+
+	// Views compare and hash the same as strings
+	String str("apple");
+	Assert(a == str);
+	Assert(StringView<char>::Hash(a) == String::Hash(str));
+
+	// Embedded NULs are compared too
+	StringView<char> nul1("ab\0cd", 5);
+	StringView<char> nul2("ab\0ce", 5);
+	Assert(nul1 != nul2);
+	Assert(nul1 < nul2);
+	Assert(nul1.IndexOf(nul2) == -1);
+	Assert(StringView<char>("xab\0cd", 6).IndexOf(nul1) == 1);
+	Assert(StringView<char>("ab\0cdab\0ce", 10).LastIndexOf(nul1) == 0);
+
+	StringView<wchar_t> wide1(L"a\0b", 3);
+	StringView<wchar_t> wide2(L"a\0c", 3);
+	Assert(wide1 < wide2 && wide2 > wide1);
+	Assert(StringView<wchar_t>(L"\x100", 1) > StringView<wchar_t>(L"\xFF", 1));
+}
+
+Fact("StringView Split")
+{
+	String str("a,b,,c");
+
+	List<StringView<char>> parts;
+	Assert(str.Split(",", false, parts) == 3);
+	Assert(parts[0] == "a");
+	Assert(parts[1] == "b");
+	Assert(parts[2] == "c");
+	Assert(parts[2].GetBuffer() == str.sz() + 5);
+
+	Assert(str.View().Split(",", true, parts) == 4);
+	Assert(parts[2].IsEmpty());
+
+	Assert(StringView<char>("").Split(",", false, parts) == 0);
+	Assert(StringView<char>().Split(",", true, parts) == 0);
+}
+
+Fact("StringView Map And Set Lookups")
+{
+	Map<String, int> map;
+	map.Set("alpha", 1);
+	map.Set("beta", 2);
+
+	StringView<char> text("alpha beta gamma");
+	List<StringView<char>> words;
+	text.Split(" ", false, words);
+
+	Assert(map.Get(words[0], -1) == 1);
+	Assert(map.Get(words[1], -1) == 2);
+	Assert(map.Get(words[2], -1) == -1);
+	Assert(map.ContainsKey(words[1]));
+	Assert(!map.ContainsKey(words[2]));
+	int value = 0;
+	Assert(map.TryGetValue(words[1], value) && value == 2);
+
+	Set<String> set;
+	set.Add("gamma");
+	Assert(set.Contains(words[2]));
+	Assert(!set.Contains(words[0]));
+}
+
+Fact("StringView Lookups With Case Insensitive Comparer")
+{
+	// SCaseI hashes and compares differently to the view's own Hash and ==
+	// so views don't take the lookup key overloads...
+	static_assert(!can_lookup<String, SCaseI, StringView<char>>::value);
+	static_assert(can_lookup<String, SDefaultCompare, StringView<char>>::value);
+
+	Map<String, int, SCaseI> map;
+	map.Set("Alpha", 1);
+	map.Set("Beta", 2);
+
+	StringView<char> text("ALPHA beta gamma");
+	List<StringView<char>> words;
+	text.Split(" ", false, words);
+
+	// ...and are found case insensitively once converted to a key
+	Assert(map.Get(String(words[0]), -1) == 1);
+	Assert(map.ContainsKey(String(words[1])));
+	Assert(!map.ContainsKey(String(words[2])));
+
+	Set<String, SCaseI> set;
+	set.Add("Gamma");
+	Assert(set.Contains(String(words[2])));
+	Assert(!set.Contains(String(words[0])));
+}
+
+Fact("StringView Parse StringBuilder And Stream")
+{
+	const char* p = "name = value";
+	StringView<char> ident;
+	Assert(Parse<char>::ParseIdentifier(p, ident));
+	Assert(ident == "name");
+	Assert(*p == ' ');
+
+	String str;
+	p = "other";
+	Assert(Parse<char>::ParseIdentifier(p, str));
+	Assert(str.IsEqualTo("other"));
+
+	StringBuilder<char> sb;
+	sb.Append(ident);
+	sb.Append(StringView<char>(" = value", 3));
+	sb.Append(str);
+	Assert(strcmp(sb.sz(), "name = other") == 0);
+
+	MemoryStream memoryStream;
+	Assert(memoryStream.Create() == 0);
+	Stream& stream = memoryStream;
+	Assert(stream.Write(ident) == 0);
+	Assert(stream.Write(str) == 0);
+	Assert(stream.GetLength() == 9);
+}
@@ -0,0 +1,145 @@
+#include "../UnitTesting.h"
+#include "../Core.h"
+#include "../Threading.h"
+#include "../Stream/MemoryStream.h"
+using namespace SimpleLib;
+
+namespace
+{
+	struct TestTag
+	{
+		static const char* Name() { return "Test Tracked Alloc"; }
+	};
+}
+
+Fact("TrackingAllocator Counts Alloc ReAlloc Free")
+{
+	AllocationTracker tracker("Test Counts");
+	TrackingAllocator<> allocator(&tracker);
+
+	void* p = allocator.Alloc(100);
+	Assert(((uintptr_t)p & 15) == 0);
+	AllocationStats s = tracker.GetStats();
+	Assert(s.bytesLive == 100);
+	Assert(s.blocksLive == 1);
+	Assert(s.allocCount == 1);
+
+	p = allocator.ReAlloc(p, 300);
+	p = allocator.ReAlloc(p, 50);
+	s = tracker.GetStats();
+	Assert(s.bytesLive == 50);
+	Assert(s.bytesPeak == 300);
+	Assert(s.bytesTotal == 300);
+	Assert(s.reallocCount == 2);
+	Assert(s.blocksLive == 1);
+
+	allocator.Free(p);
+	allocator.Free(nullptr);
+	s = tracker.GetStats();
+	Assert(s.bytesLive == 0);
+	Assert(s.blocksLive == 0);
+	Assert(s.freeCount == 1);
+	Assert(s.bytesPeak == 300);
+
+	tracker.ResetPeak();
+	Assert(tracker.GetStats().bytesPeak == 0);
+}
+
+Fact("TrackingAllocator Tracks Containers")
+{
+	AllocationTracker tracker("Test Containers");
+	{
+		List<int, TrackingAllocator<>> list{ TrackingAllocator<>(&tracker) };
+		for (int i = 0; i < 1000; i++)
+			list.Add(i);
+		AllocationStats s = tracker.GetStats();
+		Assert(s.bytesLive >= 1000 * sizeof(int));
+		Assert(s.blocksLive == 1);
+		Assert(s.reallocCount > 0);
+	}
+	Assert(tracker.GetStats().bytesLive == 0);
+
+	// Clearing a map keeps its capacity, which shows up as live bytes
+	Map<int, int, SDefaultCompare, TrackingAllocator<>> map{ TrackingAllocator<>(&tracker) };
+	for (int i = 0; i < 1000; i++)
+		map.Add(i, i);
+	size_t live = tracker.GetStats().bytesLive;
+	map.Clear();
+	Assert(map.GetCount() == 0);
+	Assert(tracker.GetStats().bytesLive == live);
+}
+
+Fact("TrackingAllocator Null Tracker Passes Through")
+{
+	TrackingAllocator<> allocator;
+	void* p = allocator.Alloc(10);
+	Assert(p != nullptr);
+	p = allocator.ReAlloc(p, 20);
+	allocator.Free(p);
+}
+
+Fact("TrackingAllocator Tagged Stateless")
+{
+	Assert(sizeof(List<int, TTrackedAlloc<TestTag>>) == sizeof(List<int>));
+
+	AllocationTracker& tracker = TTrackedAlloc<TestTag>::Tracker();
+	size_t before = tracker.GetStats().bytesLive;
+	{
+		List<int, TTrackedAlloc<TestTag>> list;
+		for (int i = 0; i < 100; i++)
+			list.Add(i);
+		Assert(tracker.GetStats().bytesLive > before);
+	}
+	Assert(tracker.GetStats().bytesLive == before);
+}
+
+Fact("TrackingAllocator Registry Sums By Tag")
+{
+	AllocationTracker a("Test Shared Tag");
+	AllocationTracker b("Test Shared Tag");
+	TrackingAllocator<>(&a).Free(TrackingAllocator<>(&a).Alloc(10));
+	void* p = TrackingAllocator<>(&a).Alloc(100);
+	void* q = TrackingAllocator<>(&b).Alloc(200);
+
+	AllocationStats s;
+	Assert(AllocationTracker::GetTagStats("Test Shared Tag", s));
+	Assert(s.bytesLive == 300);
+	Assert(s.blocksLive == 2);
+	Assert(s.allocCount == 3);
+	Assert(!AllocationTracker::GetTagStats("Test No Such Tag", s));
+
+	TrackingAllocator<>(&a).Free(p);
+	TrackingAllocator<>(&b).Free(q);
+}
+
+Fact("TrackingAllocator Dump Lists Top Tags")
+{
+	AllocationTracker small("Test Dump Small");
+	AllocationTracker large("Test Dump Large");
+	void* p = TrackingAllocator<>(&small).Alloc(1000);
+	void* q = TrackingAllocator<>(&large).Alloc(1000000);
+
+	MemoryStream ms;
+	Assert(ms.Create() == 0);
+	Assert(AllocationTracker::Dump(ms, 1000) == 0);
+	Assert(ms.Write("", 1) == 0);
+
+	const char* text = (const char*)ms.GetBuffer();
+	const char* pLarge = strstr(text, "Test Dump Large");
+	const char* pSmall = strstr(text, "Test Dump Small");
+	Assert(strstr(text, "Allocations by tag") == text);
+	Assert(pLarge != nullptr);
+	Assert(pSmall != nullptr);
+	Assert(pLarge < pSmall);
+	Assert(strstr(pLarge, "1000000") != nullptr);
+
+	// Limited to the top entries
+	MemoryStream top;
+	Assert(top.Create() == 0);
+	Assert(AllocationTracker::Dump(top, 1) == 0);
+	Assert(top.Write("", 1) == 0);
+	Assert(strstr((const char*)top.GetBuffer(), "Test Dump Small") == nullptr);
+
+	TrackingAllocator<>(&small).Free(p);
+	TrackingAllocator<>(&large).Free(q);
+}
@@ -15,3 +15,10 @@
 #include "Threading/CowListWops.h"
 #include "Threading/HighWaterHeap.h"
 #include "Threading/HighWaterHeapSet.h"
+#include "Threading/PageAllocator.h"
+#include "Threading/ObjectPool.h"
+#include "Threading/SizeClassHeap.h"
+#include "Threading/TrackingAllocator.h"
+#include "Threading/Atom.h"
+#include "Threading/WorkerSet.h"
+#include "Threading/Parallel.h"
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../Platform/Platform.h"
+#include "../Core/RealTime.h"
 
 namespace SimpleLib
 {
@@ -20,6 +21,7 @@ public:
 
 	void Enter()
 	{
+		SIMPLELIB_REALTIME_CHECK(MutexEnter);
 		Platform::mutexEnter(m_mutex);
 	}
 	bool TryEnter()
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../Platform/Platform.h"
+#include "../Core/RealTime.h"
 
 namespace SimpleLib
 {
@@ -25,6 +26,8 @@ public:
 
 	bool Wait(uint32_t timeout = kWaitForever)
 	{
+		if (timeout != 0)
+			SIMPLELIB_REALTIME_CHECK(SemaphoreWait);
 		return Platform::semaWait(m_sema, timeout);
 	}
 
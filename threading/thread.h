@@ -93,6 +93,12 @@ public:
 		Platform::Sleep(ms);
 	}
 
+	// Number of logical processors available to this process
+	static int GetProcessorCount()
+	{
+		return Platform::cpuCount();
+	}
+
 protected:
 	virtual void ThreadProc()=0;
 
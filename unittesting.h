@@ -1,6 +1,7 @@
 #pragma once
 
 #include "./Core/String.h"
+#include "./Core/RealTime.h"
 
 namespace SimpleLib
 {
@@ -26,6 +27,7 @@ public:
 
 private:
 	static void RunKind(TestEntryKind kind);
+	static void RunFact(TestEntry* f);
 	inline static List<TestEntry*> m_entries;
 	friend class TestEntry;
 };
@@ -33,13 +35,14 @@ private:
 class TestEntry
 {
 public:
-	TestEntry(TestEntryKind kind, const char* name, const char* file, int line, void (*fn)())
+	TestEntry(TestEntryKind kind, const char* name, const char* file, int line, void (*fn)(), bool realTime = false)
 	{
 		m_kind = kind;
 		m_strName = name;
 		m_strFile = file;
 		m_iLine = line;
 		m_fn = fn;
+		m_realTime = realTime;
 		TestRunner::Register(this);
 	}
 
@@ -53,6 +56,7 @@ public:
 	String m_strFile;
 	int m_iLine;
 	void (*m_fn)();
+	bool m_realTime;
 
 };
 
@@ -85,6 +89,30 @@ inline void TestRunner::RunKind(TestEntryKind kind)
 
 }
 
+// Run a fact, checking real-time facts don't allocate, lock or block
+inline void TestRunner::RunFact(TestEntry* f)
+{
+	if (!f->m_realTime)
+	{
+		f->m_fn();
+		return;
+	}
+
+	{
+		RealTimeScope scope;
+		f->m_fn();
+	}
+
+	RealTimeViolation violation;
+	if (RealTimeGuard::GetFirstViolation(violation))
+	{
+		static char message[128];
+		snprintf(message, sizeof(message), "%i real-time violation(s), first: %s at %p",
+			RealTimeGuard::GetViolationCount(), RealTimeGuard::GetKindName(violation.kind), violation.callSite);
+		throw AssertionFailed(message, f->m_strFile.sz(), f->m_iLine);
+	}
+}
+
 inline void TestRunner::Run()
 {
 	RunKind(TestEntryKind::Initialize);
@@ -102,7 +130,7 @@ inline void TestRunner::Run()
         try
         {
 			count++;
-    		m_entries[i]->m_fn();
+			RunFact(f);
 			printf("ok\n");
         }
         catch (const AssertionFailed& e)
@@ -153,6 +181,14 @@ static void SIMPLELIB_UNIQUE_NAME(fn)(); \
 static SimpleLib::TestEntry SIMPLELIB_UNIQUE_NAME(fe)(TestEntryKind::Fact, name, __FILE__, __LINE__, &SIMPLELIB_UNIQUE_NAME(fn)); \
 static void SIMPLELIB_UNIQUE_NAME(fn)() \
 
+// A fact whose body must be real-time safe: it fails if the body allocates
+// through TMalloc, enters a Mutex or blocks on a Semaphore (only checked
+// when built with _SIMPLELIB_REALTIME_GUARD, see RealTimeGuard)
+#define RealTimeFact(name) \
+static void SIMPLELIB_UNIQUE_NAME(fn)(); \
+static SimpleLib::TestEntry SIMPLELIB_UNIQUE_NAME(fe)(TestEntryKind::Fact, name, __FILE__, __LINE__, &SIMPLELIB_UNIQUE_NAME(fn), true); \
+static void SIMPLELIB_UNIQUE_NAME(fn)() \
+
 inline void _Assert(bool value, const char* expr, const char* file, int line)
 {
 	if (!value)